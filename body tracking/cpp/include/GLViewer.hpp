@@ -14,6 +14,11 @@
 #include <cuda.h>
 #include <cuda_gl_interop.h>
 
+#include "Shader.hpp"
+#include "Simple3DObject.hpp"
+#include "InstancedObject.hpp"
+#include "OffscreenRenderer.hpp"
+
 #ifndef M_PI
 #define M_PI 3.141592653f
 #endif
@@ -21,93 +26,6 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-class Shader {
-public:
-
-	Shader() {}
-	Shader(GLchar* vs, GLchar* fs);
-	~Shader();
-	GLuint getProgramId();
-
-	static const GLint ATTRIB_VERTICES_POS = 0;
-	static const GLint ATTRIB_COLOR_POS = 1;
-	static const GLint ATTRIB_NORMAL = 2;
-private:
-	bool compile(GLuint &shaderId, GLenum type, GLchar* src);
-	GLuint verterxId_;
-	GLuint fragmentId_;
-	GLuint programId_;
-};
-
-struct ShaderData {
-	Shader it;
-	GLuint MVP_Mat;
-};
-
-class Simple3DObject {
-public:
-
-	Simple3DObject();
-	~Simple3DObject();
-
-	void init();
-	bool isInit();
-	void addPt(sl::float3 pt);
-	void addClr(sl::float4 clr);
-	void addNormal(sl::float3 normal);
-	void addPoints(std::vector<sl::float3> pts, sl::float4 base_clr);
-	void addBoundingBox(std::vector<sl::float3> bbox, sl::float4 base_clr);
-	void addPoint(sl::float3 pt, sl::float4 clr);
-	void addLine(sl::float3 p1, sl::float3 p2, sl::float3 clr);
-	void addCylinder(sl::float3 startPosition, sl::float3 endPosition, sl::float4 clr);
-	void addSphere(sl::float3 position, sl::float4 clr);
-	void pushToGPU();
-	void clear();
-
-	void setDrawingType(GLenum type);
-
-	void draw();
-
-	void translate(const sl::Translation& t);
-	void setPosition(const sl::Translation& p);
-
-	void setRT(const sl::Transform& mRT);
-
-	void rotate(const sl::Orientation& rot);
-	void rotate(const sl::Rotation& m);
-	void setRotation(const sl::Orientation& rot);
-	void setRotation(const sl::Rotation& m);
-
-	const sl::Translation& getPosition() const;
-
-	sl::Transform getModelMatrix() const;
-
-private:
-	std::vector<float> vertices_;
-	std::vector<float> colors_;
-	std::vector<unsigned int> indices_;
-	std::vector<float> normals_;
-
-	bool isStatic_;
-	bool is_init;
-	bool can_draw;
-
-	GLenum drawingType_;
-
-	GLuint vaoID_;
-	/*
-	Vertex buffer IDs:
-	- [0]: Vertices coordinates;
-	- [1]: Colors;
-	- [2]: Indices;
-	- [3]: Normals
-	*/
-	GLuint vboID_[4];
-
-	sl::Translation position_;
-	sl::Orientation rotation_;
-};
-
 class ImageHandler {
 public:
 	ImageHandler();
@@ -166,6 +84,7 @@ private:
 
 	bool available;
 	bool drawBbox = false;
+	bool newFrame_ = false; // offscreen: an image was pushed since the last rendering
 
 	enum MOUSE_BUTTON {
 		LEFT = 0,
@@ -194,13 +113,17 @@ private:
 
 	std::vector<ObjectClassName> objectsName;
 
-	Simple3DObject BBox_obj;
-	Simple3DObject bones;
-	Simple3DObject joints;
+	// One instance per body, bone and joint
+	InstancedObject BBox_obj;
+	InstancedObject bones;
+	InstancedObject joints;
 
 	bool floor_plane_set = false;
 	sl::float4 floor_plane_eq;
 
+	// Used in place of the window when ZED_VIEWER_OFFSCREEN is set
+	OffscreenRenderer offscreen_;
+
 };
 
 #endif /* __VIEWER_INCLUDE__ */
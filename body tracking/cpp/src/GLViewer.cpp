@@ -9,11 +9,16 @@ GLchar* VERTEX_SHADER =
 "#version 330 core\n"
 "layout(location = 0) in vec3 in_Vertex;\n"
 "layout(location = 1) in vec4 in_Color;\n"
+"layout(location = 3) in vec4 in_ModelX;\n"
+"layout(location = 4) in vec4 in_ModelY;\n"
+"layout(location = 5) in vec4 in_ModelZ;\n"
+"layout(location = 6) in vec4 in_InstanceColor;\n"
 "uniform mat4 u_mvpMatrix;\n"
 "out vec4 b_color;\n"
 "void main() {\n"
-"   b_color = in_Color;\n"
-"	gl_Position = u_mvpMatrix * vec4(in_Vertex, 1);\n"
+"   vec4 v = vec4(in_Vertex, 1);\n"
+"   b_color = in_Color * in_InstanceColor;\n"
+"	gl_Position = u_mvpMatrix * vec4(dot(in_ModelX, v), dot(in_ModelY, v), dot(in_ModelZ, v), 1);\n"
 "}";
 
 GLchar* FRAGMENT_SHADER =
@@ -30,16 +35,21 @@ GLchar* SK_VERTEX_SHADER =
 "layout(location = 0) in vec3 in_Vertex;\n"
 "layout(location = 1) in vec4 in_Color;\n"
 "layout(location = 2) in vec3 in_Normal;\n"
+"layout(location = 3) in vec4 in_ModelX;\n"
+"layout(location = 4) in vec4 in_ModelY;\n"
+"layout(location = 5) in vec4 in_ModelZ;\n"
+"layout(location = 6) in vec4 in_InstanceColor;\n"
 "out vec4 b_color;\n"
 "out vec3 b_position;\n"
 "out vec3 b_normal;\n"
 "uniform mat4 u_mvpMatrix;\n"
 "uniform vec4 u_color;\n"
 "void main() {\n"
-"   b_color = in_Color;\n"
-"   b_position = in_Vertex;\n"
-"   b_normal = in_Normal;\n"
-"	gl_Position =  u_mvpMatrix * vec4(in_Vertex, 1);\n"
+"   vec4 v = vec4(in_Vertex, 1);\n"
+"   b_color = in_Color * in_InstanceColor;\n"
+"   b_position = vec3(dot(in_ModelX, v), dot(in_ModelY, v), dot(in_ModelZ, v));\n"
+"   b_normal = normalize(vec3(dot(in_ModelX.xyz, in_Normal), dot(in_ModelY.xyz, in_Normal), dot(in_ModelZ.xyz, in_Normal)));\n"
+"	gl_Position =  u_mvpMatrix * vec4(b_position, 1);\n"
 "}";
 
 GLchar* SK_FRAGMENT_SHADER =
@@ -84,13 +94,20 @@ GLViewer::~GLViewer() {}
 void GLViewer::exit() {
 	if (currentInstance_) {
 		image_handler.close();
+		offscreen_.close();
 		available = false;
 	}
 }
 
 bool GLViewer::isAvailable() {
-	if (available)
-		glutMainLoopEvent();
+	if (available) {
+		if (offscreen_.isInitialized()) {
+			// No window events, one frame per new image
+			if (newFrame_)
+				render();
+		} else
+			glutMainLoopEvent();
+	}
 	return available;
 }
 
@@ -98,27 +115,33 @@ void CloseFunc(void) { if (currentInstance_) currentInstance_->exit(); }
 
 void GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
 
-	glutInit(&argc, argv);
-	int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
-	int wnd_h = glutGet(GLUT_SCREEN_HEIGHT);
-	int width = wnd_w * 0.9;
-	int height = wnd_h * 0.9;
-	if (width > param.image_size.width && height > param.image_size.height) {
-		width = param.image_size.width;
-		height = param.image_size.height;
-	}
+	if (OffscreenRenderer::isRequested()) {
+		// Headless, at the camera resolution
+		if (!offscreen_.init(param.image_size.width, param.image_size.height, true))
+			return;
+	} else {
+		glutInit(&argc, argv);
+		int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
+		int wnd_h = glutGet(GLUT_SCREEN_HEIGHT);
+		int width = wnd_w * 0.9;
+		int height = wnd_h * 0.9;
+		if (width > param.image_size.width && height > param.image_size.height) {
+			width = param.image_size.width;
+			height = param.image_size.height;
+		}
 
-	glutInitWindowSize(width, height);
-	glutInitWindowPosition(wnd_w*0.05, wnd_h*0.05);
-	glutInitDisplayMode(GLUT_DOUBLE | GLUT_SRGB);
-	glutCreateWindow("ZED Body Tracking Viewer");
-	glViewport(0, 0, width, height);
+		glutInitWindowSize(width, height);
+		glutInitWindowPosition(wnd_w*0.05, wnd_h*0.05);
+		glutInitDisplayMode(GLUT_DOUBLE | GLUT_SRGB);
+		glutCreateWindow("ZED Body Tracking Viewer");
+		glViewport(0, 0, width, height);
 
-	GLenum err = glewInit();
-	if (GLEW_OK != err)
-		std::cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << "\n";
+		GLenum err = glewInit();
+		if (GLEW_OK != err)
+			std::cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << "\n";
 
-	glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+		glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+	}
 
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -142,14 +165,15 @@ void GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
 	// Create the rendering camera
 	setRenderCameraProjection(param, 0.5f, 20);
 
-	// Create the bounding box object
-	BBox_obj.init();
+	// Create the unit shapes, in white: each instance gives its transform and color
+	std::vector<sl::float3> unit_box = InstancedObject::unitBox();
+	BBox_obj.addBoundingBox(unit_box, sl::float4(1, 1, 1, 1));
 	BBox_obj.setDrawingType(GL_QUADS);
 
-	bones.init();
+	bones.addCylinder(sl::float3(0, 0, 0), sl::float3(0, 1, 0), sl::float4(1, 1, 1, 1));
 	bones.setDrawingType(GL_QUADS);
 
-	joints.init();
+	joints.addSphere(sl::float3(0, 0, 0), sl::float4(1, 1, 1, 1));
 	joints.setDrawingType(GL_QUADS);
 
 	floor_plane_set = false;
@@ -160,11 +184,13 @@ void GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
 	glDisable(GL_DEPTH_TEST); //avoid occlusion with bbox
 
 	// Map glut function on this class methods
-	glutDisplayFunc(GLViewer::drawCallback);
-	glutReshapeFunc(GLViewer::reshapeCallback);
-	glutKeyboardFunc(GLViewer::keyPressedCallback);
-	glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
-	glutCloseFunc(CloseFunc);
+	if (!offscreen_.isInitialized()) {
+		glutDisplayFunc(GLViewer::drawCallback);
+		glutReshapeFunc(GLViewer::reshapeCallback);
+		glutKeyboardFunc(GLViewer::keyPressedCallback);
+		glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
+		glutCloseFunc(CloseFunc);
+	}
 	available = true;
 }
 
@@ -203,15 +229,24 @@ void GLViewer::setRenderCameraProjection(sl::CameraParameters params, float znea
 
 void GLViewer::render() {
 	if (available) {
+		if (offscreen_.isInitialized())
+			offscreen_.beginFrame();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		glClearColor(bckgrnd_clr.r, bckgrnd_clr.g, bckgrnd_clr.b, 1.f);
 		mtx.lock();
 		update();
 		draw();
-		printText();
+		// The labels are drawn with the glut fonts, not available offscreen
+		if (!offscreen_.isInitialized())
+			printText();
+		newFrame_ = false;
 		mtx.unlock();
-		glutSwapBuffers();
-		glutPostRedisplay();
+		if (offscreen_.isInitialized())
+			offscreen_.endFrame();
+		else {
+			glutSwapBuffers();
+			glutPostRedisplay();
+		}
 	}
 }
 
@@ -228,12 +263,13 @@ void GLViewer::updateView(sl::Mat image, sl::Objects &objects) {
 	mtx.lock();
 	// Update Image
 	image_handler.pushNewImage(image);
+	newFrame_ = true;
 
 	// Clear frames object
-	BBox_obj.clear();
+	BBox_obj.clearInstances();
 	objectsName.clear();
-	bones.clear();
-	joints.clear();
+	bones.clearInstances();
+	joints.clearInstances();
 
 	// For each object
     for (auto i = objects.object_list.rbegin(); i != objects.object_list.rend(); ++i) {
@@ -252,12 +288,12 @@ void GLViewer::updateView(sl::Mat image, sl::Objects &objects) {
 					float norm_2 = kp_2.norm();
 					// draw cylinder between two keypoints
 					if (std::isfinite(norm_1) && std::isfinite(norm_2)) {
-						bones.addCylinder(kp_1, kp_2, clr_id);
+						bones.addSegmentInstance(kp_1, kp_2, clr_id);
 					}
 				}
 				for (int i = 0; i < static_cast<int>(sl::BODY_PARTS::LAST); i++) {
 					sl::float3 kp = obj.keypoint[i];
-					if (std::isfinite(kp.norm())) joints.addSphere(kp, clr_id);
+					if (std::isfinite(kp.norm())) joints.addInstance(kp, clr_id);
 				}
 			}
 
@@ -269,7 +305,7 @@ void GLViewer::updateView(sl::Mat image, sl::Objects &objects) {
 						for (int i = 4; i < 8; i++)
 							bb_[i].y = (floor_plane_eq.x * bb_[i].x + floor_plane_eq.z * bb_[i].z + floor_plane_eq.w) / (floor_plane_eq.y * -1.f);
 					}
-					BBox_obj.addBoundingBox(bb_, clr_id);
+					BBox_obj.addBoxInstance(bb_, clr_id);
 
 					objectsName.emplace_back();
 					objectsName.back().name_lineA = "ID : " + std::to_string(obj.id);
@@ -378,438 +414,6 @@ void GLViewer::idle() {
 	glutPostRedisplay();
 }
 
-Simple3DObject::Simple3DObject() {
-	is_init = can_draw = false;
-}
-
-Simple3DObject::~Simple3DObject() {
-	if (vaoID_ != 0) {
-		glDeleteBuffers(4, vboID_);
-		glDeleteVertexArrays(1, &vaoID_);
-		vaoID_ = 0;
-		is_init = can_draw = false;
-	}
-}
-
-bool Simple3DObject::isInit()
-{
-	return is_init;
-}
-
-void Simple3DObject::init() {
-	vaoID_ = 0;
-	isStatic_ = false;
-	drawingType_ = GL_TRIANGLES;
-	rotation_.setIdentity();
-	is_init = true;
-}
-
-void Simple3DObject::addPt(sl::float3 pt) {
-	vertices_.push_back(pt.x);
-	vertices_.push_back(pt.y);
-	vertices_.push_back(pt.z);
-}
-
-void Simple3DObject::addClr(sl::float4 clr) {
-	colors_.push_back(clr.r);
-	colors_.push_back(clr.g);
-	colors_.push_back(clr.b);
-	colors_.push_back(clr.a);
-}
-
-void Simple3DObject::addNormal(sl::float3 normal) {
-	normals_.push_back(normal.x);
-	normals_.push_back(normal.y);
-	normals_.push_back(normal.z);
-}
-void Simple3DObject::addPoints(std::vector<sl::float3> pts, sl::float4 base_clr)
-{
-	for (int k = 0; k < pts.size(); k++) {
-		sl::float3 pt = pts.at(k);
-		vertices_.push_back(pt.x);
-		vertices_.push_back(pt.y);
-		vertices_.push_back(pt.z);
-		colors_.push_back(base_clr.r);
-		colors_.push_back(base_clr.g);
-		colors_.push_back(base_clr.b);
-		colors_.push_back(1.f);
-		int current_size_index = (vertices_.size() / 3 - 1);
-		indices_.push_back(current_size_index);
-		indices_.push_back(current_size_index + 1);
-	}
-}
-
-void Simple3DObject::addPoint(sl::float3 pt, sl::float4 clr) {
-	addPt(pt);
-	addClr(clr);
-	indices_.push_back((int)indices_.size());
-}
-
-const std::vector<int> boxLinks = { 0,1,5,4,1,2,6,5,2,3,7,6,3,0,4,7 };
-
-void Simple3DObject::addBoundingBox(std::vector<sl::float3> bbox, sl::float4 base_clr) {
-
-	int start_id = vertices_.size() / 3;
-
-	float ratio = 1.f / 5.f;
-
-	std::vector<sl::float3> bbox_;
-	// generate TOP BOX
-	for (int i = 0; i < 4; i++)
-		bbox_.push_back(bbox[i]);
-	// generate TOP BOX FADE
-	for (int i = 4; i < 8; i++) {
-		auto midd = bbox[i - 4] - (bbox[i - 4] - bbox[i]) * ratio;
-		bbox_.push_back(midd);
-	}
-
-	// generate BOTTOM FADE
-	for (int i = 4; i < 8; i++) {
-		auto midd = bbox[i] + (bbox[i - 4] - bbox[i]) * ratio;
-		bbox_.push_back(midd);
-	}
-	// generate BOTTOM BOX
-	for (int i = 4; i < 8; i++)
-		bbox_.push_back(bbox[i]);
-
-	for (int i = 0; i < bbox_.size(); i++) {
-		vertices_.push_back(bbox_[i].x);
-		vertices_.push_back(bbox_[i].y);
-		vertices_.push_back(bbox_[i].z);
-
-		colors_.push_back(base_clr.r);
-		colors_.push_back(base_clr.g);
-		colors_.push_back(base_clr.b);
-		colors_.push_back(((i > 3) && (i < 12)) ? 0 : base_clr.a); //fading
-	}
-
-	for (int i = 0; i < boxLinks.size(); i += 4) {
-		indices_.push_back(start_id + boxLinks[i]);
-		indices_.push_back(start_id + boxLinks[i + 1]);
-		indices_.push_back(start_id + boxLinks[i + 2]);
-		indices_.push_back(start_id + boxLinks[i + 3]);
-	}
-
-	for (int i = 0; i < boxLinks.size(); i += 4) {
-		indices_.push_back(start_id + 8 + boxLinks[i]);
-		indices_.push_back(start_id + 8 + boxLinks[i + 1]);
-		indices_.push_back(start_id + 8 + boxLinks[i + 2]);
-		indices_.push_back(start_id + 8 + boxLinks[i + 3]);
-	}
-}
-
-void Simple3DObject::addLine(sl::float3 p1, sl::float3 p2, sl::float3 clr) {
-	vertices_.push_back(p1.x);
-	vertices_.push_back(p1.y);
-	vertices_.push_back(p1.z);
-
-	vertices_.push_back(p2.x);
-	vertices_.push_back(p2.y);
-	vertices_.push_back(p2.z);
-
-	colors_.push_back(clr.r);
-	colors_.push_back(clr.g);
-	colors_.push_back(clr.b);
-	colors_.push_back(1.f);
-
-	colors_.push_back(clr.r);
-	colors_.push_back(clr.g);
-	colors_.push_back(clr.b);
-	colors_.push_back(1.f);
-
-	indices_.push_back((int)indices_.size());
-	indices_.push_back((int)indices_.size());
-}
-
-void Simple3DObject::addCylinder(sl::float3 startPosition, sl::float3 endPosition, sl::float4 clr) {
-	const float m_radius = 0.010f;
-
-	sl::float3 dir = endPosition - startPosition;
-	float m_height = dir.norm();
-	dir = dir / m_height;
-
-	sl::float3 yAxis(0, 1, 0);
-	sl::float3 v = sl::float3::cross(dir, yAxis);
-	sl::Transform rotation;
-
-	if (v.norm() < 0.00001f)
-		rotation.setIdentity();
-	else {
-		float cosTheta = sl::float3::dot(dir, yAxis);
-		float scale = (1.f - cosTheta) / (1.f - (cosTheta * cosTheta));
-
-		float data[] = { 0    , v[2] , -v[1], 0,
-						-v[2], 0    , v[0] , 0,
-						v[1] , -v[0], 0    , 0,
-						0    , 0    , 0    , 1.f };
-
-		sl::Transform vx = sl::Transform(data);
-		rotation.setIdentity();
-		rotation = rotation + vx;
-		rotation = rotation + vx * vx * scale;
-	}
-
-	/////////////////////////////
-
-	sl::float3 v1;
-	sl::float3 v2;
-	sl::float3 v3;
-	sl::float3 v4;
-	sl::float3 normal;
-
-	const int NB_SEG = 32;
-	const float scale_seg = 1.f / NB_SEG;
-	auto rot = rotation.getRotationMatrix();
-	for(int j = 0; j < NB_SEG; j++){
-		float i = 2.f * M_PI * (j * scale_seg);
-		float i1 = 2.f * M_PI * ((j + 1) * scale_seg);
-		v1 = sl::float3(m_radius * cos(i), 0, m_radius * sin(i)) * rot + startPosition;
-		v2 = sl::float3(m_radius * cos(i), m_height, m_radius * sin(i)) * rot + startPosition;
-		v3 = sl::float3(m_radius * cos(i1), 0, m_radius * sin(i1)) * rot + startPosition;
-		v4 = sl::float3(m_radius * cos(i1), m_height, m_radius * sin(i1)) * rot + startPosition;
-
-		addPoint(v1, clr);
-		addPoint(v2, clr);
-		addPoint(v4, clr);
-		addPoint(v3, clr);
-
-		normal = sl::float3::cross((v2 - v1), (v3 - v1));
-		normal = normal / normal.norm();
-
-		addNormal(normal);
-		addNormal(normal);
-		addNormal(normal);
-		addNormal(normal);
-	}
-}
-
-void Simple3DObject::addSphere(sl::float3 position, sl::float4 clr) {
-	const float m_radius = 0.02f;
-	const int m_stackCount = 16;
-	const int m_sectorCount = 16;
-
-	sl::float3 point;
-	sl::float3 normal;
-
-	int i, j;
-	for (i = 0; i <= m_stackCount; i++) {
-		double lat0 = M_PI * (-0.5 + (double)(i - 1) / m_stackCount);
-		double z0 = sin(lat0);
-		double zr0 = cos(lat0);
-
-		double lat1 = M_PI * (-0.5 + (double)i / m_stackCount);
-		double z1 = sin(lat1);
-		double zr1 = cos(lat1);
-		for (j = 0; j <= m_sectorCount - 1; j++) {
-			double lng = 2 * M_PI * (double)(j - 1) / m_sectorCount;
-			double x = cos(lng);
-			double y = sin(lng);
-
-			point = sl::float3(m_radius * x * zr0, m_radius * y * zr0, m_radius * z0) + position;
-			normal = sl::float3(x * zr0, y * zr0, z0);
-			normal = normal / normal.norm();
-			addPoint(point, clr);
-			addNormal(normal);
-
-			point = sl::float3(m_radius * x * zr1, m_radius * y * zr1, m_radius * z1) + position;
-			normal = sl::float3(x * zr1, y * zr1, z1);
-			normal = normal / normal.norm();
-			addPoint(point, clr);
-			addNormal(normal);
-
-			lng = 2 * M_PI * (double)(j) / m_sectorCount;
-			x = cos(lng);
-			y = sin(lng);
-
-			point = sl::float3(m_radius * x * zr1, m_radius * y * zr1, m_radius * z1) + position;
-			normal = sl::float3(x * zr1, y * zr1, z1);
-			normal = normal / normal.norm();
-			addPoint(point, clr);
-			addNormal(normal);
-
-			point = sl::float3(m_radius * x * zr0, m_radius * y * zr0, m_radius * z0) + position;
-			normal = sl::float3(x * zr0, y * zr0, z0);
-			normal = normal / normal.norm();
-			addPoint(point, clr);
-			addNormal(normal);
-		}
-	}
-}
-
-void Simple3DObject::pushToGPU() {
-	if (!isStatic_ || vaoID_ == 0) {
-		if (vaoID_ == 0) {
-			glGenVertexArrays(1, &vaoID_);
-			glGenBuffers(4, vboID_);
-		}
-		glShadeModel(GL_SMOOTH);
-		if (vertices_.size() > 0) {
-			glBindVertexArray(vaoID_);
-			glBindBuffer(GL_ARRAY_BUFFER, vboID_[0]);
-			glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(float), &vertices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(Shader::ATTRIB_VERTICES_POS, 3, GL_FLOAT, GL_FALSE, 0, 0);
-			glEnableVertexAttribArray(Shader::ATTRIB_VERTICES_POS);
-		}
-		if (colors_.size() > 0) {
-			glBindBuffer(GL_ARRAY_BUFFER, vboID_[1]);
-			glBufferData(GL_ARRAY_BUFFER, colors_.size() * sizeof(float), &colors_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(Shader::ATTRIB_COLOR_POS, 4, GL_FLOAT, GL_FALSE, 0, 0);
-			glEnableVertexAttribArray(Shader::ATTRIB_COLOR_POS);
-		}
-		if (indices_.size() > 0) {
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboID_[2]);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned int), &indices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-			can_draw = true;
-		}
-		if (normals_.size() > 0) {
-			glBindBuffer(GL_ARRAY_BUFFER, vboID_[3]);
-			glBufferData(GL_ARRAY_BUFFER, normals_.size() * sizeof(float), &normals_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(Shader::ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
-			glEnableVertexAttribArray(Shader::ATTRIB_NORMAL);
-		}
-
-		glBindVertexArray(0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-	}
-}
-
-void Simple3DObject::clear() {
-	vertices_.clear();
-	colors_.clear();
-	indices_.clear();
-	normals_.clear();
-	can_draw = false;
-}
-
-void Simple3DObject::setDrawingType(GLenum type) {
-	drawingType_ = type;
-}
-
-void Simple3DObject::draw() {
-	if (can_draw && vaoID_) {
-		glBindVertexArray(vaoID_);
-		glDrawElements(drawingType_, (GLsizei)indices_.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
-	}
-}
-
-void Simple3DObject::translate(const sl::Translation& t) {
-	position_ = position_ + t;
-}
-
-void Simple3DObject::setPosition(const sl::Translation& p) {
-	position_ = p;
-}
-
-void Simple3DObject::setRT(const sl::Transform& mRT) {
-	position_ = mRT.getTranslation();
-	rotation_ = mRT.getOrientation();
-}
-
-void Simple3DObject::rotate(const sl::Orientation& rot) {
-	rotation_ = rot * rotation_;
-}
-
-void Simple3DObject::rotate(const sl::Rotation& m) {
-	this->rotate(sl::Orientation(m));
-}
-
-void Simple3DObject::setRotation(const sl::Orientation& rot) {
-	rotation_ = rot;
-}
-
-void Simple3DObject::setRotation(const sl::Rotation& m) {
-	this->setRotation(sl::Orientation(m));
-}
-
-const sl::Translation& Simple3DObject::getPosition() const {
-	return position_;
-}
-
-sl::Transform Simple3DObject::getModelMatrix() const {
-	sl::Transform tmp;
-	tmp.setOrientation(rotation_);
-	tmp.setTranslation(position_);
-	return tmp;
-}
-
-Shader::Shader(GLchar* vs, GLchar* fs) {
-	if (!compile(verterxId_, GL_VERTEX_SHADER, vs)) {
-		std::cout << "ERROR: while compiling vertex shader" << std::endl;
-	}
-	if (!compile(fragmentId_, GL_FRAGMENT_SHADER, fs)) {
-		std::cout << "ERROR: while compiling fragment shader" << std::endl;
-	}
-
-	programId_ = glCreateProgram();
-
-	glAttachShader(programId_, verterxId_);
-	glAttachShader(programId_, fragmentId_);
-
-	glBindAttribLocation(programId_, ATTRIB_VERTICES_POS, "in_vertex");
-	glBindAttribLocation(programId_, ATTRIB_COLOR_POS, "in_texCoord");
-
-	glLinkProgram(programId_);
-
-	GLint errorlk(0);
-	glGetProgramiv(programId_, GL_LINK_STATUS, &errorlk);
-	if (errorlk != GL_TRUE) {
-		std::cout << "ERROR: while linking Shader :" << std::endl;
-		GLint errorSize(0);
-		glGetProgramiv(programId_, GL_INFO_LOG_LENGTH, &errorSize);
-
-		char *error = new char[errorSize + 1];
-		glGetShaderInfoLog(programId_, errorSize, &errorSize, error);
-		error[errorSize] = '\0';
-		std::cout << error << std::endl;
-
-		delete[] error;
-		glDeleteProgram(programId_);
-	}
-}
-
-Shader::~Shader() {
-	if (verterxId_ != 0)
-		glDeleteShader(verterxId_);
-	if (fragmentId_ != 0)
-		glDeleteShader(fragmentId_);
-	if (programId_ != 0)
-		glDeleteShader(programId_);
-}
-
-GLuint Shader::getProgramId() {
-	return programId_;
-}
-
-bool Shader::compile(GLuint &shaderId, GLenum type, GLchar* src) {
-	shaderId = glCreateShader(type);
-	if (shaderId == 0) {
-		std::cout << "ERROR: shader type (" << type << ") does not exist" << std::endl;
-		return false;
-	}
-	glShaderSource(shaderId, 1, (const char**)&src, 0);
-	glCompileShader(shaderId);
-
-	GLint errorCp(0);
-	glGetShaderiv(shaderId, GL_COMPILE_STATUS, &errorCp);
-	if (errorCp != GL_TRUE) {
-		std::cout << "ERROR: while compiling Shader :" << std::endl;
-		GLint errorSize(0);
-		glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &errorSize);
-
-		char *error = new char[errorSize + 1];
-		glGetShaderInfoLog(shaderId, errorSize, &errorSize, error);
-		error[errorSize] = '\0';
-		std::cout << error << std::endl;
-
-		delete[] error;
-		glDeleteShader(shaderId);
-		return false;
-	}
-	return true;
-}
-
 GLchar* IMAGE_FRAGMENT_SHADER =
 "#version 330 core\n"
 " in vec2 UV;\n"
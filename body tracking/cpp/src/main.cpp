@@ -106,7 +106,8 @@ int main(int argc, char **argv) {
     bool need_floor_plane = positional_tracking_parameters.set_as_static;
     while (viewer.isAvailable()) {
         // Grab images
-        if (zed.grab() == ERROR_CODE::SUCCESS) {
+        auto returned_state = zed.grab();
+        if (returned_state == ERROR_CODE::SUCCESS) {
 
             // Once the camera has started, get the floor plane to stick the bounding box to the floor plane.
             // Only called if camera is static (see PositionalTrackingParameters)
@@ -125,6 +126,9 @@ int main(int argc, char **argv) {
             
             //Update GL View
             viewer.updateView(image, bodies);
+        } else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && OffscreenRenderer::isRequested()) {
+            // Headless rendering of an SVO: stop at its end
+            viewer.exit();
         }
     }
 
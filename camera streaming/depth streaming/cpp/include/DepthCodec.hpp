@@ -0,0 +1,37 @@
+#ifndef __DEPTH_CODEC_HDR__
+#define __DEPTH_CODEC_HDR__
+
+#include <cstdint>
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+/*
+ * 16 bit depth quantization and lossless compression.
+ *
+ * The depth is quantized to depth / scale, rounded, 0 marks the invalid pixels (NAN, INFINITY, out of range).
+ *
+ * The codec predicts each pixel from its left, up and up-left neighbors (median edge detector of JPEG-LS), and writes
+ * the zigzag encoded residuals with a byte oriented variable length code:
+ *   0xxxxxxx                  residual 0..127
+ *   10xxxxxx xxxxxxxx         residual 128..16383
+ *   110nnnnn                  run of 2..33 zero residuals
+ *   11100000 xxxxxxxx * 2     any residual
+ *   11100001 nnnnnnnn * 2     run of 34..65535 zero residuals
+ * Smooth surfaces mostly take 1 byte per pixel and the invalid areas almost nothing. The residuals are computed with
+ * AVX2 when the CPU supports it.
+ */
+
+// depth: F32_C1 in CPU memory. quantized is resized to width * height.
+void quantizeDepth(sl::Mat& depth, float scale, std::vector<uint16_t>& quantized);
+// depth must be F32_C1 in CPU memory, of the size of the quantized frame
+void dequantizeDepth(const uint16_t* quantized, float scale, sl::Mat& depth);
+
+// Size of the output buffer of encodeDepth (worst case)
+size_t encodeDepthBound(int width, int height);
+// Writes the compressed frame to 'out', returns its size
+size_t encodeDepth(const uint16_t* quantized, int width, int height, uint8_t* out);
+// Returns false if the data is corrupted or does not hold exactly width * height pixels
+bool decodeDepth(const uint8_t* data, size_t size, int width, int height, uint16_t* quantized);
+
+#endif /* __DEPTH_CODEC_HDR__ */
@@ -0,0 +1,114 @@
+#ifndef __DEPTH_TRANSPORT_HDR__
+#define __DEPTH_TRANSPORT_HDR__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Depth + pose frames over TCP.
+ *
+ * Each frame is a fixed 64 bytes header followed by the payload: the quantized depth, compressed by DepthCodec or raw.
+ * The header and the payload are sent from their own buffers with a single scatter/gather write (sendmsg), nothing is
+ * copied into an intermediate packet.
+ * The receiver acknowledges each frame (its 4 bytes id) once decoded. The sender keeps at most 'window' frames in
+ * flight: when the window is full, it waits for an acknowledgment up to the given timeout, then drops the frame. A slow
+ * link or receiver therefore drops frames at the source instead of piling up latency in the socket buffers.
+ *
+ * The header is written in the byte order of the host, little endian on all the ZED platforms. Linux / POSIX sockets.
+ */
+
+struct DepthFrame {
+    uint32_t id = 0;
+    uint64_t timestamp_ns = 0;
+    int width = 0, height = 0;
+    float depth_scale = 1.f;       // depth unit per quantization step
+    float translation[3] = {0.f, 0.f, 0.f};
+    float orientation[4] = {0.f, 0.f, 0.f, 1.f}; // quaternion x, y, z, w
+    int32_t tracking_state = 0;    // sl::POSITIONAL_TRACKING_STATE
+    std::vector<uint16_t> depth;   // quantized, 0 = invalid
+};
+
+struct DepthFrameHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t frame_id;
+    uint32_t payload_size;
+    uint64_t timestamp_ns;
+    uint16_t width, height;
+    float depth_scale;
+    float translation[3];
+    float orientation[4];
+    int32_t tracking_state;
+};
+static_assert(sizeof(DepthFrameHeader) == 64, "DepthFrameHeader is sent as is");
+
+// Transfer counters, since the connection
+struct TransportStats {
+    uint64_t frames = 0;
+    uint64_t dropped = 0;    // sender: window full or send error
+    uint64_t raw_bytes = 0;  // quantized depth, before compression
+    uint64_t wire_bytes = 0; // headers + payloads
+    double codec_ms = 0.;    // encode or decode, summed
+};
+
+class DepthSender {
+public:
+    DepthSender(int window = 4, bool compress = true);
+    ~DepthSender();
+
+    // Listens on 'port' and blocks until a receiver connects
+    bool open(int port);
+    void close();
+
+    // Returns false if the frame is dropped: window still full after timeout_ms (-1 waits forever) or connection lost
+    bool send(const DepthFrame& frame, int timeout_ms = 0);
+
+    bool isConnected() const {
+        return fd_ >= 0;
+    }
+
+    int getInFlight() const {
+        return int(sent_ - acked_);
+    }
+
+    const TransportStats& getStats() const {
+        return stats_;
+    }
+
+private:
+    // Reads the available acknowledgments, waiting up to timeout_ms for the first one
+    bool readAcks(int timeout_ms);
+
+    int window_;
+    bool compress_;
+    int listen_fd_ = -1, fd_ = -1;
+    uint32_t sent_ = 0, acked_ = 0;
+    size_t ack_bytes_ = 0; // of an incomplete acknowledgment
+    std::vector<uint8_t> payload_;
+    TransportStats stats_;
+};
+
+class DepthReceiver {
+public:
+    DepthReceiver() = default;
+    ~DepthReceiver();
+
+    bool connect(const std::string& ip, int port);
+    void close();
+
+    // Blocks until a frame is received and decoded, then acknowledges it. Returns false if the connection is lost.
+    bool receive(DepthFrame& frame);
+
+    const TransportStats& getStats() const {
+        return stats_;
+    }
+
+private:
+    int fd_ = -1;
+    std::vector<uint8_t> payload_;
+    TransportStats stats_;
+};
+
+#endif /* __DEPTH_TRANSPORT_HDR__ */
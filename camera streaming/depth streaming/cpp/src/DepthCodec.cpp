@@ -0,0 +1,217 @@
+#include "DepthCodec.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CpuFeatures.hpp"
+
+void quantizeDepth(sl::Mat& depth, float scale, std::vector<uint16_t>& quantized) {
+    const int width = int(depth.getWidth()), height = int(depth.getHeight());
+    quantized.resize(size_t(width) * height);
+    const float inv_scale = 1.f / scale;
+    for (int v = 0; v < height; v++) {
+        const float* src = depth.getPtr<float>(sl::MEM::CPU) + v * depth.getStep(sl::MEM::CPU);
+        uint16_t* dst = quantized.data() + size_t(v) * width;
+        // Branchless so that it vectorizes, NAN fails the range test
+        for (int u = 0; u < width; u++) {
+            const float q = src[u] * inv_scale + 0.5f;
+            const int32_t qi = (q >= 1.f && q < 65536.f) ? int32_t(q) : 0;
+            dst[u] = uint16_t(qi);
+        }
+    }
+}
+
+void dequantizeDepth(const uint16_t* quantized, float scale, sl::Mat& depth) {
+    const int width = int(depth.getWidth()), height = int(depth.getHeight());
+    for (int v = 0; v < height; v++) {
+        const uint16_t* src = quantized + size_t(v) * width;
+        float* dst = depth.getPtr<float>(sl::MEM::CPU) + v * depth.getStep(sl::MEM::CPU);
+        for (int u = 0; u < width; u++)
+            dst[u] = src[u] ? src[u] * scale : NAN;
+    }
+}
+
+// Median edge detector: a = left, b = up, c = up-left
+static inline uint16_t predict(uint16_t a, uint16_t b, uint16_t c) {
+    const uint16_t mn = std::min(a, b), mx = std::max(a, b);
+    if (c >= mx) return mn;
+    if (c <= mn) return mx;
+    return uint16_t(a + b - c);
+}
+
+static inline uint16_t zigzag(uint16_t value, uint16_t prediction) {
+    const int16_t d = int16_t(uint16_t(value - prediction));
+    return uint16_t((uint16_t(d) << 1) ^ uint16_t(d >> 15));
+}
+
+static inline uint16_t unzigzag(uint16_t z, uint16_t prediction) {
+    return uint16_t(prediction + uint16_t((z >> 1) ^ uint16_t(-(z & 1))));
+}
+
+// Neighbors of (u, v), the missing ones are replaced as in JPEG-LS: first row -> left, first column -> up
+static inline void neighbors(const uint16_t* row, const uint16_t* up, int u, uint16_t& a, uint16_t& b, uint16_t& c) {
+    if (!up) {
+        a = b = c = u ? row[u - 1] : 0;
+    } else if (!u) {
+        a = b = c = up[0];
+    } else {
+        a = row[u - 1];
+        b = up[u];
+        c = up[u - 1];
+    }
+}
+
+static void residualsScalar(const uint16_t* row, const uint16_t* up, int first, int last, uint16_t* z) {
+    for (int u = first; u < last; u++) {
+        uint16_t a, b, c;
+        neighbors(row, up, u, a, b, c);
+        z[u] = zigzag(row[u], predict(a, b, c));
+    }
+}
+
+#ifdef CPU_AVX2
+// Rows below the first one, 16 pixels at a time from u = 1
+CPU_AVX2_TARGET static void residualsAVX2(const uint16_t* row, const uint16_t* up, int width, uint16_t* z) {
+    residualsScalar(row, up, 0, 1, z);
+    int u = 1;
+    for (; u + 16 <= width; u += 16) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*) (row + u));
+        const __m256i a = _mm256_loadu_si256((const __m256i*) (row + u - 1));
+        const __m256i b = _mm256_loadu_si256((const __m256i*) (up + u));
+        const __m256i c = _mm256_loadu_si256((const __m256i*) (up + u - 1));
+        const __m256i mn = _mm256_min_epu16(a, b), mx = _mm256_max_epu16(a, b);
+        // c >= mx -> mn, c <= mn -> mx, else a + b - c
+        const __m256i c_ge_mx = _mm256_cmpeq_epi16(_mm256_max_epu16(c, mx), c);
+        const __m256i c_le_mn = _mm256_cmpeq_epi16(_mm256_min_epu16(c, mn), c);
+        __m256i p = _mm256_sub_epi16(_mm256_add_epi16(a, b), c);
+        p = _mm256_blendv_epi8(p, mx, c_le_mn);
+        p = _mm256_blendv_epi8(p, mn, c_ge_mx);
+        const __m256i d = _mm256_sub_epi16(x, p);
+        _mm256_storeu_si256((__m256i*) (z + u), _mm256_xor_si256(_mm256_slli_epi16(d, 1), _mm256_srai_epi16(d, 15)));
+    }
+    residualsScalar(row, up, u, width, z);
+}
+#endif
+
+size_t encodeDepthBound(int width, int height) {
+    return size_t(width) * height * 3;
+}
+
+size_t encodeDepth(const uint16_t* quantized, int width, int height, uint8_t* out) {
+    // One row of residuals at a time
+    std::vector<uint16_t> z(width);
+    uint8_t* w = out;
+#ifdef CPU_AVX2
+    const bool use_avx2 = cpuHasAVX2();
+#endif
+
+    size_t zeros = 0; // pending run of zero residuals, can span several rows
+    auto flushZeros = [&]() {
+        while (zeros) {
+            if (zeros == 1) {
+                *w++ = 0;
+                zeros = 0;
+            } else if (zeros <= 33) {
+                *w++ = uint8_t(0xC0 | (zeros - 2));
+                zeros = 0;
+            } else {
+                const size_t n = std::min<size_t>(zeros, 65535);
+                *w++ = 0xE1;
+                *w++ = uint8_t(n >> 8);
+                *w++ = uint8_t(n);
+                zeros -= n;
+            }
+        }
+    };
+
+    for (int v = 0; v < height; v++) {
+        const uint16_t* row = quantized + size_t(v) * width;
+        const uint16_t* up = v ? row - width : nullptr;
+#ifdef CPU_AVX2
+        if (up && use_avx2)
+            residualsAVX2(row, up, width, z.data());
+        else
+#endif
+            residualsScalar(row, up, 0, width, z.data());
+
+        for (int u = 0; u < width; u++) {
+            const uint16_t r = z[u];
+            if (!r) {
+                zeros++;
+                continue;
+            }
+            flushZeros();
+            if (r < 0x80)
+                *w++ = uint8_t(r);
+            else if (r < 0x4000) {
+                *w++ = uint8_t(0x80 | (r >> 8));
+                *w++ = uint8_t(r);
+            } else {
+                *w++ = 0xE0;
+                *w++ = uint8_t(r >> 8);
+                *w++ = uint8_t(r);
+            }
+        }
+    }
+    flushZeros();
+
+    return w - out;
+}
+
+bool decodeDepth(const uint8_t* data, size_t size, int width, int height, uint16_t* quantized) {
+    const uint8_t* end = data + size;
+    size_t zeros = 0; // remaining pixels of the current run of zero residuals
+    // Next residual, false if the stream is corrupted
+    auto next = [&](uint16_t& r) -> bool {
+        r = 0;
+        if (zeros) {
+            zeros--;
+            return true;
+        }
+        if (data >= end) return false;
+        const uint8_t code = *data++;
+        if (code < 0x80)
+            r = code;
+        else if (code < 0xC0) {
+            if (data >= end) return false;
+            r = uint16_t(((code & 0x3F) << 8) | *data++);
+        } else if (code < 0xE0)
+            zeros = (code & 0x1F) + 1; // run of 2..33, this pixel included
+        else if (code <= 0xE1) {
+            if (end - data < 2) return false;
+            const uint16_t value = uint16_t((data[0] << 8) | data[1]);
+            data += 2;
+            if (code == 0xE0)
+                r = value;
+            else if (value < 34)
+                return false;
+            else
+                zeros = value - 1;
+        } else
+            return false;
+        return true;
+    };
+
+    for (int v = 0; v < height; v++) {
+        uint16_t* row = quantized + size_t(v) * width;
+        const uint16_t* up = v ? row - width : nullptr;
+        uint16_t r, a, b, c;
+        if (!width) continue;
+        if (!next(r)) return false;
+        neighbors(row, up, 0, a, b, c);
+        row[0] = unzigzag(r, predict(a, b, c));
+        // The neighbors of the first pixel only are special
+        if (up) {
+            for (int u = 1; u < width; u++) {
+                if (!next(r)) return false;
+                row[u] = unzigzag(r, predict(row[u - 1], up[u], up[u - 1]));
+            }
+        } else {
+            for (int u = 1; u < width; u++) {
+                if (!next(r)) return false;
+                row[u] = unzigzag(r, row[u - 1]);
+            }
+        }
+    }
+    return zeros == 0 && data == end;
+}
@@ -0,0 +1,275 @@
+#include "DepthTransport.hpp"
+#include "DepthCodec.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const uint32_t DEPTH_FRAME_MAGIC = 0x5446445A; // "ZDFT"
+static const uint16_t DEPTH_FRAME_VERSION = 1;
+static const uint16_t DEPTH_FRAME_COMPRESSED = 1;
+
+static void setNoDelay(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+// Writes all the buffers, resuming after partial writes. MSG_NOSIGNAL: a closed connection is an error, not a SIGPIPE.
+static bool writeAll(int fd, iovec* iov, int count) {
+    while (count) {
+        msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        const ssize_t written = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        size_t left = size_t(written);
+        while (count && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count) {
+            iov->iov_base = (uint8_t*) iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    return true;
+}
+
+static bool readAll(int fd, void* data, size_t size) {
+    uint8_t* ptr = (uint8_t*) data;
+    while (size) {
+        const ssize_t received = recv(fd, ptr, size, MSG_WAITALL);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        ptr += received;
+        size -= size_t(received);
+    }
+    return true;
+}
+
+DepthSender::DepthSender(int window, bool compress) : window_(std::max(window, 1)), compress_(compress) {
+}
+
+DepthSender::~DepthSender() {
+    close();
+}
+
+bool DepthSender::open(int port) {
+    close();
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) return false;
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(uint16_t(port));
+    if (bind(listen_fd_, (sockaddr*) &address, sizeof(address)) < 0 || listen(listen_fd_, 1) < 0) {
+        cout << "[Sample][Error] Cannot listen on port " << port << ": " << strerror(errno) << endl;
+        close();
+        return false;
+    }
+
+    fd_ = accept(listen_fd_, nullptr, nullptr);
+    if (fd_ < 0) {
+        close();
+        return false;
+    }
+    setNoDelay(fd_);
+    sent_ = acked_ = 0;
+    ack_bytes_ = 0;
+    stats_ = TransportStats();
+    return true;
+}
+
+void DepthSender::close() {
+    if (fd_ >= 0) ::close(fd_);
+    if (listen_fd_ >= 0) {
+        shutdown(listen_fd_, SHUT_RDWR); // wakes up a pending accept
+        ::close(listen_fd_);
+    }
+    fd_ = listen_fd_ = -1;
+}
+
+bool DepthSender::readAcks(int timeout_ms) {
+    pollfd p = {fd_, POLLIN, 0};
+    const int ready = poll(&p, 1, timeout_ms);
+    if (ready <= 0) return ready == 0 || errno == EINTR;
+
+    // The acknowledgments are only counted, their content (the frame id) is for debugging
+    uint8_t buffer[256];
+    for (;;) {
+        const ssize_t received = recv(fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received > 0) {
+            ack_bytes_ += size_t(received);
+            acked_ += uint32_t(ack_bytes_ / sizeof(uint32_t));
+            ack_bytes_ %= sizeof(uint32_t);
+            continue;
+        }
+        if (received == 0) return false; // closed by the receiver
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+}
+
+bool DepthSender::send(const DepthFrame& frame, int timeout_ms) {
+    if (fd_ < 0) return false;
+
+    bool alive = readAcks(0);
+    if (alive && getInFlight() >= window_ && timeout_ms != 0) {
+        if (timeout_ms < 0)
+            while (alive && getInFlight() >= window_) alive = readAcks(-1);
+        else
+            alive = readAcks(timeout_ms);
+    }
+    if (!alive) {
+        cout << "[Sample] Receiver disconnected" << endl;
+        close();
+    }
+    if (!alive || getInFlight() >= window_) {
+        stats_.dropped++;
+        return false;
+    }
+
+    const size_t raw_size = frame.depth.size() * sizeof(uint16_t);
+    const void* payload = frame.depth.data();
+    size_t payload_size = raw_size;
+    if (compress_) {
+        auto start = chrono::steady_clock::now();
+        payload_.resize(encodeDepthBound(frame.width, frame.height));
+        payload_size = encodeDepth(frame.depth.data(), frame.width, frame.height, payload_.data());
+        payload = payload_.data();
+        stats_.codec_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    DepthFrameHeader header;
+    header.magic = DEPTH_FRAME_MAGIC;
+    header.version = DEPTH_FRAME_VERSION;
+    header.flags = compress_ ? DEPTH_FRAME_COMPRESSED : 0;
+    header.frame_id = frame.id;
+    header.payload_size = uint32_t(payload_size);
+    header.timestamp_ns = frame.timestamp_ns;
+    header.width = uint16_t(frame.width);
+    header.height = uint16_t(frame.height);
+    header.depth_scale = frame.depth_scale;
+    memcpy(header.translation, frame.translation, sizeof(header.translation));
+    memcpy(header.orientation, frame.orientation, sizeof(header.orientation));
+    header.tracking_state = frame.tracking_state;
+
+    iovec iov[2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = (void*) payload;
+    iov[1].iov_len = payload_size;
+    if (!writeAll(fd_, iov, 2)) {
+        cout << "[Sample] Receiver disconnected" << endl;
+        close();
+        stats_.dropped++;
+        return false;
+    }
+
+    sent_++;
+    stats_.frames++;
+    stats_.raw_bytes += raw_size;
+    stats_.wire_bytes += sizeof(header) + payload_size;
+    return true;
+}
+
+DepthReceiver::~DepthReceiver() {
+    close();
+}
+
+bool DepthReceiver::connect(const string& ip, int port) {
+    close();
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(uint16_t(port));
+    if (inet_pton(AF_INET, ip.c_str(), &address.sin_addr) != 1) {
+        cout << "[Sample][Error] Invalid address " << ip << endl;
+        return false;
+    }
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd_ < 0 || ::connect(fd_, (sockaddr*) &address, sizeof(address)) < 0) {
+        close();
+        return false;
+    }
+    setNoDelay(fd_);
+    stats_ = TransportStats();
+    return true;
+}
+
+void DepthReceiver::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+bool DepthReceiver::receive(DepthFrame& frame) {
+    if (fd_ < 0) return false;
+
+    DepthFrameHeader header;
+    if (!readAll(fd_, &header, sizeof(header))) {
+        close();
+        return false;
+    }
+    const size_t raw_size = size_t(header.width) * header.height * sizeof(uint16_t);
+    const bool compressed = (header.flags & DEPTH_FRAME_COMPRESSED) != 0;
+    // The payload size comes from the network, it sizes the reception buffer: bound it by what the sender can produce
+    if (header.magic != DEPTH_FRAME_MAGIC || header.version != DEPTH_FRAME_VERSION ||
+        (compressed && header.payload_size > encodeDepthBound(header.width, header.height)) ||
+        (!compressed && header.payload_size != raw_size)) {
+        cout << "[Sample][Error] Invalid depth frame header, closing the connection" << endl;
+        close();
+        return false;
+    }
+
+    frame.id = header.frame_id;
+    frame.timestamp_ns = header.timestamp_ns;
+    frame.width = header.width;
+    frame.height = header.height;
+    frame.depth_scale = header.depth_scale;
+    memcpy(frame.translation, header.translation, sizeof(frame.translation));
+    memcpy(frame.orientation, header.orientation, sizeof(frame.orientation));
+    frame.tracking_state = header.tracking_state;
+    frame.depth.resize(size_t(header.width) * header.height);
+
+    bool ok;
+    if (compressed) {
+        if (payload_.size() < header.payload_size) payload_.resize(header.payload_size);
+        ok = readAll(fd_, payload_.data(), header.payload_size);
+        if (ok) {
+            auto start = chrono::steady_clock::now();
+            ok = decodeDepth(payload_.data(), header.payload_size, frame.width, frame.height, frame.depth.data());
+            stats_.codec_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            if (!ok) cout << "[Sample][Error] Corrupted depth frame " << header.frame_id << endl;
+        }
+    } else // straight into the frame
+        ok = readAll(fd_, frame.depth.data(), raw_size);
+
+    // Acknowledge, the sender can send the next frame of its window
+    ok = ok && ::send(fd_, &header.frame_id, sizeof(header.frame_id), MSG_NOSIGNAL) == sizeof(header.frame_id);
+    if (!ok) {
+        close();
+        return false;
+    }
+
+    stats_.frames++;
+    stats_.raw_bytes += raw_size;
+    stats_.wire_bytes += sizeof(header) + header.payload_size;
+    return true;
+}
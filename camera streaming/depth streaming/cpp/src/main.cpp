@@ -0,0 +1,376 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+ ** This sample shows how to send the metric depth and the pose of a ZED      **
+ ** camera over the network, quantized to 16 bits and losslessly compressed.  **
+ ******************************************************************************/
+
+// Standard includes
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <thread>
+
+// ZED includes
+#include <sl/Camera.hpp>
+
+// OpenCV include (for display)
+#include <opencv2/opencv.hpp>
+
+// Sample includes
+#include "DepthCodec.hpp"
+#include "DepthTransport.hpp"
+#include "utils.hpp"
+
+// Using std and sl namespaces
+using namespace std;
+using namespace sl;
+
+const int DEFAULT_PORT = 30300;
+
+struct TransportOptions {
+    float depth_scale = 1.f; // millimeters per quantization step
+    int window = 4;
+    bool compress = true;
+};
+
+void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
+void parseArgs(int argc, char **argv, InitParameters& param);
+int runSender(int argc, char **argv, int port, const TransportOptions& options);
+int runReceiver(const string& ip, int port);
+int runBenchmark(int nb_frames, int port, const TransportOptions& options);
+void printStats(const string& name, const TransportStats& stats, double duration_s);
+
+int main(int argc, char **argv) {
+    // '--send [port]' opens the camera and waits for a receiver
+    // '--receive <ip[:port]>' connects to a sender and displays the depth
+    // '--benchmark [frames]' sends synthetic frames over the loopback, without camera
+    // '--scale <mm>' quantization step, '--window <n>' frames in flight, '--raw' disables the compression
+    enum class Mode { NONE, SEND, RECEIVE, BENCHMARK } mode = Mode::NONE;
+    int port = DEFAULT_PORT, nb_frames = 300;
+    string ip;
+    TransportOptions options;
+    for (int i = 1; i < argc; i++) {
+        const string arg(argv[i]);
+        const bool has_value = i + 1 < argc && atof(argv[i + 1]) > 0;
+        if (arg == "--send") {
+            mode = Mode::SEND;
+            if (has_value) port = atoi(argv[i + 1]);
+        }
+        if (arg == "--receive" && i + 1 < argc) {
+            mode = Mode::RECEIVE;
+            ip = argv[i + 1];
+            const size_t colon = ip.find(':');
+            if (colon != string::npos) {
+                port = atoi(ip.substr(colon + 1).c_str());
+                ip = ip.substr(0, colon);
+            }
+        }
+        if (arg == "--benchmark") {
+            mode = Mode::BENCHMARK;
+            if (has_value) nb_frames = atoi(argv[i + 1]);
+        }
+        if (arg == "--scale" && has_value) options.depth_scale = atof(argv[i + 1]);
+        if (arg == "--window" && has_value) options.window = atoi(argv[i + 1]);
+        if (arg == "--raw") options.compress = false;
+    }
+
+    switch (mode) {
+        case Mode::SEND: return runSender(argc, argv, port, options);
+        case Mode::RECEIVE: return runReceiver(ip, port);
+        case Mode::BENCHMARK: return runBenchmark(nb_frames, port, options);
+        default:
+            cout << "Usage:\n"
+                 << "  ZED_Depth_Streaming [svo file | resolution] --send [port] [--scale <mm>] [--window <n>] [--raw]\n"
+                 << "  ZED_Depth_Streaming --receive <ip[:port]>\n"
+                 << "  ZED_Depth_Streaming --benchmark [frames] [--scale <mm>] [--window <n>] [--raw]" << endl;
+            return EXIT_FAILURE;
+    }
+}
+
+static void fillFrame(DepthFrame& frame, Pose& pose, POSITIONAL_TRACKING_STATE state) {
+    auto translation = pose.getTranslation();
+    auto orientation = pose.getOrientation();
+    frame.translation[0] = translation.x;
+    frame.translation[1] = translation.y;
+    frame.translation[2] = translation.z;
+    frame.orientation[0] = orientation.ox;
+    frame.orientation[1] = orientation.oy;
+    frame.orientation[2] = orientation.oz;
+    frame.orientation[3] = orientation.ow;
+    frame.tracking_state = int32_t(state);
+}
+
+int runSender(int argc, char **argv, int port, const TransportOptions& options) {
+    Camera zed;
+    InitParameters init_parameters;
+    init_parameters.depth_mode = DEPTH_MODE::ULTRA;
+    init_parameters.coordinate_units = UNIT::MILLIMETER; // the quantization step is in millimeters
+    parseArgs(argc, argv, init_parameters);
+
+    auto returned_state = zed.open(init_parameters);
+    if (returned_state != ERROR_CODE::SUCCESS) {
+        print("Camera Open", returned_state, "Exit program.");
+        return EXIT_FAILURE;
+    }
+    returned_state = zed.enablePositionalTracking();
+    if (returned_state != ERROR_CODE::SUCCESS) {
+        print("Enabling positional tracking failed: ", returned_state);
+        zed.close();
+        return EXIT_FAILURE;
+    }
+
+    SetCtrlHandler();
+
+    DepthSender sender(options.window, options.compress);
+    print("Waiting for a receiver on port " + to_string(port));
+    if (!sender.open(port)) {
+        print("No receiver, exit program.");
+        zed.close();
+        return EXIT_FAILURE;
+    }
+    print("Receiver connected, sending the depth (press Ctrl-C to stop)");
+
+    Mat depth;
+    Pose pose;
+    DepthFrame frame;
+    frame.depth_scale = options.depth_scale;
+    auto last_print = chrono::steady_clock::now(), start = last_print;
+    while (!exit_app && sender.isConnected()) {
+        returned_state = zed.grab();
+        if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED) break;
+        if (returned_state != ERROR_CODE::SUCCESS) {
+            sleep_ms(1);
+            continue;
+        }
+        zed.retrieveMeasure(depth, MEASURE::DEPTH, MEM::CPU);
+        fillFrame(frame, pose, zed.getPosition(pose, REFERENCE_FRAME::WORLD));
+        frame.id++;
+        frame.timestamp_ns = zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds();
+        frame.width = int(depth.getWidth());
+        frame.height = int(depth.getHeight());
+        quantizeDepth(depth, options.depth_scale, frame.depth);
+        // Never wait for the receiver: a frame that does not fit in the window is dropped
+        sender.send(frame, 0);
+
+        auto now = chrono::steady_clock::now();
+        if (now - last_print > chrono::seconds(5)) {
+            printStats("Sent", sender.getStats(), chrono::duration<double>(now - start).count());
+            last_print = now;
+        }
+    }
+
+    sender.close();
+    zed.close();
+    return EXIT_SUCCESS;
+}
+
+int runReceiver(const string& ip, int port) {
+    DepthReceiver receiver;
+    if (!receiver.connect(ip, port)) {
+        print("Cannot connect to " + ip + ":" + to_string(port) + ", exit program.");
+        return EXIT_FAILURE;
+    }
+    print("Connected to " + ip + ":" + to_string(port) + ", press 'q' to quit");
+
+    DepthFrame frame;
+    Mat depth;
+    cv::Mat depth_8u, depth_color;
+    auto last_print = chrono::steady_clock::now(), start = last_print;
+    char key = ' ';
+    while (key != 'q' && receiver.receive(frame)) {
+        // Back to metric depth, NAN where invalid
+        if (int(depth.getWidth()) != frame.width || int(depth.getHeight()) != frame.height)
+            depth.alloc(Resolution(frame.width, frame.height), MAT_TYPE::F32_C1, MEM::CPU);
+        dequantizeDepth(frame.depth.data(), frame.depth_scale, depth);
+
+        // 0 - 10 m color map
+        cv::Mat depth_ocv(frame.height, frame.width, CV_32FC1, depth.getPtr<float>(MEM::CPU), depth.getStepBytes(MEM::CPU));
+        depth_ocv.convertTo(depth_8u, CV_8UC1, 255. / 10000.);
+        cv::applyColorMap(depth_8u, depth_color, cv::COLORMAP_JET);
+        depth_color.setTo(cv::Scalar(0, 0, 0), depth_8u == 0);
+        stringstream ss;
+        ss << fixed << setprecision(0) << "frame " << frame.id << "  position (mm) " << frame.translation[0] << ", "
+           << frame.translation[1] << ", " << frame.translation[2];
+        cv::putText(depth_color, ss.str(), cv::Point(10, 25), cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 255, 255), 2);
+        cv::imshow("Received depth", depth_color);
+        key = cv::waitKey(1);
+
+        auto now = chrono::steady_clock::now();
+        if (now - last_print > chrono::seconds(5)) {
+            printStats("Received", receiver.getStats(), chrono::duration<double>(now - start).count());
+            last_print = now;
+        }
+    }
+    printStats("Received", receiver.getStats(), chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    return EXIT_SUCCESS;
+}
+
+// HD720 depth of a room (floor, walls, a box), in millimeters, with stereo-like noise (growing with the square of the
+// depth) and holes
+static void syntheticDepth(Mat& depth, int seed) {
+    const int width = 1280, height = 720;
+    const float f = 700.f, camera_height = 1200.f, wall_distance = 6000.f;
+    depth.alloc(Resolution(width, height), MAT_TYPE::F32_C1, MEM::CPU);
+    mt19937 rng(seed);
+    normal_distribution<float> noise(0.f, 1.f);
+    for (int v = 0; v < height; v++) {
+        float* row = depth.getPtr<float>(MEM::CPU) + v * depth.getStep(MEM::CPU);
+        const float dy = (v - height / 2) / f;
+        for (int u = 0; u < width; u++) {
+            const float dx = (u - width / 2) / f;
+            float z = wall_distance;
+            if (dy > 0.f) z = min(z, camera_height / dy);                       // floor
+            if (dx < 0.f) z = min(z, 2500.f / -dx);                             // left wall
+            if (dx > -0.1f && dx < 0.15f && dy > 0.05f) z = min(z, 2000.f);     // box
+            z += noise(rng) * z * z * 2e-7f;
+            row[u] = z;
+        }
+    }
+    // Occlusion like holes along the box edges, and a few random ones
+    uniform_int_distribution<int> random_u(0, width - 40), random_v(0, height - 20);
+    for (int i = 0; i < 200; i++) {
+        const int u0 = random_u(rng), v0 = random_v(rng);
+        for (int v = v0; v < v0 + 20; v++)
+            for (int u = u0; u < u0 + 40; u++)
+                depth.getPtr<float>(MEM::CPU)[v * depth.getStep(MEM::CPU) + u] = NAN;
+    }
+}
+
+int runBenchmark(int nb_frames, int port, const TransportOptions& options) {
+    // A few different frames, so that the codec does not see the same data every time
+    const int nb_sources = 4;
+    vector<DepthFrame> sources(nb_sources);
+    double quantize_ms = 0.;
+    for (int i = 0; i < nb_sources; i++) {
+        Mat depth;
+        syntheticDepth(depth, i);
+        auto start = chrono::steady_clock::now();
+        quantizeDepth(depth, options.depth_scale, sources[i].depth);
+        quantize_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        sources[i].width = int(depth.getWidth());
+        sources[i].height = int(depth.getHeight());
+        sources[i].depth_scale = options.depth_scale;
+    }
+    print("Benchmark: " + to_string(nb_frames) + " frames of " + to_string(sources[0].width) + "x" +
+          to_string(sources[0].height) + " over the loopback, port " + to_string(port));
+
+    DepthSender sender(options.window, options.compress);
+    bool sender_ok = true;
+    thread sender_thread([&]() {
+        sender_ok = sender.open(port);
+        for (int i = 0; sender_ok && i < nb_frames; i++) {
+            DepthFrame& frame = sources[i % nb_sources];
+            frame.id = uint32_t(i);
+            frame.timestamp_ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+            // The benchmark measures the throughput: wait for the window instead of dropping
+            sender_ok = sender.send(frame, -1);
+        }
+    });
+
+    DepthReceiver receiver;
+    bool connected = false;
+    for (int attempt = 0; attempt < 200 && !connected; attempt++) {
+        connected = receiver.connect("127.0.0.1", port);
+        if (!connected) sleep_ms(10);
+    }
+    if (!connected) {
+        print("Cannot connect to the loopback sender");
+        sender.close();
+        sender_thread.join();
+        return EXIT_FAILURE;
+    }
+
+    DepthFrame frame;
+    int received = 0, errors = 0;
+    double latency_sum_ms = 0., latency_max_ms = 0.;
+    auto start = chrono::steady_clock::now();
+    while (received < nb_frames && receiver.receive(frame)) {
+        const uint64_t now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        const double latency_ms = (now - frame.timestamp_ns) * 1e-6;
+        latency_sum_ms += latency_ms;
+        latency_max_ms = max(latency_max_ms, latency_ms);
+        if (frame.depth != sources[frame.id % nb_sources].depth) errors++;
+        received++;
+    }
+    const double duration_s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    receiver.close();
+    sender_thread.join();
+
+    printStats("Sent", sender.getStats(), duration_s);
+    printStats("Received", receiver.getStats(), duration_s);
+    cout << "[Sample] quantization " << fixed << setprecision(2) << quantize_ms / nb_sources << " ms/frame, latency "
+         << (received ? latency_sum_ms / received : 0.) << " ms (max " << latency_max_ms << " ms), " << received
+         << " frames received, " << errors << " not identical to the sent ones" << endl;
+    return (received == nb_frames && !errors) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void printStats(const string& name, const TransportStats& stats, double duration_s) {
+    const double frames = double(max<uint64_t>(stats.frames, 1));
+    cout << "[Sample] " << name << " " << stats.frames << " frames (" << stats.dropped << " dropped), " << fixed
+         << setprecision(1) << stats.frames / duration_s << " FPS, " << stats.wire_bytes * 8e-6 / duration_s << " Mbit/s, "
+         << "ratio " << setprecision(2) << (stats.wire_bytes ? double(stats.raw_bytes) / stats.wire_bytes : 0.) << ", "
+         << "codec " << stats.codec_ms / frames << " ms/frame" << endl;
+}
+
+void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
+    cout << "[Sample]";
+    if (err_code != ERROR_CODE::SUCCESS)
+        cout << "[Error] ";
+    else
+        cout << " ";
+    cout << msg_prefix << " ";
+    if (err_code != ERROR_CODE::SUCCESS) {
+        cout << " | " << toString(err_code) << " : ";
+        cout << toVerbose(err_code);
+    }
+    if (!msg_suffix.empty())
+        cout << " " << msg_suffix;
+    cout << endl;
+}
+
+void parseArgs(int argc, char **argv, InitParameters& param) {
+    if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
+        // SVO input mode
+        param.input.setFromSVOFile(argv[1]);
+        cout << "[Sample] Using SVO File input: " << argv[1] << endl;
+    } else if (argc > 1 && string(argv[1]).find(".svo") == string::npos) {
+        string arg = string(argv[1]);
+        if (arg.find("HD2K") != string::npos) {
+            param.camera_resolution = RESOLUTION::HD2K;
+            cout << "[Sample] Using Camera in resolution HD2K" << endl;
+        } else if (arg.find("HD1080") != string::npos) {
+            param.camera_resolution = RESOLUTION::HD1080;
+            cout << "[Sample] Using Camera in resolution HD1080" << endl;
+        } else if (arg.find("HD720") != string::npos) {
+            param.camera_resolution = RESOLUTION::HD720;
+            cout << "[Sample] Using Camera in resolution HD720" << endl;
+        } else if (arg.find("VGA") != string::npos) {
+            param.camera_resolution = RESOLUTION::VGA;
+            cout << "[Sample] Using Camera in resolution VGA" << endl;
+        }
+    } else {
+        // Default
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef __STREAM_RECORDER_INCLUDE__
+#define __STREAM_RECORDER_INCLUDE__
+
+#include <chrono>
+#include <string>
+
+#include <sl/Camera.hpp>
+
+// Recording options shared by all the received streams
+struct RecordingOptions {
+    std::string path_prefix;    // empty: recording disabled
+    int segment_duration = 300; // seconds per SVO file, 0 for a single file
+    sl::SVO_COMPRESSION_MODE compression = sl::SVO_COMPRESSION_MODE::H264;
+
+    bool enabled() const {
+        return !path_prefix.empty();
+    }
+};
+
+/*
+ * StreamRecorder writes a received stream to rotating SVO segments (<prefix>_000.svo, <prefix>_001.svo, ...)
+ * using Camera::enableRecording, and keeps write statistics for each segment.
+ * update() must be called by the thread that grabs, right after every successful grab.
+ */
+class StreamRecorder {
+public:
+    StreamRecorder(sl::Camera& zed, const RecordingOptions& options, const std::string& name = "");
+    ~StreamRecorder();
+
+    bool start();
+    void update();
+    void stop();
+
+    bool isRecording() const {
+        return recording;
+    }
+
+private:
+    bool openSegment();
+    void closeSegment();
+
+    sl::Camera& zed;
+    RecordingOptions options;
+    std::string name;
+    bool recording = false;
+
+    // current segment
+    int segment_id = 0;
+    std::string segment_path;
+    std::chrono::steady_clock::time_point segment_start;
+    int frames_recorded = 0;
+    int frames_dropped = 0;
+    double compression_time = 0;    // ms, summed over the recorded frames
+    double longest_grab = 0;        // ms, longest delay between two grabs (slow disk shows here)
+    std::chrono::steady_clock::time_point last_update;
+};
+
+#endif /* __STREAM_RECORDER_INCLUDE__ */
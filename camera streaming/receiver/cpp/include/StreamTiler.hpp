@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#ifndef __STREAM_TILER_INCLUDE__
+#define __STREAM_TILER_INCLUDE__
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+#include <opencv2/opencv.hpp>
+
+#include "StreamRecorder.hpp"
+
+// Address of one stream to receive
+struct StreamSource {
+    std::string ip;
+    int port = 30000;
+};
+
+// One cell of the mosaic, written by its grab thread and read by the compositor
+struct StreamTile {
+    std::mutex mtx;
+    cv::Mat back;               // written by the grab thread, outside the lock
+    cv::Mat front;              // last complete tile, swapped with 'back' under the lock
+    uint64_t sequence = 0;      // incremented on every published frame
+    uint64_t drawn_sequence = 0;// last sequence copied into the mosaic (compositor only)
+    sl::Timestamp ts = 0;
+    std::atomic<bool> connected;
+    std::atomic<float> fps;
+    std::string label;
+
+    StreamTile() : connected(false), fps(0.f) {}
+};
+
+/*
+ * StreamTiler receives N streams concurrently, each with its own sl::Camera and grab thread,
+ * and composites the newest frame of every stream into a single tiled image.
+ *
+ * Grab threads never wait on the display: they downscale into their private back buffer and
+ * swap it with the front buffer under a short lock. The compositor copies only the tiles that
+ * changed since the previous refresh, so the display runs at its own rate whatever the
+ * slowest stream is doing.
+ */
+class StreamTiler {
+public:
+    StreamTiler(const std::vector<StreamSource>& sources, sl::Resolution tile_res);
+    ~StreamTiler();
+
+    // Start one grab thread per source, each one optionally recording its stream
+    void start(const sl::InitParameters& init_parameters, const RecordingOptions& rec_options = RecordingOptions());
+    // Stop and join all grab threads, then close the cameras
+    void stop();
+
+    // Copy the newest frame of each updated stream into the mosaic, returns the number of tiles refreshed
+    int compose(cv::Mat& mosaic, bool draw_overlay = true);
+
+    cv::Size mosaicSize() const {
+        return cv::Size(cols * tile_res.width, rows * tile_res.height);
+    }
+
+    size_t size() const {
+        return sources.size();
+    }
+
+private:
+    void acquisition(int id, sl::InitParameters init_parameters);
+
+    std::vector<StreamSource> sources;
+    std::vector<StreamTile> tiles;
+    RecordingOptions rec_options;
+    std::vector<std::thread> threads;
+    sl::Resolution tile_res;
+    int cols, rows;
+    std::atomic<bool> running;
+};
+
+// Fast area downscale of a BGRA image into 'dst' (which keeps its size and type)
+void downscaleArea(const cv::Mat& src, cv::Mat& dst);
+
+#endif /* __STREAM_TILER_INCLUDE__ */
@@ -0,0 +1,89 @@
+#include "StreamRecorder.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+StreamRecorder::StreamRecorder(sl::Camera& zed_, const RecordingOptions& options_, const string& name_)
+: zed(zed_), options(options_), name(name_) {
+}
+
+StreamRecorder::~StreamRecorder() {
+    stop();
+}
+
+bool StreamRecorder::start() {
+    if (!options.enabled() || recording) return recording;
+    segment_id = 0;
+    recording = openSegment();
+    return recording;
+}
+
+void StreamRecorder::stop() {
+    if (!recording) return;
+    closeSegment();
+    recording = false;
+}
+
+bool StreamRecorder::openSegment() {
+    stringstream ss;
+    ss << options.path_prefix;
+    if (!name.empty()) ss << "_" << name;
+    ss << "_" << setfill('0') << setw(3) << segment_id << ".svo";
+    segment_path = ss.str();
+
+    auto returned_state = zed.enableRecording(sl::RecordingParameters(sl::String(segment_path.c_str()), options.compression));
+    if (returned_state != sl::ERROR_CODE::SUCCESS) {
+        cout << "[Sample][Error] Recording " << segment_path << " : " << returned_state << endl;
+        return false;
+    }
+
+    segment_start = chrono::steady_clock::now();
+    last_update = segment_start;
+    frames_recorded = 0;
+    frames_dropped = 0;
+    compression_time = 0;
+    longest_grab = 0;
+    cout << "[Sample] Recording to " << segment_path << endl;
+    return true;
+}
+
+void StreamRecorder::closeSegment() {
+    zed.disableRecording();
+
+    float duration = chrono::duration<float>(chrono::steady_clock::now() - segment_start).count();
+    ifstream file(segment_path, ios::binary | ios::ate);
+    double size_mb = file.good() ? file.tellg() / (1024. * 1024.) : 0.;
+
+    cout << "[Sample] Segment " << segment_path << " closed: "
+        << frames_recorded << " frames, " << frames_dropped << " dropped, "
+        << fixed << setprecision(1) << duration << " s, " << size_mb << " MB ("
+        << (duration > 0 ? size_mb / duration : 0.) << " MB/s), "
+        << "avg compression " << setprecision(2) << (frames_recorded ? compression_time / frames_recorded : 0.) << " ms, "
+        << "longest grab interval " << longest_grab << " ms" << endl;
+}
+
+void StreamRecorder::update() {
+    if (!recording) return;
+
+    auto now = chrono::steady_clock::now();
+    longest_grab = max(longest_grab, chrono::duration<double, milli>(now - last_update).count());
+    last_update = now;
+
+    auto rec_status = zed.getRecordingStatus();
+    if (rec_status.status) {
+        frames_recorded++;
+        compression_time += rec_status.current_compression_time;
+    } else
+        frames_dropped++;
+
+    // Rotate: the new file is opened right away so only the frame being grabbed can be missed
+    if (options.segment_duration > 0 && chrono::duration_cast<chrono::seconds>(now - segment_start).count() >= options.segment_duration) {
+        closeSegment();
+        segment_id++;
+        recording = openSegment();
+    }
+}
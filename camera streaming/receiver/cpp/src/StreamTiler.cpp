@@ -0,0 +1,139 @@
+#include "StreamTiler.hpp"
+
+#include <cmath>
+
+using namespace std;
+
+StreamTiler::StreamTiler(const vector<StreamSource>& sources_, sl::Resolution tile_res_)
+: sources(sources_), tiles(sources_.size()), tile_res(tile_res_), running(false) {
+    // Keep the mosaic as square as possible: 16 streams -> 4x4, 6 streams -> 3x2
+    const int nb = std::max<int>(1, sources.size());
+    cols = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(nb))));
+    rows = (nb + cols - 1) / cols;
+
+    for (size_t i = 0; i < tiles.size(); i++) {
+        tiles[i].back = cv::Mat(tile_res.height, tile_res.width, CV_8UC4, cv::Scalar::all(0));
+        tiles[i].front = cv::Mat(tile_res.height, tile_res.width, CV_8UC4, cv::Scalar::all(0));
+        tiles[i].label = sources[i].ip + ":" + to_string(sources[i].port);
+    }
+}
+
+StreamTiler::~StreamTiler() {
+    stop();
+}
+
+void StreamTiler::start(const sl::InitParameters& init_parameters, const RecordingOptions& rec_options_) {
+    rec_options = rec_options_;
+    running = true;
+    for (size_t i = 0; i < sources.size(); i++)
+        threads.emplace_back(&StreamTiler::acquisition, this, static_cast<int>(i), init_parameters);
+}
+
+void StreamTiler::stop() {
+    running = false;
+    for (auto& it : threads)
+        if (it.joinable()) it.join();
+    threads.clear();
+}
+
+void StreamTiler::acquisition(int id, sl::InitParameters init_parameters) {
+    auto& tile = tiles[id];
+    init_parameters.input.setFromStream(sl::String(sources[id].ip.c_str()), sources[id].port);
+
+    sl::Camera zed;
+    auto returned_state = zed.open(init_parameters);
+    if (returned_state != sl::ERROR_CODE::SUCCESS) {
+        cout << "[Sample][Error] Stream " << tile.label << " : " << returned_state << endl;
+        return;
+    }
+    tile.connected = true;
+
+    // Let the SDK resize on the GPU down to twice the tile size, the last 2:1 area filter is done on the CPU.
+    // This keeps the device to host transfer small while avoiding the aliasing of a single large bilinear resize.
+    auto cam_res = zed.getCameraInformation().camera_configuration.resolution;
+    sl::Resolution retrieve_res(std::min(cam_res.width, tile_res.width * 2), std::min(cam_res.height, tile_res.height * 2));
+    sl::Mat image(retrieve_res, sl::MAT_TYPE::U8_C4, sl::MEM::CPU);
+
+    // Each stream is recorded to its own segments, named after its address
+    StreamRecorder recorder(zed, rec_options, sources[id].ip + "_" + to_string(sources[id].port));
+    recorder.start();
+
+    int frames = 0;
+    auto t_fps = chrono::steady_clock::now();
+    while (running) {
+        returned_state = zed.grab();
+        if (returned_state == sl::ERROR_CODE::SUCCESS) {
+            recorder.update();
+            zed.retrieveImage(image, sl::VIEW::LEFT, sl::MEM::CPU, retrieve_res);
+            cv::Mat cv_image(image.getHeight(), image.getWidth(), CV_8UC4, image.getPtr<sl::uchar1>(sl::MEM::CPU), image.getStepBytes(sl::MEM::CPU));
+            downscaleArea(cv_image, tile.back);
+
+            // publish: only a pointer swap is done under the lock
+            {
+                lock_guard<mutex> guard(tile.mtx);
+                cv::swap(tile.back, tile.front);
+                tile.ts = zed.getTimestamp(sl::TIME_REFERENCE::IMAGE);
+                tile.sequence++;
+            }
+            tile.connected = true;
+
+            frames++;
+            auto now = chrono::steady_clock::now();
+            float elapsed = chrono::duration<float>(now - t_fps).count();
+            if (elapsed > 1.f) {
+                tile.fps = frames / elapsed;
+                frames = 0;
+                t_fps = now;
+            }
+        } else if (returned_state == sl::ERROR_CODE::CAMERA_NOT_DETECTED || returned_state == sl::ERROR_CODE::CAMERA_NOT_INITIALIZED) {
+            // the sender is gone, the SDK will try to reconnect on the next grab
+            tile.connected = false;
+            tile.fps = 0.f;
+            sl::sleep_ms(10);
+        } else
+            sl::sleep_ms(1);
+    }
+    recorder.stop();
+    zed.close();
+}
+
+int StreamTiler::compose(cv::Mat& mosaic, bool draw_overlay) {
+    auto size = mosaicSize();
+    if (mosaic.size() != size || mosaic.type() != CV_8UC4)
+        mosaic = cv::Mat(size, CV_8UC4, cv::Scalar::all(0));
+
+    int nb_updated = 0;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        auto& tile = tiles[i];
+        cv::Rect roi((i % cols) * tile_res.width, (i / cols) * tile_res.height, tile_res.width, tile_res.height);
+        bool updated = false;
+        {
+            lock_guard<mutex> guard(tile.mtx);
+            if (tile.sequence != tile.drawn_sequence) {
+                tile.front.copyTo(mosaic(roi));
+                tile.drawn_sequence = tile.sequence;
+                updated = true;
+            }
+        }
+        // a lost stream keeps its last image, only its overlay is refreshed
+        if (!updated && tile.connected) continue;
+        if (updated) nb_updated++;
+
+        if (draw_overlay) {
+            char txt[64];
+            snprintf(txt, sizeof(txt), "%.1f fps", tile.fps.load());
+            cv::Scalar clr = tile.connected ? cv::Scalar(0, 255, 0, 255) : cv::Scalar(0, 0, 255, 255);
+            cv::putText(mosaic, tile.label, roi.tl() + cv::Point(8, 20), cv::FONT_HERSHEY_SIMPLEX, 0.5, clr, 1);
+            cv::putText(mosaic, txt, roi.tl() + cv::Point(8, 40), cv::FONT_HERSHEY_SIMPLEX, 0.5, clr, 1);
+        }
+    }
+    return nb_updated;
+}
+
+void downscaleArea(const cv::Mat& src, cv::Mat& dst) {
+    if (src.size() == dst.size())
+        src.copyTo(dst);
+    else
+        // INTER_AREA has a SIMD fast path for integer ratios (universal intrinsics: SSE/AVX2 on x86, NEON on Jetson)
+        cv::resize(src, dst, dst.size(), 0, 0, cv::INTER_AREA);
+}
@@ -26,6 +26,13 @@
 // Standard includes
 #include <stdio.h>
 #include <string.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 // ZED include
 #include <sl/Camera.hpp>
@@ -33,20 +40,25 @@
 // OpenCV include (for display)
 #include <opencv2/opencv.hpp>
 
+// Sample includes
+#include "StreamRecorder.hpp"
+#include "StreamTiler.hpp"
+
 // Using std and sl namespaces
 using namespace std;
 using namespace sl;
 
 // Sample functions
-void updateCameraSettings(char key, sl::Camera &zed);
+void updateCameraSettings(char key, sl::Camera &zed, const sl::Rect &roi);
 void switchCameraSettings();
 void switchViewMode();
 void printHelp();
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
+int runMultiStream(vector<StreamSource>& sources, InitParameters init_parameters, const RecordingOptions& rec_options);
 
 // Sample variables
 VIDEO_SETTINGS camera_settings_ = VIDEO_SETTINGS::BRIGHTNESS;
-VIEW view_mode = VIEW::LEFT;
+atomic<VIEW> view_mode(VIEW::LEFT);
 string str_camera_settings = "BRIGHTNESS";
 int step_camera_setting = 1;
 bool led_on = true;
@@ -112,21 +124,111 @@ void setStreamParameter(InitParameters& init_p, string& argument) {
     } else init_p.input.setFromStream(ip);
 }
 
-int main(int argc, char **argv) {
+StreamSource parseStreamSource(const string& argument) {
+    StreamSource source;
+    vector< string> configStream = split(argument, ':');
+    source.ip = configStream.at(0);
+    if (configStream.size() == 2) source.port = atoi(configStream.at(1).c_str());
+    return source;
+}
+
+// Latest frame handed from the grab thread to the display
+struct FrameExchange {
+    mutex mtx;
+    cv::Mat front;
+    uint64_t sequence = 0;
+    atomic<bool> running;
+    ERROR_CODE last_error = ERROR_CODE::SUCCESS;
+    // Keys pressed in the display, with the selection at that time: the camera is only used by the grab thread
+    vector<pair<char, sl::Rect>> pending_keys;
+
+    FrameExchange() : running(true) {}
+};
+
+/**
+    Grab thread of the single stream mode: grabs, records and publishes the current view.
+    A slow disk only delays this thread, the display and the keyboard keep running.
+ **/
+void grabLoop(Camera& zed, FrameExchange& exchange, const RecordingOptions& rec_options) {
+    StreamRecorder recorder(zed, rec_options);
+    if (rec_options.enabled() && !recorder.start())
+        print("Recording disabled");
 
-#if 0
-    auto streaming_devices = Camera::getStreamingDeviceList();
-    int nb_streaming_zed = streaming_devices.size();
+    Mat image;
+    cv::Mat back;
+    vector<pair<char, sl::Rect>> keys;
+    while (exchange.running) {
+        // Camera settings changes, between two grabs
+        keys.clear();
+        {
+            lock_guard<mutex> guard(exchange.mtx);
+            keys.swap(exchange.pending_keys);
+        }
+        for (auto &it : keys)
+            updateCameraSettings(it.first, zed, it.second);
+
+        auto returned_state = zed.grab();
+        if (returned_state == ERROR_CODE::SUCCESS) {
+            recorder.update();
 
-    print("Detect: " + to_string(nb_streaming_zed) + " ZED in streaming");
-    if (nb_streaming_zed == 0) {
-        print("No streaming ZED detected, have you take a look to the sample 'ZED Streaming Sender' ?");
-        return 0;
+            zed.retrieveImage(image, view_mode);
+            cv::Mat(image.getHeight(), image.getWidth(), (image.getChannels() == 1) ? CV_8UC1 : CV_8UC4, image.getPtr<sl::uchar1>(sl::MEM::CPU), image.getStepBytes(sl::MEM::CPU)).copyTo(back);
+
+            lock_guard<mutex> guard(exchange.mtx);
+            cv::swap(back, exchange.front);
+            exchange.sequence++;
+        } else {
+            lock_guard<mutex> guard(exchange.mtx);
+            exchange.last_error = returned_state;
+            exchange.running = false;
+        }
     }
+    recorder.stop();
+}
+
+int main(int argc, char **argv) {
 
-    for (auto& it : streaming_devices)
-        cout << "* ZED: " << it.serial_number << ", IP: " << it.ip << ", port : " << it.port << ", bitrate : " << it.current_bitrate << "\n";
-#endif
+    // Split the recording options from the stream addresses
+    RecordingOptions rec_options;
+    vector<string> stream_args;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "--record" && i + 1 < argc)
+            rec_options.path_prefix = argv[++i];
+        else if (arg == "--segment" && i + 1 < argc)
+            rec_options.segment_duration = atoi(argv[++i]);
+        else
+            stream_args.push_back(arg);
+    }
+
+    // Several streams (or discovery) requested: display them all in a single mosaic
+    if (stream_args.size() > 1 || (stream_args.size() == 1 && stream_args[0] == "--discover")) {
+        InitParameters init_parameters;
+        init_parameters.depth_mode = DEPTH_MODE::NONE;
+        init_parameters.sdk_verbose = false;
+
+        vector<StreamSource> sources;
+        for (auto& arg : stream_args) {
+            if (arg == "--discover") {
+                auto streaming_devices = Camera::getStreamingDeviceList();
+                print("Detect: " + to_string(streaming_devices.size()) + " ZED in streaming");
+                for (auto& it : streaming_devices) {
+                    cout << "* ZED: " << it.serial_number << ", IP: " << it.ip << ", port : " << it.port << ", bitrate : " << it.current_bitrate << "\n";
+                    StreamSource source;
+                    source.ip = string(it.ip.c_str());
+                    source.port = it.port;
+                    sources.push_back(source);
+                }
+            } else
+                sources.push_back(parseStreamSource(arg));
+        }
+
+        if (sources.empty()) {
+            print("No streaming ZED detected, have you take a look to the sample 'ZED Streaming Sender' ?");
+            return EXIT_FAILURE;
+        }
+        return runMultiStream(sources, init_parameters, rec_options);
+    }
 
     Camera zed;
     // Set configuration parameters for the ZED
@@ -136,11 +238,11 @@ int main(int argc, char **argv) {
     init_parameters.sdk_verbose = true;
 
     string stream_params;
-    if (argc > 1) {
-        stream_params = string(argv[1]);
+    if (!stream_args.empty()) {
+        stream_params = stream_args[0];
     } else {
         cout << "\nOpening the stream requires the IP of the sender\n";
-        cout << "Usage : ./ZED_Streaming_Receiver IP:[port]\n";
+        cout << "Usage : ./ZED_Streaming_Receiver IP:[port] [--record <path_prefix> [--segment <seconds>]]\n";
         cout << "You can specify it now, then press ENTER, 'IP:[port]': ";
         cin >> stream_params;
     }
@@ -170,50 +272,95 @@ int main(int argc, char **argv) {
     // Print help in console
     printHelp();
 
-    // Create a Mat to store images
-    Mat image;
-
     // Initialise camera setting
     switchCameraSettings();
 
+    // Grab (and record) in a dedicated thread, the display only shows the newest frame
+    FrameExchange exchange;
+    thread grab_thread(grabLoop, ref(zed), ref(exchange), cref(rec_options));
+
     // Capture new images until 'q' is pressed
+    cv::Mat cvImage;
+    uint64_t displayed_sequence = 0;
     char key = ' ';
-    while (key != 'q') {
-        // Check that a new image is successfully acquired
-        returned_state = zed.grab();
-        if (returned_state == ERROR_CODE::SUCCESS) {
-            // Retrieve left image
-            zed.retrieveImage(image, view_mode);
+    while (key != 'q' && exchange.running) {
+        bool new_frame = false;
+        {
+            lock_guard<mutex> guard(exchange.mtx);
+            if (exchange.sequence != displayed_sequence) {
+                exchange.front.copyTo(cvImage);
+                displayed_sequence = exchange.sequence;
+                new_frame = true;
+            }
+        }
 
-            // Convert sl::Mat to cv::Mat (share buffer)
-            cv::Mat cvImage(image.getHeight(), image.getWidth(), (image.getChannels() == 1) ? CV_8UC1 : CV_8UC4, image.getPtr<sl::uchar1>(sl::MEM::CPU));
-            
+        if (new_frame) {
             //Check that selection rectangle is valid and draw it on the image
             if (!selection_rect.isEmpty() && selection_rect.isContained(sl::Resolution(cvImage.cols, cvImage.rows)))
                 cv::rectangle(cvImage, cv::Rect(selection_rect.x,selection_rect.y,selection_rect.width,selection_rect.height),cv::Scalar(0, 255, 0), 2);
 
             // Display image with OpenCV
             cv::imshow(win_name, cvImage);
-
-        } else {
-            print("Error during capture : ", returned_state);
-            break;
         }
 
-        key = cv::waitKey(5);
-        // Change camera settings with keyboard
-        updateCameraSettings(key, zed);
+        int pressed = cv::waitKey(5);
+        key = static_cast<char>(pressed);
+        // Change camera settings with keyboard, applied by the grab thread
+        if (pressed >= 0 && key != 'q') {
+            lock_guard<mutex> guard(exchange.mtx);
+            exchange.pending_keys.emplace_back(key, selection_rect);
+        }
     }
 
+    exchange.running = false;
+    grab_thread.join();
+    if (exchange.last_error != ERROR_CODE::SUCCESS)
+        print("Error during capture : ", exchange.last_error);
+
     // Exit
     zed.close();
     return EXIT_SUCCESS;
 }
 
+/**
+    This function receives all the streams concurrently and displays them in a single tiled window
+ **/
+int runMultiStream(vector<StreamSource>& sources, InitParameters init_parameters, const RecordingOptions& rec_options) {
+    // Each stream gets a fixed size cell, the whole mosaic fits a 1080p monitor up to 16 streams
+    const int grid = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(sources.size()))));
+    Resolution tile_res(1920 / grid, 1080 / grid);
+
+    StreamTiler tiler(sources, tile_res);
+    print("Receiving " + to_string(sources.size()) + " streams, tile size " + to_string(tile_res.width) + "x" + to_string(tile_res.height));
+    tiler.start(init_parameters, rec_options);
+
+    cv::String win_name = "ZED Streams";
+    cv::namedWindow(win_name);
+
+    // The display is paced on the monitor refresh, never on the slowest stream
+    const auto display_period = chrono::microseconds(1000000 / 60);
+    auto next_refresh = chrono::steady_clock::now();
+    cv::Mat mosaic;
+    char key = ' ';
+    while (key != 'q') {
+        tiler.compose(mosaic);
+        cv::imshow(win_name, mosaic);
+
+        next_refresh += display_period;
+        auto now = chrono::steady_clock::now();
+        if (next_refresh < now) next_refresh = now; // we are late, do not try to catch up
+        int wait_ms = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(next_refresh - now).count());
+        key = cv::waitKey(std::max(1, wait_ms));
+    }
+
+    tiler.stop();
+    return EXIT_SUCCESS;
+}
+
 /**
     This function updates camera settings
  **/
-void updateCameraSettings(char key, sl::Camera &zed) {
+void updateCameraSettings(char key, sl::Camera &zed, const sl::Rect &roi) {
     int current_value;
 
     // Keyboard shortcuts
@@ -260,14 +407,14 @@ void updateCameraSettings(char key, sl::Camera &zed) {
 
         case 'a':
             {
-            cout<<"[Sample] set AEC_AGC_ROI on target ["<<selection_rect.x<<","<<selection_rect.y<<","<<selection_rect.width<<","<<selection_rect.height<<"]\n";
-            zed.setCameraSettings(VIDEO_SETTINGS::AEC_AGC_ROI,selection_rect,sl::SIDE::BOTH);
+            cout<<"[Sample] set AEC_AGC_ROI on target ["<<roi.x<<","<<roi.y<<","<<roi.width<<","<<roi.height<<"]\n";
+            zed.setCameraSettings(VIDEO_SETTINGS::AEC_AGC_ROI,roi,sl::SIDE::BOTH);
             }
             break;
 
         case 'f' :
             print("reset AEC_AGC_ROI to full res");
-            zed.setCameraSettings(VIDEO_SETTINGS::AEC_AGC_ROI,selection_rect,sl::SIDE::BOTH,true);
+            zed.setCameraSettings(VIDEO_SETTINGS::AEC_AGC_ROI,roi,sl::SIDE::BOTH,true);
             break;
 
         default :
@@ -298,14 +445,14 @@ void switchCameraSettings() {
     This function toggles between view mode
  **/
 void switchViewMode() {
-    view_mode = static_cast<VIEW> ((int) view_mode + 1);
+    view_mode = static_cast<VIEW> ((int) view_mode.load() + 1);
 
     // reset to 1st setting
     if (view_mode == VIEW::DEPTH_RIGHT)
         view_mode = VIEW::LEFT;
 
 
-    print("Switch to view mode: ", ERROR_CODE::SUCCESS, string(sl::toString(view_mode).c_str()));
+    print("Switch to view mode: ", ERROR_CODE::SUCCESS, string(sl::toString(view_mode.load()).c_str()));
 }
 
 /**
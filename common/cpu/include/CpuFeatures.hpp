@@ -0,0 +1,42 @@
+#ifndef __CPU_FEATURES_HDR__
+#define __CPU_FEATURES_HDR__
+
+/*
+ * SIMD instruction sets of the samples CPU kernels, shared so every kernel makes the same choice.
+ *
+ * CPU_AVX2: the AVX2 kernels are built. With GCC and Clang they are compiled for AVX2 (and POPCNT) whatever the
+ * target of the rest of the file, prefixed with CPU_AVX2_TARGET, and only called when cpuHasAVX2() says the CPU
+ * runs them. With MSVC they need /arch:AVX2.
+ * CPU_NEON: the NEON kernels are built, on 64-bit ARM only (Jetson) as some of them use AArch64 only intrinsics.
+ *
+ * Header only, include directory common/cpu/include.
+ */
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CPU_AVX2 1
+#define CPU_AVX2_TARGET __attribute__((target("avx2,popcnt")))
+#elif defined(_MSC_VER) && defined(__AVX2__)
+#include <immintrin.h>
+#define CPU_AVX2 1
+#define CPU_AVX2_TARGET
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define CPU_NEON 1
+#endif
+
+#ifdef CPU_AVX2
+// The CPU runs the AVX2 kernels, checked once
+inline bool cpuHasAVX2() {
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    return has_avx2;
+#else
+    return true; // built with /arch:AVX2
+#endif
+}
+#endif
+
+#endif /* __CPU_FEATURES_HDR__ */
@@ -0,0 +1,132 @@
+#ifndef __CPU_WORKER_POOL_HDR__
+#define __CPU_WORKER_POOL_HDR__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Worker threads created once and reused by every parallel pass of the samples CPU kernels, a pass costs two
+ * condition variable notifications instead of creating and joining a thread per core.
+ *
+ * run(nb_tasks, task) calls task(i) for every i in [0, nb_tasks), spread over the workers and the calling thread,
+ * and returns once they are all done. parallelRows(height, rows) splits [0, height) in one row block per thread.
+ * Passes are run one at a time: run() is meant to be called from a single thread.
+ *
+ * Header only, include directory common/cpu/include.
+ */
+class WorkerPool {
+public:
+    // nb_threads counts the calling thread, 0: one thread per core
+    explicit WorkerPool(int nb_threads = 0) {
+        if (nb_threads <= 0) nb_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (int t = 1; t < nb_threads; t++)
+            threads_.emplace_back(&WorkerPool::work, this);
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> guard(mtx_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (auto& it : threads_)
+            it.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Threads of a pass, the calling one included
+    int size() const {
+        return static_cast<int>(threads_.size()) + 1;
+    }
+
+    template<typename F>
+    void run(int nb_tasks, F&& task) {
+        typedef typename std::remove_reference<F>::type Task;
+        dispatch(nb_tasks, [](void* context, int i) { (*static_cast<Task*>(context))(i); }, (void*) &task);
+    }
+
+    // rows(first, last) on row blocks covering [0, height)
+    template<typename F>
+    void parallelRows(int height, F&& rows) {
+        const int nb_blocks = std::max(1, std::min(size(), height));
+        const int rows_per_block = (height + nb_blocks - 1) / nb_blocks;
+        run(nb_blocks, [&](int b) {
+            const int first = b * rows_per_block;
+            if (first < height) rows(first, std::min(height, first + rows_per_block));
+        });
+    }
+
+private:
+    typedef void (*Invoke)(void* context, int i);
+
+    void dispatch(int nb_tasks, Invoke invoke, void* context) {
+        if (threads_.empty() || nb_tasks <= 1) {
+            for (int i = 0; i < nb_tasks; i++) invoke(context, i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(mtx_);
+            invoke_ = invoke;
+            context_ = context;
+            nb_tasks_ = nb_tasks;
+            next_task_ = 0;
+            nb_finished_ = 0;
+            generation_++;
+        }
+        start_.notify_all();
+        runTasks(invoke, context, nb_tasks);
+
+        // Every worker takes part in every pass: none can still be running this one when the next one starts
+        std::unique_lock<std::mutex> lock(mtx_);
+        done_.wait(lock, [&] { return nb_finished_ == threads_.size(); });
+    }
+
+    void runTasks(Invoke invoke, void* context, int nb_tasks) {
+        for (int i = next_task_++; i < nb_tasks; i = next_task_++)
+            invoke(context, i);
+    }
+
+    void work() {
+        unsigned long long seen = 0;
+        for (;;) {
+            Invoke invoke;
+            void* context;
+            int nb_tasks;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+                invoke = invoke_;
+                context = context_;
+                nb_tasks = nb_tasks_;
+            }
+            runTasks(invoke, context, nb_tasks);
+            {
+                std::lock_guard<std::mutex> guard(mtx_);
+                nb_finished_++;
+            }
+            done_.notify_one();
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mtx_;
+    std::condition_variable start_, done_;
+    bool stop_ = false;
+    unsigned long long generation_ = 0;
+    Invoke invoke_ = nullptr;
+    void* context_ = nullptr;
+    int nb_tasks_ = 0;
+    std::atomic<int> next_task_{0};
+    size_t nb_finished_ = 0;
+};
+
+#endif /* __CPU_WORKER_POOL_HDR__ */
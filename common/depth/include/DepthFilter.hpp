@@ -0,0 +1,68 @@
+#ifndef __DEPTH_FILTER_HDR__
+#define __DEPTH_FILTER_HDR__
+
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+#include "WorkerPool.hpp"
+
+struct DepthFilterParameters {
+    float alpha = 0.2f; // smallest weight of a new measure in the depth history
+    float max_relative_diff = 0.03f; // a measure farther than this from the history (relative to the depth) is a new surface
+    float max_confidence = 10.f; // the confidence of a pixel grows by 1 per consistent measure, up to this value
+    float miss_decay = 2.f; // confidence lost for each frame without a measure
+    float min_confidence = 1.f; // the history is output when its confidence reaches this value
+    int fill_passes = 4; // hole filling passes, holes up to about 2^fill_passes pixels wide are filled
+    int nb_threads = 0; // the calling thread included, 0: all the cores
+};
+
+/*
+ * CPU depth post-processing, to be fed with the depth of SENSING_MODE::STANDARD:
+ *  - temporal filter: each pixel keeps an exponentially weighted history of its depth with a confidence. A measure
+ *    consistent with the history is blended in with a weight of max(alpha, 1 / (confidence + 1)), an inconsistent one
+ *    restarts the history, and a missing one only lowers the confidence, so that short dropouts do not flicker.
+ *  - hole filling: each pass fills an invalid pixel with the mean of the pixels at +-radius (horizontally and/or
+ *    vertically) when both are valid and on the same surface, so the depth edges are not blurred. The radius is halved
+ *    at each pass, from 2^(fill_passes - 1) to 1.
+ * Each stage is vectorized (AVX2 when the CPU supports it) and split in row blocks over worker threads created once,
+ * with the filter.
+ */
+class DepthFilter {
+public:
+    struct Stats {
+        size_t frames = 0;
+        size_t input_valid = 0; // valid input pixels
+        size_t output_valid = 0; // valid output pixels, after the history and the hole filling
+        size_t resets = 0; // histories restarted by an inconsistent measure
+    };
+
+    DepthFilter(const DepthFilterParameters& params = DepthFilterParameters());
+
+    // depth: F32_C1 in CPU memory. filtered is (re)allocated as F32_C1 in CPU memory, it may be 'depth' itself.
+    // A change of resolution resets the history.
+    void process(sl::Mat& depth, sl::Mat& filtered);
+
+    // Forgets the history, e.g. after a jump in an SVO
+    void reset();
+
+    const Stats& getStats() const {
+        return stats_;
+    }
+
+    void resetStats() {
+        stats_ = Stats();
+    }
+
+private:
+    template<typename F> void parallelRows(F&& rows);
+
+    DepthFilterParameters params_;
+    WorkerPool workers_;
+    int width_ = 0, height_ = 0;
+    std::vector<float> history_, confidence_;
+    std::vector<float> buffers_[2]; // hole filling ping-pong
+    Stats stats_;
+};
+
+#endif /* __DEPTH_FILTER_HDR__ */
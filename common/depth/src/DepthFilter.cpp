@@ -0,0 +1,248 @@
+#include "DepthFilter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "CpuFeatures.hpp"
+
+// Counters of a row block, summed once the pass is done
+struct RowCounters {
+    size_t input_valid = 0, output_valid = 0, resets = 0;
+};
+
+struct TemporalConsts {
+    float alpha, rel, max_conf, decay, min_conf;
+};
+
+static inline bool isValid(float d) {
+    return std::fabs(d) < INFINITY; // false for NAN and +-INFINITY
+}
+
+static void temporalScalar(const float* in, float* h, float* c, float* out, int first, int n, const TemporalConsts& k, RowCounters& cnt) {
+    for (int j = first; j < n; j++) {
+        const float d = in[j], hv = h[j], cv = c[j];
+        if (isValid(d)) {
+            cnt.input_valid++;
+            if (cv > 0.f && std::fabs(d - hv) < k.rel * hv) {
+                const float alpha = std::max(k.alpha, 1.f / (cv + 1.f));
+                h[j] = hv + alpha * (d - hv);
+                c[j] = std::min(cv + 1.f, k.max_conf);
+            } else {
+                if (cv > 0.f) cnt.resets++;
+                h[j] = d;
+                c[j] = 1.f;
+            }
+        } else
+            c[j] = std::max(cv - k.decay, 0.f);
+        out[j] = (c[j] >= k.min_conf) ? h[j] : NAN;
+    }
+}
+
+// Mean of the valid pairs (src[x - r], src[x + r]) and (up[x], down[x]) that lie on the same surface
+static void fillScalar(const float* src, const float* up, const float* down, float* dst, int first, int last, int width, int r, float rel) {
+    for (int x = first; x < last; x++) {
+        const float v = src[x];
+        if (isValid(v)) {
+            dst[x] = v;
+            continue;
+        }
+        float sum = 0.f, n = 0.f;
+        if (x >= r && x + r < width) {
+            const float a = src[x - r], b = src[x + r];
+            if (isValid(a) && isValid(b) && std::fabs(a - b) < rel * std::min(a, b)) {
+                sum += a + b;
+                n += 2.f;
+            }
+        }
+        if (up && down) {
+            const float a = up[x], b = down[x];
+            if (isValid(a) && isValid(b) && std::fabs(a - b) < rel * std::min(a, b)) {
+                sum += a + b;
+                n += 2.f;
+            }
+        }
+        dst[x] = (n > 0.f) ? sum / n : NAN;
+    }
+}
+
+#ifdef CPU_AVX2
+CPU_AVX2_TARGET static int temporalAVX2(const float* in, float* h, float* c, float* out, int n, const TemporalConsts& k, RowCounters& cnt) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 nan = _mm256_set1_ps(NAN);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 alpha = _mm256_set1_ps(k.alpha);
+    const __m256 rel = _mm256_set1_ps(k.rel);
+    const __m256 max_conf = _mm256_set1_ps(k.max_conf);
+    const __m256 decay = _mm256_set1_ps(k.decay);
+    const __m256 min_conf = _mm256_set1_ps(k.min_conf);
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const __m256 d = _mm256_loadu_ps(in + j);
+        const __m256 hv = _mm256_loadu_ps(h + j);
+        const __m256 cv = _mm256_loadu_ps(c + j);
+
+        const __m256 valid = _mm256_cmp_ps(_mm256_and_ps(d, abs_mask), inf, _CMP_LT_OQ);
+        const __m256 has_history = _mm256_cmp_ps(cv, zero, _CMP_GT_OQ);
+        const __m256 diff = _mm256_and_ps(_mm256_sub_ps(d, hv), abs_mask);
+        const __m256 same = _mm256_and_ps(has_history, _mm256_cmp_ps(diff, _mm256_mul_ps(rel, hv), _CMP_LT_OQ));
+        const __m256 blend = _mm256_and_ps(valid, same);
+        const __m256 restart = _mm256_andnot_ps(same, valid);
+
+        const __m256 a = _mm256_max_ps(alpha, _mm256_div_ps(one, _mm256_add_ps(cv, one)));
+        const __m256 h_blend = _mm256_add_ps(hv, _mm256_mul_ps(a, _mm256_sub_ps(d, hv)));
+        const __m256 c_blend = _mm256_min_ps(_mm256_add_ps(cv, one), max_conf);
+        const __m256 c_miss = _mm256_max_ps(_mm256_sub_ps(cv, decay), zero);
+
+        const __m256 h_new = _mm256_blendv_ps(_mm256_blendv_ps(hv, h_blend, blend), d, restart);
+        const __m256 c_new = _mm256_blendv_ps(_mm256_blendv_ps(c_miss, c_blend, blend), one, restart);
+        _mm256_storeu_ps(h + j, h_new);
+        _mm256_storeu_ps(c + j, c_new);
+        _mm256_storeu_ps(out + j, _mm256_blendv_ps(nan, h_new, _mm256_cmp_ps(c_new, min_conf, _CMP_GE_OQ)));
+
+        cnt.input_valid += _mm_popcnt_u32(_mm256_movemask_ps(valid));
+        cnt.resets += _mm_popcnt_u32(_mm256_movemask_ps(_mm256_and_ps(restart, has_history)));
+    }
+    return j;
+}
+
+CPU_AVX2_TARGET static inline __m256 pairMean(__m256 a, __m256 b, __m256 rel, __m256& n) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 valid = _mm256_and_ps(_mm256_cmp_ps(_mm256_and_ps(a, abs_mask), inf, _CMP_LT_OQ), _mm256_cmp_ps(_mm256_and_ps(b, abs_mask), inf, _CMP_LT_OQ));
+    const __m256 diff = _mm256_and_ps(_mm256_sub_ps(a, b), abs_mask);
+    const __m256 ok = _mm256_and_ps(valid, _mm256_cmp_ps(diff, _mm256_mul_ps(rel, _mm256_min_ps(a, b)), _CMP_LT_OQ));
+    n = _mm256_add_ps(n, _mm256_and_ps(ok, _mm256_set1_ps(2.f)));
+    return _mm256_and_ps(ok, _mm256_add_ps(a, b));
+}
+
+// Processes x in [r, width - r), returns the first x not done
+CPU_AVX2_TARGET static int fillAVX2(const float* src, const float* up, const float* down, float* dst, int width, int r, float rel_) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 nan = _mm256_set1_ps(NAN);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 rel = _mm256_set1_ps(rel_);
+
+    int x = r;
+    for (; x + 8 <= width - r; x += 8) {
+        const __m256 v = _mm256_loadu_ps(src + x);
+        const __m256 valid = _mm256_cmp_ps(_mm256_and_ps(v, abs_mask), inf, _CMP_LT_OQ);
+        if (_mm256_movemask_ps(valid) == 0xFF) {
+            _mm256_storeu_ps(dst + x, v);
+            continue;
+        }
+        __m256 n = zero;
+        __m256 sum = pairMean(_mm256_loadu_ps(src + x - r), _mm256_loadu_ps(src + x + r), rel, n);
+        if (up && down)
+            sum = _mm256_add_ps(sum, pairMean(_mm256_loadu_ps(up + x), _mm256_loadu_ps(down + x), rel, n));
+        const __m256 filled = _mm256_blendv_ps(nan, _mm256_div_ps(sum, n), _mm256_cmp_ps(n, zero, _CMP_GT_OQ));
+        _mm256_storeu_ps(dst + x, _mm256_blendv_ps(filled, v, valid));
+    }
+    return x;
+}
+#endif
+
+static void temporalRow(const float* in, float* h, float* c, float* out, int n, const TemporalConsts& k, RowCounters& cnt) {
+    int done = 0;
+#ifdef CPU_AVX2
+    if (cpuHasAVX2()) done = temporalAVX2(in, h, c, out, n, k, cnt);
+#endif
+    temporalScalar(in, h, c, out, done, n, k, cnt);
+}
+
+static void fillRow(const float* src, const float* up, const float* down, float* dst, int width, int r, float rel) {
+    const int left = std::min(r, width);
+    fillScalar(src, up, down, dst, 0, left, width, r, rel);
+    int x = left;
+#ifdef CPU_AVX2
+    if (cpuHasAVX2()) x = std::max(x, fillAVX2(src, up, down, dst, width, r, rel));
+#endif
+    fillScalar(src, up, down, dst, x, width, width, r, rel);
+}
+
+DepthFilter::DepthFilter(const DepthFilterParameters& params) : params_(params), workers_(params.nb_threads) {
+    params_.nb_threads = workers_.size();
+    params_.fill_passes = std::max(0, std::min(params_.fill_passes, 10));
+}
+
+void DepthFilter::reset() {
+    std::fill(history_.begin(), history_.end(), NAN);
+    std::fill(confidence_.begin(), confidence_.end(), 0.f);
+}
+
+// Row blocks spread over the workers and the calling thread. rows(first, last, counters)
+template<typename F>
+void DepthFilter::parallelRows(F&& rows) {
+    const int nb_blocks = std::max(1, std::min(params_.nb_threads, height_));
+    const int rows_per_block = (height_ + nb_blocks - 1) / nb_blocks;
+    std::vector<RowCounters> counters(nb_blocks);
+    workers_.run(nb_blocks, [&](int b) {
+        const int first = b * rows_per_block;
+        if (first < height_) rows(first, std::min(height_, first + rows_per_block), counters[b]);
+    });
+    for (auto& it : counters) {
+        stats_.input_valid += it.input_valid;
+        stats_.output_valid += it.output_valid;
+        stats_.resets += it.resets;
+    }
+}
+
+void DepthFilter::process(sl::Mat& depth, sl::Mat& filtered) {
+    const int width = depth.getWidth(), height = depth.getHeight();
+    if (width != width_ || height != height_) {
+        width_ = width;
+        height_ = height;
+        const size_t area = static_cast<size_t> (width) * height;
+        history_.resize(area);
+        confidence_.resize(area);
+        buffers_[0].resize(area);
+        buffers_[1].resize(area);
+        reset();
+    }
+
+    // Temporal filter, into buffers_[0]
+    const TemporalConsts k = {params_.alpha, params_.max_relative_diff, params_.max_confidence, params_.miss_decay, params_.min_confidence};
+    const float* depth_ptr = depth.getPtr<float>(sl::MEM::CPU);
+    const size_t depth_step = depth.getStep(sl::MEM::CPU);
+    parallelRows([&](int first, int last, RowCounters& cnt) {
+        for (int v = first; v < last; v++) {
+            const size_t offset = static_cast<size_t> (v) * width_;
+            temporalRow(depth_ptr + v * depth_step, history_.data() + offset, confidence_.data() + offset, buffers_[0].data() + offset, width_, k, cnt);
+        }
+    });
+
+    // Hole filling, every pass reads the whole result of the previous one
+    int current = 0;
+    for (int pass = params_.fill_passes - 1; pass >= 0; pass--) {
+        const int r = 1 << pass;
+        const float* src = buffers_[current].data();
+        float* dst = buffers_[1 - current].data();
+        parallelRows([&](int first, int last, RowCounters&) {
+            for (int v = first; v < last; v++) {
+                const float* up = (v >= r && v + r < height_) ? src + static_cast<size_t> (v - r) * width_ : nullptr;
+                const float* down = up ? src + static_cast<size_t> (v + r) * width_ : nullptr;
+                fillRow(src + static_cast<size_t> (v) * width_, up, down, dst + static_cast<size_t> (v) * width_, width_, r, params_.max_relative_diff);
+            }
+        });
+        current = 1 - current;
+    }
+
+    if (!filtered.isInit() || filtered.getWidth() != depth.getWidth() || filtered.getHeight() != depth.getHeight() || filtered.getDataType() != sl::MAT_TYPE::F32_C1)
+        filtered.alloc(depth.getResolution(), sl::MAT_TYPE::F32_C1, sl::MEM::CPU);
+    float* out_ptr = filtered.getPtr<float>(sl::MEM::CPU);
+    const size_t out_step = filtered.getStep(sl::MEM::CPU);
+    const float* result = buffers_[current].data();
+    parallelRows([&](int first, int last, RowCounters& cnt) {
+        for (int v = first; v < last; v++) {
+            const float* row = result + static_cast<size_t> (v) * width_;
+            memcpy(out_ptr + v * out_step, row, width_ * sizeof(float));
+            for (int u = 0; u < width_; u++)
+                cnt.output_valid += isValid(row[u]);
+        }
+    });
+    stats_.frames++;
+}
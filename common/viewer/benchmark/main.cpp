@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Rebuilds the bounding boxes of 1000 objects every frame, once as geometry and once as **
+ ** instances of a unit box, and reports the time spent building and uploading them.     **
+ ** No camera is needed.                                                                  **
+ *****************************************************************************************/
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+
+#include "Simple3DObject.hpp"
+#include "InstancedObject.hpp"
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point start) {
+    return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    const int nb_boxes = 1000;
+    const int nb_frames = 300;
+    const int nb_warmup = 10; // the first frames grow the storage
+
+    // An OpenGL context is needed for the uploads, the window itself is not shown
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
+    glutCreateWindow("Simple3DObject benchmark");
+    glutHideWindow();
+    GLenum err = glewInit();
+    if (GLEW_OK != err) {
+        cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Object detection viewers: edges and faded faces
+    Simple3DObject edges(sl::Translation(0, 0, 0), false);
+    edges.setDrawingType(GL_LINES);
+    Simple3DObject faces(sl::Translation(0, 0, 0), false);
+    faces.setDrawingType(GL_QUADS);
+    // Body tracking viewer: faded boxes
+    Simple3DObject boxes(sl::Translation(0, 0, 0), false);
+    boxes.setDrawingType(GL_QUADS);
+
+    // The same boxes, instanced
+    vector<sl::float3> unit_box = InstancedObject::unitBox();
+    const sl::float4 white(1, 1, 1, 1);
+    InstancedObject edges_inst, faces_inst, boxes_inst;
+    edges_inst.addFullEdges(unit_box, white);
+    edges_inst.addVerticalEdges(unit_box, white);
+    edges_inst.setDrawingType(GL_LINES);
+    faces_inst.addVerticalFaces(unit_box, white);
+    faces_inst.addTopFace(unit_box, white);
+    faces_inst.setDrawingType(GL_QUADS);
+    boxes_inst.addBoundingBox(unit_box, white);
+    boxes_inst.setDrawingType(GL_QUADS);
+
+    vector<sl::float3> bbox(8);
+    const sl::float4 clr(0.2f, 0.6f, 1.f, 1.f);
+
+    double build_ms = 0, upload_ms = 0, build_inst_ms = 0, upload_inst_ms = 0;
+    for (int f = 0; f < nb_warmup + nb_frames; f++) {
+        auto start = Clock::now();
+        edges.clear();
+        faces.clear();
+        boxes.clear();
+        for (int i = 0; i < nb_boxes; i++) {
+            // A 1x2x1 m box, moving a little every frame
+            const float x = (i % 32) * 1.5f + f * 0.001f, z = -2.f - (i / 32) * 1.5f;
+            bbox[0] = sl::float3(x, 2, z);
+            bbox[1] = sl::float3(x + 1, 2, z);
+            bbox[2] = sl::float3(x + 1, 2, z - 1);
+            bbox[3] = sl::float3(x, 2, z - 1);
+            for (int j = 0; j < 4; j++)
+                bbox[j + 4] = sl::float3(bbox[j].x, 0, bbox[j].z);
+
+            edges.addFullEdges(bbox, clr);
+            edges.addVerticalEdges(bbox, clr);
+            faces.addVerticalFaces(bbox, clr);
+            faces.addTopFace(bbox, clr);
+            boxes.addBoundingBox(bbox, clr);
+        }
+        const double build = elapsedMs(start);
+
+        start = Clock::now();
+        edges.pushToGPU();
+        faces.pushToGPU();
+        boxes.pushToGPU();
+        glFinish();
+        const double upload = elapsedMs(start);
+
+        start = Clock::now();
+        edges_inst.clearInstances();
+        faces_inst.clearInstances();
+        boxes_inst.clearInstances();
+        for (int i = 0; i < nb_boxes; i++) {
+            const float x = (i % 32) * 1.5f + f * 0.001f, z = -2.f - (i / 32) * 1.5f;
+            bbox[0] = sl::float3(x, 2, z);
+            bbox[1] = sl::float3(x + 1, 2, z);
+            bbox[2] = sl::float3(x + 1, 2, z - 1);
+            bbox[3] = sl::float3(x, 2, z - 1);
+            for (int j = 0; j < 4; j++)
+                bbox[j + 4] = sl::float3(bbox[j].x, 0, bbox[j].z);
+
+            edges_inst.addBoxInstance(bbox, clr);
+            faces_inst.addBoxInstance(bbox, clr);
+            boxes_inst.addBoxInstance(bbox, clr);
+        }
+        const double build_inst = elapsedMs(start);
+
+        start = Clock::now();
+        edges_inst.pushToGPU();
+        faces_inst.pushToGPU();
+        boxes_inst.pushToGPU();
+        glFinish();
+        const double upload_inst = elapsedMs(start);
+
+        if (f >= nb_warmup) {
+            build_ms += build;
+            upload_ms += upload;
+            build_inst_ms += build_inst;
+            upload_inst_ms += upload_inst;
+        }
+    }
+
+    cout << nb_boxes << " boxes per frame, average over " << nb_frames << " frames:" << endl;
+    cout << "  geometry  : build " << build_ms / nb_frames << " ms, upload " << upload_ms / nb_frames << " ms" << endl;
+    cout << "  instanced : build " << build_inst_ms / nb_frames << " ms, upload " << upload_inst_ms / nb_frames << " ms" << endl;
+    return EXIT_SUCCESS;
+}
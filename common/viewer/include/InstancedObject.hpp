@@ -0,0 +1,61 @@
+#ifndef __VIEWER_INSTANCEDOBJECT_HDR__
+#define __VIEWER_INSTANCEDOBJECT_HDR__
+
+#include <vector>
+
+#include "Simple3DObject.hpp"
+
+/*
+ * A Simple3DObject drawn many times with a single instanced draw call.
+ *
+ * The geometry added with the Simple3DObject builders is the unit shape, it is uploaded once. Each instance is an
+ * affine transform (unit shape -> world) and a color, combined by the vertex shader with the colors of the unit shape
+ * (usually built in white). Only the instances, 16 floats each, are uploaded every frame.
+ *
+ * The vertex shader reads the transform rows at Shader::ATTRIB_INSTANCE_MODEL (+0, +1, +2) and the color at
+ * Shader::ATTRIB_INSTANCE_COLOR:
+ *     layout(location = 3) in vec4 in_ModelX; ... layout(location = 6) in vec4 in_InstanceColor;
+ *     vec3 world = vec3(dot(in_ModelX, v), dot(in_ModelY, v), dot(in_ModelZ, v)); // v = vec4(in_Vertex, 1)
+ */
+class InstancedObject : public Simple3DObject {
+public:
+
+    InstancedObject();
+    ~InstancedObject();
+
+    InstancedObject(InstancedObject&& other);
+    InstancedObject& operator=(InstancedObject&& other);
+
+    // Unit shape point (x, y, z) -> origin + x * xAxis + y * yAxis + z * zAxis
+    void addInstance(const sl::float3& origin, const sl::float3& xAxis, const sl::float3& yAxis, const sl::float3& zAxis, const sl::float4& clr);
+    // Unit shape translated to 'position'
+    void addInstance(const sl::float3& position, const sl::float4& clr);
+    // Unit shape along +Y (from y = 0 to y = 1) stretched from 'start' to 'end', X and Z keep their length
+    void addSegmentInstance(const sl::float3& start, const sl::float3& end, const sl::float4& clr);
+    // unitBox() mapped on a 3D bounding box: its top face (corners 0, 1, 3) and its vertical edge (corners 0, 4)
+    void addBoxInstance(const std::vector<sl::float3>& pts, const sl::float4& clr);
+
+    void clearInstances();
+
+    void pushToGPU();
+    void draw();
+
+    // The 8 corners of the unit cube in the order of the SDK 3D bounding boxes, to build a box shape
+    static std::vector<sl::float3> unitBox();
+
+private:
+    struct Instance {
+        float model[12]; // 3 rows
+        float color[4];
+    };
+
+    void releaseInstances();
+
+    std::vector<Instance> instances_;
+    bool instancesDirty_;
+
+    StreamBuffer instanceBuffer_;
+    GLsizei nbInstances_; // uploaded
+};
+
+#endif /* __VIEWER_INSTANCEDOBJECT_HDR__ */
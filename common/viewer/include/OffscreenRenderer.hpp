@@ -0,0 +1,76 @@
+#ifndef __VIEWER_OFFSCREEN_HDR__
+#define __VIEWER_OFFSCREEN_HDR__
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+/*
+ * Headless rendering of the samples viewers: an EGL context without any window or display (surfaceless), and a
+ * framebuffer object the viewer renders into in place of its window.
+ *
+ * A viewer renders offscreen when the environment variable ZED_VIEWER_OFFSCREEN is set, its value is the output:
+ * - an existing directory: one PPM image per frame (frame_000000.ppm, ...),
+ * - any other path: the raw RGB24 frames appended to it, a file or a fifo read by a video encoder:
+ *     ffmpeg -f rawvideo -pix_fmt rgb24 -s <width>x<height> -i <path> review.mp4
+ * - empty: no output, only the frame times.
+ * The frame times (rendering and output) are printed when the renderer is closed.
+ *
+ * Needs EGL (libEGL) at build time, VIEWER_WITH_EGL is defined when it was found.
+ */
+class OffscreenRenderer {
+public:
+
+    OffscreenRenderer();
+    ~OffscreenRenderer();
+
+    OffscreenRenderer(const OffscreenRenderer&) = delete;
+    OffscreenRenderer& operator=(const OffscreenRenderer&) = delete;
+
+    // True when ZED_VIEWER_OFFSCREEN is set
+    static bool isRequested();
+
+    // Creates the context and a width x height framebuffer, makes them current and loads the GL functions (GLEW)
+    bool init(int width, int height, bool srgb);
+    bool isInitialized() const;
+
+    // Around the rendering of each frame, in place of the window buffer swap
+    void beginFrame();
+    void endFrame();
+
+    // Prints the frame times and releases the context
+    void close();
+
+    int getWidth() const;
+    int getHeight() const;
+
+private:
+    bool createContext();
+    bool createFramebuffer(bool srgb);
+    void writeFrame();
+
+    // EGLDisplay, EGLContext, EGLSurface: EGL is not exposed to the viewers
+    void* display_;
+    void* context_;
+    void* surface_;
+
+    GLuint fboID_;
+    GLuint renderbufferID_[2]; // color, depth
+    int width_;
+    int height_;
+
+    std::string directory_;
+    std::ofstream stream_;
+    std::vector<unsigned char> pixels_;
+    std::vector<unsigned char> row_;
+
+    std::chrono::steady_clock::time_point frameStart_;
+    int nbFrames_;
+    double renderMs_, renderMaxMs_;
+    double outputMs_;
+};
+
+#endif /* __VIEWER_OFFSCREEN_HDR__ */
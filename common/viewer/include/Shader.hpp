@@ -0,0 +1,46 @@
+#ifndef __VIEWER_SHADER_HDR__
+#define __VIEWER_SHADER_HDR__
+
+#include <GL/glew.h>
+
+/*
+ * GLSL program shared by the samples viewers.
+ * The vertex attributes are bound to fixed locations, they match the layout of Simple3DObject:
+ * "in_vertex" -> ATTRIB_VERTICES_POS, "in_texCoord" -> ATTRIB_COLOR_POS.
+ * The program is owned: a Shader can be moved (shader.it = Shader(vs, fs)) but not copied.
+ */
+class Shader {
+public:
+
+    Shader() {}
+    Shader(const GLchar* vs, const GLchar* fs);
+    ~Shader();
+
+    Shader(Shader&& other);
+    Shader& operator=(Shader&& other);
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
+    GLuint getProgramId();
+
+    static const GLint ATTRIB_VERTICES_POS = 0;
+    static const GLint ATTRIB_COLOR_POS = 1;
+    static const GLint ATTRIB_NORMAL = 2;
+    // InstancedObject: the 3 rows of the instance transform (3, 4, 5) and its color
+    static const GLint ATTRIB_INSTANCE_MODEL = 3;
+    static const GLint ATTRIB_INSTANCE_COLOR = 6;
+private:
+    bool compile(GLuint &shaderId, GLenum type, const GLchar* src);
+    void release();
+
+    GLuint verterxId_ = 0;
+    GLuint fragmentId_ = 0;
+    GLuint programId_ = 0;
+};
+
+struct ShaderData {
+    Shader it;
+    GLuint MVP_Mat;
+};
+
+#endif /* __VIEWER_SHADER_HDR__ */
@@ -0,0 +1,143 @@
+#ifndef __VIEWER_SIMPLE3DOBJECT_HDR__
+#define __VIEWER_SIMPLE3DOBJECT_HDR__
+
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+#include <GL/glew.h>
+
+/*
+ * Colored primitives (points, lines, triangles, quads) drawn with a single draw call.
+ *
+ * The vertices are interleaved in one buffer (position, RGBA color), the normals, only used by the shaded objects,
+ * are in a second one. Everything is recorded once in a vertex array object.
+ * pushToGPU() does nothing when the object did not change since the last upload. A static object is uploaded once. A
+ * dynamic object rebuilt each frame writes each upload in the next segment of grow-only buffers (see StreamBuffer):
+ * it neither reallocates nor orphans its buffers, and never waits for the draws of the previous frames.
+ * While the vertices are drawn in order (points, lines, strips, triangles, cylinders, spheres), no index is stored
+ * nor uploaded and the object is drawn with glDrawArrays. The boxes that share their corners use glDrawElements.
+ * The CPU storage is kept by clear(): once an object reached its usual size, rebuilding it does not allocate.
+ *
+ * The colors are RGBA, the sl::float3 overloads use an alpha of 1.
+ */
+class Simple3DObject {
+public:
+
+    Simple3DObject();
+    Simple3DObject(sl::Translation position, bool isStatic);
+    ~Simple3DObject();
+
+    // The GPU buffers are owned: an object can be moved (obj = Simple3DObject(...)) but not copied
+    Simple3DObject(Simple3DObject&& other);
+    Simple3DObject& operator=(Simple3DObject&& other);
+    Simple3DObject(const Simple3DObject&) = delete;
+    Simple3DObject& operator=(const Simple3DObject&) = delete;
+
+    void addPoint(sl::float3 pt, sl::float4 clr);
+    void addPoint(sl::float3 pt, sl::float3 clr);
+    void addPoint(float x, float y, float z, float r, float g, float b);
+    void addLine(sl::float3 p1, sl::float3 p2, sl::float4 clr);
+    void addLine(sl::float3 p1, sl::float3 p2, sl::float3 clr);
+    void addTriangle(sl::float3 p1, sl::float3 p2, sl::float3 p3, sl::float4 clr);
+    void addTriangle(sl::float3 p1, sl::float3 p2, sl::float3 p3, sl::float3 clr);
+
+    // Shaded primitives, with normals (body tracking skeletons)
+    void addCylinder(sl::float3 startPosition, sl::float3 endPosition, sl::float4 clr);
+    void addSphere(sl::float3 position, sl::float4 clr);
+
+    // 3D bounding boxes, 'pts' are the 8 corners: top face then bottom face
+    void addBoundingBox(std::vector<sl::float3> &pts, sl::float4 clr); // GL_QUADS, faded sides
+    void addFullEdges(std::vector<sl::float3> &pts, sl::float4 clr);  // GL_LINES
+    void addVerticalEdges(std::vector<sl::float3> &pts, sl::float4 clr); // GL_LINES
+    void addTopFace(std::vector<sl::float3> &pts, sl::float4 clr); // GL_QUADS
+    void addVerticalFaces(std::vector<sl::float3> &pts, sl::float4 clr); // GL_QUADS
+
+    void pushToGPU();
+    void clear();
+
+    void setDrawingType(GLenum type);
+
+    void draw();
+
+    void translate(const sl::Translation& t);
+    void setPosition(const sl::Translation& p);
+
+    void setRT(const sl::Transform& mRT);
+
+    void rotate(const sl::Orientation& rot);
+    void rotate(const sl::Rotation& m);
+    void setRotation(const sl::Orientation& rot);
+    void setRotation(const sl::Rotation& m);
+
+    const sl::Translation& getPosition() const;
+
+    sl::Transform getModelMatrix() const;
+
+protected:
+    /*
+     * A GPU buffer. A static upload sets the whole buffer, once. The dynamic uploads go in turn to NB_SEGMENTS segments
+     * of the buffer, so the segment read by a pending draw is never written: with ARB_buffer_storage the buffer is
+     * mapped once (persistent, coherent) and written with memcpy, a fence per segment telling when the GPU is done
+     * with it, otherwise the segment is written with glBufferSubData. The segments only grow.
+     */
+    struct StreamBuffer {
+        static const int NB_SEGMENTS = 3;
+
+        GLuint id = 0;
+        size_t capacity = 0; // of a segment, in bytes
+        size_t offset = 0; // of the last upload, in bytes
+        int segment = 0;
+        unsigned char* mapped = nullptr; // persistent mapping of the whole buffer
+        GLsync fences[NB_SEGMENTS] = {0, 0, 0};
+
+        // Leaves the buffer bound to 'target'
+        void upload(GLenum target, const void* data, size_t size, bool dynamic);
+        // After a draw reading the last upload: its segment is not rewritten before the draw is done
+        void fence();
+        void release();
+
+    private:
+        void allocate(GLenum target);
+    };
+
+    bool isStatic_;
+
+    GLenum drawingType_;
+
+    GLuint vaoID_;
+    GLsizei nbIndices_; // uploaded
+    bool indexed_; // uploaded with an index buffer
+    size_t indexOffset_; // of the uploaded indices in their buffer, in bytes
+
+private:
+    struct Vertex {
+        float position[3];
+        float color[4];
+    };
+
+    void addVertex(const sl::float3& pt, const sl::float4& clr);
+    void addNormal(const sl::float3& normal);
+    void useIndices(); // switches to glDrawElements
+    void addIndices(unsigned int start_id, const unsigned int* links, size_t nbLinks);
+    void release();
+
+    std::vector<Vertex> vertices_;
+    std::vector<float> normals_;
+    std::vector<unsigned int> indices_;
+    bool sequential_; // no indices, the vertices are drawn in order
+    bool dirty_; // changed since the last upload
+
+    /*
+    Vertex buffers:
+    - [0]: Vertices, interleaved position and color;
+    - [1]: Normals;
+    - [2]: Indices;
+    */
+    StreamBuffer buffers_[3];
+
+    sl::Translation position_;
+    sl::Orientation rotation_;
+};
+
+#endif /* __VIEWER_SIMPLE3DOBJECT_HDR__ */
@@ -0,0 +1,128 @@
+#include "InstancedObject.hpp"
+#include "Shader.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+InstancedObject::InstancedObject() : Simple3DObject(sl::Translation(0, 0, 0), true) {
+    instancesDirty_ = false;
+    nbInstances_ = 0;
+}
+
+InstancedObject::~InstancedObject() {
+    releaseInstances();
+}
+
+InstancedObject::InstancedObject(InstancedObject&& other) : InstancedObject() {
+    *this = std::move(other);
+}
+
+InstancedObject& InstancedObject::operator=(InstancedObject&& other) {
+    if (this != &other) {
+        releaseInstances();
+        Simple3DObject::operator=(std::move(other));
+        instances_ = std::move(other.instances_);
+        instancesDirty_ = other.instancesDirty_;
+        instanceBuffer_ = other.instanceBuffer_;
+        nbInstances_ = other.nbInstances_;
+        other.instanceBuffer_ = StreamBuffer();
+        other.nbInstances_ = 0;
+    }
+    return *this;
+}
+
+void InstancedObject::releaseInstances() {
+    instanceBuffer_.release();
+    nbInstances_ = 0;
+}
+
+void InstancedObject::addInstance(const sl::float3& origin, const sl::float3& xAxis, const sl::float3& yAxis, const sl::float3& zAxis, const sl::float4& clr) {
+    Instance it = {
+        {xAxis.x, yAxis.x, zAxis.x, origin.x,
+         xAxis.y, yAxis.y, zAxis.y, origin.y,
+         xAxis.z, yAxis.z, zAxis.z, origin.z},
+        {clr.r, clr.g, clr.b, clr.a}};
+    instances_.push_back(it);
+    instancesDirty_ = true;
+}
+
+void InstancedObject::addInstance(const sl::float3& position, const sl::float4& clr) {
+    addInstance(position, sl::float3(1, 0, 0), sl::float3(0, 1, 0), sl::float3(0, 0, 1), clr);
+}
+
+void InstancedObject::addSegmentInstance(const sl::float3& start, const sl::float3& end, const sl::float4& clr) {
+    const sl::float3 dir = end - start;
+    const float length = dir.norm();
+    if (!(length > 0.f))
+        return;
+
+    // Any unit frame around the segment, the shape is assumed to be round
+    const sl::float3 y = dir / length;
+    const sl::float3 ref = (std::fabs(y.y) < 0.9f) ? sl::float3(0, 1, 0) : sl::float3(1, 0, 0);
+    sl::float3 z = sl::float3::cross(ref, y);
+    z = z / z.norm();
+    const sl::float3 x = sl::float3::cross(y, z);
+    addInstance(start, x, dir, z, clr);
+}
+
+void InstancedObject::addBoxInstance(const std::vector<sl::float3>& pts, const sl::float4& clr) {
+    addInstance(pts[0], pts[1] - pts[0], pts[4] - pts[0], pts[3] - pts[0], clr);
+}
+
+void InstancedObject::clearInstances() {
+    instances_.clear();
+    instancesDirty_ = true;
+}
+
+std::vector<sl::float3> InstancedObject::unitBox() {
+    // top face (y = 0) then bottom face (y = 1), see addBoxInstance
+    return {
+        sl::float3(0, 0, 0), sl::float3(1, 0, 0), sl::float3(1, 0, 1), sl::float3(0, 0, 1),
+        sl::float3(0, 1, 0), sl::float3(1, 1, 0), sl::float3(1, 1, 1), sl::float3(0, 1, 1)};
+}
+
+void InstancedObject::pushToGPU() {
+    // The unit shape, uploaded once
+    Simple3DObject::pushToGPU();
+    if (!instancesDirty_ || vaoID_ == 0)
+        return;
+
+    glBindVertexArray(vaoID_);
+    const bool first = instanceBuffer_.id == 0;
+    instanceBuffer_.upload(GL_ARRAY_BUFFER, instances_.data(), instances_.size() * sizeof(Instance), true);
+
+    // The instance attributes are added to the layout of the unit shape, they advance once per instance. They are
+    // pointed at the segment just written
+    const size_t base = instanceBuffer_.offset;
+    for (int i = 0; i < 3; i++) {
+        const GLuint row = Shader::ATTRIB_INSTANCE_MODEL + i;
+        glVertexAttribPointer(row, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*) (base + offsetof(Instance, model) + i * 4 * sizeof(float)));
+        if (first) {
+            glEnableVertexAttribArray(row);
+            glVertexAttribDivisor(row, 1);
+        }
+    }
+    glVertexAttribPointer(Shader::ATTRIB_INSTANCE_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*) (base + offsetof(Instance, color)));
+    if (first) {
+        glEnableVertexAttribArray(Shader::ATTRIB_INSTANCE_COLOR);
+        glVertexAttribDivisor(Shader::ATTRIB_INSTANCE_COLOR, 1);
+    }
+    nbInstances_ = (GLsizei) instances_.size();
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instancesDirty_ = false;
+}
+
+void InstancedObject::draw() {
+    if (nbIndices_ && nbInstances_ && vaoID_) {
+        glBindVertexArray(vaoID_);
+        if (indexed_)
+            glDrawElementsInstanced(drawingType_, nbIndices_, GL_UNSIGNED_INT, (void*) indexOffset_, nbInstances_);
+        else
+            glDrawArraysInstanced(drawingType_, 0, nbIndices_, nbInstances_);
+        glBindVertexArray(0);
+        instanceBuffer_.fence();
+    }
+}
@@ -0,0 +1,271 @@
+#include "OffscreenRenderer.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef VIEWER_WITH_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <sys/stat.h>
+#endif
+
+static const char* OUTPUT_VARIABLE = "ZED_VIEWER_OFFSCREEN";
+
+OffscreenRenderer::OffscreenRenderer() {
+    display_ = context_ = surface_ = nullptr;
+    fboID_ = 0;
+    renderbufferID_[0] = renderbufferID_[1] = 0;
+    width_ = height_ = 0;
+    nbFrames_ = 0;
+    renderMs_ = renderMaxMs_ = outputMs_ = 0;
+}
+
+OffscreenRenderer::~OffscreenRenderer() {
+    close();
+}
+
+bool OffscreenRenderer::isRequested() {
+    return getenv(OUTPUT_VARIABLE) != nullptr;
+}
+
+bool OffscreenRenderer::isInitialized() const {
+    return context_ != nullptr;
+}
+
+int OffscreenRenderer::getWidth() const {
+    return width_;
+}
+
+int OffscreenRenderer::getHeight() const {
+    return height_;
+}
+
+#ifdef VIEWER_WITH_EGL
+
+bool OffscreenRenderer::init(int width, int height, bool srgb) {
+    width_ = width;
+    height_ = height;
+    if (!createContext())
+        return false;
+
+    GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // A GLEW built for GLX looks for an X display first, the GL entry points do not need it
+    if (err == GLEW_ERROR_NO_GLX_DISPLAY)
+        err = glewContextInit();
+#endif
+    if (err != GLEW_OK) {
+        std::cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << std::endl;
+        close();
+        return false;
+    }
+
+    if (!createFramebuffer(srgb)) {
+        close();
+        return false;
+    }
+
+    const char* output = getenv(OUTPUT_VARIABLE);
+    if (output && output[0] != '\0') {
+        struct stat info;
+        if (stat(output, &info) == 0 && (info.st_mode & S_IFDIR))
+            directory_ = output;
+        else {
+            stream_.open(output, std::ios::binary | std::ios::app);
+            if (!stream_.is_open())
+                std::cout << "ERROR: can not open " << output << ", the frames will not be saved" << std::endl;
+        }
+    }
+    pixels_.resize(width_ * height_ * 3);
+    row_.resize(width_ * 3);
+
+    std::cout << "Offscreen rendering " << width_ << "x" << height_ << " (" << glGetString(GL_RENDERER) << ")";
+    if (!directory_.empty())
+        std::cout << ", frames saved in " << directory_;
+    else if (stream_.is_open())
+        std::cout << ", raw RGB24 frames appended to " << output;
+    std::cout << std::endl;
+    return true;
+}
+
+bool OffscreenRenderer::createContext() {
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // Mesa: a display without any window system. The other drivers (NVIDIA) give a headless default display
+    const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay && client_extensions && strstr(client_extensions, "EGL_MESA_platform_surfaceless"))
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::cout << "ERROR: no EGL display available" << std::endl;
+        return false;
+    }
+    display_ = display;
+
+    // The viewers render into a framebuffer object, the default framebuffer is not used
+    EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint nb_configs = 0;
+    if (!eglChooseConfig(display, config_attribs, &config, 1, &nb_configs) || nb_configs == 0) {
+        config_attribs[1] = EGL_DONT_CARE;
+        if (!eglChooseConfig(display, config_attribs, &config, 1, &nb_configs) || nb_configs == 0) {
+            std::cout << "ERROR: no EGL configuration for desktop OpenGL" << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+    // The viewers use GLSL 330 with some fixed function calls (GL_QUADS, glWindowPos)
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+    if (context == EGL_NO_CONTEXT)
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+    if (context == EGL_NO_CONTEXT) {
+        std::cout << "ERROR: eglCreateContext failed (0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        close();
+        return false;
+    }
+    context_ = context;
+
+    // Surfaceless when supported, else a minimal pbuffer
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        const EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        EGLSurface surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+        if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context)) {
+            std::cout << "ERROR: eglMakeCurrent failed (0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+            close();
+            return false;
+        }
+        surface_ = surface;
+    }
+    return true;
+}
+
+bool OffscreenRenderer::createFramebuffer(bool srgb) {
+    glGenRenderbuffers(2, renderbufferID_);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbufferID_[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, width_, height_);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbufferID_[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width_, height_);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fboID_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fboID_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbufferID_[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbufferID_[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERROR: incomplete offscreen framebuffer" << std::endl;
+        return false;
+    }
+    // Stays bound: the viewers draw into it as into their window
+    glViewport(0, 0, width_, height_);
+    return true;
+}
+
+void OffscreenRenderer::close() {
+    if (nbFrames_ > 0) {
+        std::cout << "Offscreen: " << nbFrames_ << " frames, rendering " << renderMs_ / nbFrames_ << " ms on average (max " << renderMaxMs_ << " ms)";
+        if (!directory_.empty() || stream_.is_open())
+            std::cout << ", output " << outputMs_ / nbFrames_ << " ms";
+        std::cout << std::endl;
+        nbFrames_ = 0;
+    }
+    if (stream_.is_open())
+        stream_.close();
+
+    if (display_) {
+        EGLDisplay display = (EGLDisplay) display_;
+        if (context_) {
+            // Only created once GLEW is initialized, the GL entry points are null before
+            if (fboID_)
+                glDeleteFramebuffers(1, &fboID_);
+            if (renderbufferID_[0])
+                glDeleteRenderbuffers(2, renderbufferID_);
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(display, (EGLContext) context_);
+        }
+        if (surface_)
+            eglDestroySurface(display, (EGLSurface) surface_);
+        eglTerminate(display);
+    }
+    display_ = context_ = surface_ = nullptr;
+    fboID_ = 0;
+    renderbufferID_[0] = renderbufferID_[1] = 0;
+}
+
+#else
+
+bool OffscreenRenderer::init(int, int, bool) {
+    std::cout << "ERROR: offscreen rendering needs EGL, the viewer was built without it" << std::endl;
+    return false;
+}
+
+void OffscreenRenderer::close() {
+}
+
+#endif
+
+void OffscreenRenderer::beginFrame() {
+    frameStart_ = std::chrono::steady_clock::now();
+}
+
+void OffscreenRenderer::endFrame() {
+    if (!isInitialized())
+        return;
+
+    // The frame time includes the GPU work
+    glFinish();
+    auto rendered = std::chrono::steady_clock::now();
+    const double render_ms = std::chrono::duration<double, std::milli>(rendered - frameStart_).count();
+    renderMs_ += render_ms;
+    if (render_ms > renderMaxMs_)
+        renderMaxMs_ = render_ms;
+
+    if (!directory_.empty() || stream_.is_open()) {
+        writeFrame();
+        outputMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - rendered).count();
+    }
+    nbFrames_++;
+}
+
+void OffscreenRenderer::writeFrame() {
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, pixels_.data());
+
+    // OpenGL rows start at the bottom, image rows at the top
+    const size_t row_size = width_ * 3;
+    for (int y = 0; y < height_ / 2; y++) {
+        unsigned char* top = &pixels_[y * row_size];
+        unsigned char* bottom = &pixels_[(height_ - 1 - y) * row_size];
+        memcpy(row_.data(), top, row_size);
+        memcpy(top, bottom, row_size);
+        memcpy(bottom, row_.data(), row_size);
+    }
+
+    if (!directory_.empty()) {
+        char name[32];
+        snprintf(name, sizeof(name), "/frame_%06d.ppm", nbFrames_);
+        std::ofstream file(directory_ + name, std::ios::binary);
+        file << "P6\n" << width_ << " " << height_ << "\n255\n";
+        file.write((const char*) pixels_.data(), pixels_.size());
+    } else {
+        stream_.write((const char*) pixels_.data(), pixels_.size());
+        stream_.flush();
+    }
+}
@@ -0,0 +1,102 @@
+#include "Shader.hpp"
+
+#include <iostream>
+#include <utility>
+
+Shader::Shader(const GLchar* vs, const GLchar* fs) {
+    if (!compile(verterxId_, GL_VERTEX_SHADER, vs)) {
+        std::cout << "ERROR: while compiling vertex shader" << std::endl;
+    }
+    if (!compile(fragmentId_, GL_FRAGMENT_SHADER, fs)) {
+        std::cout << "ERROR: while compiling fragment shader" << std::endl;
+    }
+
+    programId_ = glCreateProgram();
+
+    glAttachShader(programId_, verterxId_);
+    glAttachShader(programId_, fragmentId_);
+
+    glBindAttribLocation(programId_, ATTRIB_VERTICES_POS, "in_vertex");
+    glBindAttribLocation(programId_, ATTRIB_COLOR_POS, "in_texCoord");
+
+    glLinkProgram(programId_);
+
+    GLint errorlk(0);
+    glGetProgramiv(programId_, GL_LINK_STATUS, &errorlk);
+    if (errorlk != GL_TRUE) {
+        std::cout << "ERROR: while linking Shader :" << std::endl;
+        GLint errorSize(0);
+        glGetProgramiv(programId_, GL_INFO_LOG_LENGTH, &errorSize);
+
+        char *error = new char[errorSize + 1];
+        glGetProgramInfoLog(programId_, errorSize, &errorSize, error);
+        error[errorSize] = '\0';
+        std::cout << error << std::endl;
+
+        delete[] error;
+        glDeleteProgram(programId_);
+        programId_ = 0;
+    }
+}
+
+Shader::~Shader() {
+    release();
+}
+
+Shader::Shader(Shader&& other) {
+    *this = std::move(other);
+}
+
+Shader& Shader::operator=(Shader&& other) {
+    if (this != &other) {
+        release();
+        verterxId_ = other.verterxId_;
+        fragmentId_ = other.fragmentId_;
+        programId_ = other.programId_;
+        other.verterxId_ = other.fragmentId_ = other.programId_ = 0;
+    }
+    return *this;
+}
+
+void Shader::release() {
+    if (verterxId_ != 0)
+        glDeleteShader(verterxId_);
+    if (fragmentId_ != 0)
+        glDeleteShader(fragmentId_);
+    if (programId_ != 0)
+        glDeleteProgram(programId_);
+    verterxId_ = fragmentId_ = programId_ = 0;
+}
+
+GLuint Shader::getProgramId() {
+    return programId_;
+}
+
+bool Shader::compile(GLuint &shaderId, GLenum type, const GLchar* src) {
+    shaderId = glCreateShader(type);
+    if (shaderId == 0) {
+        std::cout << "ERROR: shader type (" << type << ") does not exist" << std::endl;
+        return false;
+    }
+    glShaderSource(shaderId, 1, &src, 0);
+    glCompileShader(shaderId);
+
+    GLint errorCp(0);
+    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &errorCp);
+    if (errorCp != GL_TRUE) {
+        std::cout << "ERROR: while compiling Shader :" << std::endl;
+        GLint errorSize(0);
+        glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &errorSize);
+
+        char *error = new char[errorSize + 1];
+        glGetShaderInfoLog(shaderId, errorSize, &errorSize, error);
+        error[errorSize] = '\0';
+        std::cout << error << std::endl;
+
+        delete[] error;
+        glDeleteShader(shaderId);
+        shaderId = 0;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,536 @@
+#include "Simple3DObject.hpp"
+#include "Shader.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#ifndef M_PI
+#define M_PI 3.141592653f
+#endif
+
+// Subdivisions of the faded bounding box sides
+static const float grid_size = 10.0f;
+
+// Unit circle of the cylinders, with the normal of each side. Computed once, they do not depend on the cylinder
+struct CylinderTable {
+    static const int NB_SEG = 32;
+    float cos_[NB_SEG + 1];
+    float sin_[NB_SEG + 1];
+    sl::float3 normal[NB_SEG];
+
+    CylinderTable() {
+        for (int j = 0; j <= NB_SEG; j++) {
+            float i = 2.f * M_PI * (j / (float) NB_SEG);
+            cos_[j] = cos(i);
+            sin_[j] = sin(i);
+        }
+        for (int j = 0; j < NB_SEG; j++) {
+            // cross(top - base, next base - base)
+            sl::float3 n(sin_[j + 1] - sin_[j], 0, cos_[j] - cos_[j + 1]);
+            normal[j] = n / n.norm();
+        }
+    }
+};
+
+// Unit sphere of the joints, 4 points per quad. A point of the unit sphere is also its normal
+struct SphereTable {
+    static const int NB_STACK = 16;
+    static const int NB_SECTOR = 16;
+    static const int NB_POINTS = (NB_STACK + 1) * NB_SECTOR * 4;
+    sl::float3 pts[NB_POINTS];
+
+    SphereTable() {
+        int k = 0;
+        auto addPoint = [&](double lat, double lng) {
+            sl::float3 pt((float) (cos(lng) * cos(lat)), (float) (sin(lng) * cos(lat)), (float) sin(lat));
+            pts[k++] = pt / pt.norm();
+        };
+        for (int i = 0; i <= NB_STACK; i++) {
+            double lat0 = M_PI * (-0.5 + (double) (i - 1) / NB_STACK);
+            double lat1 = M_PI * (-0.5 + (double) i / NB_STACK);
+            for (int j = 0; j < NB_SECTOR; j++) {
+                double lng0 = 2 * M_PI * (double) (j - 1) / NB_SECTOR;
+                double lng1 = 2 * M_PI * (double) (j) / NB_SECTOR;
+                addPoint(lat0, lng0);
+                addPoint(lat1, lng0);
+                addPoint(lat1, lng1);
+                addPoint(lat0, lng1);
+            }
+        }
+    }
+};
+
+void Simple3DObject::StreamBuffer::upload(GLenum target, const void* data, size_t size, bool dynamic) {
+    if (id == 0)
+        glGenBuffers(1, &id);
+    if (!dynamic) {
+        glBindBuffer(target, id);
+        glBufferData(target, size, data, GL_STATIC_DRAW);
+        capacity = size;
+        offset = 0;
+        return;
+    }
+
+    if (size > capacity) {
+        // Rebuilt every frame with a varying size, keep some margin. The segments stay aligned for the attributes
+        capacity = (size + size / 2 + 63) & ~static_cast<size_t> (63);
+        allocate(target);
+    } else
+        glBindBuffer(target, id);
+    segment = (segment + 1) % NB_SEGMENTS;
+    offset = segment * capacity;
+    if (mapped) {
+        // Only waits if the GPU still reads this segment, i.e. if it is more than 2 uploads late
+        if (fences[segment]) {
+            while (glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+            glDeleteSync(fences[segment]);
+            fences[segment] = 0;
+        }
+        if (size)
+            memcpy(mapped + offset, data, size);
+    } else if (size)
+        glBufferSubData(target, offset, size, data);
+}
+
+void Simple3DObject::StreamBuffer::allocate(GLenum target) {
+    for (auto& it : fences)
+        if (it) {
+            glDeleteSync(it);
+            it = 0;
+        }
+    if (mapped) {
+        // The storage of a mapped buffer is immutable: a new buffer, the old one is freed once the GPU is done with it
+        glDeleteBuffers(1, &id);
+        glGenBuffers(1, &id);
+        mapped = nullptr;
+    }
+    glBindBuffer(target, id);
+    const GLsizeiptr total = capacity * NB_SEGMENTS;
+    if (GLEW_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target, total, nullptr, flags);
+        mapped = static_cast<unsigned char*> (glMapBufferRange(target, 0, total, flags));
+        if (mapped)
+            return;
+        // Immutable storage without mapping, start again with a regular buffer
+        glDeleteBuffers(1, &id);
+        glGenBuffers(1, &id);
+        glBindBuffer(target, id);
+    }
+    glBufferData(target, total, nullptr, GL_DYNAMIC_DRAW);
+}
+
+void Simple3DObject::StreamBuffer::fence() {
+    if (mapped) {
+        if (fences[segment])
+            glDeleteSync(fences[segment]);
+        fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void Simple3DObject::StreamBuffer::release() {
+    for (auto& it : fences)
+        if (it)
+            glDeleteSync(it);
+    // Deleting a mapped buffer also unmaps it
+    if (id != 0)
+        glDeleteBuffers(1, &id);
+    *this = StreamBuffer();
+}
+
+Simple3DObject::Simple3DObject() : Simple3DObject(sl::Translation(0, 0, 0), false) {
+}
+
+Simple3DObject::Simple3DObject(sl::Translation position, bool isStatic) : isStatic_(isStatic) {
+    vaoID_ = 0;
+    nbIndices_ = 0;
+    indexed_ = false;
+    indexOffset_ = 0;
+    sequential_ = true;
+    dirty_ = false;
+    drawingType_ = GL_TRIANGLES;
+    position_ = position;
+    rotation_.setIdentity();
+}
+
+Simple3DObject::~Simple3DObject() {
+    release();
+}
+
+Simple3DObject::Simple3DObject(Simple3DObject&& other) : Simple3DObject() {
+    *this = std::move(other);
+}
+
+Simple3DObject& Simple3DObject::operator=(Simple3DObject&& other) {
+    if (this != &other) {
+        release();
+        vertices_ = std::move(other.vertices_);
+        normals_ = std::move(other.normals_);
+        indices_ = std::move(other.indices_);
+        sequential_ = other.sequential_;
+        dirty_ = other.dirty_;
+        isStatic_ = other.isStatic_;
+        drawingType_ = other.drawingType_;
+        vaoID_ = other.vaoID_;
+        for (int i = 0; i < 3; i++) {
+            buffers_[i] = other.buffers_[i];
+            other.buffers_[i] = StreamBuffer();
+        }
+        nbIndices_ = other.nbIndices_;
+        indexed_ = other.indexed_;
+        indexOffset_ = other.indexOffset_;
+        position_ = other.position_;
+        rotation_ = other.rotation_;
+        other.vaoID_ = 0;
+        other.nbIndices_ = 0;
+    }
+    return *this;
+}
+
+void Simple3DObject::release() {
+    if (vaoID_ != 0) {
+        for (auto& it : buffers_)
+            it.release();
+        glDeleteVertexArrays(1, &vaoID_);
+        vaoID_ = 0;
+    }
+    nbIndices_ = 0;
+}
+
+void Simple3DObject::addVertex(const sl::float3& pt, const sl::float4& clr) {
+    const Vertex v = {{pt.x, pt.y, pt.z}, {clr.r, clr.g, clr.b, clr.a}};
+    vertices_.push_back(v);
+    dirty_ = true;
+}
+
+void Simple3DObject::addNormal(const sl::float3& normal) {
+    normals_.push_back(normal.x);
+    normals_.push_back(normal.y);
+    normals_.push_back(normal.z);
+}
+
+void Simple3DObject::useIndices() {
+    if (sequential_) {
+        // Write the indices that were implied so far
+        indices_.resize(vertices_.size());
+        for (unsigned int i = 0; i < indices_.size(); i++)
+            indices_[i] = i;
+        sequential_ = false;
+    }
+}
+
+void Simple3DObject::addIndices(unsigned int start_id, const unsigned int* links, size_t nbLinks) {
+    for (size_t i = 0; i < nbLinks; i++)
+        indices_.push_back(start_id + links[i]);
+}
+
+void Simple3DObject::addPoint(sl::float3 pt, sl::float4 clr) {
+    addVertex(pt, clr);
+    if (!sequential_)
+        indices_.push_back((unsigned int) vertices_.size() - 1);
+}
+
+void Simple3DObject::addPoint(sl::float3 pt, sl::float3 clr) {
+    addPoint(pt, sl::float4(clr.r, clr.g, clr.b, 1.f));
+}
+
+void Simple3DObject::addPoint(float x, float y, float z, float r, float g, float b) {
+    addPoint(sl::float3(x, y, z), sl::float4(r, g, b, 1.f));
+}
+
+void Simple3DObject::addLine(sl::float3 p1, sl::float3 p2, sl::float4 clr) {
+    addPoint(p1, clr);
+    addPoint(p2, clr);
+}
+
+void Simple3DObject::addLine(sl::float3 p1, sl::float3 p2, sl::float3 clr) {
+    addLine(p1, p2, sl::float4(clr.r, clr.g, clr.b, 1.f));
+}
+
+void Simple3DObject::addTriangle(sl::float3 p1, sl::float3 p2, sl::float3 p3, sl::float4 clr) {
+    addPoint(p1, clr);
+    addPoint(p2, clr);
+    addPoint(p3, clr);
+}
+
+void Simple3DObject::addTriangle(sl::float3 p1, sl::float3 p2, sl::float3 p3, sl::float3 clr) {
+    addTriangle(p1, p2, p3, sl::float4(clr.r, clr.g, clr.b, 1.f));
+}
+
+void Simple3DObject::addCylinder(sl::float3 startPosition, sl::float3 endPosition, sl::float4 clr) {
+    const float m_radius = 0.010f;
+
+    sl::float3 dir = endPosition - startPosition;
+    float m_height = dir.norm();
+    dir = dir / m_height;
+
+    sl::float3 yAxis(0, 1, 0);
+    sl::float3 v = sl::float3::cross(dir, yAxis);
+    sl::Transform rotation;
+
+    if (v.norm() < 0.00001f)
+        rotation.setIdentity();
+    else {
+        float cosTheta = sl::float3::dot(dir, yAxis);
+        float scale = (1.f - cosTheta) / (1.f - (cosTheta * cosTheta));
+
+        float data[] = {0, v[2], -v[1], 0,
+                        -v[2], 0, v[0], 0,
+                        v[1], -v[0], 0, 0,
+                        0, 0, 0, 1.f};
+
+        sl::Transform vx = sl::Transform(data);
+        rotation.setIdentity();
+        rotation = rotation + vx;
+        rotation = rotation + vx * vx * scale;
+    }
+
+    static const CylinderTable table;
+    const int NB_SEG = CylinderTable::NB_SEG;
+    auto rot = rotation.getRotationMatrix();
+
+    // Each point of the base circle is shared by two segments
+    const sl::float3 height = sl::float3(0, m_height, 0) * rot;
+    sl::float3 base[NB_SEG + 1];
+    for (int j = 0; j <= NB_SEG; j++)
+        base[j] = sl::float3(m_radius * table.cos_[j], 0, m_radius * table.sin_[j]) * rot + startPosition;
+
+    for (int j = 0; j < NB_SEG; j++) {
+        addPoint(base[j], clr);
+        addPoint(base[j] + height, clr);
+        addPoint(base[j + 1] + height, clr);
+        addPoint(base[j + 1], clr);
+
+        const sl::float3 normal = table.normal[j] * rot;
+        addNormal(normal);
+        addNormal(normal);
+        addNormal(normal);
+        addNormal(normal);
+    }
+}
+
+void Simple3DObject::addSphere(sl::float3 position, sl::float4 clr) {
+    const float m_radius = 0.02f;
+
+    static const SphereTable sphere;
+    for (int i = 0; i < SphereTable::NB_POINTS; i++) {
+        addPoint(sphere.pts[i] * m_radius + position, clr);
+        addNormal(sphere.pts[i]);
+    }
+}
+
+void Simple3DObject::addBoundingBox(std::vector<sl::float3> &pts, sl::float4 clr) {
+    useIndices();
+    const unsigned int start_id = (unsigned int) vertices_.size();
+
+    const float ratio = 1.f / 5.f;
+
+    sl::float4 fade_clr = clr;
+    fade_clr.a = 0;
+    // generate TOP BOX
+    for (int i = 0; i < 4; i++)
+        addVertex(pts[i], clr);
+    // generate TOP BOX FADE
+    for (int i = 4; i < 8; i++)
+        addVertex(pts[i - 4] - (pts[i - 4] - pts[i]) * ratio, fade_clr);
+    // generate BOTTOM FADE
+    for (int i = 4; i < 8; i++)
+        addVertex(pts[i] + (pts[i - 4] - pts[i]) * ratio, fade_clr);
+    // generate BOTTOM BOX
+    for (int i = 4; i < 8; i++)
+        addVertex(pts[i], clr);
+
+    static const unsigned int boxLinks[] = {0, 1, 5, 4, 1, 2, 6, 5, 2, 3, 7, 6, 3, 0, 4, 7};
+    const size_t nbLinks = sizeof(boxLinks) / sizeof(boxLinks[0]);
+    addIndices(start_id, boxLinks, nbLinks);
+    addIndices(start_id + 8, boxLinks, nbLinks);
+}
+
+void Simple3DObject::addFullEdges(std::vector<sl::float3> &pts, sl::float4 clr) {
+    useIndices();
+    clr.w = 0.4f;
+    const unsigned int start_id = (unsigned int) vertices_.size();
+    for (unsigned int i = 0; i < pts.size(); i++)
+        addVertex(pts[i], clr);
+
+    static const unsigned int boxLinks[] = {0, 1, 1, 2, 2, 3, 3, 0, // top
+                                            4, 5, 5, 6, 6, 7, 7, 4}; // bottom
+    addIndices(start_id, boxLinks, sizeof(boxLinks) / sizeof(boxLinks[0]));
+}
+
+void Simple3DObject::addVerticalEdges(std::vector<sl::float3> &pts, sl::float4 clr) {
+    useIndices();
+    static const unsigned int lineLinks[] = {0, 1, 1, 2, 2, 3, 3, 4, 4, 5};
+
+    auto addSingleVerticalLine = [&](const sl::float3& top_pt, const sl::float3& bot_pt) {
+        const sl::float3 current_pts[] = {
+            top_pt,
+            ((grid_size - 1.0f) * top_pt + bot_pt) / grid_size,
+            ((grid_size - 2.0f) * top_pt + bot_pt * 2.0f) / grid_size,
+            (2.0f * top_pt + bot_pt * (grid_size - 2.0f)) / grid_size,
+            (top_pt + bot_pt * (grid_size - 1.0f)) / grid_size,
+            bot_pt};
+
+        const unsigned int start_id = (unsigned int) vertices_.size();
+        for (int i = 0; i < 6; i++) {
+            clr.a = (i == 2 || i == 3) ? 0.0f : 0.4f;
+            addVertex(current_pts[i], clr);
+        }
+        addIndices(start_id, lineLinks, sizeof(lineLinks) / sizeof(lineLinks[0]));
+    };
+
+    addSingleVerticalLine(pts[0], pts[4]);
+    addSingleVerticalLine(pts[1], pts[5]);
+    addSingleVerticalLine(pts[2], pts[6]);
+    addSingleVerticalLine(pts[3], pts[7]);
+}
+
+void Simple3DObject::addTopFace(std::vector<sl::float3> &pts, sl::float4 clr) {
+    clr.a = 0.3f;
+    for (const auto& it : pts)
+        addPoint(it, clr);
+}
+
+void Simple3DObject::addVerticalFaces(std::vector<sl::float3> &pts, sl::float4 clr) {
+    // For each face, the first 2 indexes are always the top points
+    static const int quads[4][4] = {
+        {0, 3, 7, 4}, // front face
+        {3, 2, 6, 7}, // right face
+        {2, 1, 5, 6}, // back face
+        {1, 0, 4, 5} // left face
+    };
+
+    // The faces are split in 4 quads near the top and 4 quads near the bottom, fading towards the middle.
+    // The split heights (ratio from the top) and their alpha are shared by the 4 faces.
+    const int NB_LEVELS = 10;
+    static const float levels[NB_LEVELS] = {
+        0.f, 0.5f / grid_size, 1.0f / grid_size, 1.5f / grid_size, 2.0f / grid_size,
+        (grid_size - 2.0f) / grid_size, (grid_size - 1.5f) / grid_size, (grid_size - 1.0f) / grid_size, (grid_size - 0.5f) / grid_size, 1.f};
+    const float alpha = 0.5f;
+    const float alphas[NB_LEVELS] = {alpha, alpha, 2 * alpha / 3, alpha / 3, 0.f, 0.f, alpha / 3, 2 * alpha / 3, alpha, alpha};
+
+    sl::float3 left[NB_LEVELS];
+    sl::float3 right[NB_LEVELS];
+    for (const auto& quad : quads) {
+        for (int l = 0; l < NB_LEVELS; l++) {
+            left[l] = pts[quad[0]] * (1.f - levels[l]) + pts[quad[3]] * levels[l];
+            right[l] = pts[quad[1]] * (1.f - levels[l]) + pts[quad[2]] * levels[l];
+        }
+        for (int l = 0; l < NB_LEVELS - 1; l++) {
+            if (l == NB_LEVELS / 2 - 1) // transparent middle
+                continue;
+            clr.a = alphas[l];
+            addPoint(left[l], clr);
+            addPoint(right[l], clr);
+            clr.a = alphas[l + 1];
+            addPoint(right[l + 1], clr);
+            addPoint(left[l + 1], clr);
+        }
+    }
+}
+
+void Simple3DObject::pushToGPU() {
+    if (!dirty_ || (isStatic_ && vaoID_ != 0))
+        return;
+
+    if (vaoID_ == 0) {
+        glGenVertexArrays(1, &vaoID_);
+        glBindVertexArray(vaoID_);
+        glEnableVertexAttribArray(Shader::ATTRIB_VERTICES_POS);
+        glEnableVertexAttribArray(Shader::ATTRIB_COLOR_POS);
+    } else
+        glBindVertexArray(vaoID_);
+
+    // Each upload may go to another segment, or to a new buffer, the attributes are pointed at it again
+    const bool dynamic = !isStatic_;
+    StreamBuffer& vbo = buffers_[0];
+    vbo.upload(GL_ARRAY_BUFFER, vertices_.data(), vertices_.size() * sizeof(Vertex), dynamic);
+    glVertexAttribPointer(Shader::ATTRIB_VERTICES_POS, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) (vbo.offset + offsetof(Vertex, position)));
+    glVertexAttribPointer(Shader::ATTRIB_COLOR_POS, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) (vbo.offset + offsetof(Vertex, color)));
+
+    if (!normals_.empty() && normals_.size() == vertices_.size() * 3) {
+        buffers_[1].upload(GL_ARRAY_BUFFER, normals_.data(), normals_.size() * sizeof(float), dynamic);
+        glVertexAttribPointer(Shader::ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, (void*) buffers_[1].offset);
+        glEnableVertexAttribArray(Shader::ATTRIB_NORMAL);
+    } else
+        glDisableVertexAttribArray(Shader::ATTRIB_NORMAL);
+
+    indexed_ = !sequential_;
+    if (indexed_) {
+        // Bound while the VAO is, the VAO keeps it
+        buffers_[2].upload(GL_ELEMENT_ARRAY_BUFFER, indices_.data(), indices_.size() * sizeof(unsigned int), dynamic);
+        indexOffset_ = buffers_[2].offset;
+    }
+    nbIndices_ = (GLsizei) (indexed_ ? indices_.size() : vertices_.size());
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    dirty_ = false;
+}
+
+void Simple3DObject::clear() {
+    vertices_.clear();
+    normals_.clear();
+    indices_.clear();
+    sequential_ = true;
+    dirty_ = true;
+}
+
+void Simple3DObject::setDrawingType(GLenum type) {
+    drawingType_ = type;
+}
+
+void Simple3DObject::draw() {
+    if (nbIndices_ && vaoID_) {
+        glBindVertexArray(vaoID_);
+        if (indexed_)
+            glDrawElements(drawingType_, nbIndices_, GL_UNSIGNED_INT, (void*) indexOffset_);
+        else
+            glDrawArrays(drawingType_, 0, nbIndices_);
+        glBindVertexArray(0);
+        for (auto& it : buffers_)
+            it.fence();
+    }
+}
+
+void Simple3DObject::translate(const sl::Translation& t) {
+    position_ = position_ + t;
+}
+
+void Simple3DObject::setPosition(const sl::Translation& p) {
+    position_ = p;
+}
+
+void Simple3DObject::setRT(const sl::Transform& mRT) {
+    position_ = mRT.getTranslation();
+    rotation_ = mRT.getOrientation();
+}
+
+void Simple3DObject::rotate(const sl::Orientation& rot) {
+    rotation_ = rot * rotation_;
+}
+
+void Simple3DObject::rotate(const sl::Rotation& m) {
+    this->rotate(sl::Orientation(m));
+}
+
+void Simple3DObject::setRotation(const sl::Orientation& rot) {
+    rotation_ = rot;
+}
+
+void Simple3DObject::setRotation(const sl::Rotation& m) {
+    this->setRotation(sl::Orientation(m));
+}
+
+const sl::Translation& Simple3DObject::getPosition() const {
+    return position_;
+}
+
+sl::Transform Simple3DObject::getModelMatrix() const {
+    sl::Transform tmp = sl::Transform::identity();
+    tmp.setOrientation(rotation_);
+    tmp.setTranslation(position_);
+    return tmp;
+}
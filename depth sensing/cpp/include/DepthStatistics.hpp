@@ -0,0 +1,51 @@
+#ifndef __DEPTH_STATISTICS_HDR__
+#define __DEPTH_STATISTICS_HDR__
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+/*
+ * Depth health statistics, accumulated over a window of frames:
+ *  - valid pixel ratio (mean and worst frame), and the share of each invalid kind: occluded (NAN), too close (-INFINITY),
+ *    too far (+INFINITY)
+ *  - depth min / max / mean and histogram of the valid pixels
+ *  - confidence histogram, 10 bins of the [0, 100] confidence measure
+ *  - grab and retrieve latencies (mean, p50, p95, max)
+ * The per-pixel reductions use AVX2 when the CPU supports it.
+ */
+class DepthStatistics {
+public:
+    // The depth histogram covers [min_depth, max_depth], the values outside go to the first / last bin
+    DepthStatistics(float min_depth, float max_depth, int nb_depth_bins = 32);
+
+    // depth and confidence: F32_C1 in CPU memory, of the same size
+    void addFrame(sl::Mat& depth, sl::Mat& confidence, double grab_ms, double retrieve_ms);
+    void addGrabError();
+
+    size_t getNbFrames() const {
+        return frames_;
+    }
+
+    // Writes the current window as a single line JSON object, then starts a new window
+    void writeSummary(std::ostream& out, uint64_t timestamp_ns, double window_duration_s);
+
+private:
+    void clear();
+
+    float min_depth_, max_depth_;
+    int nb_depth_bins_;
+
+    size_t frames_ = 0, grab_errors_ = 0;
+    uint64_t pixels_ = 0, valid_ = 0, occluded_ = 0, too_close_ = 0, too_far_ = 0;
+    double valid_ratio_min_ = 1.;
+    double depth_sum_ = 0.;
+    float depth_min_, depth_max_;
+    std::vector<uint64_t> depth_hist_, confidence_hist_;
+    std::vector<double> grab_ms_, retrieve_ms_;
+    std::vector<int32_t> bins_; // row scratch
+};
+
+#endif /* __DEPTH_STATISTICS_HDR__ */
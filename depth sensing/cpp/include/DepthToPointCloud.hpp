@@ -0,0 +1,43 @@
+#ifndef __DEPTH_TO_POINT_CLOUD_HDR__
+#define __DEPTH_TO_POINT_CLOUD_HDR__
+
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+#include "WorkerPool.hpp"
+
+/*
+ * CPU back-projection of a depth map into a point cloud, with the pinhole model of the rectified left camera:
+ *     X = (u - cx) * Z / fx,  Y = (v - cy) * Z / fy
+ *
+ * Retrieving MEASURE::DEPTH (4 bytes per pixel) and back-projecting only the needed pixels is much lighter than
+ * transferring MEASURE::XYZRGBA (16 bytes per pixel). The rows are split in blocks processed by worker threads
+ * created once with the object, and each row is vectorized (AVX2 when the CPU supports it, NEON on ARM). Invalid depths (NAN, +-INFINITY) give
+ * invalid points, as in the SDK point cloud.
+ */
+class DepthToPointCloud {
+public:
+    // 'calib' is the left camera of the camera configuration, 'coord' the coordinate system the camera was opened with
+    // (IMAGE, LEFT_HANDED_Y_UP and RIGHT_HANDED_Y_UP are supported). nb_threads = 0 uses all the cores.
+    DepthToPointCloud(const sl::CameraParameters& calib, sl::COORDINATE_SYSTEM coord, int nb_threads = 0);
+
+    // depth: F32_C1 in CPU memory, at any resolution (the intrinsics are scaled accordingly).
+    // roi: area of the depth map to convert (empty: whole map), stride: keep one pixel every 'stride' in both directions.
+    // xyz is (re)allocated as F32_C3, of size roi / stride.
+    void compute(sl::Mat& depth, sl::Mat& xyz, sl::Rect roi = sl::Rect(), int stride = 1);
+
+    // Same, with the color of the left image (U8_C4, same resolution as depth) packed in the 4th channel: xyzrgba is F32_C4,
+    // with the layout of MEASURE::XYZRGBA.
+    void compute(sl::Mat& depth, sl::Mat& image, sl::Mat& xyzrgba, sl::Rect roi = sl::Rect(), int stride = 1);
+
+private:
+    void run(sl::Mat& depth, sl::Mat* image, sl::Mat& out, sl::Rect roi, int stride, bool rgba);
+
+    sl::CameraParameters calib_;
+    float sign_y_, sign_z_;
+    WorkerPool workers_;
+    std::vector<float> kx_; // (u - cx) / fx for each output column
+};
+
+#endif /* __DEPTH_TO_POINT_CLOUD_HDR__ */
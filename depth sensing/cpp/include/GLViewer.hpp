@@ -1,8 +1,10 @@
 #ifndef __VIEWER_INCLUDE__
 #define __VIEWER_INCLUDE__
 
+#include <atomic>
 #include <vector>
 #include <mutex>
+#include <chrono>
 
 #include <sl/Camera.hpp>
 
@@ -12,6 +14,11 @@
 #include <cuda.h>
 #include <cuda_gl_interop.h>
 
+#include "CameraGL.hpp"
+#include "Shader.hpp"
+#include "Simple3DObject.hpp"
+#include "OffscreenRenderer.hpp"
+
 #ifndef M_PI
 #define M_PI 3.141592653f
 #endif
@@ -29,139 +36,10 @@ void print(std::string msg_prefix, sl::ERROR_CODE err_code = sl::ERROR_CODE::SUC
 
 /////////////////
 
-class CameraGL {
-public:
-
-    CameraGL() {}
-    enum DIRECTION {
-        UP, DOWN, LEFT, RIGHT, FORWARD, BACK
-    };
-    CameraGL(sl::Translation position, sl::Translation direction, sl::Translation vertical = sl::Translation(0, 1, 0)); // vertical = Eigen::Vector3f(0, 1, 0)
-    ~CameraGL();
-
-    void update();
-    void setProjection(float horizontalFOV, float verticalFOV, float znear, float zfar);
-    const sl::Transform& getViewProjectionMatrix() const;
-
-    float getHorizontalFOV() const;
-    float getVerticalFOV() const;
-
-    // Set an offset between the eye of the camera and its position
-    // Note: Useful to use the camera as a trackball camera with z>0 and x = 0, y = 0
-    // Note: coordinates are in local space
-    void setOffsetFromPosition(const sl::Translation& offset);
-    const sl::Translation& getOffsetFromPosition() const;
-
-    void setDirection(const sl::Translation& direction, const sl::Translation &vertical);
-    void translate(const sl::Translation& t);
-    void setPosition(const sl::Translation& p);
-    void rotate(const sl::Orientation& rot);
-    void rotate(const sl::Rotation& m);
-    void setRotation(const sl::Orientation& rot);
-    void setRotation(const sl::Rotation& m);
-
-    const sl::Translation& getPosition() const;
-    const sl::Translation& getForward() const;
-    const sl::Translation& getRight() const;
-    const sl::Translation& getUp() const;
-    const sl::Translation& getVertical() const;
-    float getZNear() const;
-    float getZFar() const;
-
-    static const sl::Translation ORIGINAL_FORWARD;
-    static const sl::Translation ORIGINAL_UP;
-    static const sl::Translation ORIGINAL_RIGHT;
-
-    sl::Transform projection_;
-private:
-    void updateVectors();
-    void updateView();
-    void updateVPMatrix();
-
-    sl::Translation offset_;
-    sl::Translation position_;
-    sl::Translation forward_;
-    sl::Translation up_;
-    sl::Translation right_;
-    sl::Translation vertical_;
-
-    sl::Orientation rotation_;
-
-    sl::Transform view_;
-    sl::Transform vpMatrix_;
-    float horizontalFieldOfView_;
-    float verticalFieldOfView_;
-    float znear_;
-    float zfar_;
-};
-
-class Shader {
-public:
-
-    Shader() {}
-    Shader(GLchar* vs, GLchar* fs);
-    ~Shader();
-    GLuint getProgramId();
-
-    static const GLint ATTRIB_VERTICES_POS = 0;
-    static const GLint ATTRIB_COLOR_POS = 1;
-private:
-    bool compile(GLuint &shaderId, GLenum type, GLchar* src);
-    GLuint verterxId_;
-    GLuint fragmentId_;
-    GLuint programId_;
-};
-
-class Simple3DObject {
-public:
-
-    Simple3DObject() {}
-    Simple3DObject(sl::Translation position, bool isStatic);
-    ~Simple3DObject();
-
-    void addPoint(sl::float3 pt, sl::float3 clr);
-    void addFace(sl::float3 p1, sl::float3 p2, sl::float3 p3, sl::float3 clr);
-    void pushToGPU();
-    void clear();
-
-    void setDrawingType(GLenum type);
-
-    void draw();
-
-    void translate(const sl::Translation& t);
-    void setPosition(const sl::Translation& p);
-
-    void setRT(const sl::Transform& mRT);
-
-    void rotate(const sl::Orientation& rot);
-    void rotate(const sl::Rotation& m);
-    void setRotation(const sl::Orientation& rot);
-    void setRotation(const sl::Rotation& m);
-
-    const sl::Translation& getPosition() const;
-
-    sl::Transform getModelMatrix() const;
-private:
-    std::vector<float> vertices_;
-    std::vector<float> colors_;
-    std::vector<unsigned int> indices_;
-
-    bool isStatic_;
-
-    GLenum drawingType_;
-
-    GLuint vaoID_;
-    /*
-            Vertex buffer IDs:
-            - [0]: Vertices coordinates;
-            - [1]: Vertices colors;
-            - [2]: Indices;
-     */
-    GLuint vboID_[3];
-
-    sl::Translation position_;
-    sl::Orientation rotation_;
-
+// How the point cloud reaches the Opengl buffer
+enum class PointCloudBackend {
+    CUDA_INTEROP, // the GPU sl::Mat is copied device to device into the registered Opengl buffer
+    CPU_STREAMING // the CPU sl::Mat is uploaded through a triple buffered, persistently mapped streaming buffer (no CUDA needed)
 };
 
 class PointCloud {
@@ -171,10 +49,11 @@ public:
 
     // Initialize Opengl and Cuda buffers
     // Warning: must be called in the Opengl thread
-    void initialize(sl::Resolution res);
-    // Push a new point cloud
+    void initialize(sl::Resolution res, PointCloudBackend backend = PointCloudBackend::CUDA_INTEROP);
+    // Push a new point cloud, in GPU memory for CUDA_INTEROP, in CPU memory for CPU_STREAMING
+    // nbPoints >= 0: only the first nbPoints points of a contiguous (N x 1) cloud are uploaded and drawn, at most res.area()
     // Warning: can be called from any thread but the mutex "mutexData" must be locked
-    void pushNewPC(sl::Mat &matXYZRGBA);
+    void pushNewPC(sl::Mat &matXYZRGBA, int nbPoints = -1);
     // Update the Opengl buffer
     // Warning: must be called in the Opengl thread
     void update();
@@ -186,14 +65,33 @@ public:
     
     std::mutex mutexData;
 private:
+    void initializeStreaming();
+    void updateStreaming();
+
+    PointCloudBackend backend_;
     sl::Mat matGPU_;
     bool hasNewPCL_ = false;
+    size_t nbPoints_ = 0; // points to upload and draw
     Shader shader_;
     GLuint shMVPMatrixLoc_;
     size_t numBytes_;
     float* xyzrgbaMappedBuf_;
     GLuint bufferGLID_;
     cudaGraphicsResource* bufferCudaID_;
+
+    // CPU_STREAMING: the buffer holds 3 segments, the CPU writes one while the GPU may still read the 2 others
+    static const int NB_SEGMENTS = 3;
+    sl::Mat matCPU_;
+    bool persistent_ = false; // ARB_buffer_storage available, else the buffer is orphaned each frame
+    unsigned char* persistentPtr_ = nullptr;
+    GLsync fences_[NB_SEGMENTS] = {0, 0, 0};
+    int segment_ = 0;
+    GLint drawFirst_ = 0;
+
+    // upload bandwidth measure
+    size_t uploadedBytes_ = 0;
+    double uploadTime_ = 0;
+    std::chrono::steady_clock::time_point lastReport_;
 };
 
 // This class manages input events, window and Opengl rendering pipeline
@@ -203,8 +101,15 @@ public:
     ~GLViewer();
     bool isAvailable();
 
-    GLenum init(int argc, char **argv, sl::CameraParameters param);
-    void updatePointCloud(sl::Mat &matXYZRGBA);
+    // Returned by init() when the offscreen rendering was requested but could not start, the reason is already printed
+    static const GLenum OFFSCREEN_ERROR = 0xFFFF;
+
+    GLenum init(int argc, char **argv, sl::CameraParameters param, PointCloudBackend backend = PointCloudBackend::CUDA_INTEROP);
+    void updatePointCloud(sl::Mat &matXYZRGBA, int nbPoints = -1);
+    // Toggled with the 'n' key: the point cloud colors should be shaded with the surface normals
+    bool isNormalShading() const {
+        return normalShading_;
+    }
 
     void exit();
 private:
@@ -227,6 +132,8 @@ private:
     static void idle();
 
     bool available;
+    std::atomic<bool> normalShading_{true}; // written by the key callback, read by the grab loop
+    bool newFrame_ = false; // offscreen: a point cloud was pushed since the last rendering
 
     enum MOUSE_BUTTON {
         LEFT = 0,
@@ -255,6 +162,9 @@ private:
     CameraGL camera_;
     Shader shader_;
     GLuint shMVPMatrixLoc_;
+
+    // Used in place of the window when ZED_VIEWER_OFFSCREEN is set
+    OffscreenRenderer offscreen_;
 };
 
 #endif /* __VIEWER_INCLUDE__ */
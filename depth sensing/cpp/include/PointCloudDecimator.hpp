@@ -0,0 +1,69 @@
+#ifndef __POINT_CLOUD_DECIMATOR_HDR__
+#define __POINT_CLOUD_DECIMATOR_HDR__
+
+#include <chrono>
+#include <memory>
+
+#include <sl/Camera.hpp>
+
+enum class DecimationMode {
+    VOXEL_GRID, // one point per voxel of fixed size
+    DISTANCE_LOD // the voxel size doubles each time the distance to the camera doubles, beyond 'lod_distance'
+};
+
+struct DecimationParameters {
+    DecimationMode mode = DecimationMode::VOXEL_GRID;
+    float voxel_size = 10.f; // smallest voxel size, in the units of the point cloud
+    float lod_distance = 2000.f; // distance up to which the smallest voxel size is used (DISTANCE_LOD)
+    size_t point_budget = 200000; // maximum number of points kept per frame
+};
+
+/*
+ * Reduces an XYZRGBA point cloud to at most 'point_budget' points before it is uploaded and drawn.
+ *
+ * The first point that falls in a voxel is kept as is (position and color), the next ones are dropped. When a frame
+ * has more occupied voxels than the budget, the extra voxels are dropped and the voxel size is increased for the next
+ * frames; it goes back to 'voxel_size' when the scene gets simpler. The CPU implementation computes the voxel keys with
+ * AVX2 (selected at runtime) or NEON, the GPU implementation inserts the keys in a hash table with atomics.
+ */
+class PointCloudDecimator {
+public:
+    virtual ~PointCloudDecimator() {}
+
+    // 'cloud' is a MEASURE::XYZRGBA in the memory of the decimator. The kept points are written at the beginning of
+    // 'decimated' (allocated as point_budget x 1 F32_C4 in the same memory), returns their number.
+    size_t process(sl::Mat& cloud, sl::Mat& decimated);
+
+    sl::MEM getMemory() const {
+        return memory_;
+    }
+
+    float getVoxelSize() const {
+        return voxel_size_;
+    }
+
+    // MEM::CPU or MEM::GPU implementation
+    static std::unique_ptr<PointCloudDecimator> create(sl::MEM memory, const DecimationParameters& params);
+
+protected:
+    PointCloudDecimator(sl::MEM memory, const DecimationParameters& params);
+
+    // Writes at most 'point_budget' points in 'out', returns the number of occupied voxels of the frame. Over the budget,
+    // the kept voxels are spread over the whole cloud
+    virtual size_t decimate(sl::Mat& cloud, sl::float4* out, float inv_voxel, float inv_lod2) = 0;
+
+    DecimationParameters params_;
+
+private:
+    void adaptVoxelSize(size_t nb_voxels);
+
+    sl::MEM memory_;
+    float voxel_size_;
+
+    // stats, printed every 5 seconds
+    size_t nb_frames_ = 0, nb_in_ = 0, nb_out_ = 0;
+    double time_ = 0;
+    std::chrono::steady_clock::time_point last_report_;
+};
+
+#endif /* __POINT_CLOUD_DECIMATOR_HDR__ */
@@ -0,0 +1,25 @@
+#ifndef __SURFACE_NORMALS_HDR__
+#define __SURFACE_NORMALS_HDR__
+
+#include <sl/Camera.hpp>
+
+/*
+ * Surface normals of an organized point cloud (MEASURE::XYZRGBA or XYZ, F32_C4 in CPU memory), without leaving the sl::Mat.
+ *
+ * The normal of a pixel is the cross product of its horizontal and vertical tangents. Each tangent is the central
+ * difference when both neighbors are valid and at similar distances, else the difference with the closest valid
+ * neighbor, so the normals do not bend across depth discontinuities. A pixel without any valid neighbor on one axis
+ * gets a NAN normal. The normals are unit length and face the camera, in the coordinate system of the point cloud.
+ *
+ * The kernel is vectorized (AVX2 when the CPU supports it, NEON on ARM) and split in row blocks over worker threads
+ * created by the first call. Both functions are meant to be called from a single thread.
+ */
+
+// normals is (re)allocated as F32_C4 (nx, ny, nz, 0) in CPU memory. nb_threads limits the threads used, 0: all the cores.
+void computeNormals(sl::Mat& cloud, sl::Mat& normals, int nb_threads = 0);
+
+// Replaces the color of each point (4th channel of 'cloud') by the color lit by a light placed at the camera:
+// (ambient + (1 - ambient) * cos(angle between the normal and the view ray)). Points without normal get the ambient only.
+void shadeWithNormals(sl::Mat& cloud, sl::Mat& normals, float ambient = 0.25f, int nb_threads = 0);
+
+#endif /* __SURFACE_NORMALS_HDR__ */
@@ -0,0 +1,16 @@
+#ifndef __DECIMATION_GPU_HDR__
+#define __DECIMATION_GPU_HDR__
+
+#include <cuda_runtime.h>
+
+// Key of the empty hash table entries
+#define DECIMATION_EMPTY_KEY 0xFFFFFFFFFFFFFFFFull
+
+// Inserts the voxel key of every valid point of 'cloud' (pitch 'step' in float4) in 'table' (power of 2 size, filled with
+// DECIMATION_EMPTY_KEY), the point that creates a voxel is written to 'out' if there is room in 'budget'.
+// 'nb_voxels' is the number of occupied voxels, copied back from 'd_counter'. Returns the first CUDA error.
+cudaError_t voxelDecimateGPU(const float4* cloud, size_t step, int width, int height, float inv_voxel, float inv_lod2,
+                             unsigned long long* table, unsigned int table_size, unsigned int* d_counter, float4* out, unsigned int budget,
+                             unsigned int& nb_voxels);
+
+#endif /* __DECIMATION_GPU_HDR__ */
@@ -0,0 +1,242 @@
+#include "DepthStatistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CpuFeatures.hpp"
+
+#define NB_CONFIDENCE_BINS 10
+
+// Reductions of one row. bins[j] is the depth bin of pixel j, -1 when invalid
+struct RowAccum {
+    uint64_t valid = 0, occluded = 0, too_close = 0, too_far = 0;
+    double sum = 0.;
+    float min = INFINITY, max = -INFINITY;
+};
+
+struct BinConsts {
+    float offset, scale; // bin = (d - offset) * scale
+    int nb_bins;
+};
+
+static void depthRowScalar(const float* d, int first, int n, const BinConsts& k, int32_t* bins, RowAccum& a) {
+    for (int j = first; j < n; j++) {
+        const float v = d[j];
+        if (std::fabs(v) < INFINITY) {
+            a.valid++;
+            a.sum += v;
+            a.min = std::min(a.min, v);
+            a.max = std::max(a.max, v);
+            const float b = std::min(std::max((v - k.offset) * k.scale, 0.f), static_cast<float> (k.nb_bins - 1));
+            bins[j] = static_cast<int32_t> (b);
+        } else {
+            bins[j] = -1;
+            if (v != v) a.occluded++;
+            else if (v < 0.f) a.too_close++;
+            else a.too_far++;
+        }
+    }
+}
+
+static void confidenceRowScalar(const float* c, int first, int n, uint64_t* hist) {
+    for (int j = first; j < n; j++) {
+        const float v = c[j];
+        if (v >= 0.f && v <= 100.f) // false for NAN
+            hist[std::min(static_cast<int> (v * 0.1f), NB_CONFIDENCE_BINS - 1)]++;
+    }
+}
+
+#ifdef CPU_AVX2
+CPU_AVX2_TARGET static inline float hmin(__m256 v) {
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_min_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+}
+
+CPU_AVX2_TARGET static inline float hmax(__m256 v) {
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+}
+
+CPU_AVX2_TARGET static int depthRowAVX2(const float* d, int n, const BinConsts& k, int32_t* bins, RowAccum& a) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 minus_inf = _mm256_set1_ps(-INFINITY);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 offset = _mm256_set1_ps(k.offset);
+    const __m256 scale = _mm256_set1_ps(k.scale);
+    const __m256 last_bin = _mm256_set1_ps(static_cast<float> (k.nb_bins - 1));
+    const __m256i invalid_bin = _mm256_set1_epi32(-1);
+
+    // the row sum is accumulated in 2 double vectors, a float sum of thousands of depths in mm would lose precision
+    __m256d sum_lo = _mm256_setzero_pd(), sum_hi = _mm256_setzero_pd();
+    __m256 vmin = inf, vmax = minus_inf;
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const __m256 v = _mm256_loadu_ps(d + j);
+        const __m256 valid = _mm256_cmp_ps(_mm256_and_ps(v, abs_mask), inf, _CMP_LT_OQ);
+        const int valid_bits = _mm256_movemask_ps(valid);
+        if (valid_bits != 0xFF) {
+            a.occluded += _mm_popcnt_u32(_mm256_movemask_ps(_mm256_cmp_ps(v, v, _CMP_UNORD_Q)));
+            a.too_close += _mm_popcnt_u32(_mm256_movemask_ps(_mm256_cmp_ps(v, minus_inf, _CMP_EQ_OQ)));
+            a.too_far += _mm_popcnt_u32(_mm256_movemask_ps(_mm256_cmp_ps(v, inf, _CMP_EQ_OQ)));
+        }
+        a.valid += _mm_popcnt_u32(valid_bits);
+
+        const __m256 vz = _mm256_and_ps(valid, v); // 0 for the invalid pixels
+        sum_lo = _mm256_add_pd(sum_lo, _mm256_cvtps_pd(_mm256_castps256_ps128(vz)));
+        sum_hi = _mm256_add_pd(sum_hi, _mm256_cvtps_pd(_mm256_extractf128_ps(vz, 1)));
+        vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(inf, v, valid));
+        vmax = _mm256_max_ps(vmax, _mm256_blendv_ps(minus_inf, v, valid));
+
+        const __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(vz, offset), scale), zero), last_bin);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*> (bins + j), _mm256_blendv_epi8(invalid_bin, _mm256_cvttps_epi32(b), _mm256_castps_si256(valid)));
+    }
+    alignas(32) double s[4];
+    _mm256_store_pd(s, _mm256_add_pd(sum_lo, sum_hi));
+    a.sum += (s[0] + s[1]) + (s[2] + s[3]);
+    a.min = std::min(a.min, hmin(vmin));
+    a.max = std::max(a.max, hmax(vmax));
+    return j;
+}
+
+CPU_AVX2_TARGET static int confidenceRowAVX2(const float* c, int n, uint64_t* hist) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 hundred = _mm256_set1_ps(100.f);
+    const __m256 tenth = _mm256_set1_ps(0.1f);
+    const __m256i last_bin = _mm256_set1_epi32(NB_CONFIDENCE_BINS - 1);
+    alignas(32) int32_t bins[8];
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const __m256 v = _mm256_loadu_ps(c + j);
+        const int valid = _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(v, hundred, _CMP_LE_OQ)));
+        _mm256_store_si256(reinterpret_cast<__m256i*> (bins), _mm256_min_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(v, tenth)), last_bin));
+        for (int l = 0; l < 8; l++)
+            if (valid & (1 << l)) hist[bins[l]]++;
+    }
+    return j;
+}
+#endif
+
+DepthStatistics::DepthStatistics(float min_depth, float max_depth, int nb_depth_bins)
+: min_depth_(min_depth), max_depth_(std::max(max_depth, min_depth + 1.f)), nb_depth_bins_(std::max(1, nb_depth_bins)) {
+    clear();
+}
+
+void DepthStatistics::clear() {
+    frames_ = grab_errors_ = 0;
+    pixels_ = valid_ = occluded_ = too_close_ = too_far_ = 0;
+    valid_ratio_min_ = 1.;
+    depth_sum_ = 0.;
+    depth_min_ = INFINITY;
+    depth_max_ = -INFINITY;
+    depth_hist_.assign(nb_depth_bins_, 0);
+    confidence_hist_.assign(NB_CONFIDENCE_BINS, 0);
+    grab_ms_.clear();
+    retrieve_ms_.clear();
+}
+
+void DepthStatistics::addGrabError() {
+    grab_errors_++;
+}
+
+void DepthStatistics::addFrame(sl::Mat& depth, sl::Mat& confidence, double grab_ms, double retrieve_ms) {
+    const int width = depth.getWidth(), height = depth.getHeight();
+    const BinConsts k = {min_depth_, nb_depth_bins_ / (max_depth_ - min_depth_), nb_depth_bins_};
+    bins_.resize(width);
+
+    RowAccum a;
+    const float* depth_ptr = depth.getPtr<float>(sl::MEM::CPU);
+    const size_t depth_step = depth.getStep(sl::MEM::CPU);
+    for (int v = 0; v < height; v++) {
+        const float* row = depth_ptr + v * depth_step;
+        int done = 0;
+#ifdef CPU_AVX2
+        if (cpuHasAVX2()) done = depthRowAVX2(row, width, k, bins_.data(), a);
+#endif
+        depthRowScalar(row, done, width, k, bins_.data(), a);
+        for (int u = 0; u < width; u++)
+            if (bins_[u] >= 0) depth_hist_[bins_[u]]++;
+    }
+
+    if (confidence.isInit() && confidence.getWidth() == depth.getWidth() && confidence.getHeight() == depth.getHeight()) {
+        const float* conf_ptr = confidence.getPtr<float>(sl::MEM::CPU);
+        const size_t conf_step = confidence.getStep(sl::MEM::CPU);
+        for (int v = 0; v < height; v++) {
+            const float* row = conf_ptr + v * conf_step;
+            int done = 0;
+#ifdef CPU_AVX2
+            if (cpuHasAVX2()) done = confidenceRowAVX2(row, width, confidence_hist_.data());
+#endif
+            confidenceRowScalar(row, done, width, confidence_hist_.data());
+        }
+    }
+
+    const uint64_t area = static_cast<uint64_t> (width) * height;
+    frames_++;
+    pixels_ += area;
+    valid_ += a.valid;
+    occluded_ += a.occluded;
+    too_close_ += a.too_close;
+    too_far_ += a.too_far;
+    depth_sum_ += a.sum;
+    depth_min_ = std::min(depth_min_, a.min);
+    depth_max_ = std::max(depth_max_, a.max);
+    if (area) valid_ratio_min_ = std::min(valid_ratio_min_, a.valid / static_cast<double> (area));
+    grab_ms_.push_back(grab_ms);
+    retrieve_ms_.push_back(retrieve_ms);
+}
+
+static void writeLatency(std::ostream& out, std::vector<double>& values) {
+    if (values.empty()) {
+        out << "null";
+        return;
+    }
+    double sum = 0.;
+    for (double v : values) sum += v;
+    std::sort(values.begin(), values.end());
+    auto percentile = [&](double p) {
+        return values[std::min(values.size() - 1, static_cast<size_t> (p * values.size()))];
+    };
+    out << "{\"mean\": " << sum / values.size() << ", \"p50\": " << percentile(0.5) << ", \"p95\": " << percentile(0.95)
+        << ", \"max\": " << values.back() << "}";
+}
+
+template<typename T>
+static void writeArray(std::ostream& out, const std::vector<T>& values) {
+    out << "[";
+    for (size_t i = 0; i < values.size(); i++)
+        out << (i ? ", " : "") << values[i];
+    out << "]";
+}
+
+void DepthStatistics::writeSummary(std::ostream& out, uint64_t timestamp_ns, double window_duration_s) {
+    const double pixels = std::max<double>(1., static_cast<double> (pixels_));
+    out << "{\"timestamp_ns\": " << timestamp_ns
+        << ", \"frames\": " << frames_
+        << ", \"fps\": " << (window_duration_s > 0. ? frames_ / window_duration_s : 0.)
+        << ", \"grab_errors\": " << grab_errors_;
+    if (frames_) {
+        out << ", \"valid_ratio\": {\"mean\": " << valid_ / pixels << ", \"min\": " << valid_ratio_min_ << "}"
+            << ", \"invalid_ratio\": {\"occluded\": " << occluded_ / pixels << ", \"too_close\": " << too_close_ / pixels
+            << ", \"too_far\": " << too_far_ / pixels << "}";
+        if (valid_)
+            out << ", \"depth\": {\"min\": " << depth_min_ << ", \"max\": " << depth_max_ << ", \"mean\": " << depth_sum_ / valid_;
+        else
+            out << ", \"depth\": {\"min\": null, \"max\": null, \"mean\": null";
+        out << ", \"histogram_range\": [" << min_depth_ << ", " << max_depth_ << "], \"histogram\": ";
+        writeArray(out, depth_hist_);
+        out << "}, \"confidence_histogram\": ";
+        writeArray(out, confidence_hist_);
+        out << ", \"latency_ms\": {\"grab\": ";
+        writeLatency(out, grab_ms_);
+        out << ", \"retrieve\": ";
+        writeLatency(out, retrieve_ms_);
+        out << "}";
+    }
+    out << "}" << std::endl;
+    clear();
+}
@@ -0,0 +1,205 @@
+#include "DepthToPointCloud.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "CpuFeatures.hpp"
+
+// One output row. The camera BGRA pixel is packed as RGBA, the layout of MEASURE::XYZRGBA.
+struct RowArgs {
+    const float* depth; // first pixel of the row (roi.x)
+    const uint32_t* bgra; // same, nullptr without color
+    const float* kx; // per output column
+    float ky, sz;
+    int n, stride;
+    float* out;
+};
+
+static inline uint32_t bgraToRgba(uint32_t p) {
+    return (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+}
+
+static void rowScalar(const RowArgs& a, int first, bool rgba) {
+    const int ch = rgba ? 4 : 3;
+    for (int j = first; j < a.n; j++) {
+        const float z = a.depth[j * a.stride];
+        float* o = a.out + j * ch;
+        o[0] = a.kx[j] * z;
+        o[1] = a.ky * z;
+        o[2] = a.sz * z;
+        if (rgba) {
+            uint32_t c = bgraToRgba(a.bgra[j * a.stride]);
+            memcpy(o + 3, &c, 4);
+        }
+    }
+}
+
+#ifdef CPU_AVX2
+CPU_AVX2_TARGET static int rowAVX2(const RowArgs& a, bool rgba) {
+    const __m256 ky = _mm256_set1_ps(a.ky);
+    const __m256 sz = _mm256_set1_ps(a.sz);
+    const __m256i idx = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(a.stride));
+    // swaps bytes 0 and 2 of each pixel: BGRA -> RGBA
+    const __m256i swap_rb = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int j = 0;
+    for (; j + 8 <= a.n; j += 8) {
+        const float* d = a.depth + j * a.stride;
+        const __m256 z = (a.stride == 1) ? _mm256_loadu_ps(d) : _mm256_i32gather_ps(d, idx, 4);
+        const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(a.kx + j), z);
+        const __m256 y = _mm256_mul_ps(ky, z);
+        const __m256 zz = _mm256_mul_ps(sz, z);
+
+        if (rgba) {
+            const int* c = reinterpret_cast<const int*> (a.bgra + j * a.stride);
+            __m256i clr = (a.stride == 1) ? _mm256_loadu_si256(reinterpret_cast<const __m256i*> (c)) : _mm256_i32gather_epi32(c, idx, 4);
+            const __m256 w = _mm256_castsi256_ps(_mm256_shuffle_epi8(clr, swap_rb));
+
+            // 4x8 transpose: X, Y, Z, W vectors to 8 XYZW points
+            const __m256 t0 = _mm256_unpacklo_ps(x, y);
+            const __m256 t1 = _mm256_unpackhi_ps(x, y);
+            const __m256 t2 = _mm256_unpacklo_ps(zz, w);
+            const __m256 t3 = _mm256_unpackhi_ps(zz, w);
+            const __m256 p0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m256 p1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 p2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m256 p3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+            float* o = a.out + j * 4;
+            _mm256_storeu_ps(o, _mm256_permute2f128_ps(p0, p1, 0x20));
+            _mm256_storeu_ps(o + 8, _mm256_permute2f128_ps(p2, p3, 0x20));
+            _mm256_storeu_ps(o + 16, _mm256_permute2f128_ps(p0, p1, 0x31));
+            _mm256_storeu_ps(o + 24, _mm256_permute2f128_ps(p2, p3, 0x31));
+        } else {
+            alignas(32) float vx[8], vy[8], vz[8];
+            _mm256_store_ps(vx, x);
+            _mm256_store_ps(vy, y);
+            _mm256_store_ps(vz, zz);
+            float* o = a.out + j * 3;
+            for (int k = 0; k < 8; k++) {
+                o[k * 3] = vx[k];
+                o[k * 3 + 1] = vy[k];
+                o[k * 3 + 2] = vz[k];
+            }
+        }
+    }
+    return j;
+}
+#endif
+
+#ifdef CPU_NEON
+static int rowNEON(const RowArgs& a, bool rgba) {
+    if (a.stride != 1) return 0; // no gather, the strided rows are done by the scalar loop
+    const float32x4_t ky = vdupq_n_f32(a.ky);
+    const float32x4_t sz = vdupq_n_f32(a.sz);
+    int j = 0;
+    for (; j + 4 <= a.n; j += 4) {
+        const float32x4_t z = vld1q_f32(a.depth + j);
+        if (rgba) {
+            uint32x4_t c = vld1q_u32(a.bgra + j);
+            c = vorrq_u32(vorrq_u32(vandq_u32(c, vdupq_n_u32(0xFF00FF00u)), vandq_u32(vshrq_n_u32(c, 16), vdupq_n_u32(0xFFu))),
+                          vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0xFFu)), 16));
+            float32x4x4_t p;
+            p.val[0] = vmulq_f32(vld1q_f32(a.kx + j), z);
+            p.val[1] = vmulq_f32(ky, z);
+            p.val[2] = vmulq_f32(sz, z);
+            p.val[3] = vreinterpretq_f32_u32(c);
+            vst4q_f32(a.out + j * 4, p); // interleaves to XYZW
+        } else {
+            float32x4x3_t p;
+            p.val[0] = vmulq_f32(vld1q_f32(a.kx + j), z);
+            p.val[1] = vmulq_f32(ky, z);
+            p.val[2] = vmulq_f32(sz, z);
+            vst3q_f32(a.out + j * 3, p);
+        }
+    }
+    return j;
+}
+#endif
+
+static void processRow(const RowArgs& a, bool rgba) {
+    int done = 0;
+#ifdef CPU_AVX2
+    if (cpuHasAVX2()) done = rowAVX2(a, rgba);
+#endif
+#ifdef CPU_NEON
+    done = rowNEON(a, rgba);
+#endif
+    rowScalar(a, done, rgba);
+}
+
+DepthToPointCloud::DepthToPointCloud(const sl::CameraParameters& calib, sl::COORDINATE_SYSTEM coord, int nb_threads)
+: calib_(calib), workers_(nb_threads) {
+    // The depth map is the Z of the IMAGE coordinate system (x right, y down, z forward)
+    switch (coord) {
+        case sl::COORDINATE_SYSTEM::LEFT_HANDED_Y_UP:
+            sign_y_ = -1.f;
+            sign_z_ = 1.f;
+            break;
+        case sl::COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP:
+            sign_y_ = -1.f;
+            sign_z_ = -1.f;
+            break;
+        default:
+            if (coord != sl::COORDINATE_SYSTEM::IMAGE)
+                std::cout << "[Sample][Warning] DepthToPointCloud: unsupported coordinate system, using IMAGE" << std::endl;
+            sign_y_ = 1.f;
+            sign_z_ = 1.f;
+            break;
+    }
+}
+
+void DepthToPointCloud::compute(sl::Mat& depth, sl::Mat& xyz, sl::Rect roi, int stride) {
+    run(depth, nullptr, xyz, roi, stride, false);
+}
+
+void DepthToPointCloud::compute(sl::Mat& depth, sl::Mat& image, sl::Mat& xyzrgba, sl::Rect roi, int stride) {
+    run(depth, &image, xyzrgba, roi, stride, true);
+}
+
+void DepthToPointCloud::run(sl::Mat& depth, sl::Mat* image, sl::Mat& out, sl::Rect roi, int stride, bool rgba) {
+    stride = std::max(1, stride);
+    const int width = depth.getWidth(), height = depth.getHeight();
+    if (roi.isEmpty() || !roi.isContained(sl::Resolution(width, height)))
+        roi = sl::Rect(0, 0, width, height);
+
+    const int out_w = (roi.width + stride - 1) / stride;
+    const int out_h = (roi.height + stride - 1) / stride;
+    const sl::MAT_TYPE out_type = rgba ? sl::MAT_TYPE::F32_C4 : sl::MAT_TYPE::F32_C3;
+    if (!out.isInit() || out.getWidth() != (size_t) out_w || out.getHeight() != (size_t) out_h || out.getDataType() != out_type)
+        out.alloc(sl::Resolution(out_w, out_h), out_type, sl::MEM::CPU);
+
+    // intrinsics of the calibration resolution, scaled to the depth resolution
+    const float scale = width / static_cast<float>(calib_.image_size.width);
+    const float fx = calib_.fx * scale, fy = calib_.fy * scale;
+    const float cx = calib_.cx * scale, cy = calib_.cy * scale;
+    kx_.resize(out_w);
+    for (int j = 0; j < out_w; j++)
+        kx_[j] = (roi.x + j * stride - cx) / fx;
+
+    const float* depth_ptr = depth.getPtr<float>(sl::MEM::CPU);
+    const size_t depth_step = depth.getStep(sl::MEM::CPU);
+    const uint32_t* image_ptr = image ? reinterpret_cast<const uint32_t*> (image->getPtr<sl::uchar4>(sl::MEM::CPU)) : nullptr;
+    const size_t image_step = image ? image->getStep(sl::MEM::CPU) : 0;
+    float* out_ptr = out.getPtr<float>(sl::MEM::CPU);
+    const size_t out_step = out.getStepBytes(sl::MEM::CPU) / sizeof(float);
+
+    auto process_rows = [&](int first, int last) {
+        RowArgs a;
+        a.kx = kx_.data();
+        a.sz = sign_z_;
+        a.n = out_w;
+        a.stride = stride;
+        for (int i = first; i < last; i++) {
+            const int v = roi.y + i * stride;
+            a.depth = depth_ptr + v * depth_step + roi.x;
+            a.bgra = image_ptr ? image_ptr + v * image_step + roi.x : nullptr;
+            a.ky = sign_y_ * (v - cy) / fy;
+            a.out = out_ptr + i * out_step;
+            processRow(a, rgba);
+        }
+    };
+
+    workers_.parallelRows(out_h, process_rows);
+}
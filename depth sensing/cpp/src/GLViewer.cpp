@@ -1,5 +1,8 @@
 #include "GLViewer.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 
 
 
@@ -54,13 +57,20 @@ GLViewer::~GLViewer() {}
 void GLViewer::exit() {
     if (currentInstance_) {
         //pointCloud_.close();
+        offscreen_.close();
         available = false;
     }
 }
 
 bool GLViewer::isAvailable() {
-    if(available)
-        glutMainLoopEvent();
+    if (available) {
+        if (offscreen_.isInitialized()) {
+            // No window events, one frame per new point cloud
+            if (newFrame_)
+                render();
+        } else
+            glutMainLoopEvent();
+    }
     return available;
 }
 
@@ -94,10 +104,10 @@ Simple3DObject createFrustum(sl::CameraParameters param) {
 
     sl::float3 clr(0.2f, 0.5f, 0.8f);
 
-    it.addFace(cam_0, cam_1, cam_2, clr);
-    it.addFace(cam_0, cam_2, cam_3, clr);
-    it.addFace(cam_0, cam_3, cam_4, clr);
-    it.addFace(cam_0, cam_4, cam_1, clr);
+    it.addTriangle(cam_0, cam_1, cam_2, clr);
+    it.addTriangle(cam_0, cam_2, cam_3, clr);
+    it.addTriangle(cam_0, cam_3, cam_4, clr);
+    it.addTriangle(cam_0, cam_4, cam_1, clr);
     
     it.setDrawingType(GL_TRIANGLES);
     return it;
@@ -105,25 +115,31 @@ Simple3DObject createFrustum(sl::CameraParameters param) {
 
 void CloseFunc(void) { if(currentInstance_)  currentInstance_->exit();}
 
-GLenum GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
-
-    glutInit(&argc, argv);
-    int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
-    int wnd_h = glutGet(GLUT_SCREEN_HEIGHT) *0.9;
-    glutInitWindowSize(wnd_w*0.9, wnd_h*0.9);
-    glutInitWindowPosition(wnd_w*0.05, wnd_h*0.05);
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
-    glutCreateWindow("ZED Depth Sensing");
-
-    GLenum err = glewInit();
-    if (GLEW_OK != err)
-        return err;
-
-
-    glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+GLenum GLViewer::init(int argc, char **argv, sl::CameraParameters param, PointCloudBackend backend) {
+
+    GLenum err = GLEW_OK;
+    if (OffscreenRenderer::isRequested()) {
+        // Headless, at the point cloud resolution
+        if (!offscreen_.init(param.image_size.width, param.image_size.height, false))
+            return OFFSCREEN_ERROR;
+    } else {
+        glutInit(&argc, argv);
+        int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
+        int wnd_h = glutGet(GLUT_SCREEN_HEIGHT) *0.9;
+        glutInitWindowSize(wnd_w*0.9, wnd_h*0.9);
+        glutInitWindowPosition(wnd_w*0.05, wnd_h*0.05);
+        glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
+        glutCreateWindow("ZED Depth Sensing");
+
+        err = glewInit();
+        if (GLEW_OK != err)
+            return err;
+
+        glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+    }
     glEnable(GL_DEPTH_TEST);
 
-    pointCloud_.initialize(param.image_size);
+    pointCloud_.initialize(param.image_size, backend);
 
     // Compile and create the shader
     shader_ = Shader(VERTEX_SHADER, FRAGMENT_SHADER);
@@ -132,6 +148,9 @@ GLenum GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
     // Create the camera
     camera_ = CameraGL(sl::Translation(0, 0, 0), sl::Translation(0, 0, -100));
     camera_.setOffsetFromPosition(sl::Translation(0, 0, 5000));
+    // No reshape event offscreen, the projection follows the framebuffer size
+    if (offscreen_.isInitialized())
+        reshapeCallback(offscreen_.getWidth(), offscreen_.getHeight());
 
     frustum = createFrustum(param);
     frustum.pushToGPU();
@@ -140,13 +159,15 @@ GLenum GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
     bckgrnd_clr /= 255.f;
 
     // Map glut function on this class methods
-    glutDisplayFunc(GLViewer::drawCallback);
-    glutMouseFunc(GLViewer::mouseButtonCallback);
-    glutMotionFunc(GLViewer::mouseMotionCallback);
-    glutReshapeFunc(GLViewer::reshapeCallback);
-    glutKeyboardFunc(GLViewer::keyPressedCallback);
-    glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
-    glutCloseFunc(CloseFunc);
+    if (!offscreen_.isInitialized()) {
+        glutDisplayFunc(GLViewer::drawCallback);
+        glutMouseFunc(GLViewer::mouseButtonCallback);
+        glutMotionFunc(GLViewer::mouseMotionCallback);
+        glutReshapeFunc(GLViewer::reshapeCallback);
+        glutKeyboardFunc(GLViewer::keyPressedCallback);
+        glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
+        glutCloseFunc(CloseFunc);
+    }
 
     available = true;
     return err;
@@ -154,20 +175,28 @@ GLenum GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
 
 void GLViewer::render() {
     if (available) {
+        if (offscreen_.isInitialized())
+            offscreen_.beginFrame();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(bckgrnd_clr.r, bckgrnd_clr.g, bckgrnd_clr.b, 1.f);
         glLineWidth(2.f);
         glPointSize(1.f);
         update();
         draw();
-        glutSwapBuffers();
-        glutPostRedisplay();
+        newFrame_ = false;
+        if (offscreen_.isInitialized())
+            offscreen_.endFrame();
+        else {
+            glutSwapBuffers();
+            glutPostRedisplay();
+        }
     }
 }
 
-void GLViewer::updatePointCloud(sl::Mat &matXYZRGBA) {
+void GLViewer::updatePointCloud(sl::Mat &matXYZRGBA, int nbPoints) {
     pointCloud_.mutexData.lock();
-    pointCloud_.pushNewPC(matXYZRGBA);
+    pointCloud_.pushNewPC(matXYZRGBA, nbPoints);
+    newFrame_ = true;
     pointCloud_.mutexData.unlock();
 }
 
@@ -178,6 +207,9 @@ void GLViewer::update() {
         return;
     }
 
+    if (keyStates_['n'] == KEY_STATE::UP || keyStates_['N'] == KEY_STATE::UP)
+        normalShading_ = !normalShading_;
+
     // Rotate camera with mouse
     if (mouseButton_[MOUSE_BUTTON::LEFT]) {
         camera_.rotate(sl::Rotation((float) mouseMotion_[1] * MOUSE_R_SENSITIVITY, camera_.getRight()));
@@ -279,217 +311,6 @@ void GLViewer::idle() {
     glutPostRedisplay();
 }
 
-Simple3DObject::Simple3DObject(sl::Translation position, bool isStatic): isStatic_(isStatic) {
-    vaoID_ = 0;
-    drawingType_ = GL_TRIANGLES;
-    position_ = position;
-    rotation_.setIdentity();
-}
-
-Simple3DObject::~Simple3DObject() {
-    if (vaoID_ != 0) {
-        glDeleteBuffers(3, vboID_);
-        glDeleteVertexArrays(1, &vaoID_);
-    }
-}
-
-void Simple3DObject::addPoint(sl::float3 pt, sl::float3 clr) {
-    vertices_.push_back(pt.x);
-    vertices_.push_back(pt.y);
-    vertices_.push_back(pt.z);
-    colors_.push_back(clr.r);
-    colors_.push_back(clr.g);
-    colors_.push_back(clr.b);
-    indices_.push_back((int) indices_.size());
-}
-
-void Simple3DObject::addFace(sl::float3 p1, sl::float3 p2, sl::float3 p3, sl::float3 clr) {
-    vertices_.push_back(p1.x);
-    vertices_.push_back(p1.y);
-    vertices_.push_back(p1.z);
-
-    colors_.push_back(clr.r);
-    colors_.push_back(clr.g);
-    colors_.push_back(clr.b);
-
-    vertices_.push_back(p2.x);
-    vertices_.push_back(p2.y);
-    vertices_.push_back(p2.z);
-
-    colors_.push_back(clr.r);
-    colors_.push_back(clr.g);
-    colors_.push_back(clr.b);
-
-    vertices_.push_back(p3.x);
-    vertices_.push_back(p3.y);
-    vertices_.push_back(p3.z);
-
-    colors_.push_back(clr.r);
-    colors_.push_back(clr.g);
-    colors_.push_back(clr.b);
-
-    indices_.push_back((int) indices_.size());
-    indices_.push_back((int) indices_.size());
-    indices_.push_back((int) indices_.size());
-}
-
-void Simple3DObject::pushToGPU() {
-    if (!isStatic_ || vaoID_ == 0) {
-        if (vaoID_ == 0) {
-            glGenVertexArrays(1, &vaoID_);
-            glGenBuffers(3, vboID_);
-        }
-        glBindVertexArray(vaoID_);
-        glBindBuffer(GL_ARRAY_BUFFER, vboID_[0]);
-        glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(float), &vertices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(Shader::ATTRIB_VERTICES_POS, 3, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(Shader::ATTRIB_VERTICES_POS);
-
-        glBindBuffer(GL_ARRAY_BUFFER, vboID_[1]);
-        glBufferData(GL_ARRAY_BUFFER, colors_.size() * sizeof(float), &colors_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(Shader::ATTRIB_COLOR_POS, 3, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(Shader::ATTRIB_COLOR_POS);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboID_[2]);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned int), &indices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-
-        glBindVertexArray(0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
-}
-
-void Simple3DObject::clear() {
-    vertices_.clear();
-    colors_.clear();
-    indices_.clear();
-}
-
-void Simple3DObject::setDrawingType(GLenum type) {
-    drawingType_ = type;
-}
-
-void Simple3DObject::draw() {
-    glBindVertexArray(vaoID_);
-    glDrawElements(drawingType_, (GLsizei) indices_.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-}
-
-void Simple3DObject::translate(const sl::Translation& t) {
-    position_ = position_ + t;
-}
-
-void Simple3DObject::setPosition(const sl::Translation& p) {
-    position_ = p;
-}
-
-void Simple3DObject::setRT(const sl::Transform& mRT) {
-    position_ = mRT.getTranslation();
-    rotation_ = mRT.getOrientation();
-}
-
-void Simple3DObject::rotate(const sl::Orientation& rot) {
-    rotation_ = rot * rotation_;
-}
-
-void Simple3DObject::rotate(const sl::Rotation& m) {
-    this->rotate(sl::Orientation(m));
-}
-
-void Simple3DObject::setRotation(const sl::Orientation& rot) {
-    rotation_ = rot;
-}
-
-void Simple3DObject::setRotation(const sl::Rotation& m) {
-    this->setRotation(sl::Orientation(m));
-}
-
-const sl::Translation& Simple3DObject::getPosition() const {
-    return position_;
-}
-
-sl::Transform Simple3DObject::getModelMatrix() const {
-    sl::Transform tmp;
-    tmp.setOrientation(rotation_);
-    tmp.setTranslation(position_);
-    return tmp;
-}
-
-Shader::Shader(GLchar* vs, GLchar* fs) {
-    if (!compile(verterxId_, GL_VERTEX_SHADER, vs)) {
-        print("ERROR: while compiling vertex shader");
-    }
-    if (!compile(fragmentId_, GL_FRAGMENT_SHADER, fs)) {
-        print("ERROR: while compiling fragment shader");
-    }
-
-    programId_ = glCreateProgram();
-
-    glAttachShader(programId_, verterxId_);
-    glAttachShader(programId_, fragmentId_);
-
-    glBindAttribLocation(programId_, ATTRIB_VERTICES_POS, "in_vertex");
-    glBindAttribLocation(programId_, ATTRIB_COLOR_POS, "in_texCoord");
-
-    glLinkProgram(programId_);
-
-    GLint errorlk(0);
-    glGetProgramiv(programId_, GL_LINK_STATUS, &errorlk);
-    if (errorlk != GL_TRUE) {
-        print("ERROR: while linking shader : ");
-        GLint errorSize(0);
-        glGetProgramiv(programId_, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(programId_, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteProgram(programId_);
-    }
-}
-
-Shader::~Shader() {
-    if (verterxId_ != 0)
-        glDeleteShader(verterxId_);
-    if (fragmentId_ != 0)
-        glDeleteShader(fragmentId_);
-    if (programId_ != 0)
-        glDeleteShader(programId_);
-}
-
-GLuint Shader::getProgramId() {
-    return programId_;
-}
-
-bool Shader::compile(GLuint &shaderId, GLenum type, GLchar* src) {
-    shaderId = glCreateShader(type);
-    if (shaderId == 0) {
-        return false;
-    }
-    glShaderSource(shaderId, 1, (const char**) &src, 0);
-    glCompileShader(shaderId);
-
-    GLint errorCp(0);
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &errorCp);
-    if (errorCp != GL_TRUE) {
-        print("ERROR: while compiling shader : ");
-        GLint errorSize(0);
-        glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(shaderId, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteShader(shaderId);
-        return false;
-    }
-    return true;
-}
-
 GLchar* POINTCLOUD_VERTEX_SHADER =
 "#version 330 core\n"
 "layout(location = 0) in vec4 in_VertexRGBA;\n"
@@ -529,9 +350,34 @@ void PointCloud::close() {
         checkError(cudaGraphicsUnmapResources(1, &bufferCudaID_, 0));
         glDeleteBuffers(1, &bufferGLID_);
     }
+    if (matCPU_.isInit()) {
+        matCPU_.free();
+        for (auto& fence : fences_)
+            if (fence) {
+                glDeleteSync(fence);
+                fence = 0;
+            }
+        if (persistentPtr_) {
+            glBindBuffer(GL_ARRAY_BUFFER, bufferGLID_);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            persistentPtr_ = nullptr;
+        }
+        glDeleteBuffers(1, &bufferGLID_);
+    }
 }
 
-void PointCloud::initialize(sl::Resolution res) {
+void PointCloud::initialize(sl::Resolution res, PointCloudBackend backend) {
+    backend_ = backend;
+    shader_ = Shader(POINTCLOUD_VERTEX_SHADER, POINTCLOUD_FRAGMENT_SHADER);
+    shMVPMatrixLoc_ = glGetUniformLocation(shader_.getProgramId(), "u_mvpMatrix");
+
+    if (backend_ == PointCloudBackend::CPU_STREAMING) {
+        matCPU_.alloc(res, sl::MAT_TYPE::F32_C4, sl::MEM::CPU);
+        initializeStreaming();
+        return;
+    }
+
     glGenBuffers(1, &bufferGLID_);
     glBindBuffer(GL_ARRAY_BUFFER, bufferGLID_);
     glBufferData(GL_ARRAY_BUFFER, res.area() * 4 * sizeof(float), 0, GL_DYNAMIC_DRAW);
@@ -539,31 +385,112 @@ void PointCloud::initialize(sl::Resolution res) {
     
     checkError(cudaGraphicsGLRegisterBuffer(&bufferCudaID_, bufferGLID_, cudaGraphicsRegisterFlagsNone));
 
-    shader_ = Shader(POINTCLOUD_VERTEX_SHADER, POINTCLOUD_FRAGMENT_SHADER);
-    shMVPMatrixLoc_ = glGetUniformLocation(shader_.getProgramId(), "u_mvpMatrix");
-
     matGPU_.alloc(res, sl::MAT_TYPE::F32_C4, sl::MEM::GPU);
 
     checkError(cudaGraphicsMapResources(1, &bufferCudaID_, 0));
     checkError(cudaGraphicsResourceGetMappedPointer((void**) &xyzrgbaMappedBuf_, &numBytes_, bufferCudaID_));
 }
 
-void PointCloud::pushNewPC(sl::Mat &matXYZRGBA) {
-    if (matGPU_.isInit()) {
-        matGPU_.setFrom(matXYZRGBA, sl::COPY_TYPE::GPU_GPU);
-        hasNewPCL_ = true;
+void PointCloud::initializeStreaming() {
+    numBytes_ = matCPU_.getResolution().area() * 4 * sizeof(float);
+    persistent_ = GLEW_ARB_buffer_storage != 0;
+
+    glGenBuffers(1, &bufferGLID_);
+    glBindBuffer(GL_ARRAY_BUFFER, bufferGLID_);
+    if (persistent_) {
+        // Mapped once for the whole run, coherent so that no flush is needed. The fences tell when a segment is free again
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, numBytes_ * NB_SEGMENTS, 0, flags);
+        persistentPtr_ = static_cast<unsigned char*> (glMapBufferRange(GL_ARRAY_BUFFER, 0, numBytes_ * NB_SEGMENTS, flags));
+        if (!persistentPtr_) {
+            print("Persistent mapping failed, using buffer orphaning");
+            persistent_ = false;
+            glDeleteBuffers(1, &bufferGLID_);
+            glGenBuffers(1, &bufferGLID_);
+            glBindBuffer(GL_ARRAY_BUFFER, bufferGLID_);
+        }
+    }
+    if (!persistent_)
+        glBufferData(GL_ARRAY_BUFFER, numBytes_, 0, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    print(std::string("Point cloud upload from CPU memory, ") + (persistent_ ? "persistent mapped triple buffer" : "orphaned buffer"));
+    lastReport_ = std::chrono::steady_clock::now();
+}
+
+void PointCloud::pushNewPC(sl::Mat &matXYZRGBA, int nbPoints) {
+    sl::Mat& dst = (backend_ == PointCloudBackend::CPU_STREAMING) ? matCPU_ : matGPU_;
+    if (!dst.isInit()) return;
+    const sl::MEM mem = (backend_ == PointCloudBackend::CPU_STREAMING) ? sl::MEM::CPU : sl::MEM::GPU;
+
+    if (nbPoints < 0) {
+        dst.setFrom(matXYZRGBA, (mem == sl::MEM::CPU) ? sl::COPY_TYPE::CPU_CPU : sl::COPY_TYPE::GPU_GPU);
+        nbPoints_ = dst.getResolution().area();
+    } else {
+        // decimated cloud: only the valid part is copied
+        nbPoints_ = std::min(static_cast<size_t> (nbPoints), dst.getResolution().area());
+        const size_t bytes = nbPoints_ * sizeof(sl::float4);
+        if (mem == sl::MEM::CPU)
+            memcpy(dst.getPtr<sl::float4>(mem), matXYZRGBA.getPtr<sl::float4>(mem), bytes);
+        else
+            checkError(cudaMemcpy(dst.getPtr<sl::float4>(mem), matXYZRGBA.getPtr<sl::float4>(mem), bytes, cudaMemcpyDeviceToDevice));
     }
+    hasNewPCL_ = true;
 }
 
 void PointCloud::update() {
+    if (backend_ == PointCloudBackend::CPU_STREAMING) {
+        updateStreaming();
+        return;
+    }
     if (hasNewPCL_ && matGPU_.isInit()) {
-        checkError(cudaMemcpy(xyzrgbaMappedBuf_, matGPU_.getPtr<sl::float4>(sl::MEM::GPU), numBytes_, cudaMemcpyDeviceToDevice));
+        checkError(cudaMemcpy(xyzrgbaMappedBuf_, matGPU_.getPtr<sl::float4>(sl::MEM::GPU), nbPoints_ * sizeof(sl::float4), cudaMemcpyDeviceToDevice));
         hasNewPCL_ = false;
     }
 }
 
+void PointCloud::updateStreaming() {
+    if (!hasNewPCL_ || !matCPU_.isInit()) return;
+
+    auto start = std::chrono::steady_clock::now();
+    const unsigned char* src = matCPU_.getPtr<sl::uchar1>(sl::MEM::CPU);
+    const size_t bytes = nbPoints_ * sizeof(sl::float4);
+    if (persistent_) {
+        // Next segment: only wait if the GPU still reads it, i.e. if it is more than 2 frames late
+        const int next = (segment_ + 1) % NB_SEGMENTS;
+        if (fences_[next]) {
+            while (glClientWaitSync(fences_[next], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+            glDeleteSync(fences_[next]);
+            fences_[next] = 0;
+        }
+        memcpy(persistentPtr_ + next * numBytes_, src, bytes);
+        segment_ = next;
+        drawFirst_ = static_cast<GLint> (next * matCPU_.getResolution().area());
+    } else {
+        // Orphaning: the driver gives a fresh storage while the previous one is still drawn
+        glBindBuffer(GL_ARRAY_BUFFER, bufferGLID_);
+        glBufferData(GL_ARRAY_BUFFER, numBytes_, 0, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, src);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        drawFirst_ = 0;
+    }
+    hasNewPCL_ = false;
+
+    uploadTime_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uploadedBytes_ += bytes;
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - lastReport_).count() > 5.) {
+        print("Point cloud upload: " + std::to_string(static_cast<int>(uploadedBytes_ / (1024. * 1024. * uploadTime_))) + " MB/s ("
+            + std::to_string(uploadedBytes_ / (1024 * 1024)) + " MB in " + std::to_string(static_cast<int>(uploadTime_ * 1000.)) + " ms)");
+        uploadedBytes_ = 0;
+        uploadTime_ = 0;
+        lastReport_ = now;
+    }
+}
+
 void PointCloud::draw(const sl::Transform& vp) {
-    if (matGPU_.isInit()) {
+    const bool init = (backend_ == PointCloudBackend::CPU_STREAMING) ? matCPU_.isInit() : matGPU_.isInit();
+    if (init) {
         glUseProgram(shader_.getProgramId());
         glUniformMatrix4fv(shMVPMatrixLoc_, 1, GL_TRUE, vp.m);
         
@@ -571,149 +498,16 @@ void PointCloud::draw(const sl::Transform& vp) {
         glVertexAttribPointer(Shader::ATTRIB_VERTICES_POS, 4, GL_FLOAT, GL_FALSE, 0, 0);
         glEnableVertexAttribArray(Shader::ATTRIB_VERTICES_POS);
 
-        glDrawArrays(GL_POINTS, 0, matGPU_.getResolution().area());
+        if (backend_ == PointCloudBackend::CPU_STREAMING) {
+            glDrawArrays(GL_POINTS, drawFirst_, static_cast<GLsizei> (nbPoints_));
+            // the current segment can be rewritten once this draw is done
+            if (persistent_) {
+                if (fences_[segment_]) glDeleteSync(fences_[segment_]);
+                fences_[segment_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+        } else
+            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei> (nbPoints_));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glUseProgram(0);
     }
 }
-
-const sl::Translation CameraGL::ORIGINAL_FORWARD = sl::Translation(0, 0, 1);
-const sl::Translation CameraGL::ORIGINAL_UP = sl::Translation(0, 1, 0);
-const sl::Translation CameraGL::ORIGINAL_RIGHT = sl::Translation(1, 0, 0);
-
-CameraGL::CameraGL(sl::Translation position, sl::Translation direction, sl::Translation vertical) {
-    this->position_ = position;
-    setDirection(direction, vertical);
-
-    offset_ = sl::Translation(0, 0, 0);
-    view_.setIdentity();
-    updateView();
-    setProjection(70, 70, 200.f, 50000.f);
-    updateVPMatrix();
-}
-
-CameraGL::~CameraGL() {}
-
-void CameraGL::update() {
-    if (sl::Translation::dot(vertical_, up_) < 0)
-        vertical_ = vertical_ * -1.f;
-    updateView();
-    updateVPMatrix();
-}
-
-void CameraGL::setProjection(float horizontalFOV, float verticalFOV, float znear, float zfar) {
-    horizontalFieldOfView_ = horizontalFOV;
-    verticalFieldOfView_ = verticalFOV;
-    znear_ = znear;
-    zfar_ = zfar;
-
-    float fov_y = verticalFOV * M_PI / 180.f;
-    float fov_x = horizontalFOV * M_PI / 180.f;
-
-    projection_.setIdentity();
-    projection_(0, 0) = 1.0f / tanf(fov_x * 0.5f);
-    projection_(1, 1) = 1.0f / tanf(fov_y * 0.5f);
-    projection_(2, 2) = -(zfar + znear) / (zfar - znear);
-    projection_(3, 2) = -1;
-    projection_(2, 3) = -(2.f * zfar * znear) / (zfar - znear);
-    projection_(3, 3) = 0;
-}
-
-const sl::Transform& CameraGL::getViewProjectionMatrix() const {
-    return vpMatrix_;
-}
-
-float CameraGL::getHorizontalFOV() const {
-    return horizontalFieldOfView_;
-}
-
-float CameraGL::getVerticalFOV() const {
-    return verticalFieldOfView_;
-}
-
-void CameraGL::setOffsetFromPosition(const sl::Translation& o) {
-    offset_ = o;
-}
-
-const sl::Translation& CameraGL::getOffsetFromPosition() const {
-    return offset_;
-}
-
-void CameraGL::setDirection(const sl::Translation& direction, const sl::Translation& vertical) {
-    sl::Translation dirNormalized = direction;
-    dirNormalized.normalize();
-    this->rotation_ = sl::Orientation(ORIGINAL_FORWARD, dirNormalized * -1.f);
-    updateVectors();
-    this->vertical_ = vertical;
-    if (sl::Translation::dot(vertical_, up_) < 0)
-        rotate(sl::Rotation(M_PI, ORIGINAL_FORWARD));
-}
-
-void CameraGL::translate(const sl::Translation& t) {
-    position_ = position_ + t;
-}
-
-void CameraGL::setPosition(const sl::Translation& p) {
-    position_ = p;
-}
-
-void CameraGL::rotate(const sl::Orientation& rot) {
-    rotation_ = rot * rotation_;
-    updateVectors();
-}
-
-void CameraGL::rotate(const sl::Rotation& m) {
-    this->rotate(sl::Orientation(m));
-}
-
-void CameraGL::setRotation(const sl::Orientation& rot) {
-    rotation_ = rot;
-    updateVectors();
-}
-
-void CameraGL::setRotation(const sl::Rotation& m) {
-    this->setRotation(sl::Orientation(m));
-}
-
-const sl::Translation& CameraGL::getPosition() const {
-    return position_;
-}
-
-const sl::Translation& CameraGL::getForward() const {
-    return forward_;
-}
-
-const sl::Translation& CameraGL::getRight() const {
-    return right_;
-}
-
-const sl::Translation& CameraGL::getUp() const {
-    return up_;
-}
-
-const sl::Translation& CameraGL::getVertical() const {
-    return vertical_;
-}
-
-float CameraGL::getZNear() const {
-    return znear_;
-}
-
-float CameraGL::getZFar() const {
-    return zfar_;
-}
-
-void CameraGL::updateVectors() {
-    forward_ = ORIGINAL_FORWARD * rotation_;
-    up_ = ORIGINAL_UP * rotation_;
-    right_ = sl::Translation(ORIGINAL_RIGHT * -1.f) * rotation_;
-}
-
-void CameraGL::updateView() {
-    sl::Transform transformation(rotation_, (offset_ * rotation_) + position_);
-    view_ = sl::Transform::inverse(transformation);
-}
-
-void CameraGL::updateVPMatrix() {
-    vpMatrix_ = projection_ * view_;
-}
@@ -0,0 +1,325 @@
+#include "PointCloudDecimator.hpp"
+#include "decimation_gpu.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+
+static const uint64_t GOLDEN_RATIO_64 = 0x9E3779B97F4A7C15ull;
+
+static size_t nextPowerOfTwo(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+// Voxel coordinates of a row of points, level -1 for the invalid points
+struct RowKeys {
+    std::vector<int32_t> ix, iy, iz, level;
+
+    void resize(int n) {
+        ix.resize(n);
+        iy.resize(n);
+        iz.resize(n);
+        level.resize(n);
+    }
+
+    uint64_t key(int j) const {
+        return (static_cast<uint64_t>(level[j]) << 60) | (static_cast<uint64_t>(ix[j]) << 40) | (static_cast<uint64_t>(iy[j]) << 20) | static_cast<uint64_t>(iz[j]);
+    }
+};
+
+// The level is floor(log2(distance / lod_distance)), read from the exponent of the squared ratio. The voxel size of
+// level l is voxel_size * 2^l: 20 bits per axis cover +-524288 voxels around the camera.
+static void keysScalar(const float* p, int first, int n, float inv_voxel, float inv_lod2, RowKeys& k) {
+    for (int j = first; j < n; j++) {
+        const float x = p[j * 4], y = p[j * 4 + 1], z = p[j * 4 + 2];
+        if (!(std::fabs(z) < INFINITY)) {
+            k.level[j] = -1;
+            continue;
+        }
+        const float f = std::max(1.f, (x * x + y * y + z * z) * inv_lod2);
+        int32_t bits;
+        memcpy(&bits, &f, 4);
+        const int32_t level = std::min(((bits >> 23) - 127) >> 1, 14);
+        const int32_t scale_bits = (127 - level) << 23;
+        float scale;
+        memcpy(&scale, &scale_bits, 4);
+        scale *= inv_voxel;
+
+        k.ix[j] = (static_cast<int32_t>(std::floor(x * scale)) + (1 << 19)) & 0xFFFFF;
+        k.iy[j] = (static_cast<int32_t>(std::floor(y * scale)) + (1 << 19)) & 0xFFFFF;
+        k.iz[j] = (static_cast<int32_t>(std::floor(z * scale)) + (1 << 19)) & 0xFFFFF;
+        k.level[j] = level;
+    }
+}
+
+#ifdef CPU_AVX2
+CPU_AVX2_TARGET static int keysAVX2(const float* p, int n, float inv_voxel, float inv_lod2, RowKeys& k) {
+    // the 8x4 transpose gives the points in the order 0 2 4 6 1 3 5 7
+    const __m256i reorder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 vinv = _mm256_set1_ps(inv_voxel);
+    const __m256 vlod = _mm256_set1_ps(inv_lod2);
+    const __m256i bias = _mm256_set1_epi32(127);
+    const __m256i max_level = _mm256_set1_epi32(14);
+    const __m256i offset = _mm256_set1_epi32(1 << 19);
+    const __m256i mask = _mm256_set1_epi32(0xFFFFF);
+    const __m256i invalid = _mm256_set1_epi32(-1);
+
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const float* q = p + j * 4;
+        const __m256 a0 = _mm256_loadu_ps(q), a1 = _mm256_loadu_ps(q + 8);
+        const __m256 a2 = _mm256_loadu_ps(q + 16), a3 = _mm256_loadu_ps(q + 24);
+        const __m256 t0 = _mm256_unpacklo_ps(a0, a1);
+        const __m256 t1 = _mm256_unpackhi_ps(a0, a1);
+        const __m256 t2 = _mm256_unpacklo_ps(a2, a3);
+        const __m256 t3 = _mm256_unpackhi_ps(a2, a3);
+        const __m256 x = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), reorder);
+        const __m256 y = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)), reorder);
+        const __m256 z = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), reorder);
+
+        const __m256 valid = _mm256_cmp_ps(_mm256_and_ps(z, abs_mask), inf, _CMP_LT_OQ);
+        const __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+        // max_ps returns its second operand for NAN
+        const __m256 f = _mm256_max_ps(_mm256_mul_ps(d2, vlod), one);
+        __m256i level = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_srli_epi32(_mm256_castps_si256(f), 23), bias), 1);
+        level = _mm256_min_epi32(level, max_level);
+        const __m256 scale = _mm256_mul_ps(vinv, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_sub_epi32(bias, level), 23)));
+
+        const __m256i ix = _mm256_and_si256(_mm256_add_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(x, scale))), offset), mask);
+        const __m256i iy = _mm256_and_si256(_mm256_add_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(y, scale))), offset), mask);
+        const __m256i iz = _mm256_and_si256(_mm256_add_epi32(_mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(z, scale))), offset), mask);
+        level = _mm256_blendv_epi8(invalid, level, _mm256_castps_si256(valid));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*> (k.ix.data() + j), ix);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*> (k.iy.data() + j), iy);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*> (k.iz.data() + j), iz);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*> (k.level.data() + j), level);
+    }
+    return j;
+}
+#endif
+
+#ifdef CPU_NEON
+static int keysNEON(const float* p, int n, float inv_voxel, float inv_lod2, RowKeys& k) {
+    const float32x4_t inf = vdupq_n_f32(INFINITY);
+    const float32x4_t one = vdupq_n_f32(1.f);
+    const float32x4_t vinv = vdupq_n_f32(inv_voxel);
+    const float32x4_t vlod = vdupq_n_f32(inv_lod2);
+    const int32x4_t bias = vdupq_n_s32(127);
+    const int32x4_t max_level = vdupq_n_s32(14);
+    const int32x4_t offset = vdupq_n_s32(1 << 19);
+    const int32x4_t mask = vdupq_n_s32(0xFFFFF);
+    const int32x4_t invalid = vdupq_n_s32(-1);
+
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        const float32x4x4_t v = vld4q_f32(p + j * 4); // deinterleaves to X, Y, Z, W
+        const float32x4_t x = v.val[0], y = v.val[1], z = v.val[2];
+
+        const uint32x4_t valid = vcltq_f32(vabsq_f32(z), inf);
+        const float32x4_t d2 = vaddq_f32(vaddq_f32(vmulq_f32(x, x), vmulq_f32(y, y)), vmulq_f32(z, z));
+        const float32x4_t f = vmaxnmq_f32(one, vmulq_f32(d2, vlod));
+        int32x4_t level = vshrq_n_s32(vsubq_s32(vshrq_n_s32(vreinterpretq_s32_f32(f), 23), bias), 1);
+        level = vminq_s32(level, max_level);
+        const float32x4_t scale = vmulq_f32(vinv, vreinterpretq_f32_s32(vshlq_n_s32(vsubq_s32(bias, level), 23)));
+
+        vst1q_s32(k.ix.data() + j, vandq_s32(vaddq_s32(vcvtq_s32_f32(vrndmq_f32(vmulq_f32(x, scale))), offset), mask));
+        vst1q_s32(k.iy.data() + j, vandq_s32(vaddq_s32(vcvtq_s32_f32(vrndmq_f32(vmulq_f32(y, scale))), offset), mask));
+        vst1q_s32(k.iz.data() + j, vandq_s32(vaddq_s32(vcvtq_s32_f32(vrndmq_f32(vmulq_f32(z, scale))), offset), mask));
+        vst1q_s32(k.level.data() + j, vbslq_s32(valid, level, invalid));
+    }
+    return j;
+}
+#endif
+
+static void computeKeys(const float* p, int n, float inv_voxel, float inv_lod2, RowKeys& k) {
+    int done = 0;
+#ifdef CPU_AVX2
+    if (cpuHasAVX2()) done = keysAVX2(p, n, inv_voxel, inv_lod2, k);
+#endif
+#ifdef CPU_NEON
+    done = keysNEON(p, n, inv_voxel, inv_lod2, k);
+#endif
+    keysScalar(p, done, n, inv_voxel, inv_lod2, k);
+}
+
+// Open addressing hash table of the voxel keys, cleared each frame (a valid key has a level <= 14, it is never the empty key). Every voxel of the frame is
+// inserted, the table is doubled when half full and keeps its size for the next frames. Once the budget is reached, the kept points are chosen by
+// reservoir sampling: the dropped voxels are spread over the whole cloud, as on the GPU, and not all at its bottom.
+class DecimatorCPU : public PointCloudDecimator {
+public:
+    DecimatorCPU(const DecimationParameters& params) : PointCloudDecimator(sl::MEM::CPU, params) {
+        resizeTable(nextPowerOfTwo(params_.point_budget * 2));
+    }
+
+protected:
+    size_t decimate(sl::Mat& cloud, sl::float4* out, float inv_voxel, float inv_lod2) override {
+        std::fill(table_.begin(), table_.end(), DECIMATION_EMPTY_KEY);
+        const int width = cloud.getWidth(), height = cloud.getHeight();
+        const size_t step = cloud.getStep(sl::MEM::CPU);
+        const sl::float4* ptr = cloud.getPtr<sl::float4>(sl::MEM::CPU);
+        keys_.resize(width);
+
+        size_t nb_voxels = 0;
+        for (int v = 0; v < height; v++) {
+            const sl::float4* row = ptr + v * step;
+            computeKeys(reinterpret_cast<const float*> (row), width, inv_voxel, inv_lod2, keys_);
+            uint64_t previous = DECIMATION_EMPTY_KEY;
+            for (int u = 0; u < width; u++) {
+                if (keys_.level[u] < 0) continue;
+                const uint64_t key = keys_.key(u);
+                // neighbor pixels mostly fall in the same voxel, no need to look it up again
+                if (key == previous) continue;
+                previous = key;
+                if (!insert(key)) continue;
+                if (nb_voxels < params_.point_budget)
+                    out[nb_voxels] = row[u];
+                else {
+                    // the new voxel replaces a kept one with probability budget / (nb_voxels + 1)
+                    const size_t r = static_cast<size_t> (nextRandom() % (nb_voxels + 1));
+                    if (r < params_.point_budget) out[r] = row[u];
+                }
+                if (++nb_voxels * 2 > table_.size()) grow();
+            }
+        }
+        return nb_voxels;
+    }
+
+private:
+    // Returns true when 'key' is a new voxel
+    bool insert(uint64_t key) {
+        size_t h = (key * GOLDEN_RATIO_64) >> shift_;
+        while (table_[h] != key) {
+            if (table_[h] == DECIMATION_EMPTY_KEY) {
+                table_[h] = key;
+                return true;
+            }
+            h = (h + 1) & mask_;
+        }
+        return false;
+    }
+
+    void resizeTable(size_t size) {
+        table_.assign(size, DECIMATION_EMPTY_KEY);
+        mask_ = size - 1;
+        shift_ = 64;
+        for (size_t s = size; s > 1; s >>= 1)
+            shift_--;
+    }
+
+    void grow() {
+        std::vector<uint64_t> keys;
+        keys.swap(table_);
+        resizeTable(keys.size() * 2);
+        for (auto it : keys)
+            if (it != DECIMATION_EMPTY_KEY) insert(it);
+    }
+
+    // xorshift64, enough to pick the reservoir slots
+    uint64_t nextRandom() {
+        random_ ^= random_ << 13;
+        random_ ^= random_ >> 7;
+        random_ ^= random_ << 17;
+        return random_;
+    }
+
+    std::vector<uint64_t> table_;
+    size_t mask_;
+    int shift_;
+    uint64_t random_ = GOLDEN_RATIO_64;
+    RowKeys keys_;
+};
+
+// The GPU table can not grow during a frame, it is 4 times the budget. A CUDA error leaves the frame empty.
+class DecimatorGPU : public PointCloudDecimator {
+public:
+    DecimatorGPU(const DecimationParameters& params) : PointCloudDecimator(sl::MEM::GPU, params) {
+        table_size_ = static_cast<unsigned int> (nextPowerOfTwo(params_.point_budget * 4));
+        if (!check(cudaMalloc(&table_, table_size_ * sizeof(unsigned long long))) || !check(cudaMalloc(&counter_, sizeof(unsigned int)))) {
+            cudaFree(table_);
+            table_ = nullptr;
+        }
+    }
+
+    ~DecimatorGPU() {
+        cudaFree(table_);
+        cudaFree(counter_);
+    }
+
+protected:
+    size_t decimate(sl::Mat& cloud, sl::float4* out, float inv_voxel, float inv_lod2) override {
+        unsigned int nb_voxels = 0;
+        if (!table_) return 0;
+        check(voxelDecimateGPU(reinterpret_cast<const float4*> (cloud.getPtr<sl::float4>(sl::MEM::GPU)), cloud.getStep(sl::MEM::GPU),
+                               cloud.getWidth(), cloud.getHeight(), inv_voxel, inv_lod2, table_, table_size_, counter_,
+                               reinterpret_cast<float4*> (out), static_cast<unsigned int> (params_.point_budget), nb_voxels));
+        return nb_voxels;
+    }
+
+private:
+    static bool check(cudaError_t err) {
+        if (err != cudaSuccess)
+            std::cerr << "[Sample] Decimation: CUDA error " << err << " (" << cudaGetErrorString(err) << ")" << std::endl;
+        return err == cudaSuccess;
+    }
+
+    unsigned long long* table_ = nullptr;
+    unsigned int table_size_;
+    unsigned int* counter_ = nullptr;
+};
+
+std::unique_ptr<PointCloudDecimator> PointCloudDecimator::create(sl::MEM memory, const DecimationParameters& params) {
+    if (memory == sl::MEM::GPU)
+        return std::unique_ptr<PointCloudDecimator>(new DecimatorGPU(params));
+    return std::unique_ptr<PointCloudDecimator>(new DecimatorCPU(params));
+}
+
+PointCloudDecimator::PointCloudDecimator(sl::MEM memory, const DecimationParameters& params)
+: params_(params), memory_(memory), voxel_size_(params.voxel_size) {
+    params_.point_budget = std::max<size_t>(1, params_.point_budget);
+    last_report_ = std::chrono::steady_clock::now();
+}
+
+size_t PointCloudDecimator::process(sl::Mat& cloud, sl::Mat& decimated) {
+    auto start = std::chrono::steady_clock::now();
+    if (!decimated.isInit() || decimated.getWidth() != params_.point_budget)
+        decimated.alloc(sl::Resolution(params_.point_budget, 1), sl::MAT_TYPE::F32_C4, memory_);
+
+    const float inv_lod2 = (params_.mode == DecimationMode::DISTANCE_LOD) ? 1.f / (params_.lod_distance * params_.lod_distance) : 0.f;
+    const size_t nb_voxels = decimate(cloud, decimated.getPtr<sl::float4>(memory_), 1.f / voxel_size_, inv_lod2);
+    const size_t nb_points = std::min(nb_voxels, params_.point_budget);
+    adaptVoxelSize(nb_voxels);
+
+    auto now = std::chrono::steady_clock::now();
+    time_ += std::chrono::duration<double>(now - start).count();
+    nb_frames_++;
+    nb_in_ += cloud.getResolution().area();
+    nb_out_ += nb_points;
+    if (std::chrono::duration<double>(now - last_report_).count() > 5.) {
+        std::cout << "[Sample] Decimation: " << nb_in_ / nb_frames_ << " -> " << nb_out_ / nb_frames_ << " points, voxel " << voxel_size_
+            << ", " << time_ * 1000. / nb_frames_ << " ms per frame" << std::endl;
+        nb_frames_ = nb_in_ = nb_out_ = 0;
+        time_ = 0;
+        last_report_ = now;
+    }
+    return nb_points;
+}
+
+void PointCloudDecimator::adaptVoxelSize(size_t nb_voxels) {
+    // the points lie on surfaces: the number of voxels goes as 1 / voxel_size^2
+    const float budget = static_cast<float> (params_.point_budget);
+    if (nb_voxels > params_.point_budget)
+        voxel_size_ *= std::min(2.f, 1.05f * std::sqrt(nb_voxels / budget));
+    else if (nb_voxels < 0.8f * budget)
+        voxel_size_ = std::max(params_.voxel_size, voxel_size_ * std::max(0.5f, std::sqrt(nb_voxels / (0.9f * budget))));
+}
@@ -0,0 +1,336 @@
+#include "SurfaceNormals.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "CpuFeatures.hpp"
+#include "WorkerPool.hpp"
+
+// Rows around the current one, 'up' and 'down' are the current row (and flagged missing) on the borders
+struct NormalRow {
+    const float* up;
+    const float* cur;
+    const float* down;
+    bool has_up, has_down;
+    float* out;
+    int width;
+};
+
+static inline bool isValid(float z) {
+    return std::fabs(z) < INFINITY;
+}
+
+struct Vec3 {
+    float x, y, z;
+};
+
+static inline Vec3 load3(const float* p) {
+    return {p[0], p[1], p[2]};
+}
+
+// Tangent from the previous (a) and next (b) neighbors of p, see the header
+static inline bool tangent(const Vec3& p, const Vec3& a, bool va, const Vec3& b, bool vb, Vec3& t) {
+    const Vec3 da = {p.x - a.x, p.y - a.y, p.z - a.z};
+    const Vec3 db = {b.x - p.x, b.y - p.y, b.z - p.z};
+    const float la = da.x * da.x + da.y * da.y + da.z * da.z;
+    const float lb = db.x * db.x + db.y * db.y + db.z * db.z;
+    if (va && vb && la < 4.f * lb && lb < 4.f * la)
+        t = {da.x + db.x, da.y + db.y, da.z + db.z};
+    else if (va && (!vb || la < lb))
+        t = da;
+    else
+        t = db;
+    return va || vb;
+}
+
+static void normalsScalar(const NormalRow& r, int first, int last) {
+    for (int u = first; u < last; u++) {
+        float* o = r.out + u * 4;
+        const Vec3 p = load3(r.cur + u * 4);
+        Vec3 th, tv;
+        bool ok = isValid(p.z);
+        if (ok) {
+            const bool vl = u > 0 && isValid(r.cur[(u - 1) * 4 + 2]);
+            const bool vr = u + 1 < r.width && isValid(r.cur[(u + 1) * 4 + 2]);
+            const bool vu = r.has_up && isValid(r.up[u * 4 + 2]);
+            const bool vd = r.has_down && isValid(r.down[u * 4 + 2]);
+            ok = tangent(p, load3(r.cur + std::max(u - 1, 0) * 4), vl, load3(r.cur + std::min(u + 1, r.width - 1) * 4), vr, th)
+                && tangent(p, load3(r.up + u * 4), vu, load3(r.down + u * 4), vd, tv);
+        }
+        if (ok) {
+            Vec3 n = {th.y * tv.z - th.z * tv.y, th.z * tv.x - th.x * tv.z, th.x * tv.y - th.y * tv.x};
+            if (n.x * p.x + n.y * p.y + n.z * p.z > 0.f) // facing the camera, at the origin
+                n = {-n.x, -n.y, -n.z};
+            const float len2 = n.x * n.x + n.y * n.y + n.z * n.z;
+            if (len2 > 0.f) {
+                const float inv = 1.f / std::sqrt(len2);
+                o[0] = n.x * inv;
+                o[1] = n.y * inv;
+                o[2] = n.z * inv;
+                o[3] = 0.f;
+                continue;
+            }
+        }
+        o[0] = o[1] = o[2] = NAN;
+        o[3] = 0.f;
+    }
+}
+
+#ifdef CPU_AVX2
+struct Vec3x8 {
+    __m256 x, y, z;
+};
+
+// 8 consecutive XYZW points to X, Y, Z vectors
+CPU_AVX2_TARGET static inline Vec3x8 load8(const float* p) {
+    // the 8x4 transpose gives the points in the order 0 2 4 6 1 3 5 7
+    const __m256i reorder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256 a0 = _mm256_loadu_ps(p), a1 = _mm256_loadu_ps(p + 8);
+    const __m256 a2 = _mm256_loadu_ps(p + 16), a3 = _mm256_loadu_ps(p + 24);
+    const __m256 t0 = _mm256_unpacklo_ps(a0, a1);
+    const __m256 t1 = _mm256_unpackhi_ps(a0, a1);
+    const __m256 t2 = _mm256_unpacklo_ps(a2, a3);
+    const __m256 t3 = _mm256_unpackhi_ps(a2, a3);
+    Vec3x8 v;
+    v.x = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), reorder);
+    v.y = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)), reorder);
+    v.z = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), reorder);
+    return v;
+}
+
+CPU_AVX2_TARGET static inline __m256 validMask(__m256 z) {
+    return _mm256_cmp_ps(_mm256_and_ps(z, _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF))), _mm256_set1_ps(INFINITY), _CMP_LT_OQ);
+}
+
+CPU_AVX2_TARGET static inline __m256 dot(const Vec3x8& a, const Vec3x8& b) {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)), _mm256_mul_ps(a.z, b.z));
+}
+
+CPU_AVX2_TARGET static inline Vec3x8 select(__m256 mask, const Vec3x8& a, const Vec3x8& b) {
+    return {_mm256_blendv_ps(b.x, a.x, mask), _mm256_blendv_ps(b.y, a.y, mask), _mm256_blendv_ps(b.z, a.z, mask)};
+}
+
+CPU_AVX2_TARGET static inline __m256 tangent8(const Vec3x8& p, const Vec3x8& a, __m256 va, const Vec3x8& b, __m256 vb, Vec3x8& t) {
+    const __m256 four = _mm256_set1_ps(4.f);
+    const Vec3x8 da = {_mm256_sub_ps(p.x, a.x), _mm256_sub_ps(p.y, a.y), _mm256_sub_ps(p.z, a.z)};
+    const Vec3x8 db = {_mm256_sub_ps(b.x, p.x), _mm256_sub_ps(b.y, p.y), _mm256_sub_ps(b.z, p.z)};
+    const __m256 la = dot(da, da), lb = dot(db, db);
+    const __m256 both = _mm256_and_ps(va, vb);
+    const __m256 central = _mm256_and_ps(both, _mm256_and_ps(_mm256_cmp_ps(la, _mm256_mul_ps(four, lb), _CMP_LT_OQ),
+                                                              _mm256_cmp_ps(lb, _mm256_mul_ps(four, la), _CMP_LT_OQ)));
+    const __m256 pick_a = _mm256_and_ps(va, _mm256_or_ps(_mm256_andnot_ps(vb, va), _mm256_cmp_ps(la, lb, _CMP_LT_OQ)));
+    const Vec3x8 sum = {_mm256_add_ps(da.x, db.x), _mm256_add_ps(da.y, db.y), _mm256_add_ps(da.z, db.z)};
+    t = select(central, sum, select(pick_a, da, db));
+    return _mm256_or_ps(va, vb);
+}
+
+// Processes u in [1, width - 1), returns the first u not done
+CPU_AVX2_TARGET static int normalsAVX2(const NormalRow& r) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 nan = _mm256_set1_ps(NAN);
+    const __m256 sign = _mm256_set1_ps(-0.f);
+    const __m256 has_up = r.has_up ? _mm256_castsi256_ps(_mm256_set1_epi32(-1)) : zero;
+    const __m256 has_down = r.has_down ? _mm256_castsi256_ps(_mm256_set1_epi32(-1)) : zero;
+
+    int u = 1;
+    for (; u + 8 <= r.width - 1; u += 8) {
+        const Vec3x8 p = load8(r.cur + u * 4);
+        const Vec3x8 l = load8(r.cur + (u - 1) * 4);
+        const Vec3x8 rt = load8(r.cur + (u + 1) * 4);
+        const Vec3x8 up = load8(r.up + u * 4);
+        const Vec3x8 dn = load8(r.down + u * 4);
+
+        Vec3x8 th, tv;
+        __m256 ok = validMask(p.z);
+        ok = _mm256_and_ps(ok, tangent8(p, l, validMask(l.z), rt, validMask(rt.z), th));
+        ok = _mm256_and_ps(ok, tangent8(p, up, _mm256_and_ps(has_up, validMask(up.z)), dn, _mm256_and_ps(has_down, validMask(dn.z)), tv));
+
+        Vec3x8 n = {_mm256_sub_ps(_mm256_mul_ps(th.y, tv.z), _mm256_mul_ps(th.z, tv.y)),
+                    _mm256_sub_ps(_mm256_mul_ps(th.z, tv.x), _mm256_mul_ps(th.x, tv.z)),
+                    _mm256_sub_ps(_mm256_mul_ps(th.x, tv.y), _mm256_mul_ps(th.y, tv.x))};
+        const __m256 flip = _mm256_and_ps(_mm256_cmp_ps(dot(n, p), zero, _CMP_GT_OQ), sign);
+        n = {_mm256_xor_ps(n.x, flip), _mm256_xor_ps(n.y, flip), _mm256_xor_ps(n.z, flip)};
+        const __m256 len2 = dot(n, n);
+        ok = _mm256_and_ps(ok, _mm256_cmp_ps(len2, zero, _CMP_GT_OQ));
+        const __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+        const __m256 x = _mm256_blendv_ps(nan, _mm256_mul_ps(n.x, inv), ok);
+        const __m256 y = _mm256_blendv_ps(nan, _mm256_mul_ps(n.y, inv), ok);
+        const __m256 z = _mm256_blendv_ps(nan, _mm256_mul_ps(n.z, inv), ok);
+
+        // 4x8 transpose back to XYZW points, W = 0
+        const __m256 t0 = _mm256_unpacklo_ps(x, y);
+        const __m256 t1 = _mm256_unpackhi_ps(x, y);
+        const __m256 t2 = _mm256_unpacklo_ps(z, zero);
+        const __m256 t3 = _mm256_unpackhi_ps(z, zero);
+        const __m256 p0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 p1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m256 p2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m256 p3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        float* o = r.out + u * 4;
+        _mm256_storeu_ps(o, _mm256_permute2f128_ps(p0, p1, 0x20));
+        _mm256_storeu_ps(o + 8, _mm256_permute2f128_ps(p2, p3, 0x20));
+        _mm256_storeu_ps(o + 16, _mm256_permute2f128_ps(p0, p1, 0x31));
+        _mm256_storeu_ps(o + 24, _mm256_permute2f128_ps(p2, p3, 0x31));
+    }
+    return u;
+}
+#endif
+
+#ifdef CPU_NEON
+struct Vec3x4 {
+    float32x4_t x, y, z;
+};
+
+static inline Vec3x4 load4(const float* p) {
+    const float32x4x4_t v = vld4q_f32(p); // deinterleaves to X, Y, Z, W
+    return {v.val[0], v.val[1], v.val[2]};
+}
+
+static inline uint32x4_t validMask(float32x4_t z) {
+    return vcltq_f32(vabsq_f32(z), vdupq_n_f32(INFINITY));
+}
+
+static inline float32x4_t dot(const Vec3x4& a, const Vec3x4& b) {
+    return vaddq_f32(vaddq_f32(vmulq_f32(a.x, b.x), vmulq_f32(a.y, b.y)), vmulq_f32(a.z, b.z));
+}
+
+static inline Vec3x4 select(uint32x4_t mask, const Vec3x4& a, const Vec3x4& b) {
+    return {vbslq_f32(mask, a.x, b.x), vbslq_f32(mask, a.y, b.y), vbslq_f32(mask, a.z, b.z)};
+}
+
+static inline uint32x4_t tangent4(const Vec3x4& p, const Vec3x4& a, uint32x4_t va, const Vec3x4& b, uint32x4_t vb, Vec3x4& t) {
+    const float32x4_t four = vdupq_n_f32(4.f);
+    const Vec3x4 da = {vsubq_f32(p.x, a.x), vsubq_f32(p.y, a.y), vsubq_f32(p.z, a.z)};
+    const Vec3x4 db = {vsubq_f32(b.x, p.x), vsubq_f32(b.y, p.y), vsubq_f32(b.z, p.z)};
+    const float32x4_t la = dot(da, da), lb = dot(db, db);
+    const uint32x4_t central = vandq_u32(vandq_u32(va, vb), vandq_u32(vcltq_f32(la, vmulq_f32(four, lb)), vcltq_f32(lb, vmulq_f32(four, la))));
+    const uint32x4_t pick_a = vandq_u32(va, vorrq_u32(vmvnq_u32(vb), vcltq_f32(la, lb)));
+    const Vec3x4 sum = {vaddq_f32(da.x, db.x), vaddq_f32(da.y, db.y), vaddq_f32(da.z, db.z)};
+    t = select(central, sum, select(pick_a, da, db));
+    return vorrq_u32(va, vb);
+}
+
+static int normalsNEON(const NormalRow& r) {
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t nan = vdupq_n_f32(NAN);
+    const uint32x4_t has_up = vdupq_n_u32(r.has_up ? 0xFFFFFFFFu : 0u);
+    const uint32x4_t has_down = vdupq_n_u32(r.has_down ? 0xFFFFFFFFu : 0u);
+
+    int u = 1;
+    for (; u + 4 <= r.width - 1; u += 4) {
+        const Vec3x4 p = load4(r.cur + u * 4);
+        const Vec3x4 l = load4(r.cur + (u - 1) * 4);
+        const Vec3x4 rt = load4(r.cur + (u + 1) * 4);
+        const Vec3x4 up = load4(r.up + u * 4);
+        const Vec3x4 dn = load4(r.down + u * 4);
+
+        Vec3x4 th, tv;
+        uint32x4_t ok = validMask(p.z);
+        ok = vandq_u32(ok, tangent4(p, l, validMask(l.z), rt, validMask(rt.z), th));
+        ok = vandq_u32(ok, tangent4(p, up, vandq_u32(has_up, validMask(up.z)), dn, vandq_u32(has_down, validMask(dn.z)), tv));
+
+        Vec3x4 n = {vsubq_f32(vmulq_f32(th.y, tv.z), vmulq_f32(th.z, tv.y)),
+                    vsubq_f32(vmulq_f32(th.z, tv.x), vmulq_f32(th.x, tv.z)),
+                    vsubq_f32(vmulq_f32(th.x, tv.y), vmulq_f32(th.y, tv.x))};
+        const uint32x4_t flip = vcgtq_f32(dot(n, p), zero);
+        n = select(flip, {vnegq_f32(n.x), vnegq_f32(n.y), vnegq_f32(n.z)}, n);
+        const float32x4_t len2 = dot(n, n);
+        ok = vandq_u32(ok, vcgtq_f32(len2, zero));
+        const float32x4_t inv = vdivq_f32(vdupq_n_f32(1.f), vsqrtq_f32(len2));
+
+        float32x4x4_t o;
+        o.val[0] = vbslq_f32(ok, vmulq_f32(n.x, inv), nan);
+        o.val[1] = vbslq_f32(ok, vmulq_f32(n.y, inv), nan);
+        o.val[2] = vbslq_f32(ok, vmulq_f32(n.z, inv), nan);
+        o.val[3] = zero;
+        vst4q_f32(r.out + u * 4, o); // interleaves to XYZW
+    }
+    return u;
+}
+#endif
+
+static void normalsRow(const NormalRow& r) {
+    // the first and last columns only have one horizontal neighbor, they are done by the scalar code
+    normalsScalar(r, 0, std::min(1, r.width));
+    int u = std::min(1, r.width);
+#ifdef CPU_AVX2
+    if (cpuHasAVX2()) u = normalsAVX2(r);
+#endif
+#ifdef CPU_NEON
+    u = normalsNEON(r);
+#endif
+    normalsScalar(r, u, r.width);
+}
+
+// Workers created by the first call and kept until the end of the program, there is no object to own them
+static WorkerPool& workers() {
+    static WorkerPool pool;
+    return pool;
+}
+
+// Row blocks over at most nb_threads threads (0: all of them), the calling thread included
+template<typename F>
+static void parallelRows(int height, int nb_threads, F&& rows) {
+    WorkerPool& pool = workers();
+    if (nb_threads <= 0 || nb_threads > pool.size()) nb_threads = pool.size();
+    const int nb_blocks = std::max(1, std::min(nb_threads, height));
+    const int rows_per_block = (height + nb_blocks - 1) / nb_blocks;
+    pool.run(nb_blocks, [&](int b) {
+        const int first = b * rows_per_block;
+        if (first < height) rows(first, std::min(height, first + rows_per_block));
+    });
+}
+
+void computeNormals(sl::Mat& cloud, sl::Mat& normals, int nb_threads) {
+    const int width = cloud.getWidth(), height = cloud.getHeight();
+    if (!normals.isInit() || normals.getWidth() != cloud.getWidth() || normals.getHeight() != cloud.getHeight() || normals.getDataType() != sl::MAT_TYPE::F32_C4)
+        normals.alloc(cloud.getResolution(), sl::MAT_TYPE::F32_C4, sl::MEM::CPU);
+
+    const float* in = cloud.getPtr<float>(sl::MEM::CPU);
+    const size_t in_step = cloud.getStepBytes(sl::MEM::CPU) / sizeof(float);
+    float* out = normals.getPtr<float>(sl::MEM::CPU);
+    const size_t out_step = normals.getStepBytes(sl::MEM::CPU) / sizeof(float);
+
+    parallelRows(height, nb_threads, [&](int first, int last) {
+        for (int v = first; v < last; v++) {
+            NormalRow r;
+            r.cur = in + v * in_step;
+            r.has_up = v > 0;
+            r.has_down = v + 1 < height;
+            r.up = r.has_up ? r.cur - in_step : r.cur;
+            r.down = r.has_down ? r.cur + in_step : r.cur;
+            r.out = out + v * out_step;
+            r.width = width;
+            normalsRow(r);
+        }
+    });
+}
+
+void shadeWithNormals(sl::Mat& cloud, sl::Mat& normals, float ambient, int nb_threads) {
+    const int width = cloud.getWidth(), height = cloud.getHeight();
+    float* pts = cloud.getPtr<float>(sl::MEM::CPU);
+    const size_t pts_step = cloud.getStepBytes(sl::MEM::CPU) / sizeof(float);
+    const float* nrm = normals.getPtr<float>(sl::MEM::CPU);
+    const size_t nrm_step = normals.getStepBytes(sl::MEM::CPU) / sizeof(float);
+
+    parallelRows(height, nb_threads, [&](int first, int last) {
+        for (int v = first; v < last; v++) {
+            float* p = pts + v * pts_step;
+            const float* n = nrm + v * nrm_step;
+            for (int u = 0; u < width; u++, p += 4, n += 4) {
+                // light at the camera: the cosine is the dot product of the normal with the unit vector towards the camera
+                const float dist = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+                const float cosine = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]) / dist;
+                const float light = ambient + (1.f - ambient) * ((cosine > 0.f) ? cosine : 0.f); // NAN normal: ambient only
+                unsigned char clr[4];
+                memcpy(clr, p + 3, 4);
+                for (int c = 0; c < 3; c++)
+                    clr[c] = static_cast<unsigned char> (clr[c] * std::min(light, 1.f));
+                memcpy(p + 3, clr, 4);
+            }
+        }
+    });
+}
@@ -0,0 +1,70 @@
+/*
+ * CUDA implementation of the voxel grid decimation: every point computes its voxel key and inserts it in a global
+ * hash table with atomicCAS, the thread that creates the voxel appends its point to the output.
+ */
+
+#include "decimation_gpu.hpp"
+
+#define MAX_PROBES 64
+
+// Same key as the CPU implementation: 4 bits of level, 20 bits per axis
+__device__ __forceinline__ bool voxelKey(const float4& p, float inv_voxel, float inv_lod2, unsigned long long& key) {
+    if (!isfinite(p.z)) return false;
+
+    // level = floor(log2(distance / lod_distance)), read from the exponent of the squared ratio
+    const float f = fmaxf(1.f, (p.x * p.x + p.y * p.y + p.z * p.z) * inv_lod2);
+    const int level = min(((__float_as_int(f) >> 23) - 127) >> 1, 14);
+    const float scale = inv_voxel * __int_as_float((127 - level) << 23);
+
+    const unsigned long long ix = (static_cast<int>(floorf(p.x * scale)) + (1 << 19)) & 0xFFFFF;
+    const unsigned long long iy = (static_cast<int>(floorf(p.y * scale)) + (1 << 19)) & 0xFFFFF;
+    const unsigned long long iz = (static_cast<int>(floorf(p.z * scale)) + (1 << 19)) & 0xFFFFF;
+    key = (static_cast<unsigned long long>(level) << 60) | (ix << 40) | (iy << 20) | iz;
+    return true;
+}
+
+__global__ void _k_voxelDecimate(const float4* cloud, size_t step, int width, int height, float inv_voxel, float inv_lod2,
+                                 unsigned long long* table, unsigned int table_mask, unsigned int* counter, float4* out, unsigned int budget) {
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if (x >= width || y >= height) return;
+
+    const float4 p = cloud[x + y * step];
+    unsigned long long key;
+    if (!voxelKey(p, inv_voxel, inv_lod2, key)) return;
+
+    unsigned int h = static_cast<unsigned int>((key * 0x9E3779B97F4A7C15ull) >> 32) & table_mask;
+    for (int probe = 0; probe < MAX_PROBES; probe++) {
+        const unsigned long long prev = atomicCAS(&table[h], DECIMATION_EMPTY_KEY, key);
+        if (prev == key) return; // voxel already taken
+        if (prev == DECIMATION_EMPTY_KEY) {
+            const unsigned int idx = atomicAdd(counter, 1);
+            if (idx < budget) out[idx] = p;
+            return;
+        }
+        h = (h + 1) & table_mask;
+    }
+    // table too crowded around this key, the point is dropped
+}
+
+cudaError_t voxelDecimateGPU(const float4* cloud, size_t step, int width, int height, float inv_voxel, float inv_lod2,
+                             unsigned long long* table, unsigned int table_size, unsigned int* d_counter, float4* out, unsigned int budget,
+                             unsigned int& nb_voxels) {
+    nb_voxels = 0;
+    cudaError_t err = cudaMemset(table, 0xFF, table_size * sizeof(unsigned long long));
+    if (err == cudaSuccess) err = cudaMemset(d_counter, 0, sizeof(unsigned int));
+    if (err != cudaSuccess) return err;
+
+    dim3 dimGrid, dimBlock;
+    dimBlock.x = 32;
+    dimBlock.y = 8;
+    dimGrid.x = (width + dimBlock.x - 1) / dimBlock.x;
+    dimGrid.y = (height + dimBlock.y - 1) / dimBlock.y;
+
+    _k_voxelDecimate << <dimGrid, dimBlock, 0 >> > (cloud, step, width, height, inv_voxel, inv_lod2, table, table_size - 1, d_counter, out, budget);
+    err = cudaGetLastError();
+    if (err != cudaSuccess) return err;
+
+    // also reports the errors of the kernel execution
+    return cudaMemcpy(&nb_voxels, d_counter, sizeof(unsigned int), cudaMemcpyDeviceToHost);
+}
@@ -23,20 +23,85 @@
  ** with the ZED SDK and display the result in an OpenGL window.    **
  *********************************************************************/
 
+// Standard includes
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+
 // ZED includes
 #include <sl/Camera.hpp>
 
 // Sample includes
 #include "GLViewer.hpp"
+#include "DepthFilter.hpp"
+#include "DepthStatistics.hpp"
+#include "DepthToPointCloud.hpp"
+#include "PointCloudDecimator.hpp"
+#include "SurfaceNormals.hpp"
 
 // Using std and sl namespaces
 using namespace std;
 using namespace sl;
 
 
+struct HeadlessOptions {
+    string output; // empty: viewer mode
+    double window_s = 10.;
+    int nb_frames = 0; // 0: until the end of the SVO or Ctrl-C
+};
+
 void parseArgs(int argc, char **argv, sl::InitParameters& param);
+int runHeadless(Camera& zed, const HeadlessOptions& options, bool temporal_filter);
 
 int main(int argc, char **argv) {
+    // '--cpu-upload' displays the point cloud without CUDA-OpenGL interop, it is also used when no CUDA device is available
+    PointCloudBackend backend = PointCloudBackend::CUDA_INTEROP;
+    int nb_cuda_devices = 0;
+    if (cudaGetDeviceCount(&nb_cuda_devices) != cudaSuccess || nb_cuda_devices == 0)
+        backend = PointCloudBackend::CPU_STREAMING;
+    // '--cpu-backproject [stride]' retrieves the depth map only and builds the point cloud on the CPU, keeping one pixel every 'stride'
+    int backproject_stride = 0;
+    // '--temporal-filter' replaces the SDK FILL mode by a temporal filter and hole filling on the CPU, before the back-projection
+    bool temporal_filter = false;
+    // '--normals' shades the point cloud with its surface normals, computed on the CPU ('n' key to toggle)
+    bool normals = false;
+    // '--budget <points>' decimates the point cloud on a voxel grid ('--voxel <mm>') before the upload, '--lod <mm>' makes
+    // the voxels grow with the distance beyond the given range
+    bool decimation = false;
+    DecimationParameters decimation_params;
+    // '--headless <stats.json>' runs without window and writes depth statistics every '--window <s>', for '--frames <n>' frames
+    HeadlessOptions headless;
+    for (int i = 1; i < argc; i++) {
+        const string arg(argv[i]);
+        const bool has_value = i + 1 < argc && atof(argv[i + 1]) > 0;
+        if (arg == "--cpu-upload") backend = PointCloudBackend::CPU_STREAMING;
+        if (arg == "--cpu-backproject") {
+            backproject_stride = has_value ? atoi(argv[i + 1]) : 1;
+            backend = PointCloudBackend::CPU_STREAMING;
+        }
+        if (arg == "--temporal-filter") temporal_filter = true;
+        if (arg == "--normals") normals = true;
+        if (arg == "--budget" && has_value) {
+            decimation = true;
+            decimation_params.point_budget = atoi(argv[i + 1]);
+        }
+        if (arg == "--voxel" && has_value) decimation_params.voxel_size = atof(argv[i + 1]);
+        if (arg == "--lod" && has_value) {
+            decimation_params.mode = DecimationMode::DISTANCE_LOD;
+            decimation_params.lod_distance = atof(argv[i + 1]);
+        }
+        if (arg == "--headless" && i + 1 < argc) headless.output = argv[i + 1];
+        if (arg == "--window" && has_value) headless.window_s = atof(argv[i + 1]);
+        if (arg == "--frames" && has_value) headless.nb_frames = atoi(argv[i + 1]);
+    }
+    if (temporal_filter) {
+        backproject_stride = std::max(backproject_stride, 1);
+        backend = PointCloudBackend::CPU_STREAMING;
+    }
+    if (normals) backend = PointCloudBackend::CPU_STREAMING;
+    const MEM pc_memory = (backend == PointCloudBackend::CPU_STREAMING) ? MEM::CPU : MEM::GPU;
+
     Camera zed;
     // Set configuration parameters for the ZED
     InitParameters init_parameters;
@@ -51,12 +116,33 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     }
 
+    if (!headless.output.empty()) {
+        int ret = runHeadless(zed, headless, temporal_filter);
+        zed.close();
+        return ret;
+    }
+
     auto camera_config = zed.getCameraInformation().camera_configuration;
+    auto left_cam = camera_config.calibration_parameters.left_cam;
+    Resolution cloud_res = camera_config.resolution;
+    if (backproject_stride > 0) {
+        // the viewer sees a camera of the strided resolution
+        cloud_res = Resolution((cloud_res.width + backproject_stride - 1) / backproject_stride, (cloud_res.height + backproject_stride - 1) / backproject_stride);
+        const float scale = cloud_res.width / static_cast<float>(left_cam.image_size.width);
+        left_cam.fx *= scale;
+        left_cam.fy *= scale;
+        left_cam.cx *= scale;
+        left_cam.cy *= scale;
+        left_cam.image_size = cloud_res;
+        print("Point cloud back-projected on the CPU, stride " + to_string(backproject_stride));
+    }
 
     // Point cloud viewer
     GLViewer viewer;
     // Initialize point cloud viewer 
-    GLenum errgl = viewer.init(argc, argv, camera_config.calibration_parameters.left_cam);
+    GLenum errgl = viewer.init(argc, argv, left_cam, backend);
+    if (errgl == GLViewer::OFFSCREEN_ERROR)
+        return EXIT_FAILURE;
     if (errgl != GLEW_OK) {
         print("Error OpenGL: " + std::string((char*)glewGetErrorString(errgl)));
         return EXIT_FAILURE;
@@ -66,21 +152,60 @@ int main(int argc, char **argv) {
     // Setting the depth confidence parameters
     runParameters.confidence_threshold = 50;
     runParameters.texture_confidence_threshold = 100;
+    // the holes are filled by the temporal filter, from the raw depth
+    if (temporal_filter) runParameters.sensing_mode = SENSING_MODE::STANDARD;
 
-    // Allocation of 4 channels of float on GPU
-    Mat point_cloud(camera_config.resolution, MAT_TYPE::F32_C4, MEM::GPU);
+    // Allocation of 4 channels of float on GPU (or CPU)
+    Mat point_cloud(cloud_res, MAT_TYPE::F32_C4, pc_memory);
+    // CPU back-projection: 4 bytes of depth and 4 bytes of color per pixel instead of the 16 bytes of XYZRGBA
+    Mat depth, image;
+    DepthToPointCloud backprojection(camera_config.calibration_parameters.left_cam, init_parameters.coordinate_system);
+    DepthFilter depth_filter;
+    Mat normal_map;
+    // Decimation in the memory of the point cloud, the viewer then gets at most 'point_budget' points
+    Mat decimated;
+    std::unique_ptr<PointCloudDecimator> decimator;
+    if (decimation) {
+        decimation_params.point_budget = std::min<size_t>(decimation_params.point_budget, cloud_res.area());
+        decimator = PointCloudDecimator::create(pc_memory, decimation_params);
+        print("Point cloud decimated to " + to_string(decimation_params.point_budget) + " points per frame");
+    }
 
     // Main Loop
     while (viewer.isAvailable()) {        
         // Check that a new image is successfully acquired
-        if (zed.grab(runParameters) == ERROR_CODE::SUCCESS) {
-            // retrieve the current 3D coloread point cloud in GPU
-            zed.retrieveMeasure(point_cloud, MEASURE::XYZRGBA, MEM::GPU);
-            viewer.updatePointCloud(point_cloud);
+        auto returned_state = zed.grab(runParameters);
+        if (returned_state == ERROR_CODE::SUCCESS) {
+            if (backproject_stride > 0) {
+                zed.retrieveMeasure(depth, MEASURE::DEPTH, MEM::CPU);
+                zed.retrieveImage(image, VIEW::LEFT, MEM::CPU);
+                if (temporal_filter)
+                    depth_filter.process(depth, depth);
+                backprojection.compute(depth, image, point_cloud, Rect(), backproject_stride);
+            } else
+                // retrieve the current 3D coloread point cloud in GPU (or CPU)
+                zed.retrieveMeasure(point_cloud, MEASURE::XYZRGBA, pc_memory);
+            // on the organized cloud, before any decimation
+            if (normals && viewer.isNormalShading()) {
+                computeNormals(point_cloud, normal_map);
+                shadeWithNormals(point_cloud, normal_map);
+            }
+            if (decimator) {
+                int nb_points = static_cast<int> (decimator->process(point_cloud, decimated));
+                viewer.updatePointCloud(decimated, nb_points);
+            } else
+                viewer.updatePointCloud(point_cloud);
+        } else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && OffscreenRenderer::isRequested()) {
+            // Headless rendering of an SVO: stop at its end
+            viewer.exit();
         }
     }
     // free allocated memory before closing the ZED
     point_cloud.free();
+    depth.free();
+    image.free();
+    decimated.free();
+    normal_map.free();
 
     // close the ZED
     zed.close();
@@ -88,6 +213,76 @@ int main(int argc, char **argv) {
     return EXIT_SUCCESS;
 }
 
+static atomic<bool> stop_headless(false);
+
+// A camera that keeps failing (unplugged, broken stream) ends the run instead of retrying forever
+static const int MAX_CONSECUTIVE_GRAB_ERRORS = 100;
+static const int GRAB_ERROR_WAIT_MS = 10;
+
+static void stopHeadless(int) {
+    stop_headless = true;
+}
+
+int runHeadless(Camera& zed, const HeadlessOptions& options, bool temporal_filter) {
+    ofstream output(options.output, ios::app);
+    if (!output) {
+        print("Can not open " + options.output);
+        return EXIT_FAILURE;
+    }
+    signal(SIGINT, stopHeadless);
+
+    RuntimeParameters runParameters;
+    runParameters.confidence_threshold = 50;
+    runParameters.texture_confidence_threshold = 100;
+    if (temporal_filter) runParameters.sensing_mode = SENSING_MODE::STANDARD;
+
+    auto init = zed.getInitParameters();
+    DepthStatistics stats(max(0.f, init.depth_minimum_distance), init.depth_maximum_distance);
+    DepthFilter depth_filter;
+    Mat depth, confidence;
+    print("Headless mode, statistics written to " + options.output + " every " + to_string(options.window_s) + " s. Use Ctrl-C to stop.");
+
+    auto window_start = chrono::steady_clock::now();
+    int nb_frames = 0;
+    int consecutive_errors = 0;
+    while (!stop_headless && (options.nb_frames <= 0 || nb_frames < options.nb_frames)) {
+        auto t0 = chrono::steady_clock::now();
+        auto err = zed.grab(runParameters);
+        auto t1 = chrono::steady_clock::now();
+        if (err == ERROR_CODE::END_OF_SVOFILE_REACHED) break;
+        if (err != ERROR_CODE::SUCCESS) {
+            stats.addGrabError();
+            if (++consecutive_errors >= MAX_CONSECUTIVE_GRAB_ERRORS) {
+                print("Camera lost, headless mode stopped", err);
+                break;
+            }
+            // a failing grab returns at once, do not spin on it
+            sleep_ms(GRAB_ERROR_WAIT_MS);
+            continue;
+        }
+        consecutive_errors = 0;
+        zed.retrieveMeasure(depth, MEASURE::DEPTH, MEM::CPU);
+        zed.retrieveMeasure(confidence, MEASURE::CONFIDENCE, MEM::CPU);
+        auto t2 = chrono::steady_clock::now();
+        if (temporal_filter)
+            depth_filter.process(depth, depth);
+        stats.addFrame(depth, confidence, chrono::duration<double, milli>(t1 - t0).count(), chrono::duration<double, milli>(t2 - t1).count());
+        nb_frames++;
+
+        const double elapsed = chrono::duration<double>(chrono::steady_clock::now() - window_start).count();
+        if (elapsed >= options.window_s) {
+            stats.writeSummary(output, zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds(), elapsed);
+            window_start = chrono::steady_clock::now();
+        }
+    }
+    // last, partial window
+    if (stats.getNbFrames())
+        stats.writeSummary(output, zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds(),
+                           chrono::duration<double>(chrono::steady_clock::now() - window_start).count());
+    print(to_string(nb_frames) + " frames processed");
+    return EXIT_SUCCESS;
+}
+
 void parseArgs(int argc, char **argv, sl::InitParameters& param) {
     if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
         // SVO input mode
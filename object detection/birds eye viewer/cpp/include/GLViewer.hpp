@@ -12,6 +12,11 @@
 #include <cuda.h>
 #include <cuda_gl_interop.h>
 
+#include "CameraGL.hpp"
+#include "Shader.hpp"
+#include "Simple3DObject.hpp"
+#include "InstancedObject.hpp"
+
 #include <opencv2/opencv.hpp>
 
 #include "utils.hpp"
@@ -32,161 +37,6 @@ std::vector<sl::float3> getBBoxOnFloorPlane(std::vector<sl::float3> &bbox, sl::P
 
 // 3D
 
-class CameraGL {
-public:
-
-    CameraGL() {
-    }
-
-    enum DIRECTION {
-        UP, DOWN, LEFT, RIGHT, FORWARD, BACK
-    };
-    CameraGL(sl::Translation position, sl::Translation direction, sl::Translation vertical = sl::Translation(0, 1, 0)); // vertical = Eigen::Vector3f(0, 1, 0)
-    ~CameraGL();
-
-    void update();
-    void setProjection(float horizontalFOV, float verticalFOV, float znear, float zfar);
-    const sl::Transform& getViewProjectionMatrix() const;
-
-    float getHorizontalFOV() const;
-    float getVerticalFOV() const;
-
-    // Set an offset between the eye of the camera and its position
-    // Note: Useful to use the camera as a trackball camera with z>0 and x = 0, y = 0
-    // Note: coordinates are in local space
-    void setOffsetFromPosition(const sl::Translation& offset);
-    const sl::Translation& getOffsetFromPosition() const;
-
-    void setDirection(const sl::Translation& direction, const sl::Translation &vertical);
-    void translate(const sl::Translation& t);
-    void setPosition(const sl::Translation& p);
-    void rotate(const sl::Orientation& rot);
-    void rotate(const sl::Rotation& m);
-    void setRotation(const sl::Orientation& rot);
-    void setRotation(const sl::Rotation& m);
-
-    const sl::Translation& getPosition() const;
-    const sl::Translation& getForward() const;
-    const sl::Translation& getRight() const;
-    const sl::Translation& getUp() const;
-    const sl::Translation& getVertical() const;
-    float getZNear() const;
-    float getZFar() const;
-
-    static const sl::Translation ORIGINAL_FORWARD;
-    static const sl::Translation ORIGINAL_UP;
-    static const sl::Translation ORIGINAL_RIGHT;
-
-    sl::Transform projection_;
-    bool usePerspective_;
-private:
-    void updateVectors();
-    void updateView();
-    void updateVPMatrix();
-
-    sl::Translation offset_;
-    sl::Translation position_;
-    sl::Translation forward_;
-    sl::Translation up_;
-    sl::Translation right_;
-    sl::Translation vertical_;
-
-    sl::Orientation rotation_;
-
-    sl::Transform view_;
-    sl::Transform vpMatrix_;
-    float horizontalFieldOfView_;
-    float verticalFieldOfView_;
-    float znear_;
-    float zfar_;
-};
-
-class Shader {
-public:
-
-    Shader() {
-    }
-    Shader(GLchar* vs, GLchar* fs);
-    ~Shader();
-    GLuint getProgramId();
-
-    static const GLint ATTRIB_VERTICES_POS = 0;
-    static const GLint ATTRIB_COLOR_POS = 1;
-private:
-    bool compile(GLuint &shaderId, GLenum type, GLchar* src);
-    GLuint verterxId_;
-    GLuint fragmentId_;
-    GLuint programId_;
-};
-
-struct ShaderData {
-    Shader it;
-    GLuint MVP_Mat;
-};
-
-class Simple3DObject {
-public:
-
-    Simple3DObject() {
-    }
-    Simple3DObject(sl::Translation position, bool isStatic);
-    ~Simple3DObject();
-
-    void addPt(sl::float3 pt);
-    void addClr(sl::float4 clr);
-
-    void addBBox(std::vector<sl::float3> &pts, sl::float4 clr);
-    void addPoint(sl::float3 pt, sl::float4 clr);
-    void addTriangle(sl::float3 p1, sl::float3 p2, sl::float3 p3, sl::float4 clr);
-    void addLine(sl::float3 p1, sl::float3 p2, sl::float4 clr);
-
-    // New 3D rendering
-    void addFullEdges(std::vector<sl::float3> &pts, sl::float4 clr);
-    void addVerticalEdges(std::vector<sl::float3> &pts, sl::float4 clr);
-    void addTopFace(std::vector<sl::float3> &pts, sl::float4 clr);
-    void addVerticalFaces(std::vector<sl::float3> &pts, sl::float4 clr);
-
-    void pushToGPU();
-    void clear();
-
-    void setDrawingType(GLenum type);
-
-    void draw();
-
-    void translate(const sl::Translation& t);
-    void setPosition(const sl::Translation& p);
-
-    void setRT(const sl::Transform& mRT);
-
-    void rotate(const sl::Orientation& rot);
-    void rotate(const sl::Rotation& m);
-    void setRotation(const sl::Orientation& rot);
-    void setRotation(const sl::Rotation& m);
-
-    const sl::Translation& getPosition() const;
-
-    sl::Transform getModelMatrix() const;
-private:
-    std::vector<float> vertices_;
-    std::vector<float> colors_;
-    std::vector<unsigned int> indices_;
-
-    bool isStatic_;
-
-    GLenum drawingType_;
-
-    GLuint vaoID_;
-    /*
-    Vertex buffer IDs:
-    - [0]: Vertices coordinates;
-    - [1]: Indices;
-     */
-    GLuint vboID_[2];
-
-    sl::Translation position_;
-    sl::Orientation rotation_;
-};
-
 class PointCloud {
 public:
     PointCloud();
@@ -288,13 +138,16 @@ private:
     CameraGL camera_;
     ShaderData shaderLine;
     ShaderData shader;
+    ShaderData shaderBBox;
     sl::float4 bckgrnd_clr;
     sl::Transform cam_pose;
 
     std::vector<ObjectClassName> objectsName;
-    Simple3DObject BBox_edges;
-    Simple3DObject BBox_faces;
+    // One instance per object
+    InstancedObject BBox_edges;
+    InstancedObject BBox_faces;
     Simple3DObject skeletons;
+    Simple3DObject centroids;
     Simple3DObject floor_grid;
 };
 
@@ -7,7 +7,6 @@
 #endif
 
 #define FADED_RENDERING
-const float grid_size = 10.0f;
 
 GLchar* VERTEX_SHADER =
         "#version 330 core\n"
@@ -16,10 +15,26 @@ GLchar* VERTEX_SHADER =
         "uniform mat4 u_mvpMatrix;\n"
         "out vec4 b_color;\n"
         "void main() {\n"
-        "   b_color = in_Color;\n"
+        "   b_color = in_Color.bgra;\n" // the colors of this sample are BGR
         "	gl_Position = u_mvpMatrix * vec4(in_Vertex, 1);\n"
         "}";
 
+GLchar* BBOX_VERTEX_SHADER =
+        "#version 330 core\n"
+        "layout(location = 0) in vec3 in_Vertex;\n"
+        "layout(location = 1) in vec4 in_Color;\n"
+        "layout(location = 3) in vec4 in_ModelX;\n"
+        "layout(location = 4) in vec4 in_ModelY;\n"
+        "layout(location = 5) in vec4 in_ModelZ;\n"
+        "layout(location = 6) in vec4 in_InstanceColor;\n"
+        "uniform mat4 u_mvpMatrix;\n"
+        "out vec4 b_color;\n"
+        "void main() {\n"
+        "   vec4 v = vec4(in_Vertex, 1);\n"
+        "   b_color = vec4((in_Color.rgb * in_InstanceColor.rgb).bgr, in_Color.a);\n" // the fading comes from the unit box
+        "	gl_Position = u_mvpMatrix * vec4(dot(in_ModelX, v), dot(in_ModelY, v), dot(in_ModelZ, v), 1);\n"
+        "}";
+
 GLchar* FRAGMENT_SHADER =
         "#version 330 core\n"
         "in vec4 b_color;\n"
@@ -136,6 +151,9 @@ void GLViewer::init(int argc, char **argv, sl::CameraParameters &param) {
     shaderLine.it = Shader(VERTEX_SHADER, FRAGMENT_SHADER);
     shaderLine.MVP_Mat = glGetUniformLocation(shaderLine.it.getProgramId(), "u_mvpMatrix");
 
+    shaderBBox.it = Shader(BBOX_VERTEX_SHADER, FRAGMENT_SHADER);
+    shaderBBox.MVP_Mat = glGetUniformLocation(shaderBBox.it.getProgramId(), "u_mvpMatrix");
+
     // Create the camera
     camera_ = CameraGL(sl::Translation(0, 0, 1000), sl::Translation(0, 0, -100));
     camera_.setOffsetFromPosition(sl::Translation(0, 0, 1500));
@@ -143,15 +161,27 @@ void GLViewer::init(int argc, char **argv, sl::CameraParameters &param) {
     frustum = createFrustum(param);
     frustum.pushToGPU();
 
-    BBox_edges = Simple3DObject(sl::Translation(0, 0, 0), false);
+    // Unit bounding box, in white: each instance gives its transform and color
+    std::vector<sl::float3> unit_box = InstancedObject::unitBox();
+    const sl::float4 white(1, 1, 1, 1);
+
+    // Top and bottom full edges, faded vertical edges
+    BBox_edges.addFullEdges(unit_box, white);
+    BBox_edges.addVerticalEdges(unit_box, white);
     BBox_edges.setDrawingType(GL_LINES);
-    
-    BBox_faces = Simple3DObject(sl::Translation(0, 0, 0), false);
+
+    // Faded faces and top face
+    BBox_faces.addVerticalFaces(unit_box, white);
+    BBox_faces.addTopFace(unit_box, white);
     BBox_faces.setDrawingType(GL_QUADS);
 
     skeletons = Simple3DObject(sl::Translation(0, 0, 0), false);
     skeletons.setDrawingType(GL_LINES);
 
+    // Thin lines, as the bounding boxes edges
+    centroids = Simple3DObject(sl::Translation(0, 0, 0), false);
+    centroids.setDrawingType(GL_LINES);
+
     bckgrnd_clr = sl::float4(0.2f, 0.19f, 0.2f, 1.0f);
 
     floor_grid = Simple3DObject(sl::Translation(0, 0, 0), true);
@@ -192,10 +222,11 @@ void GLViewer::render() {
 void GLViewer::updateData(sl::Mat &matXYZRGBA, std::vector<sl::ObjectData> &objs, sl::Transform& pose) {
     mtx.lock();
     pointCloud_.pushNewPC(matXYZRGBA);
-    BBox_edges.clear();
-    BBox_faces.clear();
+    BBox_edges.clearInstances();
+    BBox_faces.clearInstances();
     objectsName.clear();
     skeletons.clear();
+    centroids.clear();
     cam_pose = pose;
     sl::float3 tr_0(0, 0, 0);
     cam_pose.setTranslation(tr_0);
@@ -224,8 +255,8 @@ void GLViewer::updateData(sl::Mat &matXYZRGBA, std::vector<sl::ObjectData> &objs
                     sl::float3 centroid4 = objs[i].position;
                     centroid4.x -= size_cendtroid;
 
-                    BBox_edges.addLine(centroid1, centroid2, sl::float4(1.f, 0.5f, 0.5f, 1.f));
-                    BBox_edges.addLine(centroid3, centroid4, sl::float4(1.f, 0.5f, 0.5f, 1.f));
+                    centroids.addLine(centroid1, centroid2, sl::float4(1.f, 0.5f, 0.5f, 1.f));
+                    centroids.addLine(centroid3, centroid4, sl::float4(1.f, 0.5f, 0.5f, 1.f));
                 }
                 
                 //Display sekeleton if available
@@ -247,14 +278,9 @@ void GLViewer::updateData(sl::Mat &matXYZRGBA, std::vector<sl::ObjectData> &objs
 }
 
 void GLViewer::createBboxRendering(std::vector<sl::float3> &bbox, sl::float4 bbox_clr) {
-    // First create top and bottom full edges
-    BBox_edges.addFullEdges(bbox, bbox_clr);
-    // Add faded vertical edges
-    BBox_edges.addVerticalEdges(bbox, bbox_clr);
-    // Add faces
-    BBox_faces.addVerticalFaces(bbox, bbox_clr);
-    // Add top face
-    BBox_faces.addTopFace(bbox, bbox_clr);
+    // Edges and faces of the unit box, see init()
+    BBox_edges.addBoxInstance(bbox, bbox_clr);
+    BBox_faces.addBoxInstance(bbox, bbox_clr);
 }
 
 void GLViewer::createIDRendering(sl::float3 & center, sl::float4 clr, unsigned int id) {
@@ -312,6 +338,7 @@ void GLViewer::update() {
     BBox_edges.pushToGPU();
     BBox_faces.pushToGPU();
     skeletons.pushToGPU();
+    centroids.pushToGPU();
     pointCloud_.update();
     mtx.unlock();
     clearInputs();
@@ -337,10 +364,15 @@ void GLViewer::draw() {
     glUniformMatrix4fv(shader.MVP_Mat, 1, GL_TRUE, vpMatrix.m);
     glLineWidth(2.f);
     frustum.draw();
-    glLineWidth(1.5f);
-    BBox_edges.draw();
     glLineWidth(4.f);
     skeletons.draw();
+    glLineWidth(1.5f);
+    centroids.draw();
+
+    glUseProgram(shaderBBox.it.getProgramId());
+    glUniformMatrix4fv(shaderBBox.MVP_Mat, 1, GL_TRUE, vpMatrix.m);
+    glLineWidth(1.5f);
+    BBox_edges.draw();
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     BBox_faces.draw();
     glUseProgram(0);
@@ -422,388 +454,6 @@ void GLViewer::idle() {
     glutPostRedisplay();
 }
 
-Simple3DObject::Simple3DObject(sl::Translation position, bool isStatic) : isStatic_(isStatic) {
-    vaoID_ = 0;
-    drawingType_ = GL_TRIANGLES;
-    position_ = position;
-    rotation_.setIdentity();
-}
-
-Simple3DObject::~Simple3DObject() {
-    if (vaoID_ != 0) {
-        glDeleteBuffers(3, vboID_);
-        glDeleteVertexArrays(1, &vaoID_);
-    }
-}
-
-void Simple3DObject::addBBox(std::vector<sl::float3> &pts, sl::float4 clr) {
-    int start_id = vertices_.size() / 3;
-
-    float transparency_top = 0.05f, transparency_bottom = 0.75f;
-    for (unsigned int i = 0; i < pts.size(); i++) {
-        addPt(pts[i]);
-        clr.a = (i < 4 ? transparency_top : transparency_bottom);
-        addClr(clr);
-    }
-
-    const std::vector<int> boxLinks = {4, 5, 5, 6, 6, 7, 7, 4, 0, 4, 1, 5, 2, 6, 3, 7};
-
-    for (unsigned int i = 0; i < boxLinks.size(); i += 2) {
-        indices_.push_back(start_id + boxLinks[i]);
-        indices_.push_back(start_id + boxLinks[i + 1]);
-    }
-}
-
-void Simple3DObject::addPt(sl::float3 pt) {
-    vertices_.push_back(pt.x);
-    vertices_.push_back(pt.y);
-    vertices_.push_back(pt.z);
-}
-
-void Simple3DObject::addClr(sl::float4 clr) {
-    colors_.push_back(clr.b);
-    colors_.push_back(clr.g);
-    colors_.push_back(clr.r);
-    colors_.push_back(clr.a);
-}
-
-void Simple3DObject::addPoint(sl::float3 pt, sl::float4 clr) {
-    addPt(pt);
-    addClr(clr);
-    indices_.push_back((int) indices_.size());
-}
-
-void Simple3DObject::addLine(sl::float3 p1, sl::float3 p2, sl::float4 clr) {
-    addPoint(p1, clr);
-    addPoint(p2, clr);
-}
-
-void Simple3DObject::addTriangle(sl::float3 p1, sl::float3 p2, sl::float3 p3, sl::float4 clr) {   
-    addPoint(p1, clr);
-    addPoint(p2, clr);
-    addPoint(p3, clr);
-}
-
-void Simple3DObject::addFullEdges(std::vector<sl::float3> &pts, sl::float4 clr) {
-	clr.w = 0.4f;
-
-    int start_id = vertices_.size() / 3;
-
-    for (unsigned int i = 0; i < pts.size(); i++) {
-        addPt(pts[i]);
-        addClr(clr);
-    }
-
-    const std::vector<int> boxLinksTop = {0, 1, 1, 2, 2, 3, 3, 0};
-    for (unsigned int i = 0; i < boxLinksTop.size(); i += 2) {
-        indices_.push_back(start_id + boxLinksTop[i]);
-        indices_.push_back(start_id + boxLinksTop[i + 1]);
-    }
-
-    const std::vector<int> boxLinksBottom = {4, 5, 5, 6, 6, 7, 7, 4};
-    for (unsigned int i = 0; i < boxLinksBottom.size(); i += 2) {
-        indices_.push_back(start_id + boxLinksBottom[i]);
-        indices_.push_back(start_id + boxLinksBottom[i + 1]);
-    }
-}
-
-void Simple3DObject::addVerticalEdges(std::vector<sl::float3> &pts, sl::float4 clr) {
-    auto addSingleVerticalLine = [&](sl::float3 top_pt, sl::float3 bot_pt) {
-        std::vector<sl::float3> current_pts{
-            top_pt,
-                    ((grid_size - 1.0f) * top_pt + bot_pt) / grid_size,
-                    ((grid_size - 2.0f) * top_pt + bot_pt * 2.0f) / grid_size,
-                    (2.0f * top_pt + bot_pt * (grid_size - 2.0f)) / grid_size,
-                    (top_pt + bot_pt * (grid_size - 1.0f)) / grid_size,
-                    bot_pt};
-
-        int start_id = vertices_.size() / 3;
-        for (unsigned int i = 0; i < current_pts.size(); i++) {
-            addPt(current_pts[i]);
-            clr.a = (i == 2 || i == 3) ? 0.0f : 0.4f;
-            addClr(clr);
-        }
-
-        const std::vector<int> boxLinks = {0, 1, 1, 2, 2, 3, 3, 4, 4, 5};
-        for (unsigned int i = 0; i < boxLinks.size(); i += 2) {
-            indices_.push_back(start_id + boxLinks[i]);
-            indices_.push_back(start_id + boxLinks[i + 1]);
-        }
-    };
-
-    addSingleVerticalLine(pts[0], pts[4]);
-    addSingleVerticalLine(pts[1], pts[5]);
-    addSingleVerticalLine(pts[2], pts[6]);
-    addSingleVerticalLine(pts[3], pts[7]);
-}
-
-void Simple3DObject::addTopFace(std::vector<sl::float3> &pts, sl::float4 clr) {
-    clr.a = 0.3f;
-    for (auto it : pts)
-        addPoint(it, clr);
-}
-
-void Simple3DObject::addVerticalFaces(std::vector<sl::float3> &pts, sl::float4 clr) {
-    auto addQuad = [&](std::vector<sl::float3> quad_pts, float alpha1, float alpha2) { // To use only with 4 points
-        for (unsigned int i = 0; i < quad_pts.size(); ++i) {
-            addPt(quad_pts[i]);
-            clr.a = (i < 2 ? alpha1 : alpha2);
-            addClr(clr);
-        }
-
-        indices_.push_back((int) indices_.size());
-        indices_.push_back((int) indices_.size());
-        indices_.push_back((int) indices_.size());
-        indices_.push_back((int) indices_.size());
-    };
-
-    // For each face, we need to add 4 quads (the first 2 indexes are always the top points of the quad)
-    std::vector<std::vector<int>> quads
-    {
-        {
-            0, 3, 7, 4
-        }, // front face
-        {
-            3, 2, 6, 7
-        }, // right face
-        {
-            2, 1, 5, 6
-        }, // back face
-        {
-            1, 0, 4, 5
-        } // left face
-    };
-	float alpha = 0.5f;
-
-	for (const auto quad : quads) {
-
-		// Top quads
-		std::vector<sl::float3> quad_pts_1{
-			pts[quad[0]],
-			pts[quad[1]],
-			((grid_size - 0.5f) * pts[quad[1]] + 0.5f * pts[quad[2]]) / grid_size,
-			((grid_size - 0.5f) * pts[quad[0]] + 0.5f * pts[quad[3]]) / grid_size };
-		addQuad(quad_pts_1, alpha, alpha);
-
-		std::vector<sl::float3> quad_pts_2{
-			((grid_size - 0.5f) * pts[quad[0]] + 0.5f * pts[quad[3]]) / grid_size,
-			((grid_size - 0.5f) * pts[quad[1]] + 0.5f * pts[quad[2]]) / grid_size,
-			((grid_size - 1.0f) * pts[quad[1]] + pts[quad[2]]) / grid_size,
-			((grid_size - 1.0f) * pts[quad[0]] + pts[quad[3]]) / grid_size };
-		addQuad(quad_pts_2, alpha, 2 * alpha / 3);
-
-		std::vector<sl::float3> quad_pts_3{
-			((grid_size - 1.0f) * pts[quad[0]] + pts[quad[3]]) / grid_size,
-			((grid_size - 1.0f) * pts[quad[1]] + pts[quad[2]]) / grid_size,
-			((grid_size - 1.5f) * pts[quad[1]] + 1.5f * pts[quad[2]]) / grid_size,
-			((grid_size - 1.5f) * pts[quad[0]] + 1.5f * pts[quad[3]]) / grid_size };
-		addQuad(quad_pts_3, 2 * alpha / 3, alpha / 3);
-
-		std::vector<sl::float3> quad_pts_4{
-			((grid_size - 1.5f) * pts[quad[0]] + 1.5f * pts[quad[3]]) / grid_size,
-			((grid_size - 1.5f) * pts[quad[1]] + 1.5f * pts[quad[2]]) / grid_size,
-			((grid_size - 2.0f) * pts[quad[1]] + 2.0f * pts[quad[2]]) / grid_size,
-			((grid_size - 2.0f) * pts[quad[0]] + 2.0f * pts[quad[3]]) / grid_size };
-		addQuad(quad_pts_4, alpha / 3, 0.0f);
-
-		// Bottom quads
-		std::vector<sl::float3> quad_pts_5{
-			(pts[quad[1]] * 2.0f + (grid_size - 2.0f) * pts[quad[2]]) / grid_size,
-			(pts[quad[0]] * 2.0f + (grid_size - 2.0f) * pts[quad[3]]) / grid_size,
-			(pts[quad[0]] * 1.5f + (grid_size - 1.5f) * pts[quad[3]]) / grid_size,
-			(pts[quad[1]] * 1.5f + (grid_size - 1.5f) * pts[quad[2]]) / grid_size };
-		addQuad(quad_pts_5, 0.0f, alpha / 3);
-
-		std::vector<sl::float3> quad_pts_6{
-			(pts[quad[1]] * 1.5f + (grid_size - 1.5f) * pts[quad[2]]) / grid_size,
-			(pts[quad[0]] * 1.5f + (grid_size - 1.5f) * pts[quad[3]]) / grid_size,
-			(pts[quad[0]] + (grid_size - 1.0f) * pts[quad[3]]) / grid_size,
-			(pts[quad[1]] + (grid_size - 1.0f) * pts[quad[2]]) / grid_size };
-		addQuad(quad_pts_6, alpha / 3, 2 * alpha / 3);
-
-		std::vector<sl::float3> quad_pts_7{
-			(pts[quad[1]] + (grid_size - 1.0f) * pts[quad[2]]) / grid_size,
-			(pts[quad[0]] + (grid_size - 1.0f) * pts[quad[3]]) / grid_size,
-			(pts[quad[0]] * 0.5f + (grid_size - 0.5f) * pts[quad[3]]) / grid_size,
-			(pts[quad[1]] * 0.5f + (grid_size - 0.5f) * pts[quad[2]]) / grid_size };
-		addQuad(quad_pts_7, 2 * alpha / 3, alpha);
-
-		std::vector<sl::float3> quad_pts_8{
-			(pts[quad[0]] * 0.5f + (grid_size - 0.5f) * pts[quad[3]]) / grid_size,
-			(pts[quad[1]] * 0.5f + (grid_size - 0.5f) * pts[quad[2]]) / grid_size,
-			pts[quad[2]],
-			pts[quad[3]] };
-		addQuad(quad_pts_8, alpha, alpha);
-	}
-}
-
-void Simple3DObject::pushToGPU() {
-    if (!isStatic_ || vaoID_ == 0) {
-        if (vaoID_ == 0) {
-            glGenVertexArrays(1, &vaoID_);
-            glGenBuffers(3, vboID_);
-        }
-
-        if (vertices_.size() > 0) {
-            glBindVertexArray(vaoID_);
-            glBindBuffer(GL_ARRAY_BUFFER, vboID_[0]);
-            glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof (float), &vertices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(Shader::ATTRIB_VERTICES_POS, 3, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(Shader::ATTRIB_VERTICES_POS);
-        }
-
-        if (colors_.size() > 0) {
-            glBindBuffer(GL_ARRAY_BUFFER, vboID_[1]);
-            glBufferData(GL_ARRAY_BUFFER, colors_.size() * sizeof (float), &colors_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(Shader::ATTRIB_COLOR_POS, 4, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(Shader::ATTRIB_COLOR_POS);
-        }
-
-        if (indices_.size() > 0) {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboID_[2]);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof (unsigned int), &indices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-        }
-
-        glBindVertexArray(0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
-}
-
-void Simple3DObject::clear() {
-    vertices_.clear();
-    colors_.clear();
-    indices_.clear();
-}
-
-void Simple3DObject::setDrawingType(GLenum type) {
-    drawingType_ = type;
-}
-
-void Simple3DObject::draw() {
-    if (indices_.size() && vaoID_) {
-        glBindVertexArray(vaoID_);
-        glDrawElements(drawingType_, (GLsizei) indices_.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    }
-}
-
-void Simple3DObject::translate(const sl::Translation& t) {
-    position_ = position_ + t;
-}
-
-void Simple3DObject::setPosition(const sl::Translation& p) {
-    position_ = p;
-}
-
-void Simple3DObject::setRT(const sl::Transform& mRT) {
-    position_ = mRT.getTranslation();
-    rotation_ = mRT.getOrientation();
-}
-
-void Simple3DObject::rotate(const sl::Orientation& rot) {
-    rotation_ = rot * rotation_;
-}
-
-void Simple3DObject::rotate(const sl::Rotation& m) {
-    this->rotate(sl::Orientation(m));
-}
-
-void Simple3DObject::setRotation(const sl::Orientation& rot) {
-    rotation_ = rot;
-}
-
-void Simple3DObject::setRotation(const sl::Rotation& m) {
-    this->setRotation(sl::Orientation(m));
-}
-
-const sl::Translation& Simple3DObject::getPosition() const {
-    return position_;
-}
-
-sl::Transform Simple3DObject::getModelMatrix() const {
-    sl::Transform tmp;
-    tmp.setOrientation(rotation_);
-    tmp.setTranslation(position_);
-    return tmp;
-}
-
-Shader::Shader(GLchar* vs, GLchar* fs) {
-    if (!compile(verterxId_, GL_VERTEX_SHADER, vs)) {
-        std::cout << "ERROR: while compiling vertex shader" << std::endl;
-    }
-    if (!compile(fragmentId_, GL_FRAGMENT_SHADER, fs)) {
-        std::cout << "ERROR: while compiling fragment shader" << std::endl;
-    }
-
-    programId_ = glCreateProgram();
-
-    glAttachShader(programId_, verterxId_);
-    glAttachShader(programId_, fragmentId_);
-
-    glBindAttribLocation(programId_, ATTRIB_VERTICES_POS, "in_vertex");
-    glBindAttribLocation(programId_, ATTRIB_COLOR_POS, "in_texCoord");
-
-    glLinkProgram(programId_);
-
-    GLint errorlk(0);
-    glGetProgramiv(programId_, GL_LINK_STATUS, &errorlk);
-    if (errorlk != GL_TRUE) {
-        std::cout << "ERROR: while linking Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetProgramiv(programId_, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(programId_, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteProgram(programId_);
-    }
-}
-
-Shader::~Shader() {
-    if (verterxId_ != 0)
-        glDeleteShader(verterxId_);
-    if (fragmentId_ != 0)
-        glDeleteShader(fragmentId_);
-    if (programId_ != 0)
-        glDeleteShader(programId_);
-}
-
-GLuint Shader::getProgramId() {
-    return programId_;
-}
-
-bool Shader::compile(GLuint &shaderId, GLenum type, GLchar* src) {
-    shaderId = glCreateShader(type);
-    if (shaderId == 0) {
-        std::cout << "ERROR: shader type (" << type << ") does not exist" << std::endl;
-        return false;
-    }
-    glShaderSource(shaderId, 1, (const char**) &src, 0);
-    glCompileShader(shaderId);
-
-    GLint errorCp(0);
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &errorCp);
-    if (errorCp != GL_TRUE) {
-        std::cout << "ERROR: while compiling Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(shaderId, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteShader(shaderId);
-        return false;
-    }
-    return true;
-}
-
 GLchar* POINTCLOUD_VERTEX_SHADER =
         "#version 330 core\n"
         "layout(location = 0) in vec4 in_VertexRGBA;\n"
@@ -891,143 +541,4 @@ void PointCloud::draw(const sl::Transform& vp) {
     }
 }
 
-const sl::Translation CameraGL::ORIGINAL_FORWARD = sl::Translation(0, 0, 1);
-const sl::Translation CameraGL::ORIGINAL_UP = sl::Translation(0, 1, 0);
-const sl::Translation CameraGL::ORIGINAL_RIGHT = sl::Translation(1, 0, 0);
-
-CameraGL::CameraGL(sl::Translation position, sl::Translation direction, sl::Translation vertical) {
-    this->position_ = position;
-    setDirection(direction, vertical);
-
-    offset_ = sl::Translation(0, 0, 0);
-    view_.setIdentity();
-    updateView();
-    setProjection(70, 70, 200.f, 50000.f);
-    updateVPMatrix();
-}
-
-CameraGL::~CameraGL() {}
 
-void CameraGL::update() {
-    if (sl::Translation::dot(vertical_, up_) < 0)
-        vertical_ = vertical_ * -1.f;
-    updateView();
-    updateVPMatrix();
-}
-
-void CameraGL::setProjection(float horizontalFOV, float verticalFOV, float znear, float zfar) {
-    horizontalFieldOfView_ = horizontalFOV;
-    verticalFieldOfView_ = verticalFOV;
-    znear_ = znear;
-    zfar_ = zfar;
-
-    float fov_y = verticalFOV * M_PI / 180.f;
-    float fov_x = horizontalFOV * M_PI / 180.f;
-
-    projection_.setIdentity();
-    projection_(0, 0) = 1.0f / tanf(fov_x * 0.5f);
-    projection_(1, 1) = 1.0f / tanf(fov_y * 0.5f);
-    projection_(2, 2) = -(zfar + znear) / (zfar - znear);
-    projection_(3, 2) = -1;
-    projection_(2, 3) = -(2.f * zfar * znear) / (zfar - znear);
-    projection_(3, 3) = 0;
-}
-
-const sl::Transform& CameraGL::getViewProjectionMatrix() const {
-    return vpMatrix_;
-}
-
-float CameraGL::getHorizontalFOV() const {
-    return horizontalFieldOfView_;
-}
-
-float CameraGL::getVerticalFOV() const {
-    return verticalFieldOfView_;
-}
-
-void CameraGL::setOffsetFromPosition(const sl::Translation& o) {
-    offset_ = o;
-}
-
-const sl::Translation& CameraGL::getOffsetFromPosition() const {
-    return offset_;
-}
-
-void CameraGL::setDirection(const sl::Translation& direction, const sl::Translation& vertical) {
-    sl::Translation dirNormalized = direction;
-    dirNormalized.normalize();
-    this->rotation_ = sl::Orientation(ORIGINAL_FORWARD, dirNormalized * -1.f);
-    updateVectors();
-    this->vertical_ = vertical;
-    if (sl::Translation::dot(vertical_, up_) < 0)
-        rotate(sl::Rotation(M_PI, ORIGINAL_FORWARD));
-}
-
-void CameraGL::translate(const sl::Translation& t) {
-    position_ = position_ + t;
-}
-
-void CameraGL::setPosition(const sl::Translation& p) {
-    position_ = p;
-}
-
-void CameraGL::rotate(const sl::Orientation& rot) {
-    rotation_ = rot * rotation_;
-    updateVectors();
-}
-
-void CameraGL::rotate(const sl::Rotation& m) {
-    this->rotate(sl::Orientation(m));
-}
-
-void CameraGL::setRotation(const sl::Orientation& rot) {
-    rotation_ = rot;
-    updateVectors();
-}
-
-void CameraGL::setRotation(const sl::Rotation& m) {
-    this->setRotation(sl::Orientation(m));
-}
-
-const sl::Translation& CameraGL::getPosition() const {
-    return position_;
-}
-
-const sl::Translation& CameraGL::getForward() const {
-    return forward_;
-}
-
-const sl::Translation& CameraGL::getRight() const {
-    return right_;
-}
-
-const sl::Translation& CameraGL::getUp() const {
-    return up_;
-}
-
-const sl::Translation& CameraGL::getVertical() const {
-    return vertical_;
-}
-
-float CameraGL::getZNear() const {
-    return znear_;
-}
-
-float CameraGL::getZFar() const {
-    return zfar_;
-}
-
-void CameraGL::updateVectors() {
-    forward_ = ORIGINAL_FORWARD * rotation_;
-    up_ = ORIGINAL_UP * rotation_;
-    right_ = sl::Translation(ORIGINAL_RIGHT * -1.f) * rotation_;
-}
-
-void CameraGL::updateView() {
-    sl::Transform transformation(rotation_, (offset_ * rotation_) + position_);
-    view_ = sl::Transform::inverse(transformation);
-}
-
-void CameraGL::updateVPMatrix() {
-    vpMatrix_ = projection_ * view_;
-}
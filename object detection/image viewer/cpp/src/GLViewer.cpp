@@ -9,11 +9,16 @@ GLchar* VERTEX_SHADER =
         "#version 330 core\n"
         "layout(location = 0) in vec3 in_Vertex;\n"
         "layout(location = 1) in vec4 in_Color;\n"
+        "layout(location = 3) in vec4 in_ModelX;\n"
+        "layout(location = 4) in vec4 in_ModelY;\n"
+        "layout(location = 5) in vec4 in_ModelZ;\n"
+        "layout(location = 6) in vec4 in_InstanceColor;\n"
         "uniform mat4 u_mvpMatrix;\n"
         "out vec4 b_color;\n"
         "void main() {\n"
-        "   b_color = in_Color;\n"
-        "	gl_Position = u_mvpMatrix * vec4(in_Vertex, 1);\n"
+        "   vec4 v = vec4(in_Vertex, 1);\n"
+        "   b_color = vec4(in_Color.rgb * in_InstanceColor.rgb, in_Color.a);\n" // the fading comes from the unit box
+        "	gl_Position = u_mvpMatrix * vec4(dot(in_ModelX, v), dot(in_ModelY, v), dot(in_ModelZ, v), 1);\n"
         "}";
 
 GLchar* FRAGMENT_SHADER =
@@ -59,8 +64,6 @@ GLchar* SK_FRAGMENT_SHADER =
 		"   out_Color = vec4(b_color.rgb * (diffuse + ambient), 1);\n"
 		"}";
 
-const float grid_size = 10.0f;
-
 GLViewer* currentInstance_ = nullptr;
 
 float const class_colors[6][3] = {
@@ -103,13 +106,20 @@ GLViewer::~GLViewer() {}
 void GLViewer::exit() {
     if (currentInstance_) {
         image_handler.close();
+        offscreen_.close();
         available = false;
     }
 }
 
 bool GLViewer::isAvailable() {
-    if (available)
-        glutMainLoopEvent();
+    if (available) {
+        if (offscreen_.isInitialized()) {
+            // No window events, one frame per new image
+            if (newFrame_)
+                render();
+        } else
+            glutMainLoopEvent();
+    }
     return available;
 }
 
@@ -117,23 +127,29 @@ void CloseFunc(void) { if (currentInstance_) currentInstance_->exit(); }
 
 void GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
 
-    glutInit(&argc, argv);
-    int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
-    int wnd_h = glutGet(GLUT_SCREEN_HEIGHT);
-    int width = wnd_w*0.9;
-    int height = wnd_h*0.9;
-   
-    glutInitWindowSize(width, height);
-    glutInitWindowPosition(wnd_w*0.05, wnd_h*0.05);
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_SRGB);
-    glutCreateWindow("ZED Object detection");
-    glViewport(0,0,width,height);
-
-    GLenum err = glewInit();
-    if (GLEW_OK != err)
-        std::cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << "\n";
-
-    glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+    if (OffscreenRenderer::isRequested()) {
+        // Headless, at the camera resolution
+        if (!offscreen_.init(param.image_size.width, param.image_size.height, true))
+            return;
+    } else {
+        glutInit(&argc, argv);
+        int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
+        int wnd_h = glutGet(GLUT_SCREEN_HEIGHT);
+        int width = wnd_w*0.9;
+        int height = wnd_h*0.9;
+
+        glutInitWindowSize(width, height);
+        glutInitWindowPosition(wnd_w*0.05, wnd_h*0.05);
+        glutInitDisplayMode(GLUT_DOUBLE | GLUT_SRGB);
+        glutCreateWindow("ZED Object detection");
+        glViewport(0,0,width,height);
+
+        GLenum err = glewInit();
+        if (GLEW_OK != err)
+            std::cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << "\n";
+
+        glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+    }
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -154,11 +170,18 @@ void GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
     // Create the rendering camera
     setRenderCameraProjection(param,0.5f,20);
 
-    // Create the bounding box object
-	BBox_edges = Simple3DObject(sl::Translation(0, 0, 0), false);
+    // Create the unit bounding box, in white: each instance gives its transform and color
+	std::vector<sl::float3> unit_box = InstancedObject::unitBox();
+	const sl::float4 white(1, 1, 1, 1);
+
+	// Top and bottom full edges, faded vertical edges
+	BBox_edges.addFullEdges(unit_box, white);
+	BBox_edges.addVerticalEdges(unit_box, white);
 	BBox_edges.setDrawingType(GL_LINES);
 
-	BBox_faces = Simple3DObject(sl::Translation(0, 0, 0), false);
+	// Faded faces and top face
+	BBox_faces.addVerticalFaces(unit_box, white);
+	BBox_faces.addTopFace(unit_box, white);
 	BBox_faces.setDrawingType(GL_QUADS);
 
     // Set background color (black)
@@ -169,11 +192,13 @@ void GLViewer::init(int argc, char **argv, sl::CameraParameters param) {
     glDisable(GL_DEPTH_TEST); //avoid occlusion with bbox
 
     // Map glut function on this class methods
-    glutDisplayFunc(GLViewer::drawCallback);
-    glutReshapeFunc(GLViewer::reshapeCallback);
-    glutKeyboardFunc(GLViewer::keyPressedCallback);
-    glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
-    glutCloseFunc(CloseFunc);
+    if (!offscreen_.isInitialized()) {
+        glutDisplayFunc(GLViewer::drawCallback);
+        glutReshapeFunc(GLViewer::reshapeCallback);
+        glutKeyboardFunc(GLViewer::keyPressedCallback);
+        glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
+        glutCloseFunc(CloseFunc);
+    }
     available = true;
 }
 
@@ -212,14 +237,21 @@ void GLViewer::setRenderCameraProjection(sl::CameraParameters params,float znear
 
 void GLViewer::render() {
     if (available) {
+        if (offscreen_.isInitialized())
+            offscreen_.beginFrame();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(bckgrnd_clr.r, bckgrnd_clr.g, bckgrnd_clr.b, 1.f);
         mtx.lock();
         update();
         draw();
+        newFrame_ = false;
         mtx.unlock();
-        glutSwapBuffers();
-        glutPostRedisplay();
+        if (offscreen_.isInitialized())
+            offscreen_.endFrame();
+        else {
+            glutSwapBuffers();
+            glutPostRedisplay();
+        }
     }
 }
 
@@ -241,10 +273,11 @@ void GLViewer::updateView(sl::Mat image, sl::Objects &objs)
 	mtx.lock();
     // Update Image
     image_handler.pushNewImage(image);
+    newFrame_ = true;
 
     // Clear frames object
-	BBox_edges.clear();
-	BBox_faces.clear();
+	BBox_edges.clearInstances();
+	BBox_faces.clearInstances();
 	objectsName.clear();
 
 	for (unsigned int i = 0; i < objs.object_list.size(); i++) {
@@ -269,14 +302,9 @@ void GLViewer::updateView(sl::Mat image, sl::Objects &objs)
 }
 
 void GLViewer::createBboxRendering(std::vector<sl::float3> &bbox, sl::float4 bbox_clr) {
-	// First create top and bottom full edges
-	BBox_edges.addFullEdges(bbox, bbox_clr);
-	// Add faded vertical edges
-	BBox_edges.addVerticalEdges(bbox, bbox_clr);
-	// Add faces
-	BBox_faces.addVerticalFaces(bbox, bbox_clr);
-	// Add top face
-	BBox_faces.addTopFace(bbox, bbox_clr);
+	// Edges and faces of the unit box, see init()
+	BBox_edges.addBoxInstance(bbox, bbox_clr);
+	BBox_faces.addBoxInstance(bbox, bbox_clr);
 }
 
 void GLViewer::createIDRendering(sl::float3 & center, sl::float4 clr, unsigned int id) {
@@ -367,581 +395,6 @@ void GLViewer::idle() {
     glutPostRedisplay();
 }
 
-Simple3DObject::Simple3DObject() {
-    is_init=false;
-}
-
-Simple3DObject::Simple3DObject(sl::Translation position, bool isStatic) : isStatic_(isStatic) {
-	vaoID_ = 0;
-	drawingType_ = GL_TRIANGLES;
-	position_ = position;
-	rotation_.setIdentity();
-}
-
-Simple3DObject::~Simple3DObject() {
-    if (vaoID_ != 0) {
-        glDeleteBuffers(4, vboID_);
-        glDeleteVertexArrays(1, &vaoID_);
-        vaoID_=0;
-        is_init=false;
-    }
-}
-
-bool Simple3DObject::isInit()
-{
-    return is_init;
-}
-
-void Simple3DObject::addBBox(std::vector<sl::float3> &pts, sl::float4 clr) {
-	int start_id = vertices_.size() / 3;
-
-	float transparency_top = 0.05f, transparency_bottom = 0.75f;
-	for (unsigned int i = 0; i < pts.size(); i++) {
-		addPt(pts[i]);
-		clr.a = (i < 4 ? transparency_top : transparency_bottom);
-		addClr(clr);
-	}
-
-	const std::vector<int> boxLinks = { 4, 5, 5, 6, 6, 7, 7, 4, 0, 4, 1, 5, 2, 6, 3, 7 };
-
-	for (unsigned int i = 0; i < boxLinks.size(); i += 2) {
-		indices_.push_back(start_id + boxLinks[i]);
-		indices_.push_back(start_id + boxLinks[i + 1]);
-	}
-}
-
-
-void Simple3DObject::addPt(sl::float3 pt) {
-	vertices_.push_back(pt.x);
-	vertices_.push_back(pt.y);
-	vertices_.push_back(pt.z);
-}
-
-void Simple3DObject::addClr(sl::float4 clr) {
-	colors_.push_back(clr.r);
-	colors_.push_back(clr.g);
-	colors_.push_back(clr.b);
-	colors_.push_back(clr.a);
-}
-
-void Simple3DObject::addNormal(sl::float3 normal) {
-	normals_.push_back(normal.x);
-	normals_.push_back(normal.y);
-	normals_.push_back(normal.z);
-}
-void Simple3DObject::addPoints(std::vector<sl::float3> pts,sl::float4 base_clr)
-{
-    for (int k=0;k<pts.size();k++) {
-        sl::float3 pt = pts.at(k);
-        vertices_.push_back(pt.x);
-        vertices_.push_back(pt.y);
-        vertices_.push_back(pt.z);
-        colors_.push_back(base_clr.r);
-        colors_.push_back(base_clr.g);
-        colors_.push_back(base_clr.b);
-        colors_.push_back(1.f);
-        int current_size_index = (vertices_.size()/3 -1);
-        indices_.push_back(current_size_index);
-        indices_.push_back(current_size_index+1);
-    }
-}
-
-void Simple3DObject::addPoint(sl::float3 pt, sl::float4 clr) {
-	addPt(pt);
-	addClr(clr);
-	indices_.push_back((int)indices_.size());
-}
-
-void Simple3DObject::addLine(sl::float3 p1, sl::float3 p2, sl::float3 clr) {
-    vertices_.push_back(p1.x);
-    vertices_.push_back(p1.y);
-    vertices_.push_back(p1.z);
-
-    vertices_.push_back(p2.x);
-    vertices_.push_back(p2.y);
-    vertices_.push_back(p2.z);
-
-    colors_.push_back(clr.r);
-    colors_.push_back(clr.g);
-    colors_.push_back(clr.b);
-    colors_.push_back(1.f);
-
-    colors_.push_back(clr.r);
-    colors_.push_back(clr.g);
-    colors_.push_back(clr.b);
-    colors_.push_back(1.f);
-
-    indices_.push_back((int)indices_.size());
-    indices_.push_back((int)indices_.size());
-}
-
-
-void Simple3DObject::addCylinder(sl::float3 startPosition, sl::float3 endPosition, sl::float4 clr) {
-	const float PI = 3.1415926f;
-
-	float m_radius = 0.010f;
-
-	sl::float3 dir = endPosition - startPosition;
-	float m_height = dir.norm();
-	float x = 0.f, y = 0.f, z = 0.f;
-
-	dir = dir / m_height;
-
-	sl::float3 yAxis = sl::float3(0, 1, 0);
-	sl::float3 v = sl::float3::cross(dir, yAxis);
-
-	//sl::float3 centerPosition =  (startPosition + endPosition) / 2;
-	sl::Transform rotation;
-
-	float sinTheta = v.norm();
-	if (sinTheta < 0.00001f)
-	{
-		rotation.setIdentity();
-	}
-	else {
-		float cosTheta = sl::float3::dot(dir, yAxis);
-		float scale = (1.f - cosTheta) / (1.f - (cosTheta * cosTheta));
-
-		float data[] = { 0    , v[2] , -v[1], 0,
-						-v[2], 0    , v[0] , 0,
-						v[1] , -v[0], 0    , 0,
-						0    , 0    , 0    , 1.f };
-
-		sl::Transform vx = sl::Transform(data);
-		sl::Transform vx2 = vx * vx;
-		sl::Transform vx2Scaled = vx2 * scale;
-
-		rotation.setIdentity();
-		rotation = rotation + vx;
-		rotation = rotation + vx2Scaled;
-	}
-
-	/////////////////////////////
-
-	sl::float3 v1;
-	sl::float3 v2;
-	sl::float3 v3;
-	sl::float3 v4;
-	sl::float3 normal;
-	float resolution = 0.1f;
-
-	for (double i = 0; i <= 2 * PI - 1; i += resolution)
-	{
-		v1 = sl::float3(m_radius * cos(i), 0, m_radius * sin(i)) * rotation.getRotationMatrix() + startPosition;
-		v2 = sl::float3(m_radius * cos(i), m_height, m_radius * sin(i)) * rotation.getRotationMatrix() + startPosition;
-		v4 = sl::float3(m_radius * cos(i + 1), m_height, m_radius * sin(i + 1)) * rotation.getRotationMatrix() + startPosition;
-		v3 = sl::float3(m_radius * cos(i + 1), 0, m_radius * sin(i + 1)) * rotation.getRotationMatrix() + startPosition;
-
-		normal = sl::float3::cross((v2 - v1), (v3 - v1));
-		normal = normal / normal.norm();
-
-		addPoint(v1, clr);
-		addPoint(v2, clr);
-		addPoint(v4, clr);
-		addPoint(v3, clr);
-
-		addNormal(normal);
-		addNormal(normal);
-		addNormal(normal);
-		addNormal(normal);
-
-	}
-	/*v1 = sl::float3(m_radius * cos(2 * PI), m_height, m_radius * sin(2 * PI)) * rotation.getRotationMatrix() + startPosition;
-	v2 = sl::float3(m_radius * cos(2 * PI), 0, m_radius * sin(2 * PI))* rotation.getRotationMatrix() + startPosition;
-	v4 = sl::float3(m_radius, 0, 0) * rotation.getRotationMatrix() + startPosition;
-	v3 = sl::float3(m_radius, m_height, 0) * rotation.getRotationMatrix() + startPosition;*/
-}
-
-void Simple3DObject::addSphere(sl::float3 position, sl::float4 clr) {
-	const float PI = 3.1415926f;
-
-	float m_radius = 0.02f;
-	float radiusInv = 1.0f / m_radius;
-
-	int stacks = 20;
-	int slices = 20;
-
-	int m_stackCount = 20;
-	int m_sectorCount = 20;
-
-	sl::float3 v1;
-	sl::float3 v2;
-	sl::float3 v3;
-	sl::float3 v4;
-	sl::float3 normal;
-
-	int i, j;
-	for (i = 0; i <= m_stackCount; i++) {
-		double lat0 = M_PI * (-0.5 + (double)(i - 1) / m_stackCount);
-		double z0 = sin(lat0);
-		double zr0 = cos(lat0);
-
-		double lat1 = M_PI * (-0.5 + (double)i / m_stackCount);
-		double z1 = sin(lat1);
-		double zr1 = cos(lat1);
-		for (j = 0; j <= m_sectorCount - 1; j++) {
-			double lng = 2 * M_PI * (double)(j - 1) / m_sectorCount;
-			double x = cos(lng);
-			double y = sin(lng);
-
-			v1 = sl::float3(m_radius * x * zr0, m_radius * y * zr0, m_radius * z0) + position;
-			normal = sl::float3(x * zr0, y * zr0, z0);
-			addPoint(v1, clr);
-
-			addNormal(normal);
-
-			v2 = sl::float3(m_radius * x * zr1, m_radius * y * zr1, m_radius * z1) + position;
-			normal = sl::float3(x * zr1, y * zr1, z1);
-
-			addPoint(v2, clr);
-
-			addNormal(normal);
-
-			lng = 2 * M_PI * (double)(j) / m_sectorCount;
-			x = cos(lng);
-			y = sin(lng);
-
-			v4 = sl::float3(m_radius * x * zr1, m_radius * y * zr1, m_radius * z1) + position;
-			normal = sl::float3(x * zr1, y * zr1, z1);
-
-			addPoint(v4, clr);
-			addNormal(normal);
-
-			v3 = sl::float3(m_radius * x * zr0, m_radius * y * zr0, m_radius * z0) + position;
-			normal = sl::float3(x * zr0, y * zr0, z0);
-			addPoint(v3, clr);
-
-			addNormal(normal);
-		}
-	}
-}
-
-void Simple3DObject::addFullEdges(std::vector<sl::float3> &pts, sl::float4 clr) {
-	clr.w = 0.4f;
-	int start_id = vertices_.size() / 3;
-
-	for (unsigned int i = 0; i < pts.size(); i++) {
-		addPt(pts[i]);
-		addClr(clr);
-	}
-
-	const std::vector<int> boxLinksTop = { 0, 1, 1, 2, 2, 3, 3, 0 };
-	for (unsigned int i = 0; i < boxLinksTop.size(); i += 2) {
-		indices_.push_back(start_id + boxLinksTop[i]);
-		indices_.push_back(start_id + boxLinksTop[i + 1]);
-	}
-
-	const std::vector<int> boxLinksBottom = { 4, 5, 5, 6, 6, 7, 7, 4 };
-	for (unsigned int i = 0; i < boxLinksBottom.size(); i += 2) {
-		indices_.push_back(start_id + boxLinksBottom[i]);
-		indices_.push_back(start_id + boxLinksBottom[i + 1]);
-	}
-}
-
-void Simple3DObject::addVerticalEdges(std::vector<sl::float3> &pts, sl::float4 clr) {
-	auto addSingleVerticalLine = [&](sl::float3 top_pt, sl::float3 bot_pt) {
-		std::vector<sl::float3> current_pts{
-			top_pt,
-					((grid_size - 1.0f) * top_pt + bot_pt) / grid_size,
-					((grid_size - 2.0f) * top_pt + bot_pt * 2.0f) / grid_size,
-					(2.0f * top_pt + bot_pt * (grid_size - 2.0f)) / grid_size,
-					(top_pt + bot_pt * (grid_size - 1.0f)) / grid_size,
-					bot_pt };
-
-		int start_id = vertices_.size() / 3;
-		for (unsigned int i = 0; i < current_pts.size(); i++) {
-			addPt(current_pts[i]);
-			clr.a = (i == 2 || i == 3) ? 0.0f : 0.4f;
-			addClr(clr);
-		}
-
-		const std::vector<int> boxLinks = { 0, 1, 1, 2, 2, 3, 3, 4, 4, 5 };
-		for (unsigned int i = 0; i < boxLinks.size(); i += 2) {
-			indices_.push_back(start_id + boxLinks[i]);
-			indices_.push_back(start_id + boxLinks[i + 1]);
-		}
-	};
-
-	addSingleVerticalLine(pts[0], pts[4]);
-	addSingleVerticalLine(pts[1], pts[5]);
-	addSingleVerticalLine(pts[2], pts[6]);
-	addSingleVerticalLine(pts[3], pts[7]);
-}
-
-void Simple3DObject::addTopFace(std::vector<sl::float3> &pts, sl::float4 clr) {
-	clr.a = 0.3f;
-	for (auto it : pts)
-		addPoint(it, clr);
-}
-
-void Simple3DObject::addVerticalFaces(std::vector<sl::float3> &pts, sl::float4 clr) {
-	auto addQuad = [&](std::vector<sl::float3> quad_pts, float alpha1, float alpha2) { // To use only with 4 points
-		for (unsigned int i = 0; i < quad_pts.size(); ++i) {
-			addPt(quad_pts[i]);
-			clr.a = (i < 2 ? alpha1 : alpha2);
-			addClr(clr);
-		}
-
-		indices_.push_back((int)indices_.size());
-		indices_.push_back((int)indices_.size());
-		indices_.push_back((int)indices_.size());
-		indices_.push_back((int)indices_.size());
-	};
-
-	// For each face, we need to add 4 quads (the first 2 indexes are always the top points of the quad)
-	std::vector<std::vector<int>> quads
-	{
-		{
-			0, 3, 7, 4
-		}, // front face
-		{
-			3, 2, 6, 7
-		}, // right face
-		{
-			2, 1, 5, 6
-		}, // back face
-		{
-			1, 0, 4, 5
-		} // left face
-	};
-	float alpha = 0.5f;
-
-	for (const auto quad : quads) {
-
-		// Top quads
-		std::vector<sl::float3> quad_pts_1{
-			pts[quad[0]],
-			pts[quad[1]],
-			((grid_size - 0.5f) * pts[quad[1]] + 0.5f * pts[quad[2]]) / grid_size,
-			((grid_size - 0.5f) * pts[quad[0]] + 0.5f * pts[quad[3]]) / grid_size };
-		addQuad(quad_pts_1, alpha, alpha);
-
-		std::vector<sl::float3> quad_pts_2{
-			((grid_size - 0.5f) * pts[quad[0]] + 0.5f * pts[quad[3]]) / grid_size,
-			((grid_size - 0.5f) * pts[quad[1]] + 0.5f * pts[quad[2]]) / grid_size,
-			((grid_size - 1.0f) * pts[quad[1]] + pts[quad[2]]) / grid_size,
-			((grid_size - 1.0f) * pts[quad[0]] + pts[quad[3]]) / grid_size };
-		addQuad(quad_pts_2, alpha, 2 * alpha / 3);
-
-		std::vector<sl::float3> quad_pts_3{
-			((grid_size - 1.0f) * pts[quad[0]] + pts[quad[3]]) / grid_size,
-			((grid_size - 1.0f) * pts[quad[1]] + pts[quad[2]]) / grid_size,
-			((grid_size - 1.5f) * pts[quad[1]] + 1.5f * pts[quad[2]]) / grid_size,
-			((grid_size - 1.5f) * pts[quad[0]] + 1.5f * pts[quad[3]]) / grid_size };
-		addQuad(quad_pts_3, 2 * alpha / 3, alpha / 3);
-
-		std::vector<sl::float3> quad_pts_4{
-			((grid_size - 1.5f) * pts[quad[0]] + 1.5f * pts[quad[3]]) / grid_size,
-			((grid_size - 1.5f) * pts[quad[1]] + 1.5f * pts[quad[2]]) / grid_size,
-			((grid_size - 2.0f) * pts[quad[1]] + 2.0f * pts[quad[2]]) / grid_size,
-			((grid_size - 2.0f) * pts[quad[0]] + 2.0f * pts[quad[3]]) / grid_size };
-		addQuad(quad_pts_4, alpha / 3, 0.0f);
-
-		// Bottom quads
-		std::vector<sl::float3> quad_pts_5{
-			(pts[quad[1]] * 2.0f + (grid_size - 2.0f) * pts[quad[2]]) / grid_size,
-			(pts[quad[0]] * 2.0f + (grid_size - 2.0f) * pts[quad[3]]) / grid_size,
-			(pts[quad[0]] * 1.5f + (grid_size - 1.5f) * pts[quad[3]]) / grid_size,
-			(pts[quad[1]] * 1.5f + (grid_size - 1.5f) * pts[quad[2]]) / grid_size };
-		addQuad(quad_pts_5, 0.0f, alpha / 3);
-
-		std::vector<sl::float3> quad_pts_6{
-			(pts[quad[1]] * 1.5f + (grid_size - 1.5f) * pts[quad[2]]) / grid_size,
-			(pts[quad[0]] * 1.5f + (grid_size - 1.5f) * pts[quad[3]]) / grid_size,
-			(pts[quad[0]] + (grid_size - 1.0f) * pts[quad[3]]) / grid_size,
-			(pts[quad[1]] + (grid_size - 1.0f) * pts[quad[2]]) / grid_size };
-		addQuad(quad_pts_6, alpha / 3, 2 * alpha / 3);
-
-		std::vector<sl::float3> quad_pts_7{
-			(pts[quad[1]] + (grid_size - 1.0f) * pts[quad[2]]) / grid_size,
-			(pts[quad[0]] + (grid_size - 1.0f) * pts[quad[3]]) / grid_size,
-			(pts[quad[0]] * 0.5f + (grid_size - 0.5f) * pts[quad[3]]) / grid_size,
-			(pts[quad[1]] * 0.5f + (grid_size - 0.5f) * pts[quad[2]]) / grid_size };
-		addQuad(quad_pts_7, 2 * alpha / 3, alpha);
-
-		std::vector<sl::float3> quad_pts_8{
-			(pts[quad[0]] * 0.5f + (grid_size - 0.5f) * pts[quad[3]]) / grid_size,
-			(pts[quad[1]] * 0.5f + (grid_size - 0.5f) * pts[quad[2]]) / grid_size,
-			pts[quad[2]],
-			pts[quad[3]] };
-		addQuad(quad_pts_8, alpha, alpha);
-	}
-}
-
-
-void Simple3DObject::pushToGPU() {
-    if (!isStatic_ || vaoID_ == 0) {
-        if (vaoID_ == 0) {
-            glGenVertexArrays(1, &vaoID_);
-            glGenBuffers(4, vboID_);
-        }
-        glShadeModel(GL_SMOOTH);
-        if (vertices_.size()>0) {
-            glBindVertexArray(vaoID_);
-            glBindBuffer(GL_ARRAY_BUFFER, vboID_[0]);
-            glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(float), &vertices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(Shader::ATTRIB_VERTICES_POS, 3, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(Shader::ATTRIB_VERTICES_POS);
-        }
-
-        if (colors_.size()>0) {
-            glBindBuffer(GL_ARRAY_BUFFER, vboID_[1]);
-            glBufferData(GL_ARRAY_BUFFER, colors_.size() * sizeof(float), &colors_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-            glVertexAttribPointer(Shader::ATTRIB_COLOR_POS, 4, GL_FLOAT, GL_FALSE, 0, 0);
-            glEnableVertexAttribArray(Shader::ATTRIB_COLOR_POS);
-        }
-        if (indices_.size()>0) {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboID_[2]);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned int), &indices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-        }
-		if (normals_.size() > 0) {
-			glBindBuffer(GL_ARRAY_BUFFER, vboID_[3]);
-			glBufferData(GL_ARRAY_BUFFER, normals_.size() * sizeof(float), &normals_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(Shader::ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
-			glEnableVertexAttribArray(Shader::ATTRIB_NORMAL);
-		}
-
-        glBindVertexArray(0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
-}
-
-void Simple3DObject::clear() {
-    vertices_.clear();
-    colors_.clear();
-    indices_.clear();
-	normals_.clear();
-}
-
-void Simple3DObject::setDrawingType(GLenum type) {
-    drawingType_ = type;
-}
-
-void Simple3DObject::draw() {
-    if (indices_.size() && vaoID_) {
-        glBindVertexArray(vaoID_);
-        glDrawElements(drawingType_, (GLsizei)indices_.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    }
-}
-
-void Simple3DObject::translate(const sl::Translation& t) {
-    position_ = position_ + t;
-}
-
-void Simple3DObject::setPosition(const sl::Translation& p) {
-    position_ = p;
-}
-
-void Simple3DObject::setRT(const sl::Transform& mRT) {
-    position_ = mRT.getTranslation();
-    rotation_ = mRT.getOrientation();
-}
-
-void Simple3DObject::rotate(const sl::Orientation& rot) {
-    rotation_ = rot * rotation_;
-}
-
-void Simple3DObject::rotate(const sl::Rotation& m) {
-    this->rotate(sl::Orientation(m));
-}
-
-void Simple3DObject::setRotation(const sl::Orientation& rot) {
-    rotation_ = rot;
-}
-
-void Simple3DObject::setRotation(const sl::Rotation& m) {
-    this->setRotation(sl::Orientation(m));
-}
-
-const sl::Translation& Simple3DObject::getPosition() const {
-    return position_;
-}
-
-sl::Transform Simple3DObject::getModelMatrix() const {
-    sl::Transform tmp;
-    tmp.setOrientation(rotation_);
-    tmp.setTranslation(position_);
-    return tmp;
-}
-
-Shader::Shader(GLchar* vs, GLchar* fs) {
-    if (!compile(verterxId_, GL_VERTEX_SHADER, vs)) {
-        std::cout << "ERROR: while compiling vertex shader" << std::endl;
-    }
-    if (!compile(fragmentId_, GL_FRAGMENT_SHADER, fs)) {
-        std::cout << "ERROR: while compiling fragment shader" << std::endl;
-    }
-
-    programId_ = glCreateProgram();
-
-    glAttachShader(programId_, verterxId_);
-    glAttachShader(programId_, fragmentId_);
-
-    glBindAttribLocation(programId_, ATTRIB_VERTICES_POS, "in_vertex");
-    glBindAttribLocation(programId_, ATTRIB_COLOR_POS, "in_texCoord");
-
-    glLinkProgram(programId_);
-
-    GLint errorlk(0);
-    glGetProgramiv(programId_, GL_LINK_STATUS, &errorlk);
-    if (errorlk != GL_TRUE) {
-        std::cout << "ERROR: while linking Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetProgramiv(programId_, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(programId_, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteProgram(programId_);
-    }
-}
-
-Shader::~Shader() {
-    if (verterxId_ != 0)
-        glDeleteShader(verterxId_);
-    if (fragmentId_ != 0)
-        glDeleteShader(fragmentId_);
-    if (programId_ != 0)
-        glDeleteShader(programId_);
-}
-
-GLuint Shader::getProgramId() {
-    return programId_;
-}
-
-bool Shader::compile(GLuint &shaderId, GLenum type, GLchar* src) {
-    shaderId = glCreateShader(type);
-    if (shaderId == 0) {
-        std::cout << "ERROR: shader type (" << type << ") does not exist" << std::endl;
-        return false;
-    }
-    glShaderSource(shaderId, 1, (const char**)&src, 0);
-    glCompileShader(shaderId);
-
-    GLint errorCp(0);
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &errorCp);
-    if (errorCp != GL_TRUE) {
-        std::cout << "ERROR: while compiling Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(shaderId, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteShader(shaderId);
-        return false;
-    }
-    return true;
-}
-
 GLchar* IMAGE_FRAGMENT_SHADER =
         "#version 330 core\n"
         " in vec2 UV;\n"
@@ -107,7 +107,8 @@ int main(int argc, char **argv) {
 	bool need_floor_plane = positional_tracking_parameters.set_as_static;
 	while (viewer.isAvailable()) {
 		// Grab images
-		if (zed.grab() == ERROR_CODE::SUCCESS) {
+		auto returned_state = zed.grab();
+		if (returned_state == ERROR_CODE::SUCCESS) {
 
 			// Retrieve left image
 			zed.retrieveImage(image, VIEW::LEFT, MEM::GPU);
@@ -117,6 +118,9 @@ int main(int argc, char **argv) {
 
 			//Update GL View
 			viewer.updateView(image, objects);
+		} else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && OffscreenRenderer::isRequested()) {
+			// Headless rendering of an SVO: stop at its end
+			viewer.exit();
 		}
 	}
 
@@ -0,0 +1,35 @@
+#ifndef DOF_CPU_H
+#define DOF_CPU_H
+
+/* dof_cpu.h.
+ *
+ * CPU implementation of the depth of field functions of dof_gpu.h, on host memory.
+ * Same Gaussian kernels (c_kernel layout), same radius per pixel and same border handling as the CUDA kernels.
+ * The image is split in row blocks over all the cores, and each block is vectorized over the pixels (AVX2 when the CPU
+ * supports it, NEON on ARM).
+ * When the sample is built with REFOCUS_CPU, these functions also implement the interface of dof_gpu.h.
+ */
+
+// ZED includes
+#include <sl/Camera.hpp>
+
+void copyKernelCPU(float *kernel_coefficients, int kernel_index);
+
+void normalizeDepthCPU(float* depth, float* depth_out, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height);
+
+void convolutionRowsCPU(sl::uchar4 *dst, sl::uchar4 *src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
+void convolutionColumnsCPU(sl::uchar4 *dst, sl::uchar4 *src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
+
+// Layered rendering, see dof_gpu.h
+struct DoFLayersCPU;
+DoFLayersCPU* createLayersCPU(int imageW, int imageH, int nb_layers);
+void releaseLayersCPU(DoFLayersCPU* layers);
+void convolutionLayersCPU(DoFLayersCPU* layers, sl::uchar4 *dst, sl::uchar4 *src, float* i_depth, int depth_pitch, float focus_point);
+
+// Box blur from a summed-area table, see dof_gpu.h. Same result as the GPU.
+struct SummedAreaTableCPU;
+SummedAreaTableCPU* createSummedAreaTableCPU(int imageW, int imageH);
+void releaseSummedAreaTableCPU(SummedAreaTableCPU* table);
+void convolutionBoxCPU(SummedAreaTableCPU* table, sl::uchar4 *dst, sl::uchar4 *src, float* i_depth, int depth_pitch, float focus_point);
+
+#endif //DOF_CPU_H
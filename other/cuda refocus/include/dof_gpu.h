@@ -7,6 +7,9 @@
  * for rendering depth of field, based on Gaussian blurring
  * using separable convolution, with depth-dependent kernel size.
  * Separable convolution is based on convolution CUDA Sample with kernel-size adaptation
+ * The kernels are queued on 'stream', the default stream if omitted, and the functions return without waiting.
+ * When built with REFOCUS_CPU, these functions run on the CPU (see dof_cpu.h) and the pointers are in host memory. They
+ * return once done and ignore the stream.
  */
 
 // ZED includes
@@ -21,10 +24,56 @@
 void copyKernel(float *kernel_coefficients, int kernel_index);
 
 // Normalize depth between 0.f and 1.f
-void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height);
+void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height, cudaStream_t stream = 0);
 
 // GPU convolution
-void convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
-void convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point);
+void convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point, cudaStream_t stream = 0);
+void convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point, cudaStream_t stream = 0);
+
+// Layered rendering: the blur radius is quantized in 'nb_layers' levels (2 to MAX_LAYERS), each level is blurred once over
+// the whole image with a fixed radius, the large radii on a downsampled image. Each pixel then blends the two levels
+// around its own radius. The cost no longer depends on the defocus, fewer levels is faster, more is closer to the
+// per-pixel convolution. Unlike the convolution, the borders are clamped instead of black.
+#define MAX_LAYERS (KERNEL_RADIUS + 1)
+#define MAX_LAYER_SCALE 3 // downsampling by 2^3 at most
+
+// Radius of the blur level 'layer' (0 = sharp) and the scale it is computed at: radius / 2^scale_log2 is below 8 pixels
+struct BlurLayer {
+    float radius;
+    int scale_log2;
+    int kernel_radius; // at that scale
+};
+
+inline BlurLayer getBlurLayer(int layer, int nb_layers) {
+    BlurLayer blur_layer;
+    blur_layer.radius = layer * KERNEL_RADIUS / (float) (nb_layers - 1);
+    blur_layer.scale_log2 = 0;
+    while (blur_layer.scale_log2 < MAX_LAYER_SCALE && blur_layer.radius >= (8 << blur_layer.scale_log2))
+        blur_layer.scale_log2++;
+    const int kernel_radius = (int) (blur_layer.radius / (1 << blur_layer.scale_log2) + 0.5f);
+    blur_layer.kernel_radius = layer == 0 ? 0 : (kernel_radius < 1 ? 1 : kernel_radius);
+    return blur_layer;
+}
+
+// Buffers of the layered rendering, for one image size and number of levels
+struct DoFLayers;
+DoFLayers* createLayers(int imageW, int imageH, int nb_layers);
+void releaseLayers(DoFLayers* layers);
+
+// Same input and output as convolutionRows + convolutionColumns (d_Dst is swapped to RGBA)
+void convolutionLayers(DoFLayers* layers, sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int depth_pitch, float focus_point, cudaStream_t stream = 0);
+
+// Box blur from a summed-area table: the table is built once per frame, then the box of any radius is 4 lookups per
+// pixel, the cost does not depend on the defocus. The box half-width is BOX_RADIUS_SCALE times the Gaussian radius (about
+// the same standard deviation) and fractional: each pixel blends the two integer boxes around it, so the blur changes
+// smoothly with the depth. At the borders, the box is cut to the image and normalized by its area.
+#define BOX_RADIUS_SCALE 0.55f
+
+struct SummedAreaTable;
+SummedAreaTable* createSummedAreaTable(int imageW, int imageH);
+void releaseSummedAreaTable(SummedAreaTable* table);
+
+// Same input and output as convolutionRows + convolutionColumns (d_Dst is swapped to RGBA)
+void convolutionBox(SummedAreaTable* table, sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int depth_pitch, float focus_point, cudaStream_t stream = 0);
 
 #endif //DOF_GPU_H
\ No newline at end of file
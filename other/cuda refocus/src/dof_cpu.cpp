@@ -0,0 +1,728 @@
+/*
+ * This file contains the CPU version of the depth of field functions,
+ * see dof_cpu.h. The results match the CUDA kernels of dof_gpu.cu, up to the
+ * rounding of the fused multiply-adds of the GPU.
+ */
+
+#include "dof_cpu.h"
+#include "dof_gpu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "WorkerPool.hpp"
+
+// Gaussian kernels of radius 1 to KERNEL_RADIUS, the kernel of radius r starts at r * r - 1 (same as c_kernel)
+static float h_kernel[KERNEL_RADIUS * (KERNEL_RADIUS + 2)];
+
+void copyKernelCPU(float *kernel_coefficients, int kernel_index) {
+    int kernel_radius = kernel_index + 1;
+    memcpy(h_kernel + kernel_index * (kernel_index + 2), kernel_coefficients, KERNEL_LENGTH_X(kernel_radius) * sizeof(float));
+}
+
+// Blur radius of a pixel, clamped to the kernels available, NAN gives 0 (same as the GPU)
+static inline int blurRadius(float depth, float focus_depth) {
+    const float radius = floorf(KERNEL_RADIUS * fabsf(depth - focus_depth));
+    return radius > 0.f ? (int) std::min(radius, (float) KERNEL_RADIUS) : 0;
+}
+
+// uchar4 <-> 3 float channels (x, y, z), w is set to 255
+static inline uint32_t packPixel(float x, float y, float z) {
+    return (uint32_t) (uint8_t) std::min(x, 255.f) | ((uint32_t) (uint8_t) std::min(y, 255.f) << 8)
+        | ((uint32_t) (uint8_t) std::min(z, 255.f) << 16) | 0xFF000000u;
+}
+
+// Workers created by the first pass and kept until the end of the program. The functions mirror the free function
+// interface of dof_gpu.h, there is no object to own them, so the pool is process wide: it is only used from the
+// thread of the sample main loop.
+static WorkerPool& workers() {
+    static WorkerPool pool;
+    return pool;
+}
+
+// Row blocks, one per core, the calling thread takes one of them
+template<typename F>
+static void parallelRows(int height, F&& rows) {
+    workers().parallelRows(height, std::forward<F>(rows));
+}
+
+void normalizeDepthCPU(float* depth, float* depth_out, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height) {
+    const float range = max_distance - min_distance;
+    parallelRows(height, [&](int first, int last) {
+        for (int v = first; v < last; v++) {
+            const float* in = depth + v * step;
+            float* out = depth_out + v * step;
+            for (unsigned int u = 0; u < width; u++) {
+                float depth_normalized = (max_distance - in[u]) / range;
+                if (depth_normalized < 0.f) depth_normalized = 0.f;
+                if (depth_normalized > 1.f) depth_normalized = 1.f;
+                // As on the GPU, the invalid pixels keep their previous value
+                if (std::isfinite(depth_normalized)) out[u] = depth_normalized;
+            }
+        }
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Convolution of one row of pixels [first, last)
+// src(u, j) is the pixel at offset j of u along the convolution axis, (x, y, z) <- (c0, c1, c2) of the sum, or
+// (c2, c1, c0) when 'swap' (column pass, as on the GPU). Taps outside of [j_min, j_max] are outside of the image.
+////////////////////////////////////////////////////////////////////////////////
+struct ConvolutionLine {
+    const uint32_t* src;   // pixel u = 0
+    ptrdiff_t tap_stride;  // in pixels, between two taps
+    const float* depth;
+    uint32_t* dst;
+    int j_min, j_max;
+    float focus_depth;
+    bool swap;
+};
+
+static void convolveScalar(const ConvolutionLine& l, int first, int last) {
+    for (int u = first; u < last; u++) {
+        const int kernel_radius = blurRadius(l.depth[u], l.focus_depth);
+        const uint32_t* center = l.src + u;
+        float sum[3];
+        if (kernel_radius > 0) {
+            const int kernel_mid = kernel_radius * kernel_radius - 1 + kernel_radius;
+            sum[0] = sum[1] = sum[2] = 0.f;
+            for (int j = std::max(-kernel_radius, l.j_min); j <= std::min(kernel_radius, l.j_max); ++j) {
+                const uint32_t p = center[j * l.tap_stride];
+                const float w = h_kernel[kernel_mid + j];
+                sum[0] += w * (float) (p & 0xFF);
+                sum[1] += w * (float) ((p >> 8) & 0xFF);
+                sum[2] += w * (float) ((p >> 16) & 0xFF);
+            }
+        } else {
+            sum[0] = (float) (*center & 0xFF);
+            sum[1] = (float) ((*center >> 8) & 0xFF);
+            sum[2] = (float) ((*center >> 16) & 0xFF);
+        }
+        l.dst[u] = l.swap ? packPixel(sum[2], sum[1], sum[0]) : packPixel(sum[0], sum[1], sum[2]);
+    }
+}
+
+#ifdef CPU_AVX2
+// 8 pixels at a time, up to the largest radius of the 8: the taps beyond the radius of a pixel get a 0 weight (masked
+// gather of the kernel), which leaves its sum unchanged. Returns the first pixel not processed.
+CPU_AVX2_TARGET static int convolveAVX2(const ConvolutionLine& l, int first, int last) {
+    const __m256 max_radius = _mm256_set1_ps((float) KERNEL_RADIUS);
+    const __m256 focus = _mm256_set1_ps(l.focus_depth);
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+    const __m256 max_value = _mm256_set1_ps(255.f);
+    alignas(32) int32_t radius[8];
+
+    int u = first;
+    for (; u + 8 <= last; u += 8) {
+        // min(32, x) returns x when it is NAN, cvtt then gives INT_MIN, clamped to 0
+        __m256 rf = _mm256_floor_ps(_mm256_mul_ps(_mm256_set1_ps((float) KERNEL_RADIUS),
+            _mm256_and_ps(_mm256_sub_ps(_mm256_loadu_ps(l.depth + u), focus), abs_mask)));
+        const __m256i r = _mm256_max_epi32(_mm256_cvttps_epi32(_mm256_min_ps(max_radius, rf)), _mm256_setzero_si256());
+        _mm256_store_si256((__m256i*) radius, r);
+        const int r_max = *std::max_element(radius, radius + 8);
+
+        const uint32_t* center = l.src + u;
+        const __m256i pc = _mm256_loadu_si256((const __m256i*) center);
+        __m256 s0, s1, s2;
+        if (r_max > 0) {
+            const __m256i mid = _mm256_add_epi32(_mm256_mullo_epi32(r, r), _mm256_sub_epi32(r, _mm256_set1_epi32(1)));
+            const __m256i blurred = _mm256_cmpgt_epi32(r, _mm256_setzero_si256());
+            s0 = s1 = s2 = _mm256_setzero_ps();
+            for (int j = std::max(-r_max, l.j_min); j <= std::min(r_max, l.j_max); ++j) {
+                const __m256i abs_j = _mm256_set1_epi32(std::abs(j));
+                const __m256i active = _mm256_andnot_si256(_mm256_cmpgt_epi32(abs_j, r), blurred);
+                const __m256 w = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), h_kernel, _mm256_add_epi32(mid, _mm256_set1_epi32(j)),
+                                                          _mm256_castsi256_ps(active), 4);
+                const __m256i p = _mm256_loadu_si256((const __m256i*) (center + j * l.tap_stride));
+                s0 = _mm256_add_ps(s0, _mm256_mul_ps(w, _mm256_cvtepi32_ps(_mm256_and_si256(p, byte_mask))));
+                s1 = _mm256_add_ps(s1, _mm256_mul_ps(w, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 8), byte_mask))));
+                s2 = _mm256_add_ps(s2, _mm256_mul_ps(w, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 16), byte_mask))));
+            }
+            // Pixels in focus keep their value
+            const __m256 sharp = _mm256_castsi256_ps(_mm256_cmpeq_epi32(r, _mm256_setzero_si256()));
+            s0 = _mm256_blendv_ps(s0, _mm256_cvtepi32_ps(_mm256_and_si256(pc, byte_mask)), sharp);
+            s1 = _mm256_blendv_ps(s1, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pc, 8), byte_mask)), sharp);
+            s2 = _mm256_blendv_ps(s2, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pc, 16), byte_mask)), sharp);
+        } else {
+            s0 = _mm256_cvtepi32_ps(_mm256_and_si256(pc, byte_mask));
+            s1 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pc, 8), byte_mask));
+            s2 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(pc, 16), byte_mask));
+        }
+        if (l.swap) std::swap(s0, s2);
+
+        // Truncation, as the float to unsigned char conversion of the GPU
+        const __m256i c0 = _mm256_cvttps_epi32(_mm256_min_ps(s0, max_value));
+        const __m256i c1 = _mm256_cvttps_epi32(_mm256_min_ps(s1, max_value));
+        const __m256i c2 = _mm256_cvttps_epi32(_mm256_min_ps(s2, max_value));
+        const __m256i out = _mm256_or_si256(_mm256_or_si256(c0, _mm256_slli_epi32(c1, 8)),
+                                            _mm256_or_si256(_mm256_slli_epi32(c2, 16), _mm256_set1_epi32((int) 0xFF000000u)));
+        _mm256_storeu_si256((__m256i*) (l.dst + u), out);
+    }
+    return u;
+}
+#endif
+
+#ifdef CPU_NEON
+// 4 pixels at a time, same principle as the AVX2 version, the kernel weights are loaded lane by lane
+static int convolveNEON(const ConvolutionLine& l, int first, int last) {
+    const uint32x4_t byte_mask = vdupq_n_u32(0xFF);
+    int32_t radius[4], mid[4];
+
+    int u = first;
+    for (; u + 4 <= last; u += 4) {
+        for (int k = 0; k < 4; k++) {
+            radius[k] = blurRadius(l.depth[u + k], l.focus_depth);
+            mid[k] = radius[k] * radius[k] - 1 + radius[k];
+        }
+        const int r_max = *std::max_element(radius, radius + 4);
+
+        const uint32_t* center = l.src + u;
+        const uint32x4_t pc = vld1q_u32(center);
+        float32x4_t s0 = vcvtq_f32_u32(vandq_u32(pc, byte_mask));
+        float32x4_t s1 = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(pc, 8), byte_mask));
+        float32x4_t s2 = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(pc, 16), byte_mask));
+        if (r_max > 0) {
+            float32x4_t b0 = vdupq_n_f32(0.f), b1 = b0, b2 = b0;
+            for (int j = std::max(-r_max, l.j_min); j <= std::min(r_max, l.j_max); ++j) {
+                float weights[4];
+                for (int k = 0; k < 4; k++)
+                    weights[k] = (radius[k] > 0 && std::abs(j) <= radius[k]) ? h_kernel[mid[k] + j] : 0.f;
+                const float32x4_t w = vld1q_f32(weights);
+                const uint32x4_t p = vld1q_u32(center + j * l.tap_stride);
+                b0 = vaddq_f32(b0, vmulq_f32(w, vcvtq_f32_u32(vandq_u32(p, byte_mask))));
+                b1 = vaddq_f32(b1, vmulq_f32(w, vcvtq_f32_u32(vandq_u32(vshrq_n_u32(p, 8), byte_mask))));
+                b2 = vaddq_f32(b2, vmulq_f32(w, vcvtq_f32_u32(vandq_u32(vshrq_n_u32(p, 16), byte_mask))));
+            }
+            const uint32x4_t sharp = vceqq_s32(vld1q_s32(radius), vdupq_n_s32(0));
+            s0 = vbslq_f32(sharp, s0, b0);
+            s1 = vbslq_f32(sharp, s1, b1);
+            s2 = vbslq_f32(sharp, s2, b2);
+        }
+        if (l.swap) std::swap(s0, s2);
+
+        const float32x4_t max_value = vdupq_n_f32(255.f);
+        const uint32x4_t c0 = vcvtq_u32_f32(vminq_f32(s0, max_value));
+        const uint32x4_t c1 = vcvtq_u32_f32(vminq_f32(s1, max_value));
+        const uint32x4_t c2 = vcvtq_u32_f32(vminq_f32(s2, max_value));
+        const uint32x4_t out = vorrq_u32(vorrq_u32(c0, vshlq_n_u32(c1, 8)), vorrq_u32(vshlq_n_u32(c2, 16), vdupq_n_u32(0xFF000000u)));
+        vst1q_u32(l.dst + u, out);
+    }
+    return u;
+}
+#endif
+
+static void convolveLine(const ConvolutionLine& l, int width) {
+    int u = 0;
+#if defined(CPU_AVX2)
+    if (cpuHasAVX2()) u = convolveAVX2(l, 0, width);
+#elif defined(CPU_NEON)
+    u = convolveNEON(l, 0, width);
+#endif
+    convolveScalar(l, u, width);
+}
+
+void convolutionRowsCPU(sl::uchar4 *dst, sl::uchar4 *src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
+    parallelRows(imageH, [&](int first, int last) {
+        // Row copy with KERNEL_RADIUS black pixels on each side, the GPU pads the image with 0 too
+        std::vector<uint32_t> padded(imageW + 2 * KERNEL_RADIUS, 0);
+        for (int v = first; v < last; v++) {
+            memcpy(padded.data() + KERNEL_RADIUS, src + v * imageW, imageW * sizeof(uint32_t));
+            ConvolutionLine l;
+            l.src = padded.data() + KERNEL_RADIUS;
+            l.tap_stride = 1;
+            l.depth = i_depth + v * depth_pitch;
+            l.dst = (uint32_t*) (dst + v * imageW);
+            l.j_min = -KERNEL_RADIUS;
+            l.j_max = KERNEL_RADIUS;
+            l.focus_depth = focus_point;
+            l.swap = false;
+            convolveLine(l, imageW);
+        }
+    });
+}
+
+void convolutionColumnsCPU(sl::uchar4 *dst, sl::uchar4 *src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
+    parallelRows(imageH, [&](int first, int last) {
+        for (int v = first; v < last; v++) {
+            ConvolutionLine l;
+            l.src = (const uint32_t*) (src + v * imageW);
+            l.tap_stride = imageW;
+            l.depth = i_depth + v * depth_pitch;
+            l.dst = (uint32_t*) (dst + v * imageW);
+            // The rows outside of the image are black, they add nothing
+            l.j_min = -v;
+            l.j_max = imageH - 1 - v;
+            l.focus_depth = focus_point;
+            l.swap = true;
+            convolveLine(l, imageW);
+        }
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Layered rendering
+////////////////////////////////////////////////////////////////////////////////
+// Bilinear sample of a blur level: offsets of the 2 pixels along one axis and weight of the second one
+struct SampleCoordinate {
+    int i0, i1;
+    float a;
+};
+
+static std::vector<SampleCoordinate> sampleCoordinates(int full_size, int size, int scale_log2) {
+    std::vector<SampleCoordinate> coordinates(full_size);
+    const float inv_scale = 1.f / (1 << scale_log2);
+    for (int i = 0; i < full_size; i++) {
+        const float f = std::min(std::max((i + 0.5f) * inv_scale - 0.5f, 0.f), (float) (size - 1));
+        coordinates[i].i0 = (int) f;
+        coordinates[i].i1 = std::min(coordinates[i].i0 + 1, size - 1);
+        coordinates[i].a = f - coordinates[i].i0;
+    }
+    return coordinates;
+}
+
+struct DoFLayersCPU {
+    int width, height, nb_layers;
+    std::vector<BlurLayer> blur_layers;
+    // Downsampled images, [0] is the source image
+    std::vector<sl::uchar4> pyramid[MAX_LAYER_SCALE + 1];
+    int scale_width[MAX_LAYER_SCALE + 1], scale_height[MAX_LAYER_SCALE + 1];
+    std::vector<SampleCoordinate> x_coordinates[MAX_LAYER_SCALE + 1], y_coordinates[MAX_LAYER_SCALE + 1];
+    std::vector<float> row_pass; // x, y, z per pixel
+    std::vector<sl::uchar4> layers[MAX_LAYERS]; // [0] is the source image
+};
+
+DoFLayersCPU* createLayersCPU(int imageW, int imageH, int nb_layers) {
+    DoFLayersCPU* l = new DoFLayersCPU;
+    l->width = imageW;
+    l->height = imageH;
+    l->nb_layers = std::max(2, std::min(nb_layers, MAX_LAYERS));
+    for (int s = 0; s <= MAX_LAYER_SCALE; s++) {
+        l->scale_width[s] = s ? (l->scale_width[s - 1] + 1) / 2 : imageW;
+        l->scale_height[s] = s ? (l->scale_height[s - 1] + 1) / 2 : imageH;
+        l->x_coordinates[s] = sampleCoordinates(imageW, l->scale_width[s], s);
+        l->y_coordinates[s] = sampleCoordinates(imageH, l->scale_height[s], s);
+    }
+    int max_scale = 0;
+    for (int k = 0; k < l->nb_layers; k++) {
+        l->blur_layers.push_back(getBlurLayer(k, l->nb_layers));
+        const int s = l->blur_layers.back().scale_log2;
+        max_scale = std::max(max_scale, s);
+        if (k) l->layers[k].resize(l->scale_width[s] * l->scale_height[s]);
+    }
+    for (int s = 1; s <= max_scale; s++)
+        l->pyramid[s].resize(l->scale_width[s] * l->scale_height[s]);
+    l->row_pass.resize(imageW * imageH * 3);
+    return l;
+}
+
+void releaseLayersCPU(DoFLayersCPU* layers) {
+    delete layers;
+}
+
+// Average of 2x2 pixels, the last row / column is repeated for odd sizes
+static void downsampleCPU(sl::uchar4* dst, int dst_w, int dst_h, const sl::uchar4* src, int src_w, int src_h) {
+    parallelRows(dst_h, [&](int first, int last) {
+        for (int v = first; v < last; v++) {
+            const sl::uchar4* r0 = src + (2 * v) * src_w;
+            const sl::uchar4* r1 = src + std::min(2 * v + 1, src_h - 1) * src_w;
+            for (int u = 0; u < dst_w; u++) {
+                const int u0 = 2 * u, u1 = std::min(2 * u + 1, src_w - 1);
+                sl::uchar4& p = dst[v * dst_w + u];
+                p.x = (r0[u0].x + r0[u1].x + r1[u0].x + r1[u1].x + 2) >> 2;
+                p.y = (r0[u0].y + r0[u1].y + r1[u0].y + r1[u1].y + 2) >> 2;
+                p.z = (r0[u0].z + r0[u1].z + r1[u0].z + r1[u1].z + 2) >> 2;
+                p.w = 255;
+            }
+        }
+    });
+}
+
+// out[i] = sum of weights[t] * inputs[t][i], the inner loop over the taps stays in registers
+static void weightedSumScalar(float* out, const float* const* inputs, const float* weights, int nb_taps, int first, int n) {
+    for (int i = first; i < n; i++) {
+        float sum = 0.f;
+        for (int t = 0; t < nb_taps; t++)
+            sum += weights[t] * inputs[t][i];
+        out[i] = sum;
+    }
+}
+
+#ifdef CPU_AVX2
+CPU_AVX2_TARGET static int weightedSumAVX2(float* out, const float* const* inputs, const float* weights, int nb_taps, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int t = 0; t < nb_taps; t++)
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[t]), _mm256_loadu_ps(inputs[t] + i)));
+        _mm256_storeu_ps(out + i, sum);
+    }
+    return i;
+}
+#endif
+
+#ifdef CPU_NEON
+static int weightedSumNEON(float* out, const float* const* inputs, const float* weights, int nb_taps, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t sum = vdupq_n_f32(0.f);
+        for (int t = 0; t < nb_taps; t++)
+            sum = vaddq_f32(sum, vmulq_f32(vdupq_n_f32(weights[t]), vld1q_f32(inputs[t] + i)));
+        vst1q_f32(out + i, sum);
+    }
+    return i;
+}
+#endif
+
+static void weightedSum(float* out, const float* const* inputs, const float* weights, int nb_taps, int n) {
+    int i = 0;
+#if defined(CPU_AVX2)
+    if (cpuHasAVX2()) i = weightedSumAVX2(out, inputs, weights, nb_taps, n);
+#elif defined(CPU_NEON)
+    i = weightedSumNEON(out, inputs, weights, nb_taps, n);
+#endif
+    weightedSumScalar(out, inputs, weights, nb_taps, i, n);
+}
+
+// Separable blur with a fixed radius and clamped borders, on float rows of x, y, z: the tap j of the row pass is the
+// row shifted by 3 * j floats, the tap j of the column pass is the row v + j
+static void blurLayerCPU(sl::uchar4* dst, const sl::uchar4* src, int w, int h, int kernel_radius, float* row_pass) {
+    const float* kernel = h_kernel + kernel_radius * kernel_radius - 1;
+    const int nb_taps = KERNEL_LENGTH_X(kernel_radius);
+    parallelRows(h, [&](int first, int last) {
+        std::vector<float> padded((w + 2 * kernel_radius) * 3);
+        std::vector<const float*> taps(nb_taps);
+        for (int t = 0; t < nb_taps; t++)
+            taps[t] = padded.data() + t * 3;
+        for (int v = first; v < last; v++) {
+            for (int i = -kernel_radius; i < w + kernel_radius; i++) {
+                const sl::uchar4& p = src[v * w + std::min(std::max(i, 0), w - 1)];
+                float* f = padded.data() + (i + kernel_radius) * 3;
+                f[0] = p.x;
+                f[1] = p.y;
+                f[2] = p.z;
+            }
+            weightedSum(row_pass + v * w * 3, taps.data(), kernel, nb_taps, w * 3);
+        }
+    });
+    parallelRows(h, [&](int first, int last) {
+        std::vector<float> sum(w * 3);
+        std::vector<const float*> taps(nb_taps);
+        for (int v = first; v < last; v++) {
+            for (int t = 0; t < nb_taps; t++)
+                taps[t] = row_pass + std::min(std::max(v + t - kernel_radius, 0), h - 1) * w * 3;
+            weightedSum(sum.data(), taps.data(), kernel, nb_taps, w * 3);
+            for (int u = 0; u < w; u++) {
+                sl::uchar4& p = dst[v * w + u];
+                p.x = (unsigned char) std::min(sum[u * 3] + 0.5f, 255.f);
+                p.y = (unsigned char) std::min(sum[u * 3 + 1] + 0.5f, 255.f);
+                p.z = (unsigned char) std::min(sum[u * 3 + 2] + 0.5f, 255.f);
+                p.w = 255;
+            }
+        }
+    });
+}
+
+// Rows of the blur levels around the full resolution row being composited
+struct CompositeRow {
+    const sl::uchar4* row0[MAX_LAYERS];
+    const sl::uchar4* row1[MAX_LAYERS];
+    float ay[MAX_LAYERS];
+    const SampleCoordinate* x[MAX_LAYERS];
+    bool full_resolution[MAX_LAYERS];
+    int last_layer;
+    float focus_depth;
+};
+
+// Position of a pixel between the blur levels: level k and weight of level k + 1
+static inline int compositeLayer(const CompositeRow& r, float depth, float& alpha) {
+    float t = r.last_layer * fabsf(depth - r.focus_depth);
+    t = t > 0.f ? std::min(t, (float) r.last_layer) : 0.f; // NAN is sharp
+    const int k = std::min((int) t, r.last_layer - 1);
+    alpha = t - k;
+    return k;
+}
+
+static inline void sampleLayer(const CompositeRow& r, int k, int u, float* c) {
+    if (r.full_resolution[k]) {
+        const sl::uchar4& p = r.row0[k][u];
+        c[0] = p.x;
+        c[1] = p.y;
+        c[2] = p.z;
+        return;
+    }
+    const SampleCoordinate& x = r.x[k][u];
+    const float ay = r.ay[k];
+    const sl::uchar4 &p00 = r.row0[k][x.i0], &p01 = r.row0[k][x.i1], &p10 = r.row1[k][x.i0], &p11 = r.row1[k][x.i1];
+    const float w00 = (1.f - x.a) * (1.f - ay), w01 = x.a * (1.f - ay), w10 = (1.f - x.a) * ay, w11 = x.a * ay;
+    c[0] = w00 * p00.x + w01 * p01.x + w10 * p10.x + w11 * p11.x;
+    c[1] = w00 * p00.y + w01 * p01.y + w10 * p10.y + w11 * p11.y;
+    c[2] = w00 * p00.z + w01 * p01.z + w10 * p10.z + w11 * p11.z;
+}
+
+static void compositeScalar(const CompositeRow& r, const float* depth, uint32_t* out, int first, int n) {
+    for (int u = first; u < n; u++) {
+        float alpha;
+        const int k = compositeLayer(r, depth[u], alpha);
+        float c0[3], c1[3];
+        sampleLayer(r, k, u, c0);
+        sampleLayer(r, k + 1, u, c1);
+        out[u] = packPixel(c0[2] + alpha * (c1[2] - c0[2]) + 0.5f, c0[1] + alpha * (c1[1] - c0[1]) + 0.5f,
+                           c0[0] + alpha * (c1[0] - c0[0]) + 0.5f);
+    }
+}
+
+#ifdef CPU_AVX2
+// One pixel at a time, its 4 channels in a SSE register
+CPU_AVX2_TARGET static inline __m128 loadPixel(const sl::uchar4* p) {
+    int32_t value;
+    memcpy(&value, p, sizeof(value));
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(value)));
+}
+
+CPU_AVX2_TARGET static inline __m128 sampleLayerAVX2(const CompositeRow& r, int k, int u) {
+    if (r.full_resolution[k]) return loadPixel(r.row0[k] + u);
+    const SampleCoordinate& x = r.x[k][u];
+    const __m128 ax = _mm_set1_ps(x.a), ay = _mm_set1_ps(r.ay[k]);
+    const __m128 p00 = loadPixel(r.row0[k] + x.i0), p01 = loadPixel(r.row0[k] + x.i1);
+    const __m128 p10 = loadPixel(r.row1[k] + x.i0), p11 = loadPixel(r.row1[k] + x.i1);
+    const __m128 top = _mm_add_ps(p00, _mm_mul_ps(ax, _mm_sub_ps(p01, p00)));
+    const __m128 bottom = _mm_add_ps(p10, _mm_mul_ps(ax, _mm_sub_ps(p11, p10)));
+    return _mm_add_ps(top, _mm_mul_ps(ay, _mm_sub_ps(bottom, top)));
+}
+
+CPU_AVX2_TARGET static int compositeAVX2(const CompositeRow& r, const float* depth, uint32_t* out, int n) {
+    const __m128 half = _mm_set1_ps(0.5f), max_value = _mm_set1_ps(255.f);
+    // z, y, x, w: the channels are swapped
+    const __m128i shuffle = _mm_setr_epi8(8, 4, 0, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    for (int u = 0; u < n; u++) {
+        float alpha;
+        const int k = compositeLayer(r, depth[u], alpha);
+        const __m128 c0 = sampleLayerAVX2(r, k, u), c1 = sampleLayerAVX2(r, k + 1, u);
+        const __m128 c = _mm_min_ps(_mm_add_ps(_mm_add_ps(c0, _mm_mul_ps(_mm_set1_ps(alpha), _mm_sub_ps(c1, c0))), half), max_value);
+        const __m128i bytes = _mm_shuffle_epi8(_mm_cvttps_epi32(c), shuffle);
+        out[u] = (uint32_t) _mm_cvtsi128_si32(bytes) | 0xFF000000u;
+    }
+    return n;
+}
+#endif
+
+void convolutionLayersCPU(DoFLayersCPU* l, sl::uchar4 *dst, sl::uchar4 *src, float* i_depth, int depth_pitch, float focus_point) {
+    const sl::uchar4* pyramid[MAX_LAYER_SCALE + 1] = {src};
+    for (int s = 1; s <= MAX_LAYER_SCALE && !l->pyramid[s].empty(); s++) {
+        downsampleCPU(l->pyramid[s].data(), l->scale_width[s], l->scale_height[s], pyramid[s - 1], l->scale_width[s - 1], l->scale_height[s - 1]);
+        pyramid[s] = l->pyramid[s].data();
+    }
+
+    const sl::uchar4* layers[MAX_LAYERS] = {src};
+    for (int k = 1; k < l->nb_layers; k++) {
+        const BlurLayer& b = l->blur_layers[k];
+        blurLayerCPU(l->layers[k].data(), pyramid[b.scale_log2], l->scale_width[b.scale_log2], l->scale_height[b.scale_log2], b.kernel_radius, l->row_pass.data());
+        layers[k] = l->layers[k].data();
+    }
+
+    // Each pixel blends the two levels around its radius, the channels are swapped as in the column convolution
+    parallelRows(l->height, [&](int first, int last) {
+        CompositeRow r;
+        r.last_layer = l->nb_layers - 1;
+        r.focus_depth = focus_point;
+        for (int v = first; v < last; v++) {
+            for (int k = 0; k <= r.last_layer; k++) {
+                const int s = l->blur_layers[k].scale_log2;
+                const SampleCoordinate& y = l->y_coordinates[s][v];
+                r.row0[k] = layers[k] + y.i0 * l->scale_width[s];
+                r.row1[k] = layers[k] + y.i1 * l->scale_width[s];
+                r.ay[k] = y.a;
+                r.x[k] = l->x_coordinates[s].data();
+                r.full_resolution[k] = s == 0;
+            }
+            const float* depth = i_depth + v * depth_pitch;
+            uint32_t* out = (uint32_t*) (dst + v * l->width);
+            int u = 0;
+#ifdef CPU_AVX2
+            if (cpuHasAVX2()) u = compositeAVX2(r, depth, out, l->width);
+#endif
+            compositeScalar(r, depth, out, u, l->width);
+        }
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Box blur from a summed-area table
+////////////////////////////////////////////////////////////////////////////////
+struct SummedAreaTableCPU {
+    int width, height;
+    // (width + 1) x (height + 1) entries of 4 sums (x, y, z, unused), the row and column 0 are 0
+    std::vector<uint32_t> sums;
+};
+
+SummedAreaTableCPU* createSummedAreaTableCPU(int imageW, int imageH) {
+    SummedAreaTableCPU* table = new SummedAreaTableCPU;
+    table->width = imageW;
+    table->height = imageH;
+    table->sums.assign((imageW + 1) * (imageH + 1) * 4, 0);
+    return table;
+}
+
+void releaseSummedAreaTableCPU(SummedAreaTableCPU* table) {
+    delete table;
+}
+
+// Mean of the box [x0, x1) x [y0, y1)
+static inline void boxMean(const uint32_t* sums, int stride, int x0, int y0, int x1, int y1, float* c) {
+    const uint32_t* s00 = sums + (y0 * stride + x0) * 4, *s01 = sums + (y0 * stride + x1) * 4;
+    const uint32_t* s10 = sums + (y1 * stride + x0) * 4, *s11 = sums + (y1 * stride + x1) * 4;
+    const float inv_area = 1.f / ((x1 - x0) * (y1 - y0));
+    for (int i = 0; i < 3; i++)
+        c[i] = (float) (s11[i] - s01[i] - s10[i] + s00[i]) * inv_area;
+}
+
+// Half-width of the box of a pixel: integer part and weight of the next integer box
+static inline int boxRadius(float depth, float focus_depth, float& alpha) {
+    float radius = KERNEL_RADIUS * fabsf(depth - focus_depth) * BOX_RADIUS_SCALE;
+    radius = radius > 0.f ? std::min(radius, KERNEL_RADIUS * BOX_RADIUS_SCALE) : 0.f; // NAN is sharp
+    const int r = (int) radius;
+    alpha = radius - r;
+    return r;
+}
+
+static void boxRowScalar(const SummedAreaTableCPU* table, int y, int first, const float* depth, float focus_depth, uint32_t* out) {
+    const int w = table->width, h = table->height, stride = w + 1;
+    const uint32_t* sums = table->sums.data();
+    for (int x = first; x < w; x++) {
+        float alpha;
+        const int r = boxRadius(depth[x], focus_depth, alpha);
+        float c0[3], c1[3];
+        boxMean(sums, stride, std::max(x - r, 0), std::max(y - r, 0), std::min(x + r + 1, w), std::min(y + r + 1, h), c0);
+        boxMean(sums, stride, std::max(x - r - 1, 0), std::max(y - r - 1, 0), std::min(x + r + 2, w), std::min(y + r + 2, h), c1);
+        out[x] = packPixel(c0[2] + alpha * (c1[2] - c0[2]) + 0.5f, c0[1] + alpha * (c1[1] - c0[1]) + 0.5f,
+                           c0[0] + alpha * (c1[0] - c0[0]) + 0.5f);
+    }
+}
+
+#ifdef CPU_AVX2
+// One pixel at a time, the 4 sums of a table entry in a SSE register. Same operations as boxMean: the box sums are
+// below 2^24, their conversion to float is exact.
+CPU_AVX2_TARGET static inline __m128 boxMeanAVX2(const uint32_t* sums, int stride, int x0, int y0, int x1, int y1) {
+    const __m128i s00 = _mm_loadu_si128((const __m128i*) (sums + (y0 * stride + x0) * 4));
+    const __m128i s01 = _mm_loadu_si128((const __m128i*) (sums + (y0 * stride + x1) * 4));
+    const __m128i s10 = _mm_loadu_si128((const __m128i*) (sums + (y1 * stride + x0) * 4));
+    const __m128i s11 = _mm_loadu_si128((const __m128i*) (sums + (y1 * stride + x1) * 4));
+    const __m128i sum = _mm_add_epi32(_mm_sub_epi32(_mm_sub_epi32(s11, s01), s10), s00);
+    return _mm_mul_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps(1.f / ((x1 - x0) * (y1 - y0))));
+}
+
+CPU_AVX2_TARGET static int boxRowAVX2(const SummedAreaTableCPU* table, int y, const float* depth, float focus_depth, uint32_t* out) {
+    const int w = table->width, h = table->height, stride = w + 1;
+    const uint32_t* sums = table->sums.data();
+    const __m128 half = _mm_set1_ps(0.5f), max_value = _mm_set1_ps(255.f);
+    // z, y, x, w: the channels are swapped
+    const __m128i shuffle = _mm_setr_epi8(8, 4, 0, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    for (int x = 0; x < w; x++) {
+        float alpha;
+        const int r = boxRadius(depth[x], focus_depth, alpha);
+        const __m128 c0 = boxMeanAVX2(sums, stride, std::max(x - r, 0), std::max(y - r, 0), std::min(x + r + 1, w), std::min(y + r + 1, h));
+        const __m128 c1 = boxMeanAVX2(sums, stride, std::max(x - r - 1, 0), std::max(y - r - 1, 0), std::min(x + r + 2, w), std::min(y + r + 2, h));
+        const __m128 c = _mm_min_ps(_mm_add_ps(_mm_add_ps(c0, _mm_mul_ps(_mm_set1_ps(alpha), _mm_sub_ps(c1, c0))), half), max_value);
+        out[x] = (uint32_t) _mm_cvtsi128_si32(_mm_shuffle_epi8(_mm_cvttps_epi32(c), shuffle)) | 0xFF000000u;
+    }
+    return w;
+}
+#endif
+
+void convolutionBoxCPU(SummedAreaTableCPU* table, sl::uchar4 *dst, sl::uchar4 *src, float* i_depth, int depth_pitch, float focus_point) {
+    const int w = table->width, h = table->height, stride = w + 1;
+    uint32_t* sums = table->sums.data();
+
+    // Prefix sums along the rows, then along the columns (each block of columns goes down the whole table)
+    parallelRows(h, [&](int first, int last) {
+        for (int y = first; y < last; y++) {
+            uint32_t* row = sums + (y + 1) * stride * 4;
+            uint32_t sum[3] = {0, 0, 0};
+            for (int x = 0; x < w; x++) {
+                const sl::uchar4& p = src[y * w + x];
+                sum[0] += p.x;
+                sum[1] += p.y;
+                sum[2] += p.z;
+                memcpy(row + (x + 1) * 4, sum, sizeof(sum));
+            }
+        }
+    });
+    parallelRows(stride * 4, [&](int first, int last) {
+        for (int y = 2; y <= h; y++) {
+            const uint32_t* previous = sums + (y - 1) * stride * 4;
+            uint32_t* row = sums + y * stride * 4;
+            for (int i = first; i < last; i++)
+                row[i] += previous[i];
+        }
+    });
+
+    parallelRows(h, [&](int first, int last) {
+        for (int y = first; y < last; y++) {
+            int x = 0;
+#ifdef CPU_AVX2
+            if (cpuHasAVX2()) x = boxRowAVX2(table, y, i_depth + y * depth_pitch, focus_point, (uint32_t*) (dst + y * w));
+#endif
+            boxRowScalar(table, y, x, i_depth + y * depth_pitch, focus_point, (uint32_t*) (dst + y * w));
+        }
+    });
+}
+
+#ifdef REFOCUS_CPU
+// The CPU implements the interface of dof_gpu.h, on host memory
+
+void copyKernel(float *kernel_coefficients, int kernel_index) {
+    copyKernelCPU(kernel_coefficients, kernel_index);
+}
+
+void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height, cudaStream_t) {
+    normalizeDepthCPU(depth, depth_out, step, min_distance, max_distance, width, height);
+}
+
+void convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point, cudaStream_t) {
+    convolutionRowsCPU(d_Dst, d_Src, i_depth, imageW, imageH, depth_pitch, focus_point);
+}
+
+void convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point, cudaStream_t) {
+    convolutionColumnsCPU(d_Dst, d_Src, i_depth, imageW, imageH, depth_pitch, focus_point);
+}
+
+struct DoFLayers {
+    DoFLayersCPU* cpu;
+};
+
+DoFLayers* createLayers(int imageW, int imageH, int nb_layers) {
+    return new DoFLayers{createLayersCPU(imageW, imageH, nb_layers)};
+}
+
+void releaseLayers(DoFLayers* layers) {
+    releaseLayersCPU(layers->cpu);
+    delete layers;
+}
+
+void convolutionLayers(DoFLayers* layers, sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int depth_pitch, float focus_point, cudaStream_t) {
+    convolutionLayersCPU(layers->cpu, d_Dst, d_Src, i_depth, depth_pitch, focus_point);
+}
+
+struct SummedAreaTable {
+    SummedAreaTableCPU* cpu;
+};
+
+SummedAreaTable* createSummedAreaTable(int imageW, int imageH) {
+    return new SummedAreaTable{createSummedAreaTableCPU(imageW, imageH)};
+}
+
+void releaseSummedAreaTable(SummedAreaTable* table) {
+    releaseSummedAreaTableCPU(table->cpu);
+    delete table;
+}
+
+void convolutionBox(SummedAreaTable* table, sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int depth_pitch, float focus_point, cudaStream_t) {
+    convolutionBoxCPU(table->cpu, d_Dst, d_Src, i_depth, depth_pitch, focus_point);
+}
+#endif
@@ -32,7 +32,7 @@ __global__ void _k_normalizeDepth(float* depth, float* depth_norm, unsigned int
         depth_norm[x_local + y_local *step] = depth_normalized;
 }
 
-void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height) {
+void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min_distance, float max_distance, unsigned int width, unsigned height, cudaStream_t stream) {
     dim3 dimGrid, dimBlock;
 
     dimBlock.x = 32;
@@ -41,11 +41,18 @@ void normalizeDepth(float* depth, float* depth_out, unsigned int step, float min
     dimGrid.x = (width + dimBlock.x - 1) / dimBlock.x;
     dimGrid.y = (height + dimBlock.y - 1) / dimBlock.y;
 
-    _k_normalizeDepth << <dimGrid, dimBlock, 0 >> > (depth, depth_out, step, min_distance, max_distance, width, height);
+    _k_normalizeDepth << <dimGrid, dimBlock, 0, stream >> > (depth, depth_out, step, min_distance, max_distance, width, height);
+}
+
+// Blur radius of a pixel, clamped to the kernels available (and to the halo of the convolutions), NAN gives 0
+__device__ int blurRadius(float depth, float focus_depth) {
+    const float radius = floorf(KERNEL_RADIUS * fabsf(depth - focus_depth));
+    return radius > 0.f ? (int) fminf(radius, (float) KERNEL_RADIUS) : 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Row convolution filter
+// The grid covers the whole image, the pixels of the last blocks beyond the image are loaded as 0 and not written
 ////////////////////////////////////////////////////////////////////////////////
 #define   ROWS_BLOCKDIM_X 32
 #define   ROWS_BLOCKDIM_Y 4
@@ -64,30 +71,35 @@ __global__ void _k_convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float*
     depth += baseY * pitch_depth + baseX;
 
     sl::uchar4 reset(0, 0, 0, 0);
+    // The rows beyond the image (last blocks) load only 0, they must still reach __syncthreads
+    const bool row_inside = baseY < imageH;
+
     //Load main data
 #pragma unroll
     for (int i = ROWS_HALO_STEPS; i < ROWS_HALO_STEPS + ROWS_RESULT_STEPS; i++) {
-        s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X] = d_Src[i * ROWS_BLOCKDIM_X];
+        s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X] = (row_inside && imageW - baseX > i * ROWS_BLOCKDIM_X) ? d_Src[i * ROWS_BLOCKDIM_X] : reset;
     }
 
     //Load left halo
 #pragma unroll
     for (int i = 0; i < ROWS_HALO_STEPS; i++) {
-        s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X] = (baseX >= -i * ROWS_BLOCKDIM_X) ? d_Src[i * ROWS_BLOCKDIM_X] : reset;
+        s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X] = (row_inside && baseX >= -i * ROWS_BLOCKDIM_X) ? d_Src[i * ROWS_BLOCKDIM_X] : reset;
     }
 
     //Load right halo
 #pragma unroll
     for (int i = ROWS_HALO_STEPS + ROWS_RESULT_STEPS; i < ROWS_HALO_STEPS + ROWS_RESULT_STEPS + ROWS_HALO_STEPS; i++) {
-        s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X] = (imageW - baseX > i * ROWS_BLOCKDIM_X) ? d_Src[i * ROWS_BLOCKDIM_X] : reset;
+        s_Data[threadIdx.y][threadIdx.x + i * ROWS_BLOCKDIM_X] = (row_inside && imageW - baseX > i * ROWS_BLOCKDIM_X) ? d_Src[i * ROWS_BLOCKDIM_X] : reset;
     }
 
     //Compute and store results
     __syncthreads();
+    if (!row_inside) return;
 #pragma unroll
     for (int i = ROWS_HALO_STEPS; i < ROWS_HALO_STEPS + ROWS_RESULT_STEPS; i++) {
+        if (imageW - baseX <= i * ROWS_BLOCKDIM_X) break;
         sl::float3 sum(0, 0, 0);
-        int kernel_radius = (int) floor((KERNEL_RADIUS) *fabs(depth[i * ROWS_BLOCKDIM_X] - focus_depth));
+        int kernel_radius = blurRadius(depth[i * ROWS_BLOCKDIM_X], focus_depth);
         int kernel_mid = kernel_radius * kernel_radius - 1 + kernel_radius;
         if (kernel_radius > 0) {
             for (int j = -kernel_radius; j <= kernel_radius; ++j) {
@@ -108,14 +120,15 @@ __global__ void _k_convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float*
     }
 }
 
-void convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
-    dim3 blocks(imageW / (ROWS_RESULT_STEPS * ROWS_BLOCKDIM_X), imageH / ROWS_BLOCKDIM_Y);
+void convolutionRows(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point, cudaStream_t stream) {
+    dim3 blocks((imageW + ROWS_RESULT_STEPS * ROWS_BLOCKDIM_X - 1) / (ROWS_RESULT_STEPS * ROWS_BLOCKDIM_X), (imageH + ROWS_BLOCKDIM_Y - 1) / ROWS_BLOCKDIM_Y);
     dim3 threads(ROWS_BLOCKDIM_X, ROWS_BLOCKDIM_Y);
-    _k_convolutionRows << <blocks, threads >> > (d_Dst, d_Src, i_depth, imageW, imageH, imageW, depth_pitch, focus_point);
+    _k_convolutionRows << <blocks, threads, 0, stream >> > (d_Dst, d_Src, i_depth, imageW, imageH, imageW, depth_pitch, focus_point);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Column convolution filter
+// Same tail handling as the rows
 ////////////////////////////////////////////////////////////////////////////////
 #define   COLUMNS_BLOCKDIM_X 16
 #define   COLUMNS_BLOCKDIM_Y 8
@@ -131,31 +144,35 @@ __global__ void _k_convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, floa
     d_Src += baseY * pitch + baseX;
     d_Dst += baseY * pitch + baseX;
     depth += baseY * pitch_depth + baseX;
+    // The columns beyond the image (last blocks) load only 0, they must still reach __syncthreads
+    const bool column_inside = baseX < imageW;
 
     //Main data
 #pragma unroll
     for (int i = COLUMNS_HALO_STEPS; i < COLUMNS_HALO_STEPS + COLUMNS_RESULT_STEPS; i++) {
-        s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = d_Src[i * COLUMNS_BLOCKDIM_Y * pitch];
+        s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = (column_inside && imageH - baseY > i * COLUMNS_BLOCKDIM_Y) ? d_Src[i * COLUMNS_BLOCKDIM_Y * pitch] : reset;
     }
 
     //Upper halo
 #pragma unroll
     for (int i = 0; i < COLUMNS_HALO_STEPS; i++) {
-        s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = (baseY >= -i * COLUMNS_BLOCKDIM_Y) ? d_Src[i * COLUMNS_BLOCKDIM_Y * pitch] : reset;
+        s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = (column_inside && baseY >= -i * COLUMNS_BLOCKDIM_Y) ? d_Src[i * COLUMNS_BLOCKDIM_Y * pitch] : reset;
     }
 
     //Lower halo
 #pragma unroll
     for (int i = COLUMNS_HALO_STEPS + COLUMNS_RESULT_STEPS; i < COLUMNS_HALO_STEPS + COLUMNS_RESULT_STEPS + COLUMNS_HALO_STEPS; i++) {
-        s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = (imageH - baseY > i * COLUMNS_BLOCKDIM_Y) ? d_Src[i * COLUMNS_BLOCKDIM_Y * pitch] : reset;
+        s_Data[threadIdx.x][threadIdx.y + i * COLUMNS_BLOCKDIM_Y] = (column_inside && imageH - baseY > i * COLUMNS_BLOCKDIM_Y) ? d_Src[i * COLUMNS_BLOCKDIM_Y * pitch] : reset;
     }
 
     //Compute and store results
     __syncthreads();
+    if (!column_inside) return;
 #pragma unroll
     for (int i = COLUMNS_HALO_STEPS; i < COLUMNS_HALO_STEPS + COLUMNS_RESULT_STEPS; i++) {
+        if (imageH - baseY <= i * COLUMNS_BLOCKDIM_Y) break;
         sl::float3 sum(0, 0, 0);
-        int kernel_radius = (int) floor((KERNEL_RADIUS) *fabs(depth[i * COLUMNS_BLOCKDIM_Y * pitch] - focus_depth));
+        int kernel_radius = blurRadius(depth[i * COLUMNS_BLOCKDIM_Y * pitch], focus_depth);
         int kernel_mid = kernel_radius * kernel_radius - 1 + kernel_radius;
 
         if (kernel_radius > 0) {
@@ -177,8 +194,286 @@ __global__ void _k_convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, floa
     }
 }
 
-void convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point) {
-    dim3 blocks(imageW / COLUMNS_BLOCKDIM_X, imageH / (COLUMNS_RESULT_STEPS * COLUMNS_BLOCKDIM_Y));
+void convolutionColumns(sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int imageW, int imageH, int depth_pitch, float focus_point, cudaStream_t stream) {
+    dim3 blocks((imageW + COLUMNS_BLOCKDIM_X - 1) / COLUMNS_BLOCKDIM_X, (imageH + COLUMNS_RESULT_STEPS * COLUMNS_BLOCKDIM_Y - 1) / (COLUMNS_RESULT_STEPS * COLUMNS_BLOCKDIM_Y));
     dim3 threads(COLUMNS_BLOCKDIM_X, COLUMNS_BLOCKDIM_Y);
-    _k_convolutionColumns << <blocks, threads >> > (d_Dst, d_Src, i_depth, imageW, imageH, imageW, depth_pitch, focus_point);
+    _k_convolutionColumns << <blocks, threads, 0, stream >> > (d_Dst, d_Src, i_depth, imageW, imageH, imageW, depth_pitch, focus_point);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Layered rendering
+////////////////////////////////////////////////////////////////////////////////
+#define LAYERS_BLOCKDIM_X 32
+#define LAYERS_BLOCKDIM_Y 8
+
+struct DoFLayers {
+    int width, height, nb_layers, max_scale;
+    BlurLayer blur_layers[MAX_LAYERS];
+    int scale_width[MAX_LAYER_SCALE + 1], scale_height[MAX_LAYER_SCALE + 1];
+    sl::uchar4* pyramid[MAX_LAYER_SCALE + 1]; // downsampled images, [0] is the source image
+    float4* row_pass;
+    sl::uchar4* layers[MAX_LAYERS];           // [0] is the source image
+};
+
+// Blur levels, passed by value to the composition kernel
+struct LayerViews {
+    const sl::uchar4* data[MAX_LAYERS];
+    int width[MAX_LAYERS], height[MAX_LAYERS], scale_log2[MAX_LAYERS];
+    int last_layer;
+};
+
+DoFLayers* createLayers(int imageW, int imageH, int nb_layers) {
+    DoFLayers* l = new DoFLayers();
+    l->width = imageW;
+    l->height = imageH;
+    l->nb_layers = nb_layers < 2 ? 2 : (nb_layers > MAX_LAYERS ? MAX_LAYERS : nb_layers);
+    for (int s = 0; s <= MAX_LAYER_SCALE; s++) {
+        l->scale_width[s] = s ? (l->scale_width[s - 1] + 1) / 2 : imageW;
+        l->scale_height[s] = s ? (l->scale_height[s - 1] + 1) / 2 : imageH;
+    }
+    l->max_scale = 0;
+    for (int k = 0; k < l->nb_layers; k++) {
+        l->blur_layers[k] = getBlurLayer(k, l->nb_layers);
+        const int s = l->blur_layers[k].scale_log2;
+        if (s > l->max_scale) l->max_scale = s;
+        if (k) cudaMalloc(&l->layers[k], l->scale_width[s] * l->scale_height[s] * sizeof(sl::uchar4));
+    }
+    for (int s = 1; s <= l->max_scale; s++)
+        cudaMalloc(&l->pyramid[s], l->scale_width[s] * l->scale_height[s] * sizeof(sl::uchar4));
+    cudaMalloc(&l->row_pass, imageW * imageH * sizeof(float4));
+    return l;
+}
+
+void releaseLayers(DoFLayers* l) {
+    for (int k = 1; k < l->nb_layers; k++) cudaFree(l->layers[k]);
+    for (int s = 1; s <= l->max_scale; s++) cudaFree(l->pyramid[s]);
+    cudaFree(l->row_pass);
+    delete l;
+}
+
+// Average of 2x2 pixels, the last row / column is repeated for odd sizes
+__global__ void _k_downsample(sl::uchar4 *d_Dst, int dst_w, int dst_h, const sl::uchar4 *d_Src, int src_w, int src_h) {
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if (x >= dst_w || y >= dst_h) return;
+
+    const int x0 = 2 * x, x1 = min(2 * x + 1, src_w - 1);
+    const sl::uchar4* r0 = d_Src + (2 * y) * src_w;
+    const sl::uchar4* r1 = d_Src + min(2 * y + 1, src_h - 1) * src_w;
+    d_Dst[y * dst_w + x] = sl::uchar4((r0[x0].x + r0[x1].x + r1[x0].x + r1[x1].x + 2) >> 2,
+                                      (r0[x0].y + r0[x1].y + r1[x0].y + r1[x1].y + 2) >> 2,
+                                      (r0[x0].z + r0[x1].z + r1[x0].z + r1[x1].z + 2) >> 2, 255);
+}
+
+// Fixed radius blur, clamped borders. The row pass keeps floats for the column pass.
+__global__ void _k_blurLayerRows(float4 *d_Dst, const sl::uchar4 *d_Src, int w, int h, int kernel_radius) {
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if (x >= w || y >= h) return;
+
+    const float* kernel = c_kernel + kernel_radius * kernel_radius - 1 + kernel_radius;
+    const sl::uchar4* row = d_Src + y * w;
+    float4 sum = make_float4(0.f, 0.f, 0.f, 0.f);
+    for (int j = -kernel_radius; j <= kernel_radius; ++j) {
+        const sl::uchar4 p = row[min(max(x + j, 0), w - 1)];
+        sum.x += kernel[j] * (float) p.x;
+        sum.y += kernel[j] * (float) p.y;
+        sum.z += kernel[j] * (float) p.z;
+    }
+    d_Dst[y * w + x] = sum;
+}
+
+__global__ void _k_blurLayerColumns(sl::uchar4 *d_Dst, const float4 *d_Src, int w, int h, int kernel_radius) {
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if (x >= w || y >= h) return;
+
+    const float* kernel = c_kernel + kernel_radius * kernel_radius - 1 + kernel_radius;
+    float4 sum = make_float4(0.f, 0.f, 0.f, 0.f);
+    for (int j = -kernel_radius; j <= kernel_radius; ++j) {
+        const float4 p = d_Src[min(max(y + j, 0), h - 1) * w + x];
+        sum.x += kernel[j] * p.x;
+        sum.y += kernel[j] * p.y;
+        sum.z += kernel[j] * p.z;
+    }
+    d_Dst[y * w + x] = sl::uchar4(fminf(sum.x + 0.5f, 255.f), fminf(sum.y + 0.5f, 255.f), fminf(sum.z + 0.5f, 255.f), 255);
+}
+
+// Bilinear sample of a blur level at the full resolution pixel (x, y)
+__device__ float3 sampleLayer(const LayerViews& views, int k, int x, int y) {
+    const sl::uchar4* data = views.data[k];
+    const int w = views.width[k], h = views.height[k];
+    if (views.scale_log2[k] == 0) {
+        const sl::uchar4 p = data[y * w + x];
+        return make_float3(p.x, p.y, p.z);
+    }
+    const float inv_scale = 1.f / (1 << views.scale_log2[k]);
+    const float fx = fminf(fmaxf((x + 0.5f) * inv_scale - 0.5f, 0.f), (float) (w - 1));
+    const float fy = fminf(fmaxf((y + 0.5f) * inv_scale - 0.5f, 0.f), (float) (h - 1));
+    const int x0 = (int) fx, y0 = (int) fy;
+    const int x1 = min(x0 + 1, w - 1), y1 = min(y0 + 1, h - 1);
+    const float ax = fx - x0, ay = fy - y0;
+    const sl::uchar4 p00 = data[y0 * w + x0], p01 = data[y0 * w + x1], p10 = data[y1 * w + x0], p11 = data[y1 * w + x1];
+    const float w00 = (1.f - ax) * (1.f - ay), w01 = ax * (1.f - ay), w10 = (1.f - ax) * ay, w11 = ax * ay;
+    return make_float3(w00 * p00.x + w01 * p01.x + w10 * p10.x + w11 * p11.x,
+                       w00 * p00.y + w01 * p01.y + w10 * p10.y + w11 * p11.y,
+                       w00 * p00.z + w01 * p01.z + w10 * p10.z + w11 * p11.z);
+}
+
+// Each pixel blends the two levels around its radius, the channels are swapped as in the column convolution
+__global__ void _k_compositeLayers(sl::uchar4 *d_Dst, float* depth, int w, int h, int pitch_depth, float focus_depth, LayerViews views) {
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if (x >= w || y >= h) return;
+
+    float t = views.last_layer * fabsf(depth[y * pitch_depth + x] - focus_depth);
+    t = t > 0.f ? fminf(t, (float) views.last_layer) : 0.f; // NAN is sharp
+    const int k = min((int) t, views.last_layer - 1);
+    const float alpha = t - k;
+    const float3 c0 = sampleLayer(views, k, x, y);
+    const float3 c1 = sampleLayer(views, k + 1, x, y);
+    d_Dst[y * w + x] = sl::uchar4(fminf(c0.z + alpha * (c1.z - c0.z) + 0.5f, 255.f),
+                                  fminf(c0.y + alpha * (c1.y - c0.y) + 0.5f, 255.f),
+                                  fminf(c0.x + alpha * (c1.x - c0.x) + 0.5f, 255.f), 255);
+}
+
+static dim3 layerBlocks(int w, int h) {
+    return dim3((w + LAYERS_BLOCKDIM_X - 1) / LAYERS_BLOCKDIM_X, (h + LAYERS_BLOCKDIM_Y - 1) / LAYERS_BLOCKDIM_Y);
+}
+
+void convolutionLayers(DoFLayers* l, sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int depth_pitch, float focus_point, cudaStream_t stream) {
+    const dim3 threads(LAYERS_BLOCKDIM_X, LAYERS_BLOCKDIM_Y);
+
+    l->pyramid[0] = d_Src;
+    for (int s = 1; s <= l->max_scale; s++)
+        _k_downsample << <layerBlocks(l->scale_width[s], l->scale_height[s]), threads, 0, stream >> > (l->pyramid[s], l->scale_width[s], l->scale_height[s], l->pyramid[s - 1], l->scale_width[s - 1], l->scale_height[s - 1]);
+
+    LayerViews views;
+    views.last_layer = l->nb_layers - 1;
+    for (int k = 0; k < l->nb_layers; k++) {
+        const BlurLayer& b = l->blur_layers[k];
+        const int w = l->scale_width[b.scale_log2], h = l->scale_height[b.scale_log2];
+        if (k) {
+            _k_blurLayerRows << <layerBlocks(w, h), threads, 0, stream >> > (l->row_pass, l->pyramid[b.scale_log2], w, h, b.kernel_radius);
+            _k_blurLayerColumns << <layerBlocks(w, h), threads, 0, stream >> > (l->layers[k], l->row_pass, w, h, b.kernel_radius);
+        }
+        views.data[k] = k ? l->layers[k] : d_Src;
+        views.width[k] = w;
+        views.height[k] = h;
+        views.scale_log2[k] = b.scale_log2;
+    }
+
+    _k_compositeLayers << <layerBlocks(l->width, l->height), threads, 0, stream >> > (d_Dst, i_depth, l->width, l->height, depth_pitch, focus_point, views);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Box blur from a summed-area table
+////////////////////////////////////////////////////////////////////////////////
+#define SUMS_BLOCKDIM_X 32
+#define SUMS_BLOCKDIM_Y 8
+
+struct SummedAreaTable {
+    int width, height;
+    // (width + 1) x (height + 1) entries of 4 sums (x, y, z, unused), the row and column 0 are 0
+    uint4* sums;
+};
+
+SummedAreaTable* createSummedAreaTable(int imageW, int imageH) {
+    SummedAreaTable* table = new SummedAreaTable();
+    table->width = imageW;
+    table->height = imageH;
+    const size_t size = (imageW + 1) * (imageH + 1) * sizeof(uint4);
+    cudaMalloc(&table->sums, size);
+    cudaMemset(table->sums, 0, size);
+    return table;
+}
+
+void releaseSummedAreaTable(SummedAreaTable* table) {
+    cudaFree(table->sums);
+    delete table;
+}
+
+// Prefix sums along the columns, one thread per column: the accesses of a warp are contiguous
+__global__ void _k_summedAreaColumns(uint4* sums, const sl::uchar4 *d_Src, int w, int h) {
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    if (x >= w) return;
+
+    uint4 sum = make_uint4(0, 0, 0, 0);
+    for (int y = 0; y < h; y++) {
+        const sl::uchar4 p = d_Src[y * w + x];
+        sum.x += p.x;
+        sum.y += p.y;
+        sum.z += p.z;
+        sums[(y + 1) * (w + 1) + x + 1] = sum;
+    }
+}
+
+// Then along the rows, one warp per row: prefix sum of 32 entries with shuffles, plus the total of the previous ones
+__global__ void _k_summedAreaRows(uint4* sums, int w, int h) {
+    const int y = blockIdx.x * blockDim.y + threadIdx.y + 1;
+    if (y > h) return; // the whole warp
+
+    const int lane = threadIdx.x;
+    uint4* row = sums + y * (w + 1) + 1;
+    uint4 carry = make_uint4(0, 0, 0, 0);
+    for (int base = 0; base < w; base += SUMS_BLOCKDIM_X) {
+        const int x = base + lane;
+        uint4 v = x < w ? row[x] : make_uint4(0, 0, 0, 0);
+#pragma unroll
+        for (int offset = 1; offset < SUMS_BLOCKDIM_X; offset <<= 1) {
+            const unsigned int nx = __shfl_up_sync(0xFFFFFFFF, v.x, offset);
+            const unsigned int ny = __shfl_up_sync(0xFFFFFFFF, v.y, offset);
+            const unsigned int nz = __shfl_up_sync(0xFFFFFFFF, v.z, offset);
+            if (lane >= offset) {
+                v.x += nx;
+                v.y += ny;
+                v.z += nz;
+            }
+        }
+        v.x += carry.x;
+        v.y += carry.y;
+        v.z += carry.z;
+        if (x < w) row[x] = v;
+        carry.x = __shfl_sync(0xFFFFFFFF, v.x, SUMS_BLOCKDIM_X - 1);
+        carry.y = __shfl_sync(0xFFFFFFFF, v.y, SUMS_BLOCKDIM_X - 1);
+        carry.z = __shfl_sync(0xFFFFFFFF, v.z, SUMS_BLOCKDIM_X - 1);
+    }
+}
+
+// Mean of the box [x0, x1) x [y0, y1). The intrinsics keep the operations of the CPU version (no fused multiply-add),
+// both give the same result.
+__device__ float3 boxMean(const uint4* sums, int stride, int x0, int y0, int x1, int y1) {
+    const uint4 s00 = sums[y0 * stride + x0], s01 = sums[y0 * stride + x1];
+    const uint4 s10 = sums[y1 * stride + x0], s11 = sums[y1 * stride + x1];
+    const float inv_area = 1.f / ((x1 - x0) * (y1 - y0));
+    return make_float3(__fmul_rn((float) (s11.x - s01.x - s10.x + s00.x), inv_area),
+                       __fmul_rn((float) (s11.y - s01.y - s10.y + s00.y), inv_area),
+                       __fmul_rn((float) (s11.z - s01.z - s10.z + s00.z), inv_area));
+}
+
+__device__ unsigned char blendChannel(float c0, float c1, float alpha) {
+    return fminf(__fadd_rn(__fadd_rn(c0, __fmul_rn(alpha, __fsub_rn(c1, c0))), 0.5f), 255.f);
+}
+
+__global__ void _k_boxFromSummedArea(sl::uchar4 *d_Dst, const uint4* sums, float* depth, int w, int h, int pitch_depth, float focus_depth) {
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+    if (x >= w || y >= h) return;
+
+    float radius = __fmul_rn(KERNEL_RADIUS * fabsf(depth[y * pitch_depth + x] - focus_depth), BOX_RADIUS_SCALE);
+    radius = radius > 0.f ? fminf(radius, KERNEL_RADIUS * BOX_RADIUS_SCALE) : 0.f; // NAN is sharp
+    const int r = (int) radius;
+    const float alpha = radius - r;
+    const int stride = w + 1;
+    const float3 c0 = boxMean(sums, stride, max(x - r, 0), max(y - r, 0), min(x + r + 1, w), min(y + r + 1, h));
+    const float3 c1 = boxMean(sums, stride, max(x - r - 1, 0), max(y - r - 1, 0), min(x + r + 2, w), min(y + r + 2, h));
+    // Channels swapped as in the column convolution
+    d_Dst[y * w + x] = sl::uchar4(blendChannel(c0.z, c1.z, alpha), blendChannel(c0.y, c1.y, alpha), blendChannel(c0.x, c1.x, alpha), 255);
+}
+
+void convolutionBox(SummedAreaTable* table, sl::uchar4 *d_Dst, sl::uchar4 *d_Src, float* i_depth, int depth_pitch, float focus_point, cudaStream_t stream) {
+    const int w = table->width, h = table->height;
+    _k_summedAreaColumns << <(w + SUMS_BLOCKDIM_X * SUMS_BLOCKDIM_Y - 1) / (SUMS_BLOCKDIM_X * SUMS_BLOCKDIM_Y), SUMS_BLOCKDIM_X * SUMS_BLOCKDIM_Y, 0, stream >> > (table->sums, d_Src, w, h);
+    _k_summedAreaRows << <(h + SUMS_BLOCKDIM_Y - 1) / SUMS_BLOCKDIM_Y, dim3(SUMS_BLOCKDIM_X, SUMS_BLOCKDIM_Y), 0, stream >> > (table->sums, w, h);
+    _k_boxFromSummedArea << <dim3((w + SUMS_BLOCKDIM_X - 1) / SUMS_BLOCKDIM_X, (h + SUMS_BLOCKDIM_Y - 1) / SUMS_BLOCKDIM_Y), dim3(SUMS_BLOCKDIM_X, SUMS_BLOCKDIM_Y), 0, stream >> > (d_Dst, table->sums, i_depth, w, h, depth_pitch, focus_point);
 }
@@ -27,43 +27,161 @@
  // ZED SDK include
 #include <sl/Camera.hpp>
 
+#include <atomic>
+#include <cstdio>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
 // OpenGL extensions
 #include "GL/glew.h"
 #include "GL/freeglut.h"
 
+// CUDA functions (implemented on the CPU, in host memory, with REFOCUS_CPU)
+#include "dof_gpu.h"
+
+#ifdef REFOCUS_CPU
+#define REFOCUS_MEM MEM::CPU
+#else
 // CUDA specific for OpenGL interoperability
 #include <cuda_gl_interop.h>
 
-// CUDA functions 
-#include "dof_gpu.h"
+// CPU functions, reference of the validation
+#include "dof_cpu.h"
+
+#define REFOCUS_MEM MEM::GPU
+#endif
 
 using namespace sl;
 using namespace std;
 
 // Declare some resources (GL texture ID, GL shader ID...)
 GLuint imageTex;
+#ifndef REFOCUS_CPU
 cudaGraphicsResource* pcuImageRes;
+#endif
 
 // ZED Camera object
 Camera zed;
 
-// Mat ressources
-Mat gpu_image_left;
-Mat gpu_Image_render;
-Mat gpu_depth;
+// Start / stop of a stage on a stream, in GPU time. With REFOCUS_CPU the functions are synchronous: CPU time, nothing to wait.
+struct StageTimer {
+#ifdef REFOCUS_CPU
+    chrono::steady_clock::time_point start_time, stop_time;
+    void create() {}
+    void release() {}
+    void start(cudaStream_t) { start_time = chrono::steady_clock::now(); }
+    void stop(cudaStream_t) { stop_time = chrono::steady_clock::now(); }
+    void wait() {}
+    void waitOn(cudaStream_t) {}
+    bool elapsed(float& ms) { ms = chrono::duration<float, milli>(stop_time - start_time).count(); return true; }
+#else
+    cudaEvent_t start_event = nullptr, stop_event = nullptr;
+    void create() { cudaEventCreate(&start_event); cudaEventCreate(&stop_event); }
+    void release() { cudaEventDestroy(start_event); cudaEventDestroy(stop_event); }
+    void start(cudaStream_t stream) { cudaEventRecord(start_event, stream); }
+    void stop(cudaStream_t stream) { cudaEventRecord(stop_event, stream); }
+    // The host waits for the end of the stage
+    void wait() { cudaEventSynchronize(stop_event); }
+    // The work queued next on 'stream' waits for the end of the stage
+    void waitOn(cudaStream_t stream) { cudaStreamWaitEvent(stream, stop_event, 0); }
+    // False while the stage is still running (or never ran)
+    bool elapsed(float& ms) { return cudaEventQuery(stop_event) == cudaSuccess && cudaEventElapsedTime(&ms, start_event, stop_event) == cudaSuccess; }
+#endif
+};
+
+// Mean time of a stage since the last report
+struct StageStats {
+    double sum = 0.;
+    int count = 0;
+    void add(double ms) { sum += ms; count++; }
+    double mean() const { return count ? sum / count : 0.; }
+};
+
+// Double-buffered pipeline: the grab thread retrieves frame N+1 into one slot while the process stream renders frame N
+// from the other slot and the display stream copies the render of frame N-1 to OpenGL.
+struct FrameSlot {
+    Mat image, depth; // written by the grab thread
+    Mat render;       // written by the process stream, read by the display stream
+    StageTimer process, display;
+    bool timed = true; // the timers of the last use are collected
+};
+FrameSlot slots[2];
+
+// Shared by the frames, only used in order on the process stream
 Mat gpu_depth_normalized;
 Mat gpu_image_convol;
 
+mutex slot_mutex;
+condition_variable slot_ready;
+int ready_slot = -1; // grabbed, not processed yet
+int used_slot = -1;  // processed last, the grab thread writes into the other one
+int presented_slot = -1;
+atomic<bool> grabbing(false);
+thread grab_thread;
+cudaStream_t process_stream = 0, display_stream = 0;
+
+StageStats grab_stats, process_stats, display_stats; // grab_stats is protected by slot_mutex
+int nb_presented = 0;
+chrono::steady_clock::time_point report_time;
+
 // Focus point detected in pixels (X,Y) when mouse click event
 float norm_depth_focus_point = 0.f;
 
+// Depth of field rendering, see dof_gpu.h
+enum class DOF_MODE {
+    CONVOLUTION, // separable convolution, Gaussian radius per pixel
+    LAYERS,      // blur levels blended per pixel
+    BOX,         // box blur from a summed-area table
+    LAST
+};
+DOF_MODE dof_mode = DOF_MODE::CONVOLUTION;
+DoFLayers* dof_layers = nullptr;
+int nb_layers = 5;
+SummedAreaTable* dof_table = nullptr;
+
+void printMode() {
+    switch (dof_mode) {
+        case DOF_MODE::CONVOLUTION: cout << " Per-pixel convolution" << endl; break;
+        case DOF_MODE::LAYERS: cout << " Layered rendering, " << nb_layers << " blur levels" << endl; break;
+        case DOF_MODE::BOX: cout << " Box blur (summed-area table)" << endl; break;
+        default: break;
+    }
+}
+
+// Depth of field of 'src' into 'dst' (RGBA) with the current mode, 'tmp' is the intermediate image of the convolution
+void renderDoF(sl::uchar4* dst, sl::uchar4* src, sl::uchar4* tmp, float* depth, int width, int height, int depth_pitch, float focus, cudaStream_t stream = 0) {
+    switch (dof_mode) {
+        case DOF_MODE::LAYERS:
+            convolutionLayers(dof_layers, dst, src, depth, depth_pitch, focus, stream);
+            break;
+        case DOF_MODE::BOX:
+            convolutionBox(dof_table, dst, src, depth, depth_pitch, focus, stream);
+            break;
+        default:
+            convolutionRows(tmp, src, depth, width, height, depth_pitch, focus, stream);
+            convolutionColumns(dst, tmp, depth, width, height, depth_pitch, focus, stream);
+            break;
+    }
+}
+
+// Before changing the buffers the process stream uses
+void waitProcessing() {
+#ifndef REFOCUS_CPU
+    cudaStreamSynchronize(process_stream);
+#endif
+}
+
 void mouseButtonCallback(int button, int state, int x, int y) {
     if (button == 0 && state) {
         // Get the depth at the mouse click point
         float depth_focus_point = 0.f;
         float max_range = zed.getInitParameters().depth_maximum_distance;
         float min_range = zed.getInitParameters().depth_minimum_distance;
-        gpu_depth.getValue<sl::float1>(x, y, &depth_focus_point, MEM::GPU);
+        if (presented_slot < 0) return;
+        slots[presented_slot].depth.getValue<sl::float1>(x, y, &depth_focus_point, REFOCUS_MEM);
         // Check that the value is valid
         if (isValidMeasure(depth_focus_point)) {
             cout << " Focus point set at : " << depth_focus_point << "mm {" << x << "," << y << "}" << endl;
@@ -73,31 +191,135 @@ void mouseButtonCallback(int button, int state, int x, int y) {
     }
 }
 
-void draw() {
+void keyPressedCallback(unsigned char key, int x, int y) {
+    switch (key) {
+        case 'm':
+            dof_mode = DOF_MODE(((int) dof_mode + 1) % (int) DOF_MODE::LAST);
+            break;
+        case '+':
+        case '-':
+            nb_layers = key == '+' ? min(nb_layers + 1, MAX_LAYERS) : max(nb_layers - 1, 2);
+            waitProcessing();
+            releaseLayers(dof_layers);
+            dof_layers = createLayers(slots[0].image.getWidth(), slots[0].image.getHeight(), nb_layers);
+            break;
+        default:
+            return;
+    }
+    printMode();
+}
+
+// Grab thread: grab + retrieve into the slot the main thread does not use, as soon as the camera has a new frame
+void grabLoop() {
     RuntimeParameters params;
     params.sensing_mode = SENSING_MODE::FILL;
 
-    if (zed.grab(params) == ERROR_CODE::SUCCESS) {
-        // Retrieve Image and Depth
-        zed.retrieveImage(gpu_image_left, VIEW::LEFT, MEM::GPU);
-        zed.retrieveMeasure(gpu_depth, MEASURE::DEPTH, MEM::GPU);
+    while (grabbing) {
+        auto start = chrono::steady_clock::now();
+        if (zed.grab(params) != ERROR_CODE::SUCCESS) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            continue;
+        }
+        int slot;
+        {
+            lock_guard<mutex> lock(slot_mutex);
+            // If the main thread did not take the previous frame yet, it is replaced by this one
+            slot = used_slot == 0 ? 1 : 0;
+            if (ready_slot == slot) ready_slot = -1;
+        }
+        // The last render from this slot has read its inputs
+        slots[slot].process.wait();
+        zed.retrieveImage(slots[slot].image, VIEW::LEFT, REFOCUS_MEM);
+        zed.retrieveMeasure(slots[slot].depth, MEASURE::DEPTH, REFOCUS_MEM);
+        {
+            lock_guard<mutex> lock(slot_mutex);
+            ready_slot = slot;
+            grab_stats.add(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        }
+        slot_ready.notify_one();
+    }
+}
 
-        // Process Image with CUDA
-        // Normalize the depth map and make separable convolution
-        float max_range = zed.getInitParameters().depth_maximum_distance;
-        float min_range = zed.getInitParameters().depth_minimum_distance;
+// Queues the depth of field of the frame on the process stream
+void processFrame(FrameSlot& frame) {
+    // The GPU timers of the last use of the slot, done by now unless the GPU is late: then they are skipped
+    float ms;
+    if (!frame.timed) {
+        if (frame.process.elapsed(ms)) process_stats.add(ms);
+        if (frame.display.elapsed(ms)) display_stats.add(ms);
+        frame.timed = true;
+    }
 
+    // Normalize the depth map and make separable convolution
+    float max_range = zed.getInitParameters().depth_maximum_distance;
+    float min_range = zed.getInitParameters().depth_minimum_distance;
 
-        normalizeDepth(gpu_depth.getPtr<float>(MEM::GPU), gpu_depth_normalized.getPtr<float>(MEM::GPU), gpu_depth.getStep(MEM::GPU), min_range, max_range, gpu_depth.getWidth(), gpu_depth.getHeight());
-        convolutionRows(gpu_image_convol.getPtr<sl::uchar4>(MEM::GPU), gpu_image_left.getPtr<sl::uchar4>(MEM::GPU), gpu_depth_normalized.getPtr<float>(MEM::GPU), gpu_image_left.getWidth(), gpu_image_left.getHeight(), gpu_depth_normalized.getStep(MEM::GPU), norm_depth_focus_point);
-        convolutionColumns(gpu_Image_render.getPtr<sl::uchar4>(MEM::GPU), gpu_image_convol.getPtr<sl::uchar4>(MEM::GPU), gpu_depth_normalized.getPtr<float>(MEM::GPU), gpu_image_left.getWidth(), gpu_image_left.getHeight(), gpu_depth_normalized.getStep(MEM::GPU), norm_depth_focus_point);
+    // The render of this slot was copied to OpenGL
+    frame.display.waitOn(process_stream);
+    frame.process.start(process_stream);
+    normalizeDepth(frame.depth.getPtr<float>(REFOCUS_MEM), gpu_depth_normalized.getPtr<float>(REFOCUS_MEM), frame.depth.getStep(REFOCUS_MEM), min_range, max_range, frame.depth.getWidth(), frame.depth.getHeight(), process_stream);
+    renderDoF(frame.render.getPtr<sl::uchar4>(REFOCUS_MEM), frame.image.getPtr<sl::uchar4>(REFOCUS_MEM), gpu_image_convol.getPtr<sl::uchar4>(REFOCUS_MEM), gpu_depth_normalized.getPtr<float>(REFOCUS_MEM), frame.image.getWidth(), frame.image.getHeight(), gpu_depth_normalized.getStep(REFOCUS_MEM), norm_depth_focus_point, process_stream);
+    frame.process.stop(process_stream);
+}
 
-        // Map to OpenGL and display
-        cudaArray_t ArrIm;
-        cudaGraphicsMapResources(1, &pcuImageRes, 0);
-        cudaGraphicsSubResourceGetMappedArray(&ArrIm, pcuImageRes, 0, 0);
-        cudaMemcpy2DToArray(ArrIm, 0, 0, gpu_Image_render.getPtr<sl::uchar4>(MEM::GPU), gpu_Image_render.getStepBytes(MEM::GPU), gpu_Image_render.getWidth() * sizeof(sl::uchar4), gpu_Image_render.getHeight(), cudaMemcpyDeviceToDevice);
-        cudaGraphicsUnmapResources(1, &pcuImageRes, 0);
+// Copies the render of the frame to the OpenGL texture once processed (display stream)
+void presentFrame(FrameSlot& frame) {
+    frame.process.waitOn(display_stream);
+    frame.display.start(display_stream);
+#ifdef REFOCUS_CPU
+    // Upload to OpenGL, the column pass already swapped the channels to RGBA
+    glBindTexture(GL_TEXTURE_2D, imageTex);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, frame.render.getStep(REFOCUS_MEM));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame.render.getWidth(), frame.render.getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, frame.render.getPtr<sl::uchar4>(REFOCUS_MEM));
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#else
+    // Map to OpenGL and display
+    cudaArray_t ArrIm;
+    cudaGraphicsMapResources(1, &pcuImageRes, display_stream);
+    cudaGraphicsSubResourceGetMappedArray(&ArrIm, pcuImageRes, 0, 0);
+    cudaMemcpy2DToArrayAsync(ArrIm, 0, 0, frame.render.getPtr<sl::uchar4>(REFOCUS_MEM), frame.render.getStepBytes(REFOCUS_MEM), frame.render.getWidth() * sizeof(sl::uchar4), frame.render.getHeight(), cudaMemcpyDeviceToDevice, display_stream);
+    cudaGraphicsUnmapResources(1, &pcuImageRes, display_stream);
+#endif
+    frame.display.stop(display_stream);
+    frame.timed = false;
+}
+
+// Mean time of each stage, and the frame rate: with the stages overlapped, the period is close to the slowest stage
+// instead of their sum
+void printTimings() {
+    double grab_ms;
+    {
+        lock_guard<mutex> lock(slot_mutex);
+        grab_ms = grab_stats.mean();
+        grab_stats = StageStats();
+    }
+    auto now = chrono::steady_clock::now();
+    const double period_ms = chrono::duration<double, milli>(now - report_time).count() / nb_presented;
+    cout << "[Sample] grab " << grab_ms << " ms, process " << process_stats.mean() << " ms, display " << display_stats.mean()
+        << " ms (sum " << grab_ms + process_stats.mean() + display_stats.mean() << " ms), frame " << period_ms << " ms, "
+        << 1000. / period_ms << " FPS" << endl;
+    process_stats = display_stats = StageStats();
+    nb_presented = 0;
+    report_time = now;
+}
+
+void draw() {
+    // Newest frame of the grab thread
+    int slot = -1;
+    {
+        unique_lock<mutex> lock(slot_mutex);
+        if (slot_ready.wait_for(lock, chrono::milliseconds(100), [] { return ready_slot >= 0; })) {
+            slot = ready_slot;
+            ready_slot = -1;
+            used_slot = slot;
+        }
+    }
+
+    if (slot >= 0) {
+        processFrame(slots[slot]);
+        // While frame N is processed, frame N-1 goes to the screen
+        if (presented_slot >= 0) presentFrame(slots[presented_slot]);
+        presented_slot = slot;
 
         //OpenGL Part
         glDrawBuffer(GL_BACK);
@@ -118,17 +340,287 @@ void draw() {
         glEnd();
 
         glutSwapBuffers();
+
+        if (++nb_presented == 100) printTimings();
     }
 
     glutPostRedisplay();
 }
 
+// Create all the gaussien kernel for different radius and copy them to GPU (or CPU with REFOCUS_CPU)
+void createGaussianKernels() {
+    vector<float> gauss_vec;
+    for (int i = 0; i < KERNEL_RADIUS; ++i) {
+        gauss_vec.resize((i + 1) * 2 + 1, 0);
+
+        // Compute Gaussian coeff
+        int rad = (gauss_vec.size() - 1) / 2;
+        float sigma = 0.3f * ((gauss_vec.size() - 1.f)*0.5f - 1.f) + 0.8f;
+        float sum = 0;
+        for (int u = -rad; u <= rad; u++) {
+            float gauss_value = expf(-1.f * (powf(u, 2.f) / (2.f * powf(sigma, 2.f))));
+            gauss_vec[u + rad] = gauss_value;
+            sum += gauss_value;
+        }
+        sum = 1.f / sum;
+        for (int u = 0; u < gauss_vec.size(); u++)
+            gauss_vec[u] *= sum;
+
+        // Copy coeff to GPU
+        copyKernel(gauss_vec.data(), i);
+#ifndef REFOCUS_CPU
+        // and to the CPU reference, for the validation
+        copyKernelCPU(gauss_vec.data(), i);
+#endif
+    }
+}
+
+// Benchmark buffers, in the memory the functions run on
+#ifdef REFOCUS_CPU
+template<typename T> T* benchmarkAlloc(size_t count) { return new T[count]; }
+template<typename T> void benchmarkFree(T* ptr) { delete[] ptr; }
+template<typename T> void benchmarkCopy(T* dst, const T* src, size_t count) { memcpy(dst, src, count * sizeof(T)); }
+void benchmarkSync() {}
+#else
+template<typename T> T* benchmarkAlloc(size_t count) { T* ptr = nullptr; cudaMalloc(&ptr, count * sizeof(T)); return ptr; }
+template<typename T> void benchmarkFree(T* ptr) { cudaFree(ptr); }
+template<typename T> void benchmarkCopy(T* dst, const T* src, size_t count) { cudaMemcpy(dst, src, count * sizeof(T), cudaMemcpyDefault); }
+void benchmarkSync() { cudaDeviceSynchronize(); }
+#endif
+
+// Checkerboard with color gradients and noise, the normalized depth goes from 0 to 1 along the diagonal, with holes (NAN)
+void syntheticFrame(int width, int height, vector<sl::uchar4>& image, vector<float>& depth) {
+    image.resize(width * height);
+    depth.resize(width * height);
+    unsigned int seed = 1;
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            seed = seed * 1664525u + 1013904223u;
+            const int noise = (seed >> 24) % 32;
+            const int check = ((x / 32 + y / 32) & 1) ? 200 : 30;
+            image[y * width + x] = sl::uchar4(check + noise, (x * 223) / width + noise, (y * 223) / height + noise, 255);
+            depth[y * width + x] = (seed >> 8) % 97 == 0 ? NAN : 0.5f * x / width + 0.5f * y / height;
+        }
+}
+
+// Mean difference of the color channels, and number of pixels with a channel differing by more than 'tolerance'
+double imageDifference(const vector<sl::uchar4>& a, const vector<sl::uchar4>& b, int tolerance, size_t& nb_errors) {
+    double difference = 0.;
+    nb_errors = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        const int dx = abs(a[i].x - b[i].x), dy = abs(a[i].y - b[i].y), dz = abs(a[i].z - b[i].z);
+        difference += dx + dy + dz;
+        if (max(dx, max(dy, dz)) > tolerance || a[i].w != b[i].w) nb_errors++;
+    }
+    return difference / (3. * a.size());
+}
+
+// All the modes on synthetic HD2K frames, the focus sweeps the whole depth range.
+// The difference is measured against the per-pixel convolution, with the focus at 0.25.
+int benchmark(int nb_frames) {
+    const int width = 2208, height = 1242;
+    const size_t count = width * height;
+    createGaussianKernels();
+
+    vector<sl::uchar4> image, output(count), reference(count);
+    vector<float> depth;
+    syntheticFrame(width, height, image, depth);
+    sl::uchar4* d_image = benchmarkAlloc<sl::uchar4>(count);
+    sl::uchar4* d_convol = benchmarkAlloc<sl::uchar4>(count);
+    sl::uchar4* d_render = benchmarkAlloc<sl::uchar4>(count);
+    float* d_depth = benchmarkAlloc<float>(count);
+    benchmarkCopy(d_image, image.data(), count);
+    benchmarkCopy(d_depth, depth.data(), count);
+    dof_table = createSummedAreaTable(width, height);
+
+    // Milliseconds per frame
+    auto run = [&](vector<sl::uchar4>& result) {
+        auto render = [&](float focus) {
+            renderDoF(d_render, d_image, d_convol, d_depth, width, height, width, focus);
+        };
+        render(0.f); // warm up
+        benchmarkSync();
+        auto start = chrono::steady_clock::now();
+        for (int f = 0; f < nb_frames; f++)
+            render(f / (float) nb_frames);
+        benchmarkSync();
+        const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / nb_frames;
+        render(0.25f);
+        benchmarkCopy(result.data(), d_render, count);
+        return ms;
+    };
+    auto report = [&](double reference_ms) {
+        const double ms = run(output);
+        size_t nb_errors;
+        const double difference = imageDifference(output, reference, 255, nb_errors);
+        cout << ": " << ms << " ms (x" << reference_ms / ms << "), mean difference " << difference << endl;
+    };
+
+    cout << "[Sample] " << width << "x" << height << ", " << nb_frames << " frames" << endl;
+    dof_mode = DOF_MODE::CONVOLUTION;
+    const double reference_ms = run(reference);
+    cout << "[Sample] Per-pixel convolution: " << reference_ms << " ms" << endl;
+    dof_mode = DOF_MODE::BOX;
+    cout << "[Sample] Box blur";
+    report(reference_ms);
+    dof_mode = DOF_MODE::LAYERS;
+    for (int layers : {2, 3, 5, 9, 17, MAX_LAYERS}) {
+        dof_layers = createLayers(width, height, layers);
+        cout << "[Sample] " << layers << " layers";
+        report(reference_ms);
+        releaseLayers(dof_layers);
+    }
+
+    releaseSummedAreaTable(dof_table);
+    benchmarkFree(d_image);
+    benchmarkFree(d_convol);
+    benchmarkFree(d_render);
+    benchmarkFree(d_depth);
+    return EXIT_SUCCESS;
+}
+
+#ifndef REFOCUS_CPU
+// Compares the CUDA functions with their CPU version (dof_cpu.h) on a synthetic frame, returns the number of failures.
+// The GPU fuses the multiply-adds: the convolutions may differ by 1, the layers by 2 (their levels are rounded too). The
+// depth normalization and the box blur are exact.
+// Any size is valid: the sizes that are not a multiple of the CUDA tiles check the tail blocks and the borders.
+int validate(int width, int height) {
+    const size_t count = width * height;
+    const float min_range = 400.f, max_range = 10000.f;
+    vector<sl::uchar4> image, output(count), reference(count), tmp(count);
+    vector<float> depth, depth_mm(count), depth_gpu(count, 0.f);
+    syntheticFrame(width, height, image, depth);
+    for (size_t i = 0; i < count; i++)
+        depth_mm[i] = max_range - depth[i] * (max_range - min_range);
+
+    sl::uchar4* d_image = benchmarkAlloc<sl::uchar4>(count);
+    sl::uchar4* d_convol = benchmarkAlloc<sl::uchar4>(count);
+    sl::uchar4* d_render = benchmarkAlloc<sl::uchar4>(count);
+    float* d_depth = benchmarkAlloc<float>(count);
+    float* d_depth_mm = benchmarkAlloc<float>(count);
+    benchmarkCopy(d_image, image.data(), count);
+    benchmarkCopy(d_depth_mm, depth_mm.data(), count);
+    benchmarkCopy(d_depth, depth_gpu.data(), count);
+
+    int nb_failures = 0;
+    auto check = [&](const string& name, size_t nb_errors, double difference, double gpu_ms, double cpu_ms) {
+        cout << "[Sample] " << width << "x" << height << " " << name << ": " << (nb_errors ? "FAILED, " : "ok, ")
+            << nb_errors << " pixels out of tolerance, mean difference " << difference;
+        if (gpu_ms > 0.) cout << ", GPU " << gpu_ms << " ms, CPU " << cpu_ms << " ms";
+        cout << endl;
+        if (nb_errors) nb_failures++;
+    };
+    auto elapsed = [](chrono::steady_clock::time_point start) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    // The NAN keep the previous value, 0 on both sides
+    vector<float> depth_cpu(count, 0.f);
+    normalizeDepth(d_depth_mm, d_depth, width, min_range, max_range, width, height);
+    normalizeDepthCPU(depth_mm.data(), depth_cpu.data(), width, min_range, max_range, width, height);
+    benchmarkCopy(depth_gpu.data(), d_depth, count);
+    size_t nb_errors = 0;
+    for (size_t i = 0; i < count; i++)
+        if (depth_gpu[i] != depth_cpu[i]) nb_errors++;
+    check("depth normalization", nb_errors, 0., 0., 0.);
+
+    // Same normalized depth for both
+    benchmarkCopy(d_depth, depth.data(), count);
+    dof_layers = createLayers(width, height, nb_layers);
+    dof_table = createSummedAreaTable(width, height);
+    DoFLayersCPU* layers_cpu = createLayersCPU(width, height, nb_layers);
+    SummedAreaTableCPU* table_cpu = createSummedAreaTableCPU(width, height);
+    const char* names[] = {"convolution", "layers", "box"};
+    const int tolerances[] = {1, 2, 0};
+    for (int mode = 0; mode < (int) DOF_MODE::LAST; mode++) {
+        dof_mode = DOF_MODE(mode);
+        for (float focus : {0.f, 0.35f, 0.8f}) {
+            benchmarkSync();
+            auto start = chrono::steady_clock::now();
+            renderDoF(d_render, d_image, d_convol, d_depth, width, height, width, focus);
+            benchmarkSync();
+            const double gpu_ms = elapsed(start);
+            benchmarkCopy(output.data(), d_render, count);
+            start = chrono::steady_clock::now();
+            switch (dof_mode) {
+                case DOF_MODE::LAYERS:
+                    convolutionLayersCPU(layers_cpu, reference.data(), image.data(), depth.data(), width, focus);
+                    break;
+                case DOF_MODE::BOX:
+                    convolutionBoxCPU(table_cpu, reference.data(), image.data(), depth.data(), width, focus);
+                    break;
+                default:
+                    convolutionRowsCPU(tmp.data(), image.data(), depth.data(), width, height, width, focus);
+                    convolutionColumnsCPU(reference.data(), tmp.data(), depth.data(), width, height, width, focus);
+                    break;
+            }
+            const double cpu_ms = elapsed(start);
+            const double difference = imageDifference(output, reference, tolerances[mode], nb_errors);
+            check(string(names[mode]) + ", focus " + to_string((int) (focus * 100)) + "%", nb_errors, difference, gpu_ms, cpu_ms);
+        }
+    }
+
+    releaseLayers(dof_layers);
+    releaseSummedAreaTable(dof_table);
+    releaseLayersCPU(layers_cpu);
+    releaseSummedAreaTableCPU(table_cpu);
+    benchmarkFree(d_image);
+    benchmarkFree(d_convol);
+    benchmarkFree(d_render);
+    benchmarkFree(d_depth);
+    benchmarkFree(d_depth_mm);
+    return nb_failures;
+}
+
+// The camera resolutions, then ROI sizes that are not a multiple of any tile (down to a single pixel)
+int validateSizes() {
+    const int sizes[][2] = {
+        {672, 376}, {1280, 720}, {1920, 1080}, {2208, 1242},
+        {640, 480}, {333, 197}, {1001, 17}, {31, 509}, {1, 1}
+    };
+    int nb_failures = 0;
+    for (auto& size : sizes)
+        nb_failures += validate(size[0], size[1]);
+    cout << "[Sample] Validation: " << nb_failures << " failure(s)" << endl;
+    return nb_failures;
+}
+#endif
+
 int main(int argc, char **argv) {
 
-    if (argc > 2) {
-        cout << "Only the path of a SVO can be passed in arg" << endl;
+    int benchmark_frames = 0;
+    bool run_validation = false;
+    int roi_width = 0, roi_height = 0;
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        const bool has_value = i + 1 < argc && atof(argv[i + 1]) > 0;
+        if (arg == "--layers" && has_value) {
+            nb_layers = max(2, min(atoi(argv[++i]), MAX_LAYERS));
+            dof_mode = DOF_MODE::LAYERS;
+        } else if (arg == "--box")
+            dof_mode = DOF_MODE::BOX;
+        else if (arg == "--benchmark")
+            benchmark_frames = has_value ? atoi(argv[++i]) : 50;
+        else if (arg == "--validate") {
+            run_validation = true;
+            if (has_value && sscanf(argv[++i], "%dx%d", &roi_width, &roi_height) != 2) roi_width = roi_height = 0;
+        } else {
+            cout << "Usage: ZED_CUDA_Refocus [--layers N | --box] [--benchmark [frames]] [--validate [WxH]]" << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (run_validation) {
+#ifdef REFOCUS_CPU
+        cout << "[Sample][Error] --validate compares the CUDA functions with the CPU ones, it needs the CUDA build" << endl;
         return EXIT_FAILURE;
+#else
+        createGaussianKernels();
+        const int nb_failures = (roi_width > 0 && roi_height > 0) ? validate(roi_width, roi_height) : validateSizes();
+        return nb_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+#endif
     }
+    if (benchmark_frames > 0)
+        return benchmark(benchmark_frames);
 
     // Init glut
     glutInit(&argc, argv);
@@ -166,53 +658,68 @@ int main(int argc, char **argv) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, camera_resolution_.width, camera_resolution_.height, 0, GL_BGRA_EXT, GL_UNSIGNED_BYTE, NULL);
     glBindTexture(GL_TEXTURE_2D, 0);
+#ifndef REFOCUS_CPU
     cudaError_t state = cudaGraphicsGLRegisterImage(&pcuImageRes, imageTex, GL_TEXTURE_2D, cudaGraphicsRegisterFlagsWriteDiscard);
     if (state != cudaSuccess)
         return EXIT_FAILURE;
+#endif
 
     glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
 
     // Alloc Mat and tmp buffer
-    gpu_image_left.alloc(camera_resolution_, MAT_TYPE::U8_C4, MEM::GPU);
-    gpu_Image_render.alloc(camera_resolution_, MAT_TYPE::U8_C4, MEM::GPU);
-    gpu_depth.alloc(camera_resolution_, MAT_TYPE::F32_C1, MEM::GPU);
-    gpu_depth_normalized.alloc(camera_resolution_, MAT_TYPE::F32_C1, MEM::GPU);
-    gpu_image_convol.alloc(camera_resolution_, MAT_TYPE::U8_C4, MEM::GPU);
-
-    vector<float> gauss_vec;
-    // Create all the gaussien kernel for different radius and copy them to GPU
-    for (int i = 0; i < KERNEL_RADIUS; ++i) {
-        gauss_vec.resize((i + 1) * 2 + 1, 0);
-
-        // Compute Gaussian coeff
-        int rad = (gauss_vec.size() - 1) / 2;
-        float sigma = 0.3f * ((gauss_vec.size() - 1.f)*0.5f - 1.f) + 0.8f;
-        float sum = 0;
-        for (int u = -rad; u <= rad; u++) {
-            float gauss_value = expf(-1.f * (powf(u, 2.f) / (2.f * powf(sigma, 2.f))));
-            gauss_vec[u + rad] = gauss_value;
-            sum += gauss_value;
-        }
-        sum = 1.f / sum;
-        for (int u = 0; u < gauss_vec.size(); u++)
-            gauss_vec[u] *= sum;
-
-        // Copy coeff to GPU
-        copyKernel(gauss_vec.data(), i);
+    for (auto& frame : slots) {
+        frame.image.alloc(camera_resolution_, MAT_TYPE::U8_C4, REFOCUS_MEM);
+        frame.depth.alloc(camera_resolution_, MAT_TYPE::F32_C1, REFOCUS_MEM);
+        frame.render.alloc(camera_resolution_, MAT_TYPE::U8_C4, REFOCUS_MEM);
+        frame.process.create();
+        frame.display.create();
     }
+    gpu_depth_normalized.alloc(camera_resolution_, MAT_TYPE::F32_C1, REFOCUS_MEM);
+    gpu_image_convol.alloc(camera_resolution_, MAT_TYPE::U8_C4, REFOCUS_MEM);
+#ifndef REFOCUS_CPU
+    // Non-blocking: no implicit synchronization with the default stream
+    cudaStreamCreateWithFlags(&process_stream, cudaStreamNonBlocking);
+    cudaStreamCreateWithFlags(&display_stream, cudaStreamNonBlocking);
+#endif
+
+    createGaussianKernels();
+    dof_layers = createLayers(camera_resolution_.width, camera_resolution_.height, nb_layers);
+    dof_table = createSummedAreaTable(camera_resolution_.width, camera_resolution_.height);
 
     cout << "** Click on the image to set the focus distance **" << endl;
+    cout << "** 'm' switches between the per-pixel convolution, the layered rendering and the box blur **" << endl;
+    cout << "** '+' / '-' change the number of blur levels of the layered rendering **" << endl;
+    printMode();
+
+    grabbing = true;
+    grab_thread = thread(grabLoop);
+    report_time = chrono::steady_clock::now();
 
     glutDisplayFunc(draw);
     glutMouseFunc(mouseButtonCallback);
+    glutKeyboardFunc(keyPressedCallback);
     glutMainLoop(); // Start main loop 
 
     //On close
-    gpu_image_left.free();
-    gpu_Image_render.free();
-    gpu_depth.free();
+    grabbing = false;
+    grab_thread.join();
+#ifndef REFOCUS_CPU
+    cudaStreamSynchronize(display_stream);
+    waitProcessing();
+    cudaStreamDestroy(process_stream);
+    cudaStreamDestroy(display_stream);
+#endif
+    for (auto& frame : slots) {
+        frame.image.free();
+        frame.depth.free();
+        frame.render.free();
+        frame.process.release();
+        frame.display.release();
+    }
     gpu_depth_normalized.free();
     gpu_image_convol.free();
+    releaseLayers(dof_layers);
+    releaseSummedAreaTable(dof_table);
     zed.close();
     return EXIT_SUCCESS;
 }
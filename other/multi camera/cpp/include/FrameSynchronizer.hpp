@@ -0,0 +1,122 @@
+#ifndef __FRAME_SYNCHRONIZER_HDR__
+#define __FRAME_SYNCHRONIZER_HDR__
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/*
+ * Groups the frames of N cameras by timestamp.
+ *
+ * Each acquisition thread push()es its frames (timestamp in ns + any payload), the consumer pop()s
+ * synchronized sets: one frame per camera, all within 'tolerance' of the newest one. Frames that can
+ * not be part of a set (too old compared to the other cameras, or pushed out of a full queue) are
+ * counted as orphans. The class does not depend on the ZED SDK, so the grouping can be driven by
+ * synthetic timestamp streams.
+ */
+template<typename T>
+class FrameSynchronizer {
+public:
+    struct Frame {
+        uint64_t ts;
+        T data;
+    };
+
+    struct Stats {
+        uint64_t sets = 0;
+        uint64_t skew_sum = 0; // ns, spread between the oldest and newest frame of each set
+        uint64_t skew_max = 0; // ns
+        std::vector<uint64_t> orphans; // per camera
+
+        double meanSkewMs() const {
+            return sets ? (skew_sum / static_cast<double>(sets)) * 1e-6 : 0.;
+        }
+    };
+
+    FrameSynchronizer(int nb_cameras, uint64_t tolerance_ns, size_t max_queue = 8)
+    : queues(nb_cameras), tolerance(tolerance_ns), max_queue(max_queue) {
+        stats.orphans.resize(nb_cameras, 0);
+    }
+
+    // Producer side, thread safe. Timestamps of a given camera must be increasing.
+    void push(int camera, uint64_t ts, const T& data) {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto& q = queues[camera];
+        q.push_back({ts, data});
+        // bound the memory if another camera stopped producing
+        while (q.size() > max_queue) {
+            q.pop_front();
+            stats.orphans[camera]++;
+        }
+    }
+
+    // Consumer side, thread safe. Returns true and fills 'set' (one frame per camera) if a set is complete.
+    bool pop(std::vector<Frame>& set) {
+        std::lock_guard<std::mutex> guard(mtx);
+        for (;;) {
+            for (auto& q : queues)
+                if (q.empty()) return false;
+
+            // the newest head is the reference, every older head out of tolerance can never be matched anymore
+            uint64_t ref = 0;
+            for (auto& q : queues)
+                ref = std::max(ref, q.front().ts);
+
+            bool dropped = false;
+            for (size_t c = 0; c < queues.size(); c++) {
+                auto& q = queues[c];
+                while (!q.empty() && q.front().ts + tolerance < ref) {
+                    q.pop_front();
+                    stats.orphans[c]++;
+                    dropped = true;
+                }
+                // a following frame may be even closer to the reference
+                while (q.size() > 1 && q[1].ts <= ref + tolerance && distance(q[1].ts, ref) < distance(q.front().ts, ref)) {
+                    q.pop_front();
+                    stats.orphans[c]++;
+                    dropped = true;
+                }
+            }
+            // the reference may have moved, check again
+            if (dropped) continue;
+
+            set.resize(queues.size());
+            uint64_t ts_min = ref;
+            for (size_t c = 0; c < queues.size(); c++) {
+                set[c] = queues[c].front();
+                queues[c].pop_front();
+                ts_min = std::min(ts_min, set[c].ts);
+            }
+            stats.sets++;
+            stats.skew_sum += ref - ts_min;
+            stats.skew_max = std::max(stats.skew_max, ref - ts_min);
+            return true;
+        }
+    }
+
+    Stats getStats() {
+        std::lock_guard<std::mutex> guard(mtx);
+        return stats;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> guard(mtx);
+        stats = Stats();
+        stats.orphans.resize(queues.size(), 0);
+    }
+
+private:
+    static uint64_t distance(uint64_t a, uint64_t b) {
+        return a > b ? a - b : b - a;
+    }
+
+    std::mutex mtx;
+    std::vector<std::deque<Frame>> queues;
+    uint64_t tolerance;
+    size_t max_queue;
+    Stats stats;
+};
+
+#endif /* __FRAME_SYNCHRONIZER_HDR__ */
@@ -0,0 +1,83 @@
+#ifndef __POINT_CLOUD_FUSION_HDR__
+#define __POINT_CLOUD_FUSION_HDR__
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+#include "TripleBuffer.hpp"
+#include "WorkerPool.hpp"
+
+// Rigid transform camera -> world, row major 3x4
+struct Extrinsics {
+    float m[12] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0};
+};
+
+// Reads one line per camera: "<serial> <tx> <ty> <tz> <rx> <ry> <rz>", translation in meters and
+// rotation as a rotation vector in radians. Lines starting with '#' are ignored.
+bool loadExtrinsics(const std::string& path, std::map<unsigned int, Extrinsics>& extrinsics);
+
+// Running sum of the points that fell in a voxel
+struct VoxelAccum {
+    float x = 0, y = 0, z = 0;
+    float r = 0, g = 0, b = 0;
+    uint32_t count = 0;
+
+    void add(const VoxelAccum& o) {
+        x += o.x; y += o.y; z += o.z;
+        r += o.r; g += o.g; b += o.b;
+        count += o.count;
+    }
+};
+
+// Voxels of one camera, split in buckets by key hash so that the final merge can process the buckets in parallel
+struct VoxelBuckets {
+    std::vector<std::unordered_map<uint64_t, VoxelAccum>> buckets;
+    sl::Timestamp ts = 0;
+};
+
+/*
+ * Fuses the point clouds of several cameras into a single world frame cloud, voxel-hashed at a fixed voxel size.
+ *
+ * integrate() is called by each acquisition thread with its own XYZRGBA measure: the points are transformed with the
+ * camera extrinsics and accumulated into the camera's voxel buckets, then handed over through a triple buffer.
+ * merge() takes the newest buckets of every camera, and merges bucket i of all cameras in the same worker, so the
+ * workers never touch the same voxel and need no lock. The merge workers are created once, with the fusion.
+ */
+class PointCloudFusion {
+public:
+    // nb_threads: merge workers, the calling thread included (0: one per core)
+    PointCloudFusion(int nb_cameras, float voxel_size, int nb_threads = 0, int nb_buckets = 64);
+
+    void setExtrinsics(int camera, const Extrinsics& extrinsics);
+
+    // Called by the acquisition thread of 'camera' only
+    void integrate(int camera, sl::Mat& cloud, sl::Timestamp ts);
+
+    // Builds the fused cloud (x, y, z, packed rgba) from the newest frame of each camera. Returns the number of voxels.
+    size_t merge(std::vector<sl::float4>& fused);
+
+    float getVoxelSize() const {
+        return voxel_size;
+    }
+
+private:
+    uint64_t key(float x, float y, float z) const;
+
+    int nb_buckets;
+    float voxel_size;
+    std::vector<Extrinsics> extrinsics;
+    std::vector<TripleBuffer<VoxelBuckets>> cameras;
+    std::vector<std::vector<sl::float4>> merged_buckets;
+    WorkerPool workers;
+    std::vector<std::unordered_map<uint64_t, VoxelAccum>> worker_voxels; // one per worker, kept between merges
+};
+
+// Saves the fused cloud as an ASCII PLY file
+bool savePly(const std::string& path, const std::vector<sl::float4>& cloud);
+
+#endif /* __POINT_CLOUD_FUSION_HDR__ */
@@ -0,0 +1,51 @@
+#ifndef __THREAD_AFFINITY_HDR__
+#define __THREAD_AFFINITY_HDR__
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Where and how an acquisition thread runs. Negative / zero values leave the OS defaults.
+struct ThreadPlacement {
+    std::vector<int> cpus; // allowed cores, empty: any
+    int numa_node = -1; // restricts 'cpus' (or all the cores) to this node
+    int rt_priority = 0; // SCHED_FIFO priority [1, 99], 0: keep the normal scheduler
+};
+
+// Applies the placement to the calling thread, prints a warning and keeps going for what is not permitted.
+// Buffers allocated (and first written) by the thread afterwards are placed on its NUMA node by the kernel.
+void applyThreadPlacement(const ThreadPlacement& placement, const std::string& name);
+
+// Cores of a NUMA node, read from sysfs. Empty if the node does not exist or on non-Linux systems.
+std::vector<int> getNumaNodeCpus(int node);
+
+// Parses "2,3,6-8" into {2, 3, 6, 7, 8}
+std::vector<int> parseCpuList(const std::string& list);
+
+// Grab interval statistics of one camera, filled by its acquisition thread and read by the display thread
+class GrabJitter {
+public:
+    void tick() {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> guard(mtx);
+        if (count_ticks++ > 0) {
+            double dt = std::chrono::duration<double, std::milli>(now - last).count();
+            intervals.push_back(dt);
+        }
+        last = now;
+    }
+
+    // Mean, standard deviation and max grab interval (ms) since the previous report, and the number of intervals
+    // longer than 1.5x the mean, i.e. the gaps that show in the timestamps
+    std::string report();
+
+private:
+    std::mutex mtx;
+    std::chrono::steady_clock::time_point last;
+    uint64_t count_ticks = 0;
+    std::vector<double> intervals;
+};
+
+#endif /* __THREAD_AFFINITY_HDR__ */
@@ -0,0 +1,57 @@
+#ifndef __TRIPLE_BUFFER_HDR__
+#define __TRIPLE_BUFFER_HDR__
+
+#include <atomic>
+
+/*
+ * Lock-free single producer / single consumer triple buffer.
+ *
+ * The producer owns the 'write' slot, the consumer owns the 'read' slot, and the third slot is the
+ * hand-over point. Publishing and reading are a single atomic exchange of slot indices, so neither
+ * side ever waits nor sees a slot while the other one is using it: no torn frame, and the consumer
+ * always gets the newest published one (older ones are overwritten, never queued).
+ */
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : write_idx(0), read_idx(1), spare(2) {}
+
+    // Producer side: fill writeBuffer() then publish() it
+    T& writeBuffer() {
+        return slots[write_idx];
+    }
+
+    void publish() {
+        // hand the written slot over and take back the spare one, flagged as new
+        write_idx = spare.exchange(write_idx | NEW_DATA, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer side: update() returns true if a newer slot has been published since the previous call,
+    // readBuffer() then refers to it until the next update()
+    bool update() {
+        if (!(spare.load(std::memory_order_relaxed) & NEW_DATA))
+            return false;
+        read_idx = spare.exchange(read_idx, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    T& readBuffer() {
+        return slots[read_idx];
+    }
+
+    // Direct access to a slot, only valid for the producer before its first publish() (e.g. for allocation)
+    T& slot(int i) {
+        return slots[i];
+    }
+
+private:
+    static const int INDEX_MASK = 0x3;
+    static const int NEW_DATA = 0x4;
+
+    T slots[3];
+    int write_idx; // owned by the producer
+    int read_idx; // owned by the consumer
+    std::atomic<int> spare; // index of the hand-over slot | NEW_DATA
+};
+
+#endif /* __TRIPLE_BUFFER_HDR__ */
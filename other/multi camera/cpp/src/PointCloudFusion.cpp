@@ -0,0 +1,159 @@
+#include "PointCloudFusion.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+bool loadExtrinsics(const string& path, map<unsigned int, Extrinsics>& extrinsics) {
+    ifstream file(path);
+    if (!file) {
+        cout << "[Error] can not open calibration file " << path << endl;
+        return false;
+    }
+
+    string line;
+    while (getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        stringstream ss(line);
+        unsigned int serial;
+        float t[3], rv[3];
+        if (!(ss >> serial >> t[0] >> t[1] >> t[2] >> rv[0] >> rv[1] >> rv[2])) {
+            cout << "[Warning] ignored calibration line: " << line << endl;
+            continue;
+        }
+
+        // Rodrigues: R = I + sin(a) K + (1 - cos(a)) K^2, with K the cross product matrix of the unit axis
+        Extrinsics e;
+        const float angle = sqrt(rv[0] * rv[0] + rv[1] * rv[1] + rv[2] * rv[2]);
+        if (angle > 1e-9f) {
+            const float kx = rv[0] / angle, ky = rv[1] / angle, kz = rv[2] / angle;
+            const float s = sin(angle), c = cos(angle), v = 1.f - c;
+            float R[9] = {
+                c + kx * kx * v, kx * ky * v - kz * s, kx * kz * v + ky * s,
+                ky * kx * v + kz * s, c + ky * ky * v, ky * kz * v - kx * s,
+                kz * kx * v - ky * s, kz * ky * v + kx * s, c + kz * kz * v
+            };
+            for (int r = 0; r < 3; r++)
+                for (int col = 0; col < 3; col++)
+                    e.m[r * 4 + col] = R[r * 3 + col];
+        }
+        e.m[3] = t[0];
+        e.m[7] = t[1];
+        e.m[11] = t[2];
+        extrinsics[serial] = e;
+    }
+    return true;
+}
+
+PointCloudFusion::PointCloudFusion(int nb_cameras, float voxel_size_, int nb_threads, int nb_buckets_)
+: nb_buckets(nb_buckets_), voxel_size(voxel_size_), extrinsics(nb_cameras), cameras(nb_cameras), merged_buckets(nb_buckets_),
+workers(nb_threads), worker_voxels(workers.size()) {
+    // allocated before any thread runs
+    for (auto& cam : cameras)
+        for (int i = 0; i < 3; i++)
+            cam.slot(i).buckets.resize(nb_buckets);
+}
+
+void PointCloudFusion::setExtrinsics(int camera, const Extrinsics& e) {
+    extrinsics[camera] = e;
+}
+
+inline uint64_t PointCloudFusion::key(float x, float y, float z) const {
+    // 21 bits per axis, +-1048576 voxels around the origin
+    const uint64_t ix = static_cast<uint64_t>(static_cast<int64_t>(floor(x / voxel_size)) + (1 << 20)) & 0x1FFFFF;
+    const uint64_t iy = static_cast<uint64_t>(static_cast<int64_t>(floor(y / voxel_size)) + (1 << 20)) & 0x1FFFFF;
+    const uint64_t iz = static_cast<uint64_t>(static_cast<int64_t>(floor(z / voxel_size)) + (1 << 20)) & 0x1FFFFF;
+    return (ix << 42) | (iy << 21) | iz;
+}
+
+void PointCloudFusion::integrate(int camera, sl::Mat& cloud, sl::Timestamp ts) {
+    auto& frame = cameras[camera].writeBuffer();
+    for (auto& bucket : frame.buckets)
+        bucket.clear(); // keeps the allocated hash tables from one frame to the next
+    frame.ts = ts;
+
+    const float* m = extrinsics[camera].m;
+    const int width = cloud.getWidth();
+    const int height = cloud.getHeight();
+    for (int v = 0; v < height; v++) {
+        const sl::float4* row = cloud.getPtr<sl::float4>(sl::MEM::CPU) + v * cloud.getStep(sl::MEM::CPU);
+        for (int u = 0; u < width; u++) {
+            const sl::float4& p = row[u];
+            if (!std::isfinite(p.z)) continue;
+
+            VoxelAccum pt;
+            pt.x = m[0] * p.x + m[1] * p.y + m[2] * p.z + m[3];
+            pt.y = m[4] * p.x + m[5] * p.y + m[6] * p.z + m[7];
+            pt.z = m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11];
+            unsigned char clr[4];
+            memcpy(clr, &p.w, 4);
+            pt.r = clr[0];
+            pt.g = clr[1];
+            pt.b = clr[2];
+            pt.count = 1;
+
+            const uint64_t k = key(pt.x, pt.y, pt.z);
+            frame.buckets[((k * 0x9E3779B97F4A7C15ull) >> 32) % nb_buckets][k].add(pt);
+        }
+    }
+    cameras[camera].publish();
+}
+
+size_t PointCloudFusion::merge(vector<sl::float4>& fused) {
+    // take the newest frame of every camera, a camera without a new frame keeps its previous one
+    for (auto& cam : cameras)
+        cam.update();
+
+    const int nb_threads = workers.size();
+    auto merge_buckets = [&](int first) {
+        auto& voxels = worker_voxels[first];
+        for (int b = first; b < nb_buckets; b += nb_threads) {
+            voxels.clear();
+            for (auto& cam : cameras)
+                for (auto& it : cam.readBuffer().buckets[b])
+                    voxels[it.first].add(it.second);
+
+            auto& out = merged_buckets[b];
+            out.clear();
+            for (auto& it : voxels) {
+                const VoxelAccum& a = it.second;
+                const float inv = 1.f / a.count;
+                unsigned char clr[4] = {
+                    static_cast<unsigned char>(a.r * inv), static_cast<unsigned char>(a.g * inv), static_cast<unsigned char>(a.b * inv), 255
+                };
+                sl::float4 p;
+                p.x = a.x * inv;
+                p.y = a.y * inv;
+                p.z = a.z * inv;
+                memcpy(&p.w, clr, 4);
+                out.push_back(p);
+            }
+        }
+    };
+
+    // bucket b of every camera is only read by task (b % nb_threads), and written to merged_buckets[b]: no lock needed
+    workers.run(nb_threads, merge_buckets);
+
+    fused.clear();
+    for (auto& bucket : merged_buckets)
+        fused.insert(fused.end(), bucket.begin(), bucket.end());
+    return fused.size();
+}
+
+bool savePly(const string& path, const vector<sl::float4>& cloud) {
+    ofstream file(path);
+    if (!file) return false;
+    file << "ply\nformat ascii 1.0\nelement vertex " << cloud.size() << "\n"
+        << "property float x\nproperty float y\nproperty float z\n"
+        << "property uchar red\nproperty uchar green\nproperty uchar blue\nend_header\n";
+    for (auto& p : cloud) {
+        unsigned char clr[4];
+        memcpy(clr, &p.w, 4);
+        file << p.x << " " << p.y << " " << p.z << " " << (int) clr[0] << " " << (int) clr[1] << " " << (int) clr[2] << "\n";
+    }
+    return true;
+}
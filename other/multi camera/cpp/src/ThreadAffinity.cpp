@@ -0,0 +1,107 @@
+#include "ThreadAffinity.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+vector<int> parseCpuList(const string& list) {
+    vector<int> cpus;
+    stringstream ss(list);
+    string item;
+    while (getline(ss, item, ',')) {
+        int first, last;
+        if (sscanf(item.c_str(), "%d-%d", &first, &last) == 2) {
+            for (int c = first; c <= last; c++) cpus.push_back(c);
+        } else if (sscanf(item.c_str(), "%d", &first) == 1)
+            cpus.push_back(first);
+    }
+    return cpus;
+}
+
+vector<int> getNumaNodeCpus(int node) {
+    vector<int> cpus;
+#ifdef __linux__
+    ifstream file("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+    string list;
+    if (file && getline(file, list))
+        cpus = parseCpuList(list);
+#endif
+    return cpus;
+}
+
+void applyThreadPlacement(const ThreadPlacement& placement, const string& name) {
+#ifdef __linux__
+    vector<int> cpus = placement.cpus;
+    if (placement.numa_node >= 0) {
+        auto node_cpus = getNumaNodeCpus(placement.numa_node);
+        if (node_cpus.empty())
+            cout << "[Warning] " << name << ": NUMA node " << placement.numa_node << " not found" << endl;
+        else if (cpus.empty())
+            cpus = node_cpus;
+        else {
+            // keep only the requested cores that belong to the node
+            vector<int> both;
+            for (int c : cpus)
+                if (find(node_cpus.begin(), node_cpus.end(), c) != node_cpus.end()) both.push_back(c);
+            if (both.empty())
+                cout << "[Warning] " << name << ": none of the requested cores is on NUMA node " << placement.numa_node << endl;
+            else
+                cpus = both;
+        }
+    }
+
+    if (!cpus.empty()) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (int c : cpus) CPU_SET(c, &cpuset);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        if (err)
+            cout << "[Warning] " << name << ": can not set CPU affinity (" << strerror(err) << ")" << endl;
+    }
+
+    if (placement.rt_priority > 0) {
+        sched_param param;
+        param.sched_priority = std::min(placement.rt_priority, sched_get_priority_max(SCHED_FIFO));
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err)
+            cout << "[Warning] " << name << ": can not use SCHED_FIFO (" << strerror(err) << "), run as root or grant CAP_SYS_NICE" << endl;
+    }
+#else
+    if (!placement.cpus.empty() || placement.numa_node >= 0 || placement.rt_priority > 0)
+        cout << "[Warning] " << name << ": thread placement is only available on Linux" << endl;
+#endif
+}
+
+string GrabJitter::report() {
+    vector<double> values;
+    {
+        lock_guard<mutex> guard(mtx);
+        values.swap(intervals);
+    }
+    if (values.empty()) return "no frame";
+
+    double sum = 0., sum_sq = 0., max_dt = 0.;
+    for (double dt : values) {
+        sum += dt;
+        sum_sq += dt * dt;
+        max_dt = max(max_dt, dt);
+    }
+    const double mean = sum / values.size();
+    const double stddev = sqrt(max(0., sum_sq / values.size() - mean * mean));
+    const int gaps = count_if(values.begin(), values.end(), [mean](double dt) { return dt > 1.5 * mean; });
+
+    char txt[128];
+    snprintf(txt, sizeof(txt), "grab interval %.2f ms, jitter %.2f ms, max %.2f ms, gaps %d/%zu", mean, stddev, max_dt, gaps, values.size());
+    return string(txt);
+}
@@ -27,17 +27,96 @@
 #include <sl/Camera.hpp>
 
 #include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <thread>
+
+#include "FrameSynchronizer.hpp"
+#include "PointCloudFusion.hpp"
+#include "ThreadAffinity.hpp"
+#include "TripleBuffer.hpp"
+
  // Using std and sl namespaces
 using namespace std;
 using namespace sl;
 
-void zed_acquisition(Camera& zed, cv::Mat& image_low_res, bool& run, Timestamp& ts);
+// Frame exchanged between an acquisition thread and the display.
+// The sequence number counts the published frames, a gap on the reader side means late frames.
+struct CameraFrame {
+    cv::Mat image;
+    Timestamp ts = 0;
+    uint64_t seq = 0;
+};
+
+// Display side statistics, per camera
+struct FrameStats {
+    uint64_t last_seq = 0;
+    uint64_t displayed = 0;
+    uint64_t late = 0; // published but overwritten by a newer frame before being displayed
+};
+
+typedef FrameSynchronizer<cv::Mat> ImageSynchronizer;
+
+// Optional processing of an acquisition thread
+struct AcquisitionParams {
+    ThreadPlacement placement;
+    ImageSynchronizer* sync = nullptr;
+    int sync_id = -1;
+    PointCloudFusion* fusion = nullptr;
+    int fusion_id = -1;
+};
+
+void zed_acquisition(Camera& zed, TripleBuffer<CameraFrame>& buffer, atomic<bool>& run, AcquisitionParams params, GrabJitter& jitter);
+void drawTopView(const vector<sl::float4>& cloud, cv::Mat& view);
 
 int main(int argc, char** argv) {
+
+    // '--sync [tolerance_ms]' groups the frames of all cameras by timestamp
+    bool enable_sync = false;
+    float sync_tolerance_ms = 5.f;
+    // '--cpus 2,3,4,5' pins camera i on the i-th core, '--numa 0,0,1,1' places camera i (thread and buffers) on the i-th node,
+    // '--rt [priority]' runs the acquisition threads with SCHED_FIFO, '--display-cpu n' pins the display thread
+    vector<int> cpus, numa_nodes;
+    int rt_priority = 0;
+    int display_cpu = -1;
+    // '--fuse <calibration file> [voxel_size]' merges the point clouds of all cameras in the world frame
+    string calibration_file;
+    float voxel_size = 0.02f;
+    const float fusion_rate = 15.f;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg == "--sync") {
+            enable_sync = true;
+            if (i + 1 < argc && atof(argv[i + 1]) > 0.f) sync_tolerance_ms = atof(argv[++i]);
+        } else if (arg == "--cpus" && i + 1 < argc)
+            cpus = parseCpuList(argv[++i]);
+        else if (arg == "--numa" && i + 1 < argc)
+            numa_nodes = parseCpuList(argv[++i]);
+        else if (arg == "--rt") {
+            rt_priority = 50;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0) rt_priority = atoi(argv[++i]);
+        } else if (arg == "--display-cpu" && i + 1 < argc)
+            display_cpu = atoi(argv[++i]);
+        else if (arg == "--fuse" && i + 1 < argc) {
+            calibration_file = argv[++i];
+            if (i + 1 < argc && atof(argv[i + 1]) > 0.f) voxel_size = atof(argv[++i]);
+        }
+    }
+
+    if (display_cpu >= 0) {
+        ThreadPlacement display_placement;
+        display_placement.cpus.push_back(display_cpu);
+        applyThreadPlacement(display_placement, "Display");
+    }
     
 	InitParameters init_parameters;
     init_parameters.depth_mode = DEPTH_MODE::PERFORMANCE;
     init_parameters.camera_resolution = RESOLUTION::HD720;
+    init_parameters.coordinate_units = UNIT::METER; // the calibration and the voxel size are in meters
     
 	vector< DeviceProperties> devList = Camera::getDeviceList();
     int nb_detected_zed = devList.size();
@@ -67,38 +146,131 @@ int main(int argc, char** argv) {
         }
     }
     
-    bool run = true;
+    atomic<bool> run(true);
     // Create a grab thread for each opened camera
     vector<thread> thread_pool(nb_detected_zed); // compute threads
-    vector<cv::Mat> images_lr(nb_detected_zed); // display images
+    vector<TripleBuffer<CameraFrame>> buffers(nb_detected_zed); // frames exchanged with the display
     vector<string> wnd_names(nb_detected_zed); // display windows names
-    vector<Timestamp> images_ts(nb_detected_zed); // images timestamps
+    vector<FrameStats> stats(nb_detected_zed);
+    vector<GrabJitter> jitters(nb_detected_zed);
+
+    // The synchronizer waits for every camera, so it only takes the ones that are opened
+    vector<int> sync_ids(nb_detected_zed, -1);
+    int nb_opened = 0;
+    for (int z = 0; z < nb_detected_zed; z++)
+        if (zeds[z].isOpened()) sync_ids[z] = nb_opened++;
+    unique_ptr<ImageSynchronizer> sync;
+    if (enable_sync && nb_opened > 1) {
+        sync.reset(new ImageSynchronizer(nb_opened, static_cast<uint64_t>(sync_tolerance_ms * 1e6f)));
+        cout << "Synchronizing " << nb_opened << " cameras, tolerance " << sync_tolerance_ms << " ms" << endl;
+        cv::namedWindow("Synchronized");
+    }
+
+    // Every opened camera integrates its cloud, placed in the world frame with its extrinsics
+    unique_ptr<PointCloudFusion> fusion;
+    map<unsigned int, Extrinsics> extrinsics;
+    if (!calibration_file.empty() && loadExtrinsics(calibration_file, extrinsics)) {
+        fusion.reset(new PointCloudFusion(nb_detected_zed, voxel_size, std::max(1u, std::thread::hardware_concurrency() / 2)));
+        for (int z = 0; z < nb_detected_zed; z++) {
+            if (!zeds[z].isOpened()) continue;
+            auto serial = zeds[z].getCameraInformation().serial_number;
+            if (extrinsics.count(serial))
+                fusion->setExtrinsics(z, extrinsics[serial]);
+            else
+                cout << "[Warning] no extrinsics for ZED SN" << serial << ", using identity" << endl;
+        }
+        cout << "Fusing the point clouds, voxel size " << voxel_size << " m, press 's' to save the fused cloud" << endl;
+    }
 
     for (int z = 0; z < nb_detected_zed; z++)
         if (zeds[z].isOpened()) {
-            // create an image to store Left+Depth image
-            images_lr[z] = cv::Mat(404, 720*2, CV_8UC4);
-            // camera acquisition thread
-            thread_pool[z] = std::thread(zed_acquisition, ref(zeds[z]), ref(images_lr[z]), ref(run), ref(images_ts[z]));
+            AcquisitionParams params;
+            if (z < (int) cpus.size()) params.placement.cpus.push_back(cpus[z]);
+            if (z < (int) numa_nodes.size()) params.placement.numa_node = numa_nodes[z];
+            params.placement.rt_priority = rt_priority;
+            params.sync = sync.get();
+            params.sync_id = sync_ids[z];
+            params.fusion = fusion.get();
+            params.fusion_id = z;
+            // camera acquisition thread, it allocates its own buffers once placed
+            thread_pool[z] = std::thread(zed_acquisition, ref(zeds[z]), ref(buffers[z]), ref(run), params, ref(jitters[z]));
             // create windows for display
             wnd_names[z] = "ZED ID: " + to_string(z);
             cv::namedWindow(wnd_names[z]);
         }
 
-    vector<Timestamp> last_ts(nb_detected_zed, 0); // use to detect new images
-
+    vector<ImageSynchronizer::Frame> sync_set;
+    cv::Mat sync_image;
+    vector<sl::float4> fused_cloud;
+    cv::Mat top_view;
+    int nb_fusions = 0;
+    float fusion_time_ms = 0.f;
+    auto last_fusion = chrono::steady_clock::now();
+    auto last_report = chrono::steady_clock::now();
     char key = ' ';
     // Loop until 'Esc' is pressed
     while (key != 27) {
-        // Resize and show images
+        // Show the newest image of each camera, if any
         for (int z = 0; z < nb_detected_zed; z++) {
-            if (images_ts[z] > last_ts[z]) { // if the current timestamp is newer it is a new image
-                cv::imshow(wnd_names[z], images_lr[z]);
-                last_ts[z] = images_ts[z];
+            if (zeds[z].isOpened() && buffers[z].update()) {
+                auto& frame = buffers[z].readBuffer();
+                auto& st = stats[z];
+                if (st.last_seq && frame.seq > st.last_seq + 1) st.late += frame.seq - st.last_seq - 1;
+                st.last_seq = frame.seq;
+                st.displayed++;
+                cv::imshow(wnd_names[z], frame.image);
             }
         }
 
+        // Show the newest synchronized set, one camera per row
+        if (sync) {
+            bool new_set = false;
+            while (sync->pop(sync_set)) new_set = true;
+            if (new_set) {
+                vector<cv::Mat> rows;
+                for (auto& it : sync_set) rows.push_back(it.data);
+                cv::vconcat(rows, sync_image);
+                cv::imshow("Synchronized", sync_image);
+            }
+        }
+
+        // Merge the newest clouds of all cameras at a fixed rate
+        auto now = chrono::steady_clock::now();
+        if (fusion && chrono::duration<float>(now - last_fusion).count() >= 1.f / fusion_rate) {
+            last_fusion = now;
+            fusion->merge(fused_cloud);
+            fusion_time_ms += chrono::duration<float, milli>(chrono::steady_clock::now() - now).count();
+            nb_fusions++;
+            drawTopView(fused_cloud, top_view);
+            cv::imshow("Fused point cloud (top view)", top_view);
+        }
+
+        // Report every 5 seconds
+        if (chrono::duration_cast<chrono::seconds>(now - last_report).count() >= 5) {
+            for (int z = 0; z < nb_detected_zed; z++)
+                if (zeds[z].isOpened())
+                    cout << "ZED ID: " << z << " displayed " << stats[z].displayed << ", late " << stats[z].late << " | " << jitters[z].report() << endl;
+            if (sync) {
+                auto sync_stats = sync->getStats();
+                cout << "Synchronized sets: " << sync_stats.sets << ", skew mean " << sync_stats.meanSkewMs() << " ms, max " << sync_stats.skew_max * 1e-6 << " ms, orphans:";
+                for (int z = 0; z < nb_detected_zed; z++)
+                    if (sync_ids[z] >= 0) cout << " [ID " << z << "] " << sync_stats.orphans[sync_ids[z]];
+                cout << endl;
+                sync->resetStats();
+            }
+            if (fusion && nb_fusions) {
+                cout << "Fused cloud: " << fused_cloud.size() << " voxels, " << nb_fusions / 5.f << " Hz, merge " << fusion_time_ms / nb_fusions << " ms" << endl;
+                nb_fusions = 0;
+                fusion_time_ms = 0.f;
+            }
+            last_report = now;
+        }
+
         key = cv::waitKey(10);
+        if (key == 's' && fusion) {
+            if (savePly("fused_cloud.ply", fused_cloud))
+                cout << "Fused cloud saved in fused_cloud.ply (" << fused_cloud.size() << " points)" << endl;
+        }
     }
 
     // stop all running threads
@@ -106,29 +278,76 @@ int main(int argc, char** argv) {
 
     // Wait for every thread to be stopped
     for (int z = 0; z < nb_detected_zed; z++)
-        if (zeds[z].isOpened()) 
+        if (thread_pool[z].joinable()) 
             thread_pool[z].join();
 
     return EXIT_SUCCESS;
 }
 
-void zed_acquisition(Camera& zed, cv::Mat& image_low_res, bool& run, Timestamp& ts) {
+void zed_acquisition(Camera& zed, TripleBuffer<CameraFrame>& buffer, atomic<bool>& run, AcquisitionParams params, GrabJitter& jitter) {
+    applyThreadPlacement(params.placement, "ZED SN" + to_string(zed.getCameraInformation().serial_number));
+
+    // create the images to store Left+Depth, once for the 3 slots. They are written here first, so their
+    // pages land on the NUMA node of this thread. The display only reads a slot after it has been published.
+    for (int i = 0; i < 3; i++)
+        buffer.slot(i).image = cv::Mat(404, 720 * 2, CV_8UC4, cv::Scalar::all(0));
+
     Mat zed_image;
-    const int w_low_res = image_low_res.cols / 2;
-    const int h_low_res = image_low_res.rows;
+    const int w_low_res = buffer.writeBuffer().image.cols / 2;
+    const int h_low_res = buffer.writeBuffer().image.rows;
     Resolution low_res(w_low_res, h_low_res);
+    // the point cloud is retrieved at a reduced resolution, the voxel grid is coarser anyway
+    Mat point_cloud;
+    Resolution cloud_res(640, 360);
+    uint64_t seq = 0;
     while (run) {
         // grab current images and compute depth
         if (zed.grab() == ERROR_CODE::SUCCESS) {
+            jitter.tick();
+            // the slot is owned by this thread until it is published
+            auto& frame = buffer.writeBuffer();
             zed.retrieveImage(zed_image, VIEW::LEFT, MEM::CPU, low_res);
             // copy Left image to the left part of the side by side image
-            cv::Mat(h_low_res, w_low_res, CV_8UC4, zed_image.getPtr<sl::uchar1>(MEM::CPU)).copyTo(image_low_res(cv::Rect(0, 0, w_low_res, h_low_res)));
+            cv::Mat(h_low_res, w_low_res, CV_8UC4, zed_image.getPtr<sl::uchar1>(MEM::CPU)).copyTo(frame.image(cv::Rect(0, 0, w_low_res, h_low_res)));
             zed.retrieveImage(zed_image, VIEW::DEPTH, MEM::CPU, low_res);
             // copy Dpeth image to the right part of the side by side image
-            cv::Mat(h_low_res, w_low_res, CV_8UC4, zed_image.getPtr<sl::uchar1>(MEM::CPU)).copyTo(image_low_res(cv::Rect(w_low_res, 0, w_low_res, h_low_res)));
-            ts = zed.getTimestamp(TIME_REFERENCE::IMAGE);
+            cv::Mat(h_low_res, w_low_res, CV_8UC4, zed_image.getPtr<sl::uchar1>(MEM::CPU)).copyTo(frame.image(cv::Rect(w_low_res, 0, w_low_res, h_low_res)));
+            const Timestamp ts = zed.getTimestamp(TIME_REFERENCE::IMAGE);
+            frame.ts = ts;
+            frame.seq = ++seq;
+            // the synchronizer keeps its own copy, the slot belongs to the display once it is published
+            if (params.sync) params.sync->push(params.sync_id, ts.getNanoseconds(), frame.image.clone());
+            buffer.publish();
+
+            if (params.fusion) {
+                zed.retrieveMeasure(point_cloud, MEASURE::XYZRGBA, MEM::CPU, cloud_res);
+                params.fusion->integrate(params.fusion_id, point_cloud, ts);
+            }
         }
         sleep_ms(2);
     }
     zed.close();
 }
+
+// Bird's eye view of the fused cloud (X right, Z up in the image), fitted to the extent of the cloud
+void drawTopView(const vector<sl::float4>& cloud, cv::Mat& view) {
+    const int size = 720;
+    view = cv::Mat(size, size, CV_8UC3, cv::Scalar::all(0));
+    if (cloud.empty()) return;
+
+    float min_x = cloud[0].x, max_x = cloud[0].x, min_z = cloud[0].z, max_z = cloud[0].z;
+    for (auto& p : cloud) {
+        min_x = std::min(min_x, p.x);
+        max_x = std::max(max_x, p.x);
+        min_z = std::min(min_z, p.z);
+        max_z = std::max(max_z, p.z);
+    }
+    const float scale = (size - 1) / std::max(1e-3f, std::max(max_x - min_x, max_z - min_z));
+    for (auto& p : cloud) {
+        int u = static_cast<int>((p.x - min_x) * scale);
+        int v = size - 1 - static_cast<int>((p.z - min_z) * scale);
+        unsigned char clr[4];
+        memcpy(clr, &p.w, 4);
+        view.at<cv::Vec3b>(v, u) = cv::Vec3b(clr[2], clr[1], clr[0]); // RGBA -> BGR
+    }
+}
@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Drives the frame synchronizer of the sample with synthetic timestamp streams and     **
+ ** checks which frames are paired: aligned cameras, a dropped frame, a camera late to   **
+ ** deliver, a camera out of tolerance, the nearest frame choice and a stopped camera.   **
+ ** Each frame carries its index as payload.                                             **
+ *****************************************************************************************/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "FrameSynchronizer.hpp"
+
+using namespace std;
+
+typedef FrameSynchronizer<int> Synchronizer;
+
+static const uint64_t MS = 1000000; // ns
+static const uint64_t PERIOD = 33 * MS;
+
+static int nb_failures = 0;
+
+static void check(bool condition, const string& test, const string& what) {
+    if (!condition) {
+        cout << "FAILED " << test << ": " << what << endl;
+        nb_failures++;
+    }
+}
+
+// Pops every available set, appends the payloads (one vector per set)
+static void popAll(Synchronizer& sync, vector<vector<int>>& sets) {
+    vector<Synchronizer::Frame> set;
+    while (sync.pop(set)) {
+        sets.emplace_back();
+        for (auto& it : set) sets.back().push_back(it.data);
+    }
+}
+
+static vector<vector<int>> popAll(Synchronizer& sync) {
+    vector<vector<int>> sets;
+    popAll(sync, sets);
+    return sets;
+}
+
+static bool sameIndex(const vector<vector<int>>& sets, int first) {
+    for (size_t s = 0; s < sets.size(); s++)
+        for (auto it : sets[s])
+            if (it != first + static_cast<int>(s)) return false;
+    return true;
+}
+
+// 3 cameras at 30 fps with a constant offset below the tolerance: every frame is paired with the same index
+static void testAligned() {
+    const string name = "aligned";
+    Synchronizer sync(3, 5 * MS);
+    const uint64_t offsets[3] = {0, 2 * MS, 4 * MS};
+    vector<vector<int>> sets;
+    for (int i = 0; i < 10; i++) {
+        for (int c = 0; c < 3; c++)
+            sync.push(c, i * PERIOD + offsets[c], i);
+        popAll(sync, sets);
+    }
+    check(sets.size() == 10, name, "10 sets expected, got " + to_string(sets.size()));
+    check(sameIndex(sets, 0), name, "frames of different indices paired");
+    auto stats = sync.getStats();
+    check(stats.skew_max == 4 * MS, name, "max skew of 4 ms expected");
+    check(stats.orphans == vector<uint64_t>(3, 0), name, "no orphan expected");
+}
+
+// Camera 1 drops frame 3: frame 3 of the other cameras can not be paired anymore and is an orphan
+static void testDrop() {
+    const string name = "drop";
+    Synchronizer sync(3, 5 * MS);
+    vector<vector<int>> sets;
+    for (int i = 0; i < 6; i++) {
+        for (int c = 0; c < 3; c++)
+            if (!(c == 1 && i == 3))
+                sync.push(c, i * PERIOD + c * MS, i);
+        popAll(sync, sets);
+    }
+    check(sets.size() == 5, name, "5 sets expected, got " + to_string(sets.size()));
+    if (sets.size() == 5) {
+        check(sets[2] == vector<int>(3, 2), name, "set 2 should hold the frames 2");
+        check(sets[3] == vector<int>(3, 4), name, "set 3 should hold the frames 4");
+    }
+    auto stats = sync.getStats();
+    check(stats.orphans == vector<uint64_t>({1, 0, 1}), name, "frame 3 of cameras 0 and 2 should be orphans");
+}
+
+// Camera 2 delivers its frames later than the others: no set until they arrive, then the same pairing
+static void testLateDelivery() {
+    const string name = "late delivery";
+    Synchronizer sync(3, 5 * MS);
+    for (int i = 0; i < 5; i++)
+        for (int c = 0; c < 2; c++)
+            sync.push(c, i * PERIOD + c * MS, i);
+    check(popAll(sync).empty(), name, "no set expected before camera 2 delivers");
+    for (int i = 0; i < 5; i++)
+        sync.push(2, i * PERIOD + 3 * MS, i);
+    auto sets = popAll(sync);
+    check(sets.size() == 5, name, "5 sets expected, got " + to_string(sets.size()));
+    check(sameIndex(sets, 0), name, "frames of different indices paired");
+    check(sync.getStats().orphans == vector<uint64_t>(3, 0), name, "no orphan expected");
+}
+
+// Camera 1 is 15 ms late, over the 5 ms tolerance: no set, every frame but the last ones is an orphan
+static void testOutOfTolerance() {
+    const string name = "out of tolerance";
+    Synchronizer sync(2, 5 * MS);
+    for (int i = 0; i < 6; i++) {
+        sync.push(0, i * PERIOD, i);
+        sync.push(1, i * PERIOD + 15 * MS, i);
+    }
+    check(popAll(sync).empty(), name, "no set expected");
+    auto stats = sync.getStats();
+    check(stats.orphans[0] + stats.orphans[1] >= 10, name, "the unpaired frames should be orphans");
+}
+
+// Camera 1 has two frames within tolerance of the frame of camera 0: the nearest one is paired
+static void testNearest() {
+    const string name = "nearest";
+    Synchronizer sync(2, 10 * MS);
+    sync.push(0, 100 * MS, 0);
+    sync.push(1, 95 * MS, 0);
+    sync.push(1, 99 * MS, 1);
+    auto sets = popAll(sync);
+    check(sets.size() == 1 && sets[0] == vector<int>({0, 1}), name, "frame 1 of camera 1 (1 ms away) should be paired");
+    check(sync.getStats().orphans == vector<uint64_t>({0, 1}), name, "frame 0 of camera 1 should be an orphan");
+}
+
+// Camera 1 stops producing: the queue of camera 0 stays bounded, its oldest frames become orphans
+static void testStoppedCamera() {
+    const string name = "stopped camera";
+    const size_t max_queue = 4;
+    Synchronizer sync(2, 5 * MS, max_queue);
+    for (int i = 0; i < 10; i++)
+        sync.push(0, i * PERIOD, i);
+    check(popAll(sync).empty(), name, "no set expected");
+    check(sync.getStats().orphans[0] == 10 - max_queue, name, "the frames over the queue size should be orphans");
+    // camera 1 comes back on frame 9: only the newest frame of camera 0 can be paired
+    sync.push(1, 9 * PERIOD + MS, 9);
+    auto sets = popAll(sync);
+    check(sets.size() == 1 && sets[0] == vector<int>({9, 9}), name, "frames 9 should be paired");
+}
+
+int main() {
+    testAligned();
+    testDrop();
+    testLateDelivery();
+    testOutOfTolerance();
+    testNearest();
+    testStoppedCamera();
+    cout << (nb_failures ? "FAILED" : "PASSED") << endl;
+    return nb_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
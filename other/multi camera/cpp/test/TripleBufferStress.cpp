@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************************
+ ** Stress test of the triple buffer of the sample, built with ThreadSanitizer: several   **
+ ** producers (4 by default) publish frames as fast as they can, one consumer reads all  **
+ ** of them, like the display of the sample. Each frame is filled with its sequence      **
+ ** number, the consumer checks that every frame it reads is complete and newer than the **
+ ** previous one. Any race on a slot is reported by ThreadSanitizer.                     **
+ ** Usage: TripleBufferStress [nb_producers] [nb_frames]                                 **
+ *****************************************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "TripleBuffer.hpp"
+
+using namespace std;
+
+struct Frame {
+    uint64_t seq = 0;
+    vector<uint64_t> data; // every value is 'seq' in a complete frame
+};
+
+static const size_t FRAME_SIZE = 4096;
+
+int main(int argc, char **argv) {
+    const int nb_producers = argc > 1 ? max(1, atoi(argv[1])) : 4;
+    const uint64_t nb_frames = argc > 2 ? strtoull(argv[2], nullptr, 10) : 20000;
+
+    vector<TripleBuffer<Frame>> buffers(nb_producers);
+    atomic<int> running(nb_producers);
+    vector<thread> producers;
+    for (int p = 0; p < nb_producers; p++) {
+        producers.emplace_back([&, p]() {
+            auto& buffer = buffers[p];
+            for (int i = 0; i < 3; i++)
+                buffer.slot(i).data.assign(FRAME_SIZE, 0);
+            for (uint64_t seq = 1; seq <= nb_frames; seq++) {
+                auto& frame = buffer.writeBuffer();
+                frame.seq = seq;
+                for (auto& it : frame.data) it = seq;
+                buffer.publish();
+            }
+            running--;
+        });
+    }
+
+    // Consumer: reads until every producer is done, then once more for the last frames
+    vector<uint64_t> last_seq(nb_producers, 0), nb_read(nb_producers, 0), late(nb_producers, 0);
+    uint64_t torn = 0, not_newer = 0;
+    bool done = false;
+    while (!done) {
+        done = running == 0;
+        for (int p = 0; p < nb_producers; p++) {
+            if (!buffers[p].update()) continue;
+            const auto& frame = buffers[p].readBuffer();
+            for (auto it : frame.data)
+                if (it != frame.seq) {
+                    torn++;
+                    break;
+                }
+            if (frame.seq <= last_seq[p])
+                not_newer++;
+            else
+                late[p] += frame.seq - last_seq[p] - 1;
+            last_seq[p] = frame.seq;
+            nb_read[p]++;
+        }
+    }
+    for (auto& it : producers)
+        it.join();
+
+    bool success = torn == 0 && not_newer == 0;
+    for (int p = 0; p < nb_producers; p++) {
+        cout << "Producer " << p << ": " << nb_read[p] << " frames read, " << late[p] << " late, last " << last_seq[p] << endl;
+        // the newest frame is never lost
+        if (last_seq[p] != nb_frames) success = false;
+    }
+    cout << "Torn frames: " << torn << ", frames not newer than the previous one: " << not_newer << endl;
+    cout << (success ? "PASSED" : "FAILED") << endl;
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -31,6 +31,10 @@
 #include <ctime>
 
 #include <sl/Camera.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 #include <GL/glew.h>
@@ -53,8 +57,33 @@ cudaGraphicsResource* pcuImageRes;
 cudaGraphicsResource* pcuDepthRes;
 
 Camera zed;
-Mat gpuLeftImage;
-Mat gpuDepthImage;
+
+// The grab thread retrieves into a ring of GPU frames, the GL thread presents the newest one. With 3 frames, the grab
+// thread always has one to write into: neither the newest (waiting for the GL thread) nor the one being presented.
+#define RING_SIZE 3
+struct GpuFrame {
+    Mat left;
+    Mat depth;
+    chrono::steady_clock::time_point grab_time; // for the frame age
+    cudaEvent_t presented;   // end of the last copy to the textures, before the frame is written again
+};
+GpuFrame ring[RING_SIZE];
+cudaStream_t display_stream;
+
+mutex ring_mutex;
+condition_variable ring_cv;
+int newest_frame = -1;     // grabbed, not presented yet
+int presented_frame = -1;  // copied to the textures last
+atomic<bool> grabbing(false);
+thread grab_thread;
+
+// Counters, under ring_mutex
+unsigned long long nb_grabbed = 0;
+unsigned long long nb_dropped = 0; // replaced by a newer frame before being presented
+// GL thread only
+unsigned long long nb_presented = 0;
+double age_sum_ms = 0.;
+chrono::steady_clock::time_point title_time;
 
 // Simple fragment shader that switch red and blue channels (RGBA -->BGRA)
 string strFragmentShad = ("uniform sampler2D texImage;\n"
@@ -62,35 +91,104 @@ string strFragmentShad = ("uniform sampler2D texImage;\n"
         " vec4 color = texture2D(texImage, gl_TexCoord[0].st);\n"
         " gl_FragColor = vec4(color.b, color.g, color.r, color.a);\n}");
 
-// Main loop for acquisition and rendering : 
-// * grab from the ZED SDK
+// Acquisition thread :
+// * grab from the ZED SDK, at the camera rate, whatever the display does
+// * retrieve the left image and the depth image in GPU memory, into a free frame of the ring
+// * publish it as the newest frame, the previous newest frame is dropped if it was not presented yet
+void grabLoop() {
+    while (grabbing) {
+        if (zed.grab() != ERROR_CODE::SUCCESS) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            continue;
+        }
+        auto grab_time = chrono::steady_clock::now();
+
+        int index = 0;
+        {
+            lock_guard<mutex> lock(ring_mutex);
+            while (index == newest_frame || index == presented_frame) index++;
+        }
+        GpuFrame& frame = ring[index];
+        // The GL thread may still be copying this frame to the textures
+        cudaEventSynchronize(frame.presented);
+
+        // Make sure that retrieveXXX() functions of the ZED SDK are used with sl::MEM::GPU parameters.
+        // Note that we use the depth image here in a 8UC4 (RGBA) format.
+        if (zed.retrieveImage(frame.left, VIEW::LEFT, MEM::GPU) != ERROR_CODE::SUCCESS ||
+            zed.retrieveImage(frame.depth, VIEW::DEPTH, MEM::GPU) != ERROR_CODE::SUCCESS)
+            continue;
+        frame.grab_time = grab_time;
+
+        {
+            lock_guard<mutex> lock(ring_mutex);
+            if (newest_frame >= 0) nb_dropped++;
+            newest_frame = index;
+            nb_grabbed++;
+        }
+        ring_cv.notify_one();
+    }
+}
+
+// Grab rate, display rate, mean age of the presented frames (end of their grab to display) and dropped frames, once per second
+void updateTitle() {
+    auto now = chrono::steady_clock::now();
+    const double elapsed_s = chrono::duration<double>(now - title_time).count();
+    if (elapsed_s < 1.) return;
+
+    static unsigned long long last_grabbed = 0;
+    unsigned long long grabbed, dropped;
+    {
+        lock_guard<mutex> lock(ring_mutex);
+        grabbed = nb_grabbed;
+        dropped = nb_dropped;
+    }
+    char title[256];
+    snprintf(title, sizeof(title), "ZED OGL interop - grab %.1f FPS, display %.1f FPS, frame age %.1f ms, dropped %llu",
+        (grabbed - last_grabbed) / elapsed_s, nb_presented / elapsed_s, nb_presented ? age_sum_ms / nb_presented : 0., dropped);
+    glutSetWindowTitle(title);
+
+    last_grabbed = grabbed;
+    nb_presented = 0;
+    age_sum_ms = 0.;
+    title_time = now;
+}
+
+// Main loop for rendering : 
+// * take the newest frame of the grab thread, if there is a new one
 // * Map cuda and opengl resources and copy the GPU buffer into a CUDA array
 // * Use the OpenGL texture to render on the screen
 
 void draw() {
-    if (zed.grab() == ERROR_CODE::SUCCESS) {
-        // Map GPU Resource for left image
-        // With OpenGL textures, we need to use the cudaGraphicsSubResourceGetMappedArray CUDA functions. It will link/sync the OpenGL texture with a CUDA cuArray
-        // Then, we just have to copy our GPU Buffer to the CudaArray (DeviceToDevice copy) and the texture will contain the GPU buffer content.
-        // That's the most efficient way since we don't have to go back on the CPU to render the texture. Make sure that retrieveXXX() functions of the ZED SDK
-        // are used with sl::MEM::GPU parameters.
-        if (zed.retrieveImage(gpuLeftImage, VIEW::LEFT, MEM::GPU) == ERROR_CODE::SUCCESS) {
-            cudaArray_t ArrIm;
-            cudaGraphicsMapResources(1, &pcuImageRes, 0);
-            cudaGraphicsSubResourceGetMappedArray(&ArrIm, pcuImageRes, 0, 0);
-            cudaMemcpy2DToArray(ArrIm, 0, 0, gpuLeftImage.getPtr<sl::uchar1>(MEM::GPU), gpuLeftImage.getStepBytes(MEM::GPU), gpuLeftImage.getWidth() * sizeof (sl::uchar4), gpuLeftImage.getHeight(), cudaMemcpyDeviceToDevice);
-            cudaGraphicsUnmapResources(1, &pcuImageRes, 0);
+    int index = -1;
+    {
+        // Short wait: the window stays responsive without a busy loop
+        unique_lock<mutex> lock(ring_mutex);
+        if (ring_cv.wait_for(lock, chrono::milliseconds(10), [] { return newest_frame >= 0; })) {
+            index = newest_frame;
+            newest_frame = -1;
+            presented_frame = index;
         }
+    }
 
-        // Map GPU Resource for depth image.
-        // Note that we use the depth image here in a 8UC4 (RGBA) format.
-        if (zed.retrieveImage(gpuDepthImage, VIEW::DEPTH, MEM::GPU) == ERROR_CODE::SUCCESS) {
-            cudaArray_t ArrDe;
-            cudaGraphicsMapResources(1, &pcuDepthRes, 0);
-            cudaGraphicsSubResourceGetMappedArray(&ArrDe, pcuDepthRes, 0, 0);
-            cudaMemcpy2DToArray(ArrDe, 0, 0, gpuDepthImage.getPtr<sl::uchar1>(MEM::GPU), gpuDepthImage.getStepBytes(MEM::GPU), gpuLeftImage.getWidth() * sizeof (sl::uchar4), gpuLeftImage.getHeight(), cudaMemcpyDeviceToDevice);
-            cudaGraphicsUnmapResources(1, &pcuDepthRes, 0);
-        }
+    if (index >= 0) {
+        GpuFrame& frame = ring[index];
+        // Map GPU Resource for left image and depth image
+        // With OpenGL textures, we need to use the cudaGraphicsSubResourceGetMappedArray CUDA functions. It will link/sync the OpenGL texture with a CUDA cuArray
+        // Then, we just have to copy our GPU Buffer to the CudaArray (DeviceToDevice copy) and the texture will contain the GPU buffer content.
+        // That's the most efficient way since we don't have to go back on the CPU to render the texture.
+        // The copies are queued on the display stream, the event tells the grab thread when the frame can be written again.
+        cudaGraphicsResource* resources[2] = {pcuImageRes, pcuDepthRes};
+        cudaArray_t ArrIm, ArrDe;
+        cudaGraphicsMapResources(2, resources, display_stream);
+        cudaGraphicsSubResourceGetMappedArray(&ArrIm, pcuImageRes, 0, 0);
+        cudaGraphicsSubResourceGetMappedArray(&ArrDe, pcuDepthRes, 0, 0);
+        cudaMemcpy2DToArrayAsync(ArrIm, 0, 0, frame.left.getPtr<sl::uchar1>(MEM::GPU), frame.left.getStepBytes(MEM::GPU), frame.left.getWidth() * sizeof (sl::uchar4), frame.left.getHeight(), cudaMemcpyDeviceToDevice, display_stream);
+        cudaMemcpy2DToArrayAsync(ArrDe, 0, 0, frame.depth.getPtr<sl::uchar1>(MEM::GPU), frame.depth.getStepBytes(MEM::GPU), frame.left.getWidth() * sizeof (sl::uchar4), frame.left.getHeight(), cudaMemcpyDeviceToDevice, display_stream);
+        cudaGraphicsUnmapResources(2, resources, display_stream);
+        cudaEventRecord(frame.presented, display_stream);
+
+        nb_presented++;
+        age_sum_ms += chrono::duration<double, milli>(chrono::steady_clock::now() - frame.grab_time).count();
 
         ////  OpenGL rendering part ////
         glDrawBuffer(GL_BACK); // Write to both BACK_LEFT & BACK_RIGHT
@@ -136,12 +234,21 @@ void draw() {
         glutSwapBuffers();
     }
 
+    updateTitle();
     glutPostRedisplay();
 }
 
 void close() {
-    gpuLeftImage.free();
-    gpuDepthImage.free();
+    // Stop the grab thread before releasing what it writes into
+    grabbing = false;
+    if (grab_thread.joinable()) grab_thread.join();
+    cudaStreamSynchronize(display_stream);
+    for (auto& frame : ring) {
+        frame.left.free();
+        frame.depth.free();
+        cudaEventDestroy(frame.presented);
+    }
+    cudaStreamDestroy(display_stream);
     zed.close();
     glDeleteShader(shaderF);
     glDeleteProgram(program);
@@ -254,6 +361,17 @@ int main(int argc, char **argv) {
     // Set the uniform variable for texImage (sampler2D) to the texture unit (GL_TEXTURE0 by default --> id = 0)
     glUniform1i(glGetUniformLocation(program, "texImage"), 0);
 
+    // Allocate the ring of GPU frames and start the grab thread
+    for (auto& frame : ring) {
+        frame.left.alloc(res_, MAT_TYPE::U8_C4, MEM::GPU);
+        frame.depth.alloc(res_, MAT_TYPE::U8_C4, MEM::GPU);
+        cudaEventCreateWithFlags(&frame.presented, cudaEventDisableTiming);
+    }
+    cudaStreamCreateWithFlags(&display_stream, cudaStreamNonBlocking);
+    title_time = chrono::steady_clock::now();
+    grabbing = true;
+    grab_thread = thread(grabLoop);
+
     // Start the draw loop and closing event function
     glutDisplayFunc(draw);
     glutCloseFunc(close);
@@ -6,6 +6,9 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "Shader.hpp"
+#include "OffscreenRenderer.hpp"
+
 #include <mutex>
 
 #ifndef M_PI
@@ -28,30 +31,6 @@ struct UserAction {
     }
 };
 
-class Shader {
-public:
-    Shader() {}
-    Shader(GLchar* vs, GLchar* fs);
-    ~Shader();
-
-    GLuint getProgramId();
-
-    static const GLint ATTRIB_VERTICES_POS = 0;
-    static const GLint ATTRIB_VERTICES_DIST = 1;
-
-private:
-    bool compile(GLuint &shaderId, GLenum type, GLchar* src);
-    GLuint verterxId_;
-    GLuint fragmentId_;
-    GLuint programId_;
-};
-
-struct ShaderData {
-    Shader it;
-    GLuint MVP_Mat;
-    GLuint shColorLoc;
-};
-
 class MeshObject {
     GLuint vaoID_;
     GLuint vboID_[3];
@@ -71,6 +50,7 @@ public:
     void alloc();
     sl::PLANE_TYPE type;
     ShaderData shader;
+    GLuint shColorLoc;
 };
 
 class ImageHandler {
@@ -126,6 +106,7 @@ private:
     std::mutex mtx;
 
     bool available;    
+    bool newFrame_ = false; // offscreen: an image was pushed since the last rendering
     sl::Transform pose;
     sl::POSITIONAL_TRACKING_STATE tracking_state;
     UserAction user_action;
@@ -139,6 +120,9 @@ private:
     sl::Transform camera_projection;
     ImageHandler image_handler;
     MeshObject mesh_object; // Opengl mesh container
+
+    // Used in place of the window when ZED_VIEWER_OFFSCREEN is set
+    OffscreenRenderer offscreen_;
 };
 
 #endif
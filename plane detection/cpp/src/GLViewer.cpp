@@ -4,6 +4,9 @@
 
 using namespace std;
 
+// The distance to the plane edges is passed in place of the color of the shared Shader
+static const GLint ATTRIB_VERTICES_DIST = Shader::ATTRIB_COLOR_POS;
+
 void print(std::string msg_prefix, sl::ERROR_CODE err_code, std::string msg_suffix) {
     cout <<"[Sample]";
     if (err_code != sl::ERROR_CODE::SUCCESS)
@@ -88,7 +91,7 @@ void MeshObject::alloc(){
     glGenBuffers(3, vboID_);
     shader.it = Shader(MESH_VERTEX_SHADER, MESH_FRAGMENT_SHADER);
     shader.MVP_Mat = glGetUniformLocation(shader.it.getProgramId(), "u_mvpMatrix");
-    shader.shColorLoc = glGetUniformLocation(shader.it.getProgramId(), "u_color");
+    shColorLoc = glGetUniformLocation(shader.it.getProgramId(), "u_color");
 }
 
 void MeshObject::updateMesh(std::vector<sl::float3> &vertices, std::vector<sl::uint3> &triangles, std::vector<int> &border) {
@@ -124,8 +127,8 @@ void MeshObject::pushToGPU() {
 
         glBindBuffer(GL_ARRAY_BUFFER, vboID_[1]);
         glBufferData(GL_ARRAY_BUFFER, edge_dist.size() * sizeof(float), &edge_dist[0], GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(Shader::ATTRIB_VERTICES_DIST, 1, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(Shader::ATTRIB_VERTICES_DIST);
+        glVertexAttribPointer(ATTRIB_VERTICES_DIST, 1, GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(ATTRIB_VERTICES_DIST);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboID_[2]);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, tri.size() * sizeof(sl::uint3), &tri[0], GL_DYNAMIC_DRAW);
@@ -172,44 +175,57 @@ bool cudaSafeCall(cudaError_t err) {
 void GLViewer::exit() {
     if(available) {
         image_handler.close();
+        offscreen_.close();
     }
     available = false;
 }
 
 bool GLViewer::isAvailable() {
-    if(available)
-        glutMainLoopEvent();
+    if (available) {
+        if (offscreen_.isInitialized()) {
+            // No window events, one frame per new image
+            if (newFrame_)
+                render();
+        } else
+            glutMainLoopEvent();
+    }
     return available;
 }
 
 void CloseFunc(void) { if(currentInstance_) currentInstance_->exit(); }
 
 bool GLViewer::init(int argc, char **argv, sl::CameraParameters &camLeft, bool has_imu) {
+    if (OffscreenRenderer::isRequested()) {
+        // Headless, the image at its own resolution
+        if (!offscreen_.init(camLeft.image_size.width, camLeft.image_size.height, false))
+            return true;
+        reshapeCallback(offscreen_.getWidth(), offscreen_.getHeight());
+    } else {
+        glutInit(&argc, argv);
+        int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
+        int wnd_h = glutGet(GLUT_SCREEN_HEIGHT);
+        int width = wnd_w * 0.9;
+        int height = wnd_h * 0.9;
+        if (width > camLeft.image_size.width && height > camLeft.image_size.height) {
+            width = camLeft.image_size.width;
+            height = camLeft.image_size.height;
+        }
 
-    glutInit(&argc, argv);
-    int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
-    int wnd_h = glutGet(GLUT_SCREEN_HEIGHT);
-    int width = wnd_w * 0.9;
-    int height = wnd_h * 0.9;
-    if (width > camLeft.image_size.width && height > camLeft.image_size.height) {
-        width = camLeft.image_size.width;
-        height = camLeft.image_size.height;
-    }
-    
-    glutInitWindowSize(width, height);
-    glutInitWindowPosition(wnd_w * 0.05, wnd_h * 0.05);
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
-    glutCreateWindow("ZED Plane Detection");
-    
-    reshapeCallback(width, height);
+        glutInitWindowSize(width, height);
+        glutInitWindowPosition(wnd_w * 0.05, wnd_h * 0.05);
+        glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
+        glutCreateWindow("ZED Plane Detection");
 
-    GLenum err = glewInit();
-    if (GLEW_OK != err){
-        std::cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << "\n";
-        return true;
-    }
+        reshapeCallback(width, height);
+
+        GLenum err = glewInit();
+        if (GLEW_OK != err){
+            std::cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << "\n";
+            return true;
+        }
 
-    glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+        glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+    }
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -229,11 +245,13 @@ bool GLViewer::init(int argc, char **argv, sl::CameraParameters &camLeft, bool h
     mesh_object.alloc();
 
     // Set glut callback before start
-    glutDisplayFunc(GLViewer::drawCallback);
-    glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
-    glutMouseFunc(GLViewer::mouseButtonCallback);
-    glutReshapeFunc(GLViewer::reshapeCallback);
-    glutCloseFunc(CloseFunc);
+    if (!offscreen_.isInitialized()) {
+        glutDisplayFunc(GLViewer::drawCallback);
+        glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
+        glutMouseFunc(GLViewer::mouseButtonCallback);
+        glutReshapeFunc(GLViewer::reshapeCallback);
+        glutCloseFunc(CloseFunc);
+    }
 
     use_imu = has_imu;
     user_action.hit_coord = sl::float2(.5f, .5f);
@@ -321,11 +339,15 @@ UserAction GLViewer::updateImageAndState(sl::Mat &im, sl::Transform &pose_, sl::
             tracking_state = track_state;
         }
         new_data = true;
+        newFrame_ = true;
         mtx.unlock();
     }
 
     auto cpy = user_action;
     user_action.clear();
+    // No space bar offscreen, the floor plane is searched for on its own
+    if (offscreen_.isInitialized())
+        cpy.press_space = true;
     return cpy;
 }
 
@@ -341,14 +363,23 @@ void GLViewer::updateMesh(sl::Mesh &mesh, sl::PLANE_TYPE type) {
 void GLViewer::render() {
     if(available) {
         mtx.lock();
+        if (offscreen_.isInitialized())
+            offscreen_.beginFrame();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0, 0, 0, 1.f);
         update();
         draw();
-        printText();
+        // The text is drawn with the glut fonts, not available offscreen
+        if (!offscreen_.isInitialized())
+            printText();
+        newFrame_ = false;
         mtx.unlock();
-        glutSwapBuffers();
-        glutPostRedisplay();
+        if (offscreen_.isInitialized())
+            offscreen_.endFrame();
+        else {
+            glutSwapBuffers();
+            glutPostRedisplay();
+        }
     }
 }
 
@@ -388,12 +419,12 @@ void GLViewer::draw() {
 
             sl::float3 clr_plane = getPlaneColor(mesh_object.type);
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            glUniform3fv(mesh_object.shader.shColorLoc, 1, clr_plane.v);
+            glUniform3fv(mesh_object.shColorLoc, 1, clr_plane.v);
             mesh_object.draw();
 
             glLineWidth(0.5);
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            glUniform3fv(mesh_object.shader.shColorLoc, 1, clr_plane.v);
+            glUniform3fv(mesh_object.shColorLoc, 1, clr_plane.v);
             mesh_object.draw();
             glUseProgram(0);
         }
@@ -453,81 +484,6 @@ void GLViewer::printText() {
     }
 }
 
-Shader::Shader(GLchar* vs, GLchar* fs) {
-    if(!compile(verterxId_, GL_VERTEX_SHADER, vs)) {
-        std::cout << "ERROR: while compiling vertex shader" << std::endl;
-    }
-    if(!compile(fragmentId_, GL_FRAGMENT_SHADER, fs)) {
-        std::cout << "ERROR: while compiling fragment shader" << std::endl;
-    }
-
-    programId_ = glCreateProgram();
-
-    glAttachShader(programId_, verterxId_);
-    glAttachShader(programId_, fragmentId_);
-
-    glBindAttribLocation(programId_, ATTRIB_VERTICES_POS, "in_vertex");
-
-    glLinkProgram(programId_);
-
-    GLint errorlk(0);
-    glGetProgramiv(programId_, GL_LINK_STATUS, &errorlk);
-    if(errorlk != GL_TRUE) {
-        std::cout << "ERROR: while linking Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetProgramiv(programId_, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(programId_, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteProgram(programId_);
-    }
-}
-
-Shader::~Shader() {
-    if(verterxId_ != 0)
-        glDeleteShader(verterxId_);
-    if(fragmentId_ != 0)
-        glDeleteShader(fragmentId_);
-    if(programId_ != 0)
-        glDeleteShader(programId_);
-}
-
-GLuint Shader::getProgramId() {
-    return programId_;
-}
-
-bool Shader::compile(GLuint &shaderId, GLenum type, GLchar* src) {
-    shaderId = glCreateShader(type);
-    if(shaderId == 0) {
-        std::cout << "ERROR: shader type (" << type << ") does not exist" << std::endl;
-        return false;
-    }
-    glShaderSource(shaderId, 1, (const char**) &src, 0);
-    glCompileShader(shaderId);
-
-    GLint errorCp(0);
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &errorCp);
-    if(errorCp != GL_TRUE) {
-        std::cout << "ERROR: while compiling Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(shaderId, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteShader(shaderId);
-        return false;
-    }
-    return true;
-}
-
 ImageHandler::ImageHandler() {}
 
 ImageHandler::~ImageHandler() {
@@ -84,7 +84,8 @@ int main(int argc, char** argv) {
     runtime_parameters.measure3D_reference_frame = REFERENCE_FRAME::WORLD;
     
     while(viewer.isAvailable()) {
-        if(zed.grab(runtime_parameters) == ERROR_CODE::SUCCESS) {
+        ERROR_CODE grab_state = zed.grab(runtime_parameters);
+        if(grab_state == ERROR_CODE::SUCCESS) {
             // Retrieve image in GPU memory
             zed.retrieveImage(image, VIEW::LEFT, MEM::GPU);
             // Update pose data (used for projection of the mesh over the current image)
@@ -114,6 +115,9 @@ int main(int argc, char** argv) {
             }
 
             user_action = viewer.updateImageAndState(image, pose.pose_data, tracking_state);
+        } else if (grab_state == ERROR_CODE::END_OF_SVOFILE_REACHED && OffscreenRenderer::isRequested()) {
+            // Headless rendering of an SVO: stop at its end
+            viewer.exit();
         }
     }
 
@@ -13,6 +13,11 @@
 #include "ZEDModel.hpp"    /* OpenGL Utility Toolkit header */
 #include <sl/Camera.hpp>
 
+#include "CameraGL.hpp"
+#include "Shader.hpp"
+#include "Simple3DObject.hpp"
+#include "OffscreenRenderer.hpp"
+
 #ifndef M_PI
 #define M_PI 3.1416f
 #endif
@@ -31,124 +36,6 @@ using namespace std;
 void print(std::string msg_prefix, sl::ERROR_CODE err_code = sl::ERROR_CODE::SUCCESS, std::string msg_suffix = "") ;
 
 /////////////////
-class CameraGL {
-public:
-
-    CameraGL();
-    ~CameraGL();
-
-    void update();
-    void setProjection(float im_ratio);
-    const sl::Transform& getViewProjectionMatrix() const;
-
-    void setDirection(const sl::Translation& direction, const sl::Translation &vertical);
-    void translate(const sl::Translation& t);
-    void setPosition(const sl::Translation& p);
-    void rotate(const sl::Rotation& m);
-    void setRotation(const sl::Rotation& m);
-
-    const sl::Translation& getForward() const;
-    const sl::Translation& getRight() const;
-    const sl::Translation& getUp() const;
-    const sl::Translation& getVertical() const;
-
-private:
-    static const sl::Translation ORIGINAL_FORWARD;
-    static const sl::Translation ORIGINAL_UP;
-    static const sl::Translation ORIGINAL_RIGHT;
-
-    sl::Transform projection_;
-    void updateVectors();
-
-    sl::Translation position_;
-    sl::Translation forward_;
-    sl::Translation up_;
-    sl::Translation right_;
-    sl::Translation vertical_;
-    sl::Orientation rotation_;
-    sl::Transform vpMatrix_;
-
-    const float znear;
-    const float zfar;
-    const float horizontalFOV;
-};
-
-
-class Shader {
-public:
-
-    Shader() {}
-    Shader(GLchar* vs, GLchar* fs);
-    ~Shader();
-    GLuint getProgramId();
-
-    static const GLint ATTRIB_VERTICES_POS = 0;
-    static const GLint ATTRIB_COLOR_POS = 1;
-private:
-    bool compile(GLuint &shaderId, GLenum type, GLchar* src);
-    GLuint verterxId_;
-    GLuint fragmentId_;
-    GLuint programId_;
-};
-
-class Simple3DObject {
-public:
-
-    Simple3DObject();
-    Simple3DObject(sl::Translation position, bool isStatic);
-    ~Simple3DObject();
-
-    void addPoint(float x, float y, float z, float r, float g, float b);
-    void addLine(sl::float3 p1, sl::float3 p2, sl::float3 clr);
-    void addPoint(sl::float3 position, sl::float3 color);
-    void pushToGPU();
-    void clear();
-
-    void setDrawingType(GLenum type);
-
-    void draw();
-
-    void translate(const sl::Translation& t);
-    void setPosition(const sl::Translation& p);
-
-    void setRT(const sl::Transform& mRT);
-
-    void rotate(const sl::Orientation& rot);
-    void rotate(const sl::Rotation& m);
-    void setRotation(const sl::Orientation& rot);
-    void setRotation(const sl::Rotation& m);
-
-    const sl::Translation& getPosition() const;
-
-    sl::Transform getModelMatrix() const;
-private:
-    std::vector<float> vertices_;
-    std::vector<float> colors_;
-    std::vector<unsigned int> indices_;
-
-    bool isStatic_;
-
-    GLenum drawingType_;
-
-    GLuint vaoID_;
-    /*
-    Vertex buffer IDs:
-    - [0]: Vertices coordinates;
-    - [1]: RGB color values;
-    - [2]: Indices;
-    */
-    GLuint vboID_[3];
-
-    sl::Translation position_;
-    sl::Orientation rotation_;
-
-};
-
-struct ShaderData {
-    Shader it;
-    GLuint MVP_Mat;
-};
-
 // This class manages input events, window and Opengl rendering pipeline
 class GLViewer {
 public:
@@ -181,6 +68,7 @@ private:
     static void idle();
 
     bool available;
+    bool newFrame_ = false; // offscreen: a pose was pushed since the last rendering
 
     enum MOUSE_BUTTON {
         LEFT = 0,
@@ -221,6 +109,9 @@ private:
     CameraGL camera_;
     ShaderData shaderLine;
     ShaderData mainShader;
+
+    // Used in place of the window when ZED_VIEWER_OFFSCREEN is set
+    OffscreenRenderer offscreen_;
 };
 
 #endif /* __GL_VIEWER_HDR__ */
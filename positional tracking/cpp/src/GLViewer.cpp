@@ -52,12 +52,19 @@ GLViewer::GLViewer() : available(false) {
 GLViewer::~GLViewer() {}
 
 void GLViewer::exit() {
+    offscreen_.close();
     available = false;    
 }
 
 bool GLViewer::isAvailable() {
-    if(available)
-        glutMainLoopEvent();
+    if (available) {
+        if (offscreen_.isInitialized()) {
+            // No window events, one frame per new pose
+            if (newFrame_)
+                render();
+        } else
+            glutMainLoopEvent();
+    }
     return available;
 }
 
@@ -85,21 +92,27 @@ void addVert(Simple3DObject &obj, float i_f, float limit, sl::float3 &clr) {
 }
 
 void GLViewer::init(int argc, char **argv, sl::MODEL camera_model) {
-    glutInit(&argc, argv);
-
-    int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
-    int wnd_h = glutGet(GLUT_SCREEN_HEIGHT) *0.9;
-    glutInitWindowSize(wnd_w*0.9, wnd_h*0.9);
-    glutInitWindowPosition(wnd_w*0.05, wnd_h*0.05);
-
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
-    glutCreateWindow("ZED Positional Tracking");
-
-    GLenum err = glewInit();
-    if (GLEW_OK != err)
-        print("ERROR: glewInit failed: " + std::string((char*)glewGetErrorString(err)));
-
-    glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+    if (OffscreenRenderer::isRequested()) {
+        // Headless, the view does not depend on the camera resolution
+        if (!offscreen_.init(1280, 720, false))
+            return;
+    } else {
+        glutInit(&argc, argv);
+
+        int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
+        int wnd_h = glutGet(GLUT_SCREEN_HEIGHT) *0.9;
+        glutInitWindowSize(wnd_w*0.9, wnd_h*0.9);
+        glutInitWindowPosition(wnd_w*0.05, wnd_h*0.05);
+
+        glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
+        glutCreateWindow("ZED Positional Tracking");
+
+        GLenum err = glewInit();
+        if (GLEW_OK != err)
+            print("ERROR: glewInit failed: " + std::string((char*)glewGetErrorString(err)));
+
+        glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+    }
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -113,13 +126,17 @@ void GLViewer::init(int argc, char **argv, sl::MODEL camera_model) {
     shaderLine.it = Shader(VERTEX_SHADER, FRAGMENT_SHADER);
     shaderLine.MVP_Mat = glGetUniformLocation(shaderLine.it.getProgramId(), "u_mvpMatrix");
 
-    // Create the camera
+    // Create the camera, 70 degrees horizontal field of view between 1 cm and 100 m
+    camera_.setProjection(70.f, 70.f, 0.01f, 100.f);
     camera_.setPosition(sl::Translation(0.3, 3.3, -3.3));
     camera_.setDirection(sl::Translation(0, 0, -4), sl::Translation(0, 1, 0));
     sl::float3 euler(-50, 180, 0);
     sl::Rotation cam_rot;
     cam_rot.setEulerAngles(euler, 0);
     camera_.setRotation(sl::Rotation(cam_rot));
+    // No reshape event offscreen, the projection follows the framebuffer size
+    if (offscreen_.isInitialized())
+        reshapeCallback(offscreen_.getWidth(), offscreen_.getHeight());
     
     floor_grid = Simple3DObject(sl::Translation(0, 0, 0), true);
     floor_grid.setDrawingType(GL_LINES);
@@ -166,26 +183,37 @@ void GLViewer::init(int argc, char **argv, sl::MODEL camera_model) {
     updateZEDposition = false;
 
     // Map glut function on this class methods
-    glutDisplayFunc(GLViewer::drawCallback);
-    glutMouseFunc(GLViewer::mouseButtonCallback);
-    glutMotionFunc(GLViewer::mouseMotionCallback);
-    glutReshapeFunc(GLViewer::reshapeCallback);
-    glutKeyboardFunc(GLViewer::keyPressedCallback);
-    glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
-    glutCloseFunc(CloseFunc);
+    if (!offscreen_.isInitialized()) {
+        glutDisplayFunc(GLViewer::drawCallback);
+        glutMouseFunc(GLViewer::mouseButtonCallback);
+        glutMotionFunc(GLViewer::mouseMotionCallback);
+        glutReshapeFunc(GLViewer::reshapeCallback);
+        glutKeyboardFunc(GLViewer::keyPressedCallback);
+        glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
+        glutCloseFunc(CloseFunc);
+    }
     
     available = true;
 }
 
 void GLViewer::render() {
     if (available) {
+        if (offscreen_.isInitialized())
+            offscreen_.beginFrame();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(bckgrnd_clr.r, bckgrnd_clr.g, bckgrnd_clr.b, 1.f);
         update();
         draw();
-        printText();
-        glutSwapBuffers();
-        glutPostRedisplay();
+        // The text is drawn with the glut fonts, not available offscreen
+        if (!offscreen_.isInitialized())
+            printText();
+        newFrame_ = false;
+        if (offscreen_.isInitialized())
+            offscreen_.endFrame();
+        else {
+            glutSwapBuffers();
+            glutPostRedisplay();
+        }
     }
 }
 
@@ -274,6 +302,7 @@ void GLViewer::updateData(sl::Transform zed_rt, std::string str_t, std::string s
     txtT = str_t;
     txtR = str_r;
     trackState = state;
+    newFrame_ = true;
     mtx.unlock();
 }
 
@@ -362,7 +391,8 @@ void GLViewer::mouseMotionCallback(int x, int y) {
 
 void GLViewer::reshapeCallback(int width, int height) {
     glViewport(0, 0, width, height);
-    currentInstance_->camera_.setProjection((float) height / (float) width);
+    CameraGL& camera = currentInstance_->camera_;
+    camera.setProjection(camera.getHorizontalFOV(), camera.getHorizontalFOV() * (float) height / (float) width, camera.getZNear(), camera.getZFar());
 }
 
 void GLViewer::keyPressedCallback(unsigned char c, int x, int y) {
@@ -378,309 +408,4 @@ void GLViewer::idle() {
     glutPostRedisplay();
 }
 
-Simple3DObject::Simple3DObject(): isStatic_(false) {
-    vaoID_ = 0;
-    drawingType_ = GL_TRIANGLES;
-    position_ = sl::float3(0, 0, 0);
-    rotation_.setIdentity();
-}
 
-Simple3DObject::Simple3DObject(Translation position, bool isStatic): isStatic_(isStatic) {
-    vaoID_ = 0;
-    drawingType_ = GL_TRIANGLES;
-    position_ = position;
-    rotation_.setIdentity();
-}
-
-Simple3DObject::~Simple3DObject() {
-    if (vaoID_ != 0) {
-        glDeleteBuffers(3, vboID_);
-        glDeleteVertexArrays(1, &vaoID_);
-    }
-}
-
-void Simple3DObject::addPoint(sl::float3 position, sl::float3 color) {
-    addPoint(position.x, position.y, position.z, color.r, color.g, color.b);
-}
-
-void Simple3DObject::addPoint(float x, float y, float z, float r, float g, float b) {
-    vertices_.push_back(x);
-    vertices_.push_back(y);
-    vertices_.push_back(z);
-    colors_.push_back(r);
-    colors_.push_back(g);
-    colors_.push_back(b);
-    indices_.push_back((int) indices_.size());
-}
-
-void Simple3DObject::addLine(sl::float3 p1, sl::float3 p2, sl::float3 clr) {
-    vertices_.push_back(p1.x);
-    vertices_.push_back(p1.y);
-    vertices_.push_back(p1.z);
-
-    vertices_.push_back(p2.x);
-    vertices_.push_back(p2.y);
-    vertices_.push_back(p2.z);
-
-    colors_.push_back(clr.r);
-    colors_.push_back(clr.g);
-    colors_.push_back(clr.b);
-
-    colors_.push_back(clr.r);
-    colors_.push_back(clr.g);
-    colors_.push_back(clr.b);
-
-    indices_.push_back((int) indices_.size());
-    indices_.push_back((int) indices_.size());
-}
-
-void Simple3DObject::pushToGPU() {
-    if (!isStatic_ || vaoID_ == 0) {
-        if (vaoID_ == 0) {
-            glGenVertexArrays(1, &vaoID_);
-            glGenBuffers(3, vboID_);
-        }
-        glBindVertexArray(vaoID_);
-		if (vertices_.size()) {
-			glBindBuffer(GL_ARRAY_BUFFER, vboID_[0]);
-			glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(float), &vertices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(Shader::ATTRIB_VERTICES_POS, 3, GL_FLOAT, GL_FALSE, 0, 0);
-			glEnableVertexAttribArray(Shader::ATTRIB_VERTICES_POS);
-		}
-
-		if (colors_.size()) {
-			glBindBuffer(GL_ARRAY_BUFFER, vboID_[1]);
-			glBufferData(GL_ARRAY_BUFFER, colors_.size() * sizeof(float), &colors_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-			glVertexAttribPointer(Shader::ATTRIB_COLOR_POS, 3, GL_FLOAT, GL_FALSE, 0, 0);
-			glEnableVertexAttribArray(Shader::ATTRIB_COLOR_POS);
-		}
-
-		if (indices_.size()) {
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vboID_[2]);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned int), &indices_[0], isStatic_ ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
-		}
-
-        glBindVertexArray(0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-    }
-}
-
-void Simple3DObject::clear() {
-    vertices_.clear();
-    colors_.clear();
-    indices_.clear();
-}
-
-void Simple3DObject::setDrawingType(GLenum type) {
-    drawingType_ = type;
-}
-
-void Simple3DObject::draw() {
-    if(indices_.size() && vaoID_) {
-        glBindVertexArray(vaoID_);
-        glDrawElements(drawingType_, (GLsizei) indices_.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    }
-}
-
-void Simple3DObject::translate(const Translation& t) {
-    position_ = position_ + t;
-}
-
-void Simple3DObject::setPosition(const Translation& p) {
-    position_ = p;
-}
-
-void Simple3DObject::setRT(const Transform& mRT) {
-    position_ = mRT.getTranslation();
-    rotation_ = mRT.getOrientation();
-}
-
-void Simple3DObject::rotate(const Orientation& rot) {
-    rotation_ = rot * rotation_;
-}
-
-void Simple3DObject::rotate(const Rotation& m) {
-    this->rotate(sl::Orientation(m));
-}
-
-void Simple3DObject::setRotation(const Orientation& rot) {
-    rotation_ = rot;
-}
-
-void Simple3DObject::setRotation(const Rotation& m) {
-    this->setRotation(sl::Orientation(m));
-}
-
-const Translation& Simple3DObject::getPosition() const {
-    return position_;
-}
-
-Transform Simple3DObject::getModelMatrix() const {
-    Transform tmp = Transform::identity();
-    tmp.setOrientation(rotation_);
-    tmp.setTranslation(position_);
-    return tmp;
-}
-
-Shader::Shader(GLchar* vs, GLchar* fs) {
-    if (!compile(verterxId_, GL_VERTEX_SHADER, vs)) {
-        std::cout << "ERROR: while compiling vertex shader" << std::endl;
-    }
-    if (!compile(fragmentId_, GL_FRAGMENT_SHADER, fs)) {
-        std::cout << "ERROR: while compiling fragment shader" << std::endl;
-    }
-
-    programId_ = glCreateProgram();
-
-    glAttachShader(programId_, verterxId_);
-    glAttachShader(programId_, fragmentId_);
-
-    glBindAttribLocation(programId_, ATTRIB_VERTICES_POS, "in_vertex");
-    glBindAttribLocation(programId_, ATTRIB_COLOR_POS, "in_texCoord");
-
-    glLinkProgram(programId_);
-
-    GLint errorlk(0);
-    glGetProgramiv(programId_, GL_LINK_STATUS, &errorlk);
-    if (errorlk != GL_TRUE) {
-        std::cout << "ERROR: while linking Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetProgramiv(programId_, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(programId_, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteProgram(programId_);
-    }
-}
-
-Shader::~Shader() {
-    if (verterxId_ != 0)
-        glDeleteShader(verterxId_);
-    if (fragmentId_ != 0)
-        glDeleteShader(fragmentId_);
-    if (programId_ != 0)
-        glDeleteShader(programId_);
-}
-
-GLuint Shader::getProgramId() {
-    return programId_;
-}
-
-bool Shader::compile(GLuint &shaderId, GLenum type, GLchar* src) {
-    shaderId = glCreateShader(type);
-    if (shaderId == 0) {
-        std::cout << "ERROR: shader type (" << type << ") does not exist" << std::endl;
-        return false;
-    }
-    glShaderSource(shaderId, 1, (const char**) &src, 0);
-    glCompileShader(shaderId);
-
-    GLint errorCp(0);
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &errorCp);
-    if (errorCp != GL_TRUE) {
-        std::cout << "ERROR: while compiling Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(shaderId, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteShader(shaderId);
-        return false;
-    }
-    return true;
-}
-
-const sl::Translation CameraGL::ORIGINAL_FORWARD = sl::Translation(0, 0, 1);
-const sl::Translation CameraGL::ORIGINAL_UP = sl::Translation(0, 1, 0);
-const sl::Translation CameraGL::ORIGINAL_RIGHT = sl::Translation(1, 0, 0);
-
-CameraGL::CameraGL(): znear(0.01f), zfar(100.f), horizontalFOV(70.f) {
-    setProjection(1.78f);
-}
-
-CameraGL::~CameraGL() {}
-
-void CameraGL::update() {
-    if (sl::Translation::dot(vertical_, up_) < 0)
-        vertical_ = vertical_ * -1.f;
-    sl::Transform transformation(rotation_, position_);
-    vpMatrix_ = projection_ * sl::Transform::inverse(transformation);
-}
-
-void CameraGL::setProjection(float im_ratio) {
-
-    float fov_x = horizontalFOV * M_PI / 180.f;
-    float fov_y = horizontalFOV * im_ratio * M_PI / 180.f;
-
-    projection_.setIdentity();
-    projection_(0, 0) = 1.f / tanf(fov_x * .5f);
-    projection_(1, 1) = 1.f / tanf(fov_y * .5f);
-    projection_(2, 2) = -(zfar + znear) / (zfar - znear);
-    projection_(3, 2) = -1.f;
-    projection_(2, 3) = -(2.f * zfar * znear) / (zfar - znear);
-    projection_(3, 3) = 0.f;
-}
-
-const sl::Transform& CameraGL::getViewProjectionMatrix() const {
-    return vpMatrix_;
-}
-
-void CameraGL::setDirection(const sl::Translation& direction, const sl::Translation& vertical) {
-    sl::Translation dirNormalized = direction;
-    dirNormalized.normalize();
-    this->rotation_ = sl::Orientation(ORIGINAL_FORWARD, dirNormalized * -1.f);
-    updateVectors();
-    this->vertical_ = vertical;
-    if (sl::Translation::dot(vertical_, up_) < 0.f)
-        rotate(sl::Rotation(M_PI, ORIGINAL_FORWARD));
-}
-
-void CameraGL::translate(const sl::Translation& t) {
-    position_ = position_ + t;
-}
-
-void CameraGL::setPosition(const sl::Translation& p) {
-    position_ = p;
-}
-
-void CameraGL::rotate(const sl::Rotation& m) {
-    rotation_ = sl::Orientation(m) * rotation_;
-    updateVectors();
-}
-
-void CameraGL::setRotation(const sl::Rotation& m) {
-    rotation_ = sl::Orientation(m);
-    updateVectors();
-}
-
-const sl::Translation& CameraGL::getForward() const {
-    return forward_;
-}
-
-const sl::Translation& CameraGL::getRight() const {
-    return right_;
-}
-
-const sl::Translation& CameraGL::getUp() const {
-    return up_;
-}
-
-const sl::Translation& CameraGL::getVertical() const {
-    return vertical_;
-}
-
-void CameraGL::updateVectors() {
-    forward_ = ORIGINAL_FORWARD * rotation_;
-    up_ = ORIGINAL_UP * rotation_;
-    right_ = sl::Translation(ORIGINAL_RIGHT * -1.f) * rotation_;
-}
@@ -86,7 +86,8 @@ int main(int argc, char **argv) {
 #endif
     
     while (viewer.isAvailable()) {
-        if (zed.grab() == ERROR_CODE::SUCCESS) {
+        returned_state = zed.grab();
+        if (returned_state == ERROR_CODE::SUCCESS) {
             // Get the position of the camera in a fixed reference frame (the World Frame)
             tracking_state = zed.getPosition(camera_path, REFERENCE_FRAME::WORLD);
 
@@ -106,6 +107,9 @@ int main(int argc, char **argv) {
             viewer.updateData(camera_path.pose_data, string(text_translation), string(text_rotation), tracking_state);
 #endif
 
+        } else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && OffscreenRenderer::isRequested()) {
+            // Headless rendering of an SVO: stop at its end
+            viewer.exit();
         } else
             sleep_ms(1);
     }
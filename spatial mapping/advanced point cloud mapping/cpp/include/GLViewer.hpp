@@ -10,6 +10,11 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "CameraGL.hpp"
+#include "Shader.hpp"
+#include "Simple3DObject.hpp"
+#include "OffscreenRenderer.hpp"
+
 #include <list>
 
 #ifndef M_PI
@@ -24,145 +29,6 @@ const float KEY_T_SENSITIVITY = 0.1f;
 
 /////////////////
 
-class CameraGL {
-public:
-
-    CameraGL() {}
-    enum DIRECTION {
-        UP, DOWN, LEFT, RIGHT, FORWARD, BACK
-    };
-    CameraGL(sl::Translation position, sl::Translation direction, sl::Translation vertical = sl::Translation(0, 1, 0)); // vertical = Eigen::Vector3f(0, 1, 0)
-    ~CameraGL();
-
-    void update();
-    void setProjection(float horizontalFOV, float verticalFOV, float znear, float zfar);
-    const sl::Transform& getViewProjectionMatrix() const;
-
-    float getHorizontalFOV() const;
-    float getVerticalFOV() const;
-
-    // Set an offset between the eye of the camera and its position
-    // Note: Useful to use the camera as a trackball camera with z>0 and x = 0, y = 0
-    // Note: coordinates are in local space
-    void setOffsetFromPosition(const sl::Translation& offset);
-    const sl::Translation& getOffsetFromPosition() const;
-
-    void setDirection(const sl::Translation& direction, const sl::Translation &vertical);
-    void translate(const sl::Translation& t);
-    void setPosition(const sl::Translation& p);
-    void rotate(const sl::Orientation& rot);
-    void rotate(const sl::Rotation& m);
-    void setRotation(const sl::Orientation& rot);
-    void setRotation(const sl::Rotation& m);
-
-    const sl::Translation& getPosition() const;
-    const sl::Translation& getForward() const;
-    const sl::Translation& getRight() const;
-    const sl::Translation& getUp() const;
-    const sl::Translation& getVertical() const;
-    float getZNear() const;
-    float getZFar() const;
-
-    static const sl::Translation ORIGINAL_FORWARD;
-    static const sl::Translation ORIGINAL_UP;
-    static const sl::Translation ORIGINAL_RIGHT;
-
-    sl::Transform projection_;
-private:
-    void updateVectors();
-    void updateView();
-    void updateVPMatrix();
-
-    sl::Translation offset_;
-    sl::Translation position_;
-    sl::Translation forward_;
-    sl::Translation up_;
-    sl::Translation right_;
-    sl::Translation vertical_;
-
-    sl::Orientation rotation_;
-
-    sl::Transform view_;
-    sl::Transform vpMatrix_;
-    float horizontalFieldOfView_;
-    float verticalFieldOfView_;
-    float znear_;
-    float zfar_;
-};
-
-class Shader {
-public:
-    Shader() {}
-    Shader(GLchar* vs, GLchar* fs);
-    ~Shader();
-    GLuint getProgramId();
-
-    static const GLint ATTRIB_VERTICES_POS = 0;
-    static const GLint ATTRIB_COLOR_POS = 1;
-private:
-    bool compile(GLuint &shaderId, GLenum type, GLchar* src);
-    GLuint verterxId_;
-    GLuint fragmentId_;
-    GLuint programId_;
-};
-
-struct ShaderData {
-    Shader it;
-    GLuint MVP_Mat;
-};
-
-class Simple3DObject {
-public:
-
-    Simple3DObject();
-    Simple3DObject(sl::Translation position, bool isStatic);
-    ~Simple3DObject();
-
-    void addPoint(float x, float y, float z, float r, float g, float b);
-    void addLine(sl::float3 p1, sl::float3 p2, sl::float3 clr);
-    void addPoint(sl::float3 position, sl::float3 color);
-    void pushToGPU();
-    void clear();
-
-    void setDrawingType(GLenum type);
-
-    void draw();
-
-    void translate(const sl::Translation& t);
-    void setPosition(const sl::Translation& p);
-
-    void setRT(const sl::Transform& mRT);
-
-    void rotate(const sl::Orientation& rot);
-    void rotate(const sl::Rotation& m);
-    void setRotation(const sl::Orientation& rot);
-    void setRotation(const sl::Rotation& m);
-
-    const sl::Translation& getPosition() const;
-
-    sl::Transform getModelMatrix() const;
-private:
-    std::vector<float> vertices_;
-    std::vector<float> colors_;
-    std::vector<unsigned int> indices_;
-
-    bool isStatic_;
-
-    GLenum drawingType_;
-
-    GLuint vaoID_;
-    /*
-    Vertex buffer IDs:
-    - [0]: Vertices coordinates;
-    - [1]: RGB color values;
-    - [2]: Indices;
-    */
-    GLuint vboID_[3];
-
-    sl::Translation position_;
-    sl::Orientation rotation_;
-};
-
 class SubMapObj {
     GLuint vaoID_;
     GLuint vboID_[2];
@@ -183,6 +49,9 @@ public:
     ~GLViewer();
     bool isAvailable();
 
+    // Returned by init() when the offscreen rendering was requested but could not start, the reason is already printed
+    static const GLenum OFFSCREEN_ERROR = 0xFFFF;
+
     GLenum init(int argc, char **argv, sl::CameraParameters param, sl::FusedPointCloud* ptr, sl::MODEL zed_model);   
     void updatePose(sl::Pose pose_, sl::POSITIONAL_TRACKING_STATE tracking_state);
     
@@ -218,6 +87,7 @@ private:
     static void idle();
 
     bool available;
+    bool newFrame_ = false; // offscreen: a pose was pushed since the last rendering
 
     enum MOUSE_BUTTON {
         LEFT = 0,
@@ -261,6 +131,9 @@ private:
 
     sl::FusedPointCloud* p_fpc;
     std::list<SubMapObj> sub_maps;  // Opengl mesh container
+
+    // Used in place of the window when ZED_VIEWER_OFFSCREEN is set
+    OffscreenRenderer offscreen_;
 };
 
 #endif /* __VIEWER_INCLUDE__ */
@@ -64,6 +64,10 @@ int main(int argc, char **argv) {
     // Initialize point cloud viewer
     FusedPointCloud map;
     GLenum errgl = viewer.init(argc, argv, camera_infos.camera_configuration.calibration_parameters.left_cam, &map, camera_infos.camera_model);
+    if (errgl == GLViewer::OFFSCREEN_ERROR) {
+        zed.close();
+        return EXIT_FAILURE;
+    }
     if (errgl!=GLEW_OK)
         print("Error OpenGL: "+std::string((char*)glewGetErrorString(errgl)));
 
@@ -110,7 +114,8 @@ int main(int argc, char **argv) {
     // Start the main loop
     while (viewer.isAvailable()) {
         // Grab a new image
-        if (zed.grab(runtime_parameters) == ERROR_CODE::SUCCESS) {
+        returned_state = zed.grab(runtime_parameters);
+        if (returned_state == ERROR_CODE::SUCCESS) {
             // Retrieve the left image
             zed.retrieveImage(image_zed, VIEW::LEFT, MEM::CPU, display_resolution);
             // Retrieve the camera pose data
@@ -133,8 +138,14 @@ int main(int argc, char **argv) {
                     viewer.updateChunks();
                 }
             }
-            cv::imshow("ZED View", image_zed_ocv);
-            cv::waitKey(15);
+            // No OpenCV window either when rendering headless
+            if (!OffscreenRenderer::isRequested()) {
+                cv::imshow("ZED View", image_zed_ocv);
+                cv::waitKey(15);
+            }
+        } else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED && OffscreenRenderer::isRequested()) {
+            // Headless rendering of an SVO: stop at its end
+            viewer.exit();
         }
     }
 
@@ -8,6 +8,9 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 
+#include "Shader.hpp"
+#include "OffscreenRenderer.hpp"
+
 #include <mutex>
 
 #include <list>
@@ -21,29 +24,6 @@ using namespace std;
 void print(std::string msg_prefix, sl::ERROR_CODE err_code = sl::ERROR_CODE::SUCCESS, std::string msg_suffix = "") ;
 
 /////////////////
-class Shader{
-public:
-Shader() {}
-    Shader(GLchar* vs, GLchar* fs);
-    ~Shader();
-
-    GLuint getProgramId();
-
-    static const GLint ATTRIB_VERTICES_POS = 0;
-    static const GLint ATTRIB_COLOR_POS = 1;
-private:
-    bool compile(GLuint &shaderId, GLenum type, GLchar* src);
-    GLuint verterxId_;
-    GLuint fragmentId_;
-    GLuint programId_;
-};
-
-struct ShaderData {
-    Shader it;
-    GLuint MVP_Mat;
-    GLuint shColorLoc;
-};
-
 class SubMapObj {
     GLuint vaoID_;
     GLuint vboID_[2];
@@ -125,6 +105,8 @@ private:
 
     bool available;
     bool change_state;
+    bool newFrame_ = false; // offscreen: an image was pushed since the last rendering
+    bool mappingStarted_ = false; // offscreen: the mapping was started without the space bar
 
     std::list<SubMapObj> sub_maps;  // Opengl mesh container
     sl::float3 vertices_color;      // Defines the color of the mesh
@@ -145,6 +127,10 @@ private:
     sl::FusedPointCloud* p_fpc;
     ImageHandler image_handler;
     ShaderData shader_obj;
+    GLuint shColorLoc;
+
+    // Used in place of the window when ZED_VIEWER_OFFSCREEN is set
+    OffscreenRenderer offscreen_;
 };
 
 /* Find MyDocuments directory for windows platforms.*/
@@ -181,13 +181,20 @@ bool cudaSafeCall(cudaError_t err) {
 void GLViewer::exit() {
     if(available) {
         image_handler.close();
+        offscreen_.close();
     }
     available = false;
 }
 
 bool GLViewer::isAvailable() {
-    if(available)
-        glutMainLoopEvent();
+    if (available) {
+        if (offscreen_.isInitialized()) {
+            // No window events, one frame per new image
+            if (newFrame_)
+                render();
+        } else
+            glutMainLoopEvent();
+    }
     return available;
 }
 
@@ -208,28 +215,34 @@ void GLViewer::initPtr(sl::FusedPointCloud* ptr) {
 
 template<typename T>
 bool GLViewer::init(int argc, char **argv, sl::CameraParameters camLeft, T *ptr) { 
+    if (OffscreenRenderer::isRequested()) {
+        // Headless, the image at its own resolution
+        if (!offscreen_.init(camLeft.image_size.width, camLeft.image_size.height, false))
+            return true;
+        reshapeCallback(offscreen_.getWidth(), offscreen_.getHeight());
+    } else {
+        glutInit(&argc, argv);
+        int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
+        int wnd_h = glutGet(GLUT_SCREEN_HEIGHT);
+        int width = wnd_w * 0.9;
+        int height = wnd_h * 0.9;
+        if (width > camLeft.image_size.width && height > camLeft.image_size.height) {
+            width = camLeft.image_size.width;
+            height = camLeft.image_size.height;
+        }
 
-    glutInit(&argc, argv);
-    int wnd_w = glutGet(GLUT_SCREEN_WIDTH);
-    int wnd_h = glutGet(GLUT_SCREEN_HEIGHT);
-    int width = wnd_w * 0.9;
-    int height = wnd_h * 0.9;
-    if (width > camLeft.image_size.width && height > camLeft.image_size.height) {
-        width = camLeft.image_size.width;
-        height = camLeft.image_size.height;
-    }
-
-    glutInitWindowSize(width, height);
-    glutInitWindowPosition(wnd_w * 0.05, wnd_h * 0.05);
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
-    glutCreateWindow("ZED Spatial Mapping Viewer");
-    glViewport(0, 0, width, height);
+        glutInitWindowSize(width, height);
+        glutInitWindowPosition(wnd_w * 0.05, wnd_h * 0.05);
+        glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
+        glutCreateWindow("ZED Spatial Mapping Viewer");
+        glViewport(0, 0, width, height);
 
-    GLenum err = glewInit();
-    if (GLEW_OK != err)
-        std::cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << "\n";
+        GLenum err = glewInit();
+        if (GLEW_OK != err)
+            std::cout << "ERROR: glewInit failed: " << glewGetErrorString(err) << "\n";
 
-    glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+        glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_CONTINUE_EXECUTION);
+    }
 
     glEnable(GL_LINE_SMOOTH);
     glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
@@ -246,7 +259,7 @@ bool GLViewer::init(int argc, char **argv, sl::CameraParameters camLeft, T *ptr)
     else
         shader_obj.it = Shader(FPC_VERTEX_SHADER, FRAGMENT_SHADER);
     shader_obj.MVP_Mat = glGetUniformLocation(shader_obj.it.getProgramId(), "u_mvpMatrix");
-    shader_obj.shColorLoc = glGetUniformLocation(shader_obj.it.getProgramId(), "u_color");
+    shColorLoc = glGetUniformLocation(shader_obj.it.getProgramId(), "u_color");
 
     // Create the rendering camera
     setRenderCameraProjection(camLeft, 0.5f, 20);
@@ -255,10 +268,12 @@ bool GLViewer::init(int argc, char **argv, sl::CameraParameters camLeft, T *ptr)
     glPointSize(4.f);
 
     // Set glut callback before start
-    glutDisplayFunc(GLViewer::drawCallback);
-    glutReshapeFunc(GLViewer::reshapeCallback);
-    glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
-    glutCloseFunc(CloseFunc);
+    if (!offscreen_.isInitialized()) {
+        glutDisplayFunc(GLViewer::drawCallback);
+        glutReshapeFunc(GLViewer::reshapeCallback);
+        glutKeyboardUpFunc(GLViewer::keyReleasedCallback);
+        glutCloseFunc(CloseFunc);
+    }
 
     ask_clear = false;
     available = true;
@@ -344,11 +359,17 @@ bool GLViewer::updateImageAndState(sl::Mat &im, sl::Transform &pose_, sl::POSITI
             tracking_state = track_state;
             mapping_state = mapp_state;
         }
+        newFrame_ = true;
         mtx.unlock();
     }
 
     bool cpy_state = change_state;
     change_state = false;
+    // No space bar offscreen, the mapping starts with the first image
+    if (offscreen_.isInitialized() && !mappingStarted_) {
+        mappingStarted_ = true;
+        cpy_state = true;
+    }
     return cpy_state;
 }
 
@@ -359,15 +380,24 @@ void GLViewer::clearCurrentMesh() {
 
 void GLViewer::render() {
     if(available) {
+        if (offscreen_.isInitialized())
+            offscreen_.beginFrame();
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0, 0, 0, 1.f);
         mtx.lock();
         update();
         draw();
-        printText();
+        // The text is drawn with the glut fonts, not available offscreen
+        if (!offscreen_.isInitialized())
+            printText();
+        newFrame_ = false;
         mtx.unlock();
-        glutSwapBuffers();
-        glutPostRedisplay();
+        if (offscreen_.isInitialized())
+            offscreen_.endFrame();
+        else {
+            glutSwapBuffers();
+            glutPostRedisplay();
+        }
     }
 }
 
@@ -460,7 +490,7 @@ void GLViewer::draw() {
             sl::Transform vpMatrix = camera_projection * sl::Transform::inverse(pose);
             glUseProgram(shader_obj.it.getProgramId());
             glUniformMatrix4fv(shader_obj.MVP_Mat, 1, GL_TRUE, vpMatrix.m);
-            glUniform3fv(shader_obj.shColorLoc, 1, vertices_color.v);
+            glUniform3fv(shColorLoc, 1, vertices_color.v);
 
             for (auto &it: sub_maps)
                 it.draw();
@@ -470,81 +500,6 @@ void GLViewer::draw() {
     }
 }
 
-Shader::Shader(GLchar* vs, GLchar* fs) {
-    if(!compile(verterxId_, GL_VERTEX_SHADER, vs)) {
-        std::cout << "ERROR: while compiling vertex shader" << std::endl;
-    }
-    if(!compile(fragmentId_, GL_FRAGMENT_SHADER, fs)) {
-        std::cout << "ERROR: while compiling fragment shader" << std::endl;
-    }
-
-    programId_ = glCreateProgram();
-
-    glAttachShader(programId_, verterxId_);
-    glAttachShader(programId_, fragmentId_);
-
-    glBindAttribLocation(programId_, ATTRIB_VERTICES_POS, "in_vertex");
-
-    glLinkProgram(programId_);
-
-    GLint errorlk(0);
-    glGetProgramiv(programId_, GL_LINK_STATUS, &errorlk);
-    if(errorlk != GL_TRUE) {
-        std::cout << "ERROR: while linking Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetProgramiv(programId_, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(programId_, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteProgram(programId_);
-    }
-}
-
-Shader::~Shader() {
-    if(verterxId_ != 0)
-        glDeleteShader(verterxId_);
-    if(fragmentId_ != 0)
-        glDeleteShader(fragmentId_);
-    if(programId_ != 0)
-        glDeleteShader(programId_);
-}
-
-GLuint Shader::getProgramId() {
-    return programId_;
-}
-
-bool Shader::compile(GLuint &shaderId, GLenum type, GLchar* src) {
-    shaderId = glCreateShader(type);
-    if(shaderId == 0) {
-        std::cout << "ERROR: shader type (" << type << ") does not exist" << std::endl;
-        return false;
-    }
-    glShaderSource(shaderId, 1, (const char**) &src, 0);
-    glCompileShader(shaderId);
-
-    GLint errorCp(0);
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &errorCp);
-    if(errorCp != GL_TRUE) {
-        std::cout << "ERROR: while compiling Shader :" << std::endl;
-        GLint errorSize(0);
-        glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &errorSize);
-
-        char *error = new char[errorSize + 1];
-        glGetShaderInfoLog(shaderId, errorSize, &errorSize, error);
-        error[errorSize] = '\0';
-        std::cout << error << std::endl;
-
-        delete[] error;
-        glDeleteShader(shaderId);
-        return false;
-    }
-    return true;
-}
-
 std::string getDir() {
     std::string myDir;
 #if _WIN32
@@ -90,7 +90,9 @@ int main(int argc, char** argv) {
     }
 
     while(viewer.isAvailable()) {
-        if(zed.grab() == ERROR_CODE::SUCCESS) {
+        bool change_state = false;
+        ERROR_CODE grab_state = zed.grab();
+        if(grab_state == ERROR_CODE::SUCCESS) {
             // Retrieve image in GPU memory
             zed.retrieveImage(image, VIEW::LEFT, MEM::GPU);
             // Update pose data (used for projection of the mesh over the current image)
@@ -112,63 +114,67 @@ int main(int argc, char** argv) {
                 }
             }
 
-            bool change_state = viewer.updateImageAndState(image, pose.pose_data, tracking_state, mapping_state);
+            change_state = viewer.updateImageAndState(image, pose.pose_data, tracking_state, mapping_state);
+        } else if (grab_state == ERROR_CODE::END_OF_SVOFILE_REACHED && OffscreenRenderer::isRequested()) {
+            // Headless rendering of an SVO: stop the mapping to save the map, then stop at its end
+            change_state = mapping_activated;
+            viewer.exit();
+        }
 
-            if(change_state) {
-                if(!mapping_activated) {
-                    Transform init_pose;
-                    zed.resetPositionalTracking(init_pose);
+        if(change_state) {
+            if(!mapping_activated) {
+                Transform init_pose;
+                zed.resetPositionalTracking(init_pose);
 
-                    // Configure Spatial Mapping parameters
+                // Configure Spatial Mapping parameters
 					spatial_mapping_parameters.resolution_meter = SpatialMappingParameters::get(SpatialMappingParameters::MAPPING_RESOLUTION::LOW);
-                    spatial_mapping_parameters.use_chunk_only = true;
-                    spatial_mapping_parameters.save_texture = false;
+                spatial_mapping_parameters.use_chunk_only = true;
+                spatial_mapping_parameters.save_texture = false;
 #if CREATE_MESH
 					spatial_mapping_parameters.map_type = SpatialMappingParameters::SPATIAL_MAP_TYPE::MESH;
 #else
 					spatial_mapping_parameters.map_type = SpatialMappingParameters::SPATIAL_MAP_TYPE::FUSED_POINT_CLOUD;
 #endif					
-                    // Enable spatial mapping
-                    try {
-                        zed.enableSpatialMapping(spatial_mapping_parameters);
-                        print("Spatial Mapping will output a " + string(toString(spatial_mapping_parameters.map_type).c_str()));
-                    } catch(string e) {
-                        print("Error enable Spatial Mapping "+ e);
-                    }
-
-                    // Clear previous Mesh data
-                    map.clear();
-                    viewer.clearCurrentMesh();
-
-                    // Start a timer, we retrieve the mesh every XXms.
-                    ts_last = chrono::high_resolution_clock::now();
+                // Enable spatial mapping
+                try {
+                    zed.enableSpatialMapping(spatial_mapping_parameters);
+                    print("Spatial Mapping will output a " + string(toString(spatial_mapping_parameters.map_type).c_str()));
+                } catch(string e) {
+                    print("Error enable Spatial Mapping "+ e);
+                }
 
-                    mapping_activated = true;
-                } else {
-                    // Extract the whole mesh
-                    zed.extractWholeSpatialMap(map);
+                // Clear previous Mesh data
+                map.clear();
+                viewer.clearCurrentMesh();
+
+                // Start a timer, we retrieve the mesh every XXms.
+                ts_last = chrono::high_resolution_clock::now();
+
+                mapping_activated = true;
+            } else {
+                // Extract the whole mesh
+                zed.extractWholeSpatialMap(map);
 #if CREATE_MESH
-                    MeshFilterParameters filter_params;
-                    filter_params.set(MeshFilterParameters::MESH_FILTER::MEDIUM);
-                    // Filter the extracted mesh
-                    map.filter(filter_params, true);
+                MeshFilterParameters filter_params;
+                filter_params.set(MeshFilterParameters::MESH_FILTER::MEDIUM);
+                // Filter the extracted mesh
+                map.filter(filter_params, true);
 					viewer.clearCurrentMesh();
 
-                    // If textures have been saved during spatial mapping, apply them to the mesh
-                    if(spatial_mapping_parameters.save_texture)
-                        map.applyTexture(MESH_TEXTURE_FORMAT::RGB);
+                // If textures have been saved during spatial mapping, apply them to the mesh
+                if(spatial_mapping_parameters.save_texture)
+                    map.applyTexture(MESH_TEXTURE_FORMAT::RGB);
 #endif
-                    // Save mesh as an OBJ file
-                    string saveName = getDir() + "mesh_gen.obj";
-                    bool error_save = map.save(saveName.c_str());
-                    if(error_save)
-                        print("Mesh saved under: " +saveName);
+                // Save mesh as an OBJ file
+                string saveName = getDir() + "mesh_gen.obj";
+                bool error_save = map.save(saveName.c_str());
+                if(error_save)
+                    print("Mesh saved under: " +saveName);
 					else
-                        print("Failed to save the mesh under: " +saveName);
+                    print("Failed to save the mesh under: " +saveName);
 
-                    mapping_state = SPATIAL_MAPPING_STATE::NOT_ENABLED;
-                    mapping_activated = false;
-                }
+                mapping_state = SPATIAL_MAPPING_STATE::NOT_ENABLED;
+                mapping_activated = false;
             }
         }
     }
@@ -0,0 +1,92 @@
+#ifndef __HEIGHT_MAP_HDR__
+#define __HEIGHT_MAP_HDR__
+
+#include <cstdint>
+#include <vector>
+
+#include <sl/Camera.hpp>
+
+/*
+ * Rolling 2.5D height map, built from the point clouds of a moving camera.
+ *
+ * The map is a fixed size square grid of the ground plane (X, Y of a Z up coordinate system), that follows the camera.
+ * Each cell keeps the max and min height and the number of points that fell in it. The grid is stored as a circular
+ * buffer indexed by the world cell coordinates modulo its size: moving the grid only clears the cells that enter it,
+ * the others stay in place.
+ *
+ * The binning of the points (transform by the camera pose + cell index) is vectorized, AVX2 when the CPU supports it,
+ * NEON on ARM.
+ */
+
+struct HeightMapParameters {
+    // Cell side, in the unit of the point clouds
+    float cell_size = 0.05f;
+    // Cells per side, rounded up to a power of two
+    int size = 512;
+    // Points outside of [min_height, max_height] (Z of the world frame) are ignored, ceiling for instance
+    float min_height = -2.f;
+    float max_height = 2.f;
+};
+
+class HeightMap {
+public:
+    struct Cell {
+        float max_height;
+        float min_height;
+        uint32_t hits;
+    };
+
+    HeightMap(const HeightMapParameters& parameters = HeightMapParameters());
+
+    // Centers the grid on the world position (x, y), the cells leaving the grid are dropped
+    void recenter(float x, float y);
+
+    // Adds a point cloud (XYZ or XYZRGBA, F32_C4 in CPU memory) seen from camera_to_world, the pose given by getPosition
+    // in the WORLD reference frame. The coordinate system must be Z up. Returns the number of points added to the grid.
+    size_t integrate(sl::Mat& cloud, const sl::Transform& camera_to_world);
+
+    // Empties all the cells
+    void clear();
+
+    // Cell at (col, row) of the grid, (0, 0) is the cell of lowest world X and Y. Empty cells have hits = 0.
+    Cell getCell(int col, int row) const {
+        const size_t i = storageIndex(col + origin_x_, row + origin_y_);
+        return {max_height_[i], min_height_[i], hits_[i]};
+    }
+
+    int getSize() const {
+        return size_;
+    }
+
+    float getCellSize() const {
+        return parameters_.cell_size;
+    }
+
+    // World position of the corner (lowest X and Y) of the cell (0, 0)
+    float getOriginX() const {
+        return origin_x_ * parameters_.cell_size;
+    }
+
+    float getOriginY() const {
+        return origin_y_ * parameters_.cell_size;
+    }
+
+private:
+    // world cell coordinates -> index in the storage
+    size_t storageIndex(int cx, int cy) const {
+        return (size_t(cy & mask_) << log2_size_) | size_t(cx & mask_);
+    }
+
+    void clearColumn(int cx);
+    void clearRow(int cy);
+
+    HeightMapParameters parameters_;
+    int size_, log2_size_, mask_;
+    // World cell coordinates of the cell (0, 0)
+    int origin_x_ = 0, origin_y_ = 0;
+
+    std::vector<float> max_height_, min_height_;
+    std::vector<uint32_t> hits_;
+};
+
+#endif /* __HEIGHT_MAP_HDR__ */
@@ -0,0 +1,241 @@
+#include "HeightMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CpuFeatures.hpp"
+
+// Everything needed to bin a point: pose (3x4, row major), grid window and height range
+struct Binning {
+    float pose[12];
+    float inv_cell_size;
+    float min_x, max_x, min_y, max_y; // window, in cells, [min, max)
+    float min_height, max_height;
+    int log2_size, mask;
+
+    float* max_height_grid;
+    float* min_height_grid;
+    uint32_t* hits_grid;
+};
+
+static inline void addToCell(const Binning& b, int32_t index, float height) {
+    b.max_height_grid[index] = std::max(b.max_height_grid[index], height);
+    b.min_height_grid[index] = std::min(b.min_height_grid[index], height);
+    b.hits_grid[index]++;
+}
+
+// Bins points [first, last) of a row, returns the number of points added
+static size_t binScalar(const Binning& b, const float* row, int first, int last) {
+    size_t added = 0;
+    for (int u = first; u < last; u++) {
+        const float* p = row + u * 4;
+        const float* m = b.pose;
+        const float wx = m[0] * p[0] + m[1] * p[1] + m[2] * p[2] + m[3];
+        const float wy = m[4] * p[0] + m[5] * p[1] + m[6] * p[2] + m[7];
+        const float wz = m[8] * p[0] + m[9] * p[1] + m[10] * p[2] + m[11];
+        const float fx = std::floor(wx * b.inv_cell_size);
+        const float fy = std::floor(wy * b.inv_cell_size);
+        // NAN and INFINITY (invalid points) fail these tests
+        if (wz >= b.min_height && wz <= b.max_height && fx >= b.min_x && fx < b.max_x && fy >= b.min_y && fy < b.max_y) {
+            const int32_t index = ((int32_t(fy) & b.mask) << b.log2_size) | (int32_t(fx) & b.mask);
+            addToCell(b, index, wz);
+            added++;
+        }
+    }
+    return added;
+}
+
+#ifdef CPU_AVX2
+// 8 points at a time: the cell indices and heights are computed in registers, the cells are then updated one by one
+CPU_AVX2_TARGET static size_t binAVX2(const Binning& b, const float* row, int width) {
+    const float* m = b.pose;
+    const __m256 inv = _mm256_set1_ps(b.inv_cell_size);
+    const __m256 min_x = _mm256_set1_ps(b.min_x), max_x = _mm256_set1_ps(b.max_x);
+    const __m256 min_y = _mm256_set1_ps(b.min_y), max_y = _mm256_set1_ps(b.max_y);
+    const __m256 min_h = _mm256_set1_ps(b.min_height), max_h = _mm256_set1_ps(b.max_height);
+    const __m256i mask = _mm256_set1_epi32(b.mask);
+    const __m128i shift = _mm_cvtsi32_si128(b.log2_size);
+
+    alignas(32) int32_t index[8];
+    alignas(32) float height[8];
+    size_t added = 0;
+    int u = 0;
+    for (; u + 8 <= width; u += 8) {
+        const float* p = row + u * 4;
+        // AoS -> SoA, the points come out in the order 0 2 4 6 1 3 5 7, which does not matter here
+        const __m256 a = _mm256_loadu_ps(p), c = _mm256_loadu_ps(p + 8);
+        const __m256 d = _mm256_loadu_ps(p + 16), e = _mm256_loadu_ps(p + 24);
+        const __m256 lo0 = _mm256_unpacklo_ps(a, c), lo1 = _mm256_unpacklo_ps(d, e);
+        const __m256 hi0 = _mm256_unpackhi_ps(a, c), hi1 = _mm256_unpackhi_ps(d, e);
+        const __m256 x = _mm256_shuffle_ps(lo0, lo1, 0x44);
+        const __m256 y = _mm256_shuffle_ps(lo0, lo1, 0xEE);
+        const __m256 z = _mm256_shuffle_ps(hi0, hi1, 0x44);
+
+        // Same operation order as binScalar, so that both give the same grid
+        const __m256 wx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[0]), x),
+            _mm256_mul_ps(_mm256_set1_ps(m[1]), y)), _mm256_mul_ps(_mm256_set1_ps(m[2]), z)), _mm256_set1_ps(m[3]));
+        const __m256 wy = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[4]), x),
+            _mm256_mul_ps(_mm256_set1_ps(m[5]), y)), _mm256_mul_ps(_mm256_set1_ps(m[6]), z)), _mm256_set1_ps(m[7]));
+        const __m256 wz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[8]), x),
+            _mm256_mul_ps(_mm256_set1_ps(m[9]), y)), _mm256_mul_ps(_mm256_set1_ps(m[10]), z)), _mm256_set1_ps(m[11]));
+        const __m256 fx = _mm256_floor_ps(_mm256_mul_ps(wx, inv));
+        const __m256 fy = _mm256_floor_ps(_mm256_mul_ps(wy, inv));
+
+        // Ordered, non signaling comparisons: NAN lanes are rejected
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(wz, min_h, _CMP_GE_OQ), _mm256_cmp_ps(wz, max_h, _CMP_LE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(fx, min_x, _CMP_GE_OQ), _mm256_cmp_ps(fx, max_x, _CMP_LT_OQ)));
+        valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(fy, min_y, _CMP_GE_OQ), _mm256_cmp_ps(fy, max_y, _CMP_LT_OQ)));
+        const int lanes = _mm256_movemask_ps(valid);
+        if (!lanes)
+            continue;
+
+        const __m256i cx = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+        const __m256i cy = _mm256_and_si256(_mm256_cvttps_epi32(fy), mask);
+        _mm256_store_si256((__m256i*)index, _mm256_or_si256(_mm256_sll_epi32(cy, shift), cx));
+        _mm256_store_ps(height, wz);
+        for (int k = 0; k < 8; k++)
+            if (lanes & (1 << k)) {
+                addToCell(b, index[k], height[k]);
+                added++;
+            }
+    }
+    return added + binScalar(b, row, u, width);
+}
+#endif
+
+#ifdef CPU_NEON
+static size_t binNEON(const Binning& b, const float* row, int width) {
+    const float* m = b.pose;
+    const float32x4_t inv = vdupq_n_f32(b.inv_cell_size);
+    const int32x4_t mask = vdupq_n_s32(b.mask);
+    const int32x4_t shift = vdupq_n_s32(b.log2_size);
+
+    int32_t index[4];
+    float height[4];
+    uint32_t valid[4];
+    size_t added = 0;
+    int u = 0;
+    for (; u + 4 <= width; u += 4) {
+        const float32x4x4_t p = vld4q_f32(row + u * 4);
+        const float32x4_t x = p.val[0], y = p.val[1], z = p.val[2];
+
+        const float32x4_t wx = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, m[0]), vmulq_n_f32(y, m[1])), vmulq_n_f32(z, m[2])), vdupq_n_f32(m[3]));
+        const float32x4_t wy = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, m[4]), vmulq_n_f32(y, m[5])), vmulq_n_f32(z, m[6])), vdupq_n_f32(m[7]));
+        const float32x4_t wz = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, m[8]), vmulq_n_f32(y, m[9])), vmulq_n_f32(z, m[10])), vdupq_n_f32(m[11]));
+        const float32x4_t fx = vrndmq_f32(vmulq_f32(wx, inv));
+        const float32x4_t fy = vrndmq_f32(vmulq_f32(wy, inv));
+
+        uint32x4_t ok = vandq_u32(vcgeq_f32(wz, vdupq_n_f32(b.min_height)), vcleq_f32(wz, vdupq_n_f32(b.max_height)));
+        ok = vandq_u32(ok, vandq_u32(vcgeq_f32(fx, vdupq_n_f32(b.min_x)), vcltq_f32(fx, vdupq_n_f32(b.max_x))));
+        ok = vandq_u32(ok, vandq_u32(vcgeq_f32(fy, vdupq_n_f32(b.min_y)), vcltq_f32(fy, vdupq_n_f32(b.max_y))));
+        if (vmaxvq_u32(ok) == 0)
+            continue;
+
+        const int32x4_t cx = vandq_s32(vcvtq_s32_f32(fx), mask);
+        const int32x4_t cy = vandq_s32(vcvtq_s32_f32(fy), mask);
+        vst1q_s32(index, vorrq_s32(vshlq_s32(cy, shift), cx));
+        vst1q_f32(height, wz);
+        vst1q_u32(valid, ok);
+        for (int k = 0; k < 4; k++)
+            if (valid[k]) {
+                addToCell(b, index[k], height[k]);
+                added++;
+            }
+    }
+    return added + binScalar(b, row, u, width);
+}
+#endif
+
+HeightMap::HeightMap(const HeightMapParameters& parameters) : parameters_(parameters) {
+    log2_size_ = 0;
+    while ((1 << log2_size_) < std::max(parameters_.size, 1))
+        log2_size_++;
+    size_ = 1 << log2_size_;
+    mask_ = size_ - 1;
+    parameters_.size = size_;
+
+    const size_t nb_cells = size_t(size_) * size_;
+    max_height_.resize(nb_cells);
+    min_height_.resize(nb_cells);
+    hits_.resize(nb_cells);
+    clear();
+}
+
+void HeightMap::clear() {
+    std::fill(max_height_.begin(), max_height_.end(), -INFINITY);
+    std::fill(min_height_.begin(), min_height_.end(), INFINITY);
+    std::fill(hits_.begin(), hits_.end(), 0u);
+}
+
+void HeightMap::clearColumn(int cx) {
+    for (int cy = 0; cy < size_; cy++) {
+        const size_t i = storageIndex(cx, cy);
+        max_height_[i] = -INFINITY;
+        min_height_[i] = INFINITY;
+        hits_[i] = 0;
+    }
+}
+
+void HeightMap::clearRow(int cy) {
+    const size_t first = storageIndex(0, cy);
+    std::fill(max_height_.begin() + first, max_height_.begin() + first + size_, -INFINITY);
+    std::fill(min_height_.begin() + first, min_height_.begin() + first + size_, INFINITY);
+    std::fill(hits_.begin() + first, hits_.begin() + first + size_, 0u);
+}
+
+void HeightMap::recenter(float x, float y) {
+    const int origin_x = int(std::floor(x / parameters_.cell_size)) - size_ / 2;
+    const int origin_y = int(std::floor(y / parameters_.cell_size)) - size_ / 2;
+    const int dx = origin_x - origin_x_, dy = origin_y - origin_y_;
+
+    if (std::abs(dx) >= size_ || std::abs(dy) >= size_)
+        clear();
+    else {
+        // Only the columns and rows entering the grid are reset, they reuse the storage of the ones leaving it
+        for (int cx = std::min(origin_x_, origin_x) + (dx > 0 ? size_ : 0), n = 0; n < std::abs(dx); cx++, n++)
+            clearColumn(cx);
+        for (int cy = std::min(origin_y_, origin_y) + (dy > 0 ? size_ : 0), n = 0; n < std::abs(dy); cy++, n++)
+            clearRow(cy);
+    }
+    origin_x_ = origin_x;
+    origin_y_ = origin_y;
+}
+
+size_t HeightMap::integrate(sl::Mat& cloud, const sl::Transform& camera_to_world) {
+    Binning b;
+    for (int i = 0; i < 12; i++)
+        b.pose[i] = camera_to_world.m[i];
+    b.inv_cell_size = 1.f / parameters_.cell_size;
+    b.min_x = float(origin_x_);
+    b.max_x = float(origin_x_ + size_);
+    b.min_y = float(origin_y_);
+    b.max_y = float(origin_y_ + size_);
+    b.min_height = parameters_.min_height;
+    b.max_height = parameters_.max_height;
+    b.log2_size = log2_size_;
+    b.mask = mask_;
+    b.max_height_grid = max_height_.data();
+    b.min_height_grid = min_height_.data();
+    b.hits_grid = hits_.data();
+
+    const int width = int(cloud.getWidth());
+    const int height = int(cloud.getHeight());
+    const size_t step = cloud.getStepBytes(sl::MEM::CPU);
+    const uint8_t* data = cloud.getPtr<sl::uchar1>(sl::MEM::CPU);
+#ifdef CPU_AVX2
+    const bool use_avx2 = cpuHasAVX2();
+#endif
+
+    size_t added = 0;
+    for (int v = 0; v < height; v++) {
+        const float* row = (const float*) (data + v * step);
+#if defined(CPU_AVX2)
+        added += use_avx2 ? binAVX2(b, row, width) : binScalar(b, row, 0, width);
+#elif defined(CPU_NEON)
+        added += binNEON(b, row, width);
+#else
+        added += binScalar(b, row, 0, width);
+#endif
+    }
+    return added;
+}
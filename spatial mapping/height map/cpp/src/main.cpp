@@ -0,0 +1,298 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/*****************************************************************************
+ ** This sample demonstrates how to build a rolling 2.5D height map of the   **
+ ** ground around the camera, from the point cloud and the camera pose.      **
+ *****************************************************************************/
+
+// Standard includes
+#include <chrono>
+#include <random>
+
+// ZED includes
+#include <sl/Camera.hpp>
+
+// Sample includes
+#include "HeightMap.hpp"
+
+#include <opencv2/opencv.hpp>
+
+// Using std and sl namespaces
+using namespace std;
+using namespace sl;
+
+void parseArgs(int argc, char **argv, InitParameters& param);
+void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
+void renderHeightMap(const HeightMap& map, cv::Mat& display, bool occupancy);
+int runBenchmark(const HeightMapParameters& parameters, int nb_frames);
+
+// A cell is an obstacle when its points span more than this height (occupancy view)
+const float OBSTACLE_HEIGHT = 0.15f;
+// Cells with less points are displayed as unknown
+const uint32_t MIN_HITS = 3;
+
+int main(int argc, char **argv) {
+    // The floor is the origin of the world frame, everything above 2 m (ceiling) is ignored
+    HeightMapParameters parameters;
+    parameters.min_height = -0.5f;
+    parameters.max_height = 2.f;
+    // '--benchmark [frames]' integrates synthetic point clouds, without camera
+    int benchmark_frames = 0;
+    for (int i = 1; i < argc; i++) {
+        const string arg(argv[i]);
+        const bool has_value = i + 1 < argc && atof(argv[i + 1]) > 0;
+        if (arg == "--cell" && has_value) parameters.cell_size = atof(argv[i + 1]);
+        if (arg == "--size" && has_value) parameters.size = atoi(argv[i + 1]);
+        if (arg == "--benchmark") benchmark_frames = has_value ? atoi(argv[i + 1]) : 300;
+    }
+    if (benchmark_frames)
+        return runBenchmark(parameters, benchmark_frames);
+
+    Camera zed;
+    // Set configuration parameters for the ZED
+    InitParameters init_parameters;
+    init_parameters.depth_mode = DEPTH_MODE::ULTRA;
+    init_parameters.coordinate_system = COORDINATE_SYSTEM::RIGHT_HANDED_Z_UP; // the map is in the X, Y plane
+    init_parameters.coordinate_units = UNIT::METER;
+    parseArgs(argc, argv, init_parameters);
+
+    // Open the camera
+    auto returned_state = zed.open(init_parameters);
+    if (returned_state != ERROR_CODE::SUCCESS) {
+        print("Open Camera", returned_state, "\nExit program.");
+        zed.close();
+        return EXIT_FAILURE;
+    }
+
+    // Setup and start positional tracking, with the floor as origin so that the heights are above the ground
+    PositionalTrackingParameters positional_tracking_parameters;
+    positional_tracking_parameters.set_floor_as_origin = true;
+    returned_state = zed.enablePositionalTracking(positional_tracking_parameters);
+    if (returned_state != ERROR_CODE::SUCCESS) {
+        print("Enabling positional tracking failed: ", returned_state);
+        zed.close();
+        return EXIT_FAILURE;
+    }
+
+    // The point cloud is retrieved at half resolution, the cells are much bigger than a pixel anyway
+    auto resolution = zed.getCameraInformation().camera_configuration.resolution;
+    Resolution cloud_resolution(resolution.width / 2, resolution.height / 2);
+    Mat point_cloud(cloud_resolution, MAT_TYPE::F32_C4, MEM::CPU);
+
+    HeightMap map(parameters);
+    print("Height map of " + to_string(map.getSize()) + "x" + to_string(map.getSize()) + " cells of " +
+          to_string(int(map.getCellSize() * 100)) + " cm");
+    print("Press 'o' to switch between the height and the occupancy views, 'c' to clear the map, 'q' to quit");
+
+    Pose pose;
+    cv::Mat display;
+    bool occupancy = false;
+    char key = ' ';
+    while (key != 'q') {
+        returned_state = zed.grab();
+        if (returned_state == ERROR_CODE::SUCCESS) {
+            auto tracking_state = zed.getPosition(pose, REFERENCE_FRAME::WORLD);
+            if (tracking_state == POSITIONAL_TRACKING_STATE::OK) {
+                zed.retrieveMeasure(point_cloud, MEASURE::XYZ, MEM::CPU, cloud_resolution);
+
+                auto start = chrono::steady_clock::now();
+                auto translation = pose.getTranslation();
+                map.recenter(translation.x, translation.y);
+                map.integrate(point_cloud, pose.pose_data);
+                const double integrate_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+                renderHeightMap(map, display, occupancy);
+                cv::putText(display, "update: " + to_string(integrate_ms).substr(0, 5) + " ms", cv::Point(10, 20),
+                            cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255, 255, 255));
+                cv::imshow("Height Map", display);
+            }
+        } else if (returned_state == ERROR_CODE::END_OF_SVOFILE_REACHED)
+            break;
+        key = cv::waitKey(10);
+        if (key == 'o') occupancy = !occupancy;
+        if (key == 'c') map.clear();
+    }
+
+    // Free allocated memory before closing the camera
+    point_cloud.free();
+    zed.close();
+    return EXIT_SUCCESS;
+}
+
+// Top-down view of the map, X to the right and Y up, with the camera in the center.
+// Height view: color map of the max height of the cells. Occupancy view: obstacles in red, free cells in white.
+void renderHeightMap(const HeightMap& map, cv::Mat& display, bool occupancy) {
+    const int size = map.getSize();
+    cv::Mat heights(size, size, CV_8UC1), known(size, size, CV_8UC1), obstacles(size, size, CV_8UC1);
+    // The color map covers [-0.5 m, 2 m]
+    const float min_h = -0.5f, scale = 255.f / 2.5f;
+    for (int row = 0; row < size; row++) {
+        unsigned char* h = heights.ptr<unsigned char>(size - 1 - row);
+        unsigned char* k = known.ptr<unsigned char>(size - 1 - row);
+        unsigned char* o = obstacles.ptr<unsigned char>(size - 1 - row);
+        for (int col = 0; col < size; col++) {
+            const HeightMap::Cell cell = map.getCell(col, row);
+            k[col] = cell.hits >= MIN_HITS ? 255 : 0;
+            o[col] = (k[col] && cell.max_height - cell.min_height > OBSTACLE_HEIGHT) ? 255 : 0;
+            h[col] = k[col] ? cv::saturate_cast<unsigned char>((cell.max_height - min_h) * scale) : 0;
+        }
+    }
+
+    cv::Mat image(size, size, CV_8UC3, cv::Scalar(60, 60, 60));
+    if (occupancy) {
+        image.setTo(cv::Scalar(255, 255, 255), known);
+        image.setTo(cv::Scalar(0, 0, 220), obstacles);
+    } else {
+        cv::Mat colors;
+        cv::applyColorMap(heights, colors, cv::COLORMAP_JET);
+        colors.copyTo(image, known);
+    }
+    cv::circle(image, cv::Point(size / 2, size / 2), 3, cv::Scalar(0, 255, 0), -1);
+
+    const int display_size = 640;
+    cv::resize(image, display, cv::Size(display_size, display_size), 0, 0, cv::INTER_NEAREST);
+}
+
+// Synthetic point cloud of a 1280x720 camera, 1 m above a flat ground, facing a 1 m high wall 4 m ahead.
+// The sky and 10% of random pixels are invalid (NAN), as in a real depth map.
+static void syntheticCloud(Mat& cloud) {
+    const int width = 1280, height = 720;
+    const float f = 700.f, wall_distance = 4.f, wall_height = 1.f, camera_height = 1.f;
+    cloud.alloc(Resolution(width, height), MAT_TYPE::F32_C4, MEM::CPU);
+    mt19937 rng(42);
+    uniform_real_distribution<float> noise(-0.005f, 0.005f);
+    for (int v = 0; v < height; v++) {
+        float4* row = (float4*) (cloud.getPtr<uchar1>(MEM::CPU) + v * cloud.getStepBytes(MEM::CPU));
+        for (int u = 0; u < width; u++) {
+            // Camera frame of RIGHT_HANDED_Z_UP: X right, Y forward, Z up
+            const float dx = (u - width / 2) / f, dz = (height / 2 - v) / f;
+            float4 p;
+            p.x = p.y = p.z = p.w = NAN;
+            const float t_wall = wall_distance;
+            if (dz * t_wall > -camera_height && dz * t_wall < wall_height - camera_height) {
+                p.x = dx * t_wall;
+                p.y = t_wall;
+                p.z = dz * t_wall;
+            } else if (dz < 0.f) {
+                const float t = camera_height / -dz;
+                p.x = dx * t;
+                p.y = t;
+                p.z = -camera_height;
+            }
+            p.y += noise(rng);
+            p.z += noise(rng);
+            if (rng() % 10 == 0)
+                p.x = p.y = p.z = NAN;
+            row[u] = p;
+        }
+    }
+}
+
+int runBenchmark(const HeightMapParameters& parameters, int nb_frames) {
+    Mat cloud;
+    syntheticCloud(cloud);
+    const size_t nb_points = cloud.getResolution().area();
+
+    HeightMap map(parameters);
+    print("Benchmark: " + to_string(nb_frames) + " synthetic clouds of " + to_string(nb_points) + " points, " +
+          to_string(map.getSize()) + "x" + to_string(map.getSize()) + " cells of " + to_string(map.getCellSize()));
+
+    // The camera walks along a circle of 5 m radius, turning with it, 1 m above the ground
+    double recenter_us = 0., integrate_ms = 0.;
+    size_t added = 0;
+    for (int i = 0; i < nb_frames; i++) {
+        const float angle = i * 0.01f, radius = 5.f;
+        Transform camera_to_world;
+        camera_to_world.setEulerAngles(float3(0.f, 0.f, angle));
+        camera_to_world.setTranslation(Translation(radius * cos(angle), radius * sin(angle), 1.f));
+
+        auto start = chrono::steady_clock::now();
+        map.recenter(camera_to_world.getTranslation().x, camera_to_world.getTranslation().y);
+        auto recentered = chrono::steady_clock::now();
+        added += map.integrate(cloud, camera_to_world);
+        auto end = chrono::steady_clock::now();
+        recenter_us += chrono::duration<double, micro>(recentered - start).count();
+        integrate_ms += chrono::duration<double, milli>(end - recentered).count();
+    }
+
+    size_t known_cells = 0;
+    for (int row = 0; row < map.getSize(); row++)
+        for (int col = 0; col < map.getSize(); col++)
+            known_cells += map.getCell(col, row).hits > 0;
+
+    cout << "[Sample] integrate: " << integrate_ms / nb_frames << " ms per cloud, "
+         << nb_points * nb_frames / (integrate_ms * 1e3) << " Mpoints/s, "
+         << 100. * added / (double(nb_points) * nb_frames) << "% of the points in the grid" << endl;
+    cout << "[Sample] recenter: " << recenter_us / nb_frames << " us per frame" << endl;
+    cout << "[Sample] " << known_cells << " cells observed in the current grid" << endl;
+    return EXIT_SUCCESS;
+}
+
+void parseArgs(int argc, char **argv, InitParameters& param) {
+    if (argc > 1 && string(argv[1]).find(".svo") != string::npos) {
+        // SVO input mode
+        param.input.setFromSVOFile(argv[1]);
+        cout << "[Sample] Using SVO File input: " << argv[1] << endl;
+    } else if (argc > 1 && string(argv[1]).find(".svo") == string::npos) {
+        string arg = string(argv[1]);
+        unsigned int a, b, c, d, port;
+        if (sscanf(arg.c_str(), "%u.%u.%u.%u:%d", &a, &b, &c, &d, &port) == 5) {
+            // Stream input mode - IP + port
+            string ip_adress = to_string(a) + "." + to_string(b) + "." + to_string(c) + "." + to_string(d);
+            param.input.setFromStream(String(ip_adress.c_str()), port);
+            cout << "[Sample] Using Stream input, IP : " << ip_adress << ", port : " << port << endl;
+        } else if (sscanf(arg.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) == 4) {
+            // Stream input mode - IP only
+            param.input.setFromStream(String(argv[1]));
+            cout << "[Sample] Using Stream input, IP : " << argv[1] << endl;
+        } else if (arg.find("HD2K") != string::npos) {
+            param.camera_resolution = RESOLUTION::HD2K;
+            cout << "[Sample] Using Camera in resolution HD2K" << endl;
+        } else if (arg.find("HD1080") != string::npos) {
+            param.camera_resolution = RESOLUTION::HD1080;
+            cout << "[Sample] Using Camera in resolution HD1080" << endl;
+        } else if (arg.find("HD720") != string::npos) {
+            param.camera_resolution = RESOLUTION::HD720;
+            cout << "[Sample] Using Camera in resolution HD720" << endl;
+        } else if (arg.find("VGA") != string::npos) {
+            param.camera_resolution = RESOLUTION::VGA;
+            cout << "[Sample] Using Camera in resolution VGA" << endl;
+        }
+    } else {
+        // Default
+    }
+}
+
+void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
+    cout << "[Sample]";
+    if (err_code != ERROR_CODE::SUCCESS)
+        cout << "[Error] ";
+    else
+        cout << " ";
+    cout << msg_prefix << " ";
+    if (err_code != ERROR_CODE::SUCCESS) {
+        cout << " | " << toString(err_code) << " : ";
+        cout << toVerbose(err_code);
+    }
+    if (!msg_suffix.empty())
+        cout << " " << msg_suffix;
+    cout << endl;
+}
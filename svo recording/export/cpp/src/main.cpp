@@ -31,6 +31,7 @@
 #include <sstream>
 #include <opencv2/opencv.hpp>
 #include "utils.hpp"
+#include "DepthFilter.hpp"
 
 // Using namespace
 using namespace sl;
@@ -43,12 +44,14 @@ enum APP_TYPE {
 };
 
 void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
+void depthView(const cv::Mat& depth, cv::Mat& view, float min_depth, float max_depth);
 
 int main(int argc, char **argv) {
 
-    if (argc != 4) {
+    const bool temporal_filter = (argc == 5 && string(argv[4]) == "--temporal-filter");
+    if (argc != 4 && !temporal_filter) {
         cout << "Usage: \n\n";
-        cout << "    ZED_SVO_Export A B C \n\n";
+        cout << "    ZED_SVO_Export A B C [--temporal-filter]\n\n";
         cout << "Please use the following parameters from the command line:\n";
         cout << " A - SVO file path (input) : \"path/to/file.svo\"\n";
         cout << " B - AVI file path (output) or image sequence folder(output) : \"path/to/output/file.avi\" or \"path/to/output/folder\"\n";
@@ -57,6 +60,7 @@ int main(int argc, char **argv) {
         cout << "                   2=Export LEFT+RIGHT image sequence.\n";
         cout << "                   3=Export LEFT+DEPTH_VIEW image sequence.\n";
         cout << "                   4=Export LEFT+DEPTH_16Bit image sequence.\n";
+        cout << " --temporal-filter: the depth (modes 1, 3 and 4) is filtered over time and its holes are filled by the sample, instead of the FILL mode\n";
         cout << " A and B need to end with '/' or '\\'\n\n";
         cout << "Examples: \n";
         cout << "  (AVI LEFT+RIGHT)   ZED_SVO_Export \"path/to/file.svo\" \"path/to/output/file.avi\" 0\n";
@@ -142,7 +146,12 @@ int main(int argc, char **argv) {
     }
 
     RuntimeParameters rt_param;
-    rt_param.sensing_mode = SENSING_MODE::FILL;
+    rt_param.sensing_mode = temporal_filter ? SENSING_MODE::STANDARD : SENSING_MODE::FILL;
+    DepthFilter depth_filter;
+    const float min_depth = std::max(0.f, zed.getInitParameters().depth_minimum_distance); // -1: default
+    float max_depth = zed.getInitParameters().depth_maximum_distance;
+    if (max_depth <= 0.f) // -1: default, the maximum range of the camera (in millimeters here)
+        max_depth = (zed.getCameraInformation().camera_model == MODEL::ZED_M ? 15.f : 20.f) * 1000.f;
 
     // Start SVO conversion to AVI/SEQUENCE
     print("Converting SVO... Use Ctrl-C to interrupt conversion.");
@@ -166,10 +175,19 @@ int main(int argc, char **argv) {
                     zed.retrieveImage(right_image, VIEW::RIGHT);
                     break;
                 case LEFT_AND_DEPTH:
-                    zed.retrieveImage(right_image, VIEW::DEPTH);
+                    if (temporal_filter) {
+                        zed.retrieveMeasure(depth_image, MEASURE::DEPTH);
+                        depth_filter.process(depth_image, depth_image);
+                        depthView(depth_image_ocv, right_image_ocv, min_depth, max_depth);
+                    } else
+                        zed.retrieveImage(right_image, VIEW::DEPTH);
                     break;
                 case LEFT_AND_DEPTH_16:
                     zed.retrieveMeasure(depth_image, MEASURE::DEPTH);
+                    if (temporal_filter) {
+                        depth_filter.process(depth_image, depth_image);
+                        cv::patchNaNs(depth_image_ocv, 0); // 0: no depth
+                    }
                     break;
                 default:
                     break;
@@ -217,11 +235,26 @@ int main(int argc, char **argv) {
         // Close the video writer
         video_writer.release();
     }
+    if (temporal_filter) {
+        auto& stats = depth_filter.getStats();
+        if (stats.frames && stats.output_valid)
+            print("Temporal filter: " + to_string(100.f * stats.input_valid / stats.output_valid) + " % of the output depth measured, "
+                + to_string(stats.resets / stats.frames) + " pixels restarted per frame");
+    }
 
     zed.close();
     return EXIT_SUCCESS;
 }
 
+// Same look as VIEW::DEPTH: white close, black far or invalid
+void depthView(const cv::Mat& depth, cv::Mat& view, float min_depth, float max_depth) {
+    cv::Mat gray;
+    const double scale = -255. / (max_depth - min_depth);
+    depth.convertTo(gray, CV_8UC1, scale, -scale * max_depth);
+    gray.setTo(0, depth != depth); // NAN
+    cv::cvtColor(gray, view, cv::COLOR_GRAY2BGRA);
+}
+
 void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
     cout <<"[Sample]";
     if (err_code != ERROR_CODE::SUCCESS)
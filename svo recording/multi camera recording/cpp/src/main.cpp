@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2020, STEREOLABS.
+//
+// All rights reserved.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+///////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************
+** This sample shows how to record all the connected ZEDs at once, in SVO format.      **
+** Every camera is opened and ready to record before the recording starts for all of  **
+** them at the same time. A session manifest gives the first frame timestamp of each  **
+** SVO, to align them when they are processed later.                                  **
+*****************************************************************************************/
+
+// Standard includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+// ZED includes
+#include <sl/Camera.hpp>
+
+// Sample includes
+#include "utils.hpp"
+
+// Using namespace
+using namespace sl;
+using namespace std;
+
+// Releases all the waiting threads at once, when the last expected one arrives
+class StartBarrier {
+public:
+    StartBarrier(int count_) : count(count_) {}
+
+    void wait() {
+        unique_lock<mutex> lock(mtx);
+        if (--count <= 0) {
+            cv.notify_all();
+            return;
+        }
+        cv.wait(lock, [this] { return count <= 0; });
+    }
+
+private:
+    mutex mtx;
+    condition_variable cv;
+    int count;
+};
+
+// Recording state of one camera, written by its thread, read by main once the threads are joined
+struct CameraSession {
+    unsigned int serial = 0;
+    string model;
+    string svo_path;
+    Resolution resolution;
+    float fps = 0;
+    bool ready = false;
+    uint64_t first_frame_ts = 0; // ns, TIME_REFERENCE::IMAGE
+    uint64_t last_frame_ts = 0;
+    int frames_recorded = 0;
+    int frames_not_recorded = 0; // grabbed but refused by the recorder
+    int frames_dropped = 0; // missing in the timestamps, estimated from the frame period
+    int grab_errors = 0;
+    bool lost = false; // stopped after MAX_CONSECUTIVE_GRAB_ERRORS
+};
+
+// A camera that keeps failing (unplugged) stops recording instead of retrying forever
+static const int MAX_CONSECUTIVE_GRAB_ERRORS = 100;
+static const int GRAB_ERROR_WAIT_MS = 10;
+
+void print(string msg_prefix, ERROR_CODE err_code = ERROR_CODE::SUCCESS, string msg_suffix = "");
+void recordCamera(Camera& zed, CameraSession& session, StartBarrier& barrier, atomic<bool>& run);
+void writeManifest(const string& path, const vector<CameraSession>& sessions);
+string jsonEscape(const string& value);
+
+int main(int argc, char **argv) {
+
+    if (argc < 2) {
+        cout << "Usage : ./ZED_SVO_Multi_Camera_Recording <session_prefix> [HD2K|HD1080|HD720|VGA]\n";
+        cout << "        records <session_prefix>_<serial>.svo for each camera and <session_prefix>.json\n";
+        return EXIT_FAILURE;
+    }
+    string prefix(argv[1]);
+
+    InitParameters init_parameters;
+    init_parameters.camera_resolution = RESOLUTION::HD720;
+    init_parameters.depth_mode = DEPTH_MODE::NONE;
+    if (argc > 2) {
+        string arg(argv[2]);
+        if (arg.find("HD2K") != string::npos) init_parameters.camera_resolution = RESOLUTION::HD2K;
+        else if (arg.find("HD1080") != string::npos) init_parameters.camera_resolution = RESOLUTION::HD1080;
+        else if (arg.find("VGA") != string::npos) init_parameters.camera_resolution = RESOLUTION::VGA;
+    }
+
+    auto devList = Camera::getDeviceList();
+    int nb_detected_zed = devList.size();
+    if (nb_detected_zed == 0) {
+        print("No ZED Detected, exit program");
+        return EXIT_FAILURE;
+    }
+    print(to_string(nb_detected_zed) + " ZED Detected");
+
+    // Open every camera first, opening is slow and would delay the start of the others
+    vector<Camera> zeds(nb_detected_zed);
+    vector<CameraSession> sessions(nb_detected_zed);
+    int nb_opened = 0;
+    for (int z = 0; z < nb_detected_zed; z++) {
+        init_parameters.input.setFromSerialNumber(devList[z].serial_number);
+        auto returned_state = zeds[z].open(init_parameters);
+        if (returned_state != ERROR_CODE::SUCCESS) {
+            print("Camera Open SN" + to_string(devList[z].serial_number), returned_state, "Camera skipped.");
+            continue;
+        }
+        auto cam_info = zeds[z].getCameraInformation();
+        auto& session = sessions[z];
+        session.serial = cam_info.serial_number;
+        session.model = string(toString(cam_info.camera_model).c_str());
+        session.resolution = cam_info.camera_configuration.resolution;
+        session.fps = cam_info.camera_configuration.fps;
+        session.svo_path = prefix + "_" + to_string(session.serial) + ".svo";
+        session.ready = true;
+        nb_opened++;
+    }
+    if (nb_opened == 0) {
+        print("No ZED could be opened, exit program");
+        return EXIT_FAILURE;
+    }
+
+    // Each thread enables its recording, then waits for the others: the first grab of all the cameras happens together
+    StartBarrier barrier(nb_opened);
+    atomic<bool> run(true);
+    vector<thread> threads;
+    for (int z = 0; z < nb_detected_zed; z++)
+        if (sessions[z].ready)
+            threads.emplace_back(recordCamera, ref(zeds[z]), ref(sessions[z]), ref(barrier), ref(run));
+
+    print("SVOs are Recording, use Ctrl-C to stop.");
+    SetCtrlHandler();
+    while (!exit_app)
+        sleep_ms(50);
+    run = false;
+    for (auto& it : threads)
+        it.join();
+
+    // Report
+    uint64_t first_min = 0, first_max = 0;
+    for (auto& s : sessions) {
+        if (!s.ready || !s.first_frame_ts) continue;
+        first_min = first_min ? min(first_min, s.first_frame_ts) : s.first_frame_ts;
+        first_max = max(first_max, s.first_frame_ts);
+        int expected = s.frames_recorded + s.frames_not_recorded + s.frames_dropped;
+        cout << "[Sample] SN" << s.serial << ": " << s.frames_recorded << " frames recorded, "
+            << s.frames_dropped + s.frames_not_recorded << " dropped ("
+            << (expected ? 100.f * (s.frames_dropped + s.frames_not_recorded) / expected : 0.f) << " %), "
+            << s.grab_errors << " grab errors" << (s.lost ? ", camera lost" : "") << endl;
+    }
+    print("Start spread between cameras: " + to_string((first_max - first_min) * 1e-6) + " ms");
+
+    writeManifest(prefix + ".json", sessions);
+    print("Session manifest written to " + prefix + ".json");
+    return EXIT_SUCCESS;
+}
+
+void recordCamera(Camera& zed, CameraSession& session, StartBarrier& barrier, atomic<bool>& run) {
+    auto returned_state = zed.enableRecording(RecordingParameters(String(session.svo_path.c_str()), SVO_COMPRESSION_MODE::H264));
+    if (returned_state != ERROR_CODE::SUCCESS) {
+        print("Recording SN" + to_string(session.serial), returned_state);
+        session.ready = false;
+    }
+    // a camera that failed still has to release the others
+    barrier.wait();
+    if (!session.ready) {
+        zed.close();
+        return;
+    }
+
+    const uint64_t frame_period = static_cast<uint64_t>(1e9 / session.fps);
+    int consecutive_errors = 0;
+    while (run) {
+        returned_state = zed.grab();
+        if (returned_state != ERROR_CODE::SUCCESS) {
+            session.grab_errors++;
+            if (++consecutive_errors >= MAX_CONSECUTIVE_GRAB_ERRORS) {
+                print("SN" + to_string(session.serial) + " lost, recording stopped", returned_state);
+                session.lost = true;
+                break;
+            }
+            // a failing grab returns at once, do not spin on it
+            sleep_ms(GRAB_ERROR_WAIT_MS);
+            continue;
+        }
+        consecutive_errors = 0;
+        if (!zed.getRecordingStatus().status) {
+            session.frames_not_recorded++;
+            continue;
+        }
+
+        uint64_t ts = zed.getTimestamp(TIME_REFERENCE::IMAGE).getNanoseconds();
+        if (!session.first_frame_ts)
+            session.first_frame_ts = ts;
+        else if (ts > session.last_frame_ts + frame_period + frame_period / 2)
+            // more than 1.5 period since the previous frame: the frames in between are lost
+            session.frames_dropped += static_cast<int>((ts - session.last_frame_ts + frame_period / 2) / frame_period) - 1;
+        session.last_frame_ts = ts;
+        session.frames_recorded++;
+    }
+
+    zed.disableRecording();
+    zed.close();
+}
+
+void writeManifest(const string& path, const vector<CameraSession>& sessions) {
+    ofstream file(path);
+    file << "{\n  \"cameras\": [";
+    bool first = true;
+    for (auto& s : sessions) {
+        if (!s.ready) continue;
+        file << (first ? "\n" : ",\n");
+        first = false;
+        file << "    {\n"
+            << "      \"serial_number\": " << s.serial << ",\n"
+            << "      \"model\": \"" << jsonEscape(s.model) << "\",\n"
+            << "      \"svo\": \"" << jsonEscape(s.svo_path) << "\",\n"
+            << "      \"resolution\": [" << s.resolution.width << ", " << s.resolution.height << "],\n"
+            << "      \"fps\": " << s.fps << ",\n"
+            << "      \"first_frame_timestamp_ns\": " << s.first_frame_ts << ",\n"
+            << "      \"last_frame_timestamp_ns\": " << s.last_frame_ts << ",\n"
+            << "      \"frames_recorded\": " << s.frames_recorded << ",\n"
+            << "      \"frames_dropped\": " << s.frames_dropped + s.frames_not_recorded << ",\n"
+            << "      \"lost\": " << (s.lost ? "true" : "false") << "\n"
+            << "    }";
+    }
+    file << "\n  ]\n}\n";
+}
+
+// The SVO path comes from the command line, it may hold quotes, backslashes (Windows) or control characters
+string jsonEscape(const string& value) {
+    string escaped;
+    escaped.reserve(value.size());
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\b': escaped += "\\b"; break;
+            case '\f': escaped += "\\f"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char code[7];
+                    snprintf(code, sizeof(code), "\\u%04x", c);
+                    escaped += code;
+                } else
+                    escaped += static_cast<char>(c);
+        }
+    }
+    return escaped;
+}
+
+void print(string msg_prefix, ERROR_CODE err_code, string msg_suffix) {
+    cout <<"[Sample]";
+    if (err_code != ERROR_CODE::SUCCESS)
+        cout << "[Error] ";
+    else
+        cout<<" ";
+    cout << msg_prefix << " ";
+    if (err_code != ERROR_CODE::SUCCESS) {
+        cout << " | " << toString(err_code) << " : ";
+        cout << toVerbose(err_code);
+    }
+    if (!msg_suffix.empty())
+        cout << " " << msg_suffix;
+    cout << endl;
+}